@@ -3,6 +3,8 @@
 #include <chrono>
 #include <cstdlib>
 #include <ctime>
+#include "random.hpp"
+#include "buffer_pool.hpp"
 using namespace std;
 using namespace std::chrono;
 
@@ -89,16 +91,13 @@ float parallelAvg(int nums[], int length)
 // Main
 int main()
 {
-    srand(time(0)); // Seed random number generator
-
     int length;
     cout << "Enter number of elements: ";
     cin >> length;
 
-    int* nums = new int[length];
-    for (int i = 0; i < length; i++) {
-        nums[i] = rand() % length + 1;  // Random values from 1 to 1000
-    }
+    hpc::pooled_buffer<int> buffer = hpc::buffer_pool::global().acquire<int>(length);
+    int* nums = buffer.data();
+    hpc::parallel_fill_uniform(nums, nums + length, 1, length, time(0)); // Random values from 1 to length
 
     displayArray(nums, length);
 
@@ -126,7 +125,6 @@ int main()
     cout << "Min: " << pMin << "\nMax: " << pMax << "\nSum: " << pSum << "\nAverage: " << pAvg << endl;
     cout << "Parallel execution time: " << duration_cast<microseconds>(endPar - startPar).count() << " microseconds" << endl;
 
-    delete[] nums;
     return 0;
 }
 
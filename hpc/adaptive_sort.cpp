@@ -0,0 +1,147 @@
+/*
+ * Adaptive Parallel Sort Benchmark using adaptive_sort.hpp
+ * ========================================================
+ *
+ * COMPILATION & EXECUTION:
+ *
+ * For Ubuntu:
+ * -----------
+ * g++ -std=c++20 -O2 -fopenmp -o adaptive_sort adaptive_sort.cpp
+ * ./adaptive_sort
+ *
+ * For macOS:
+ * ----------
+ * g++ -std=c++20 -O2 -Xpreprocessor -fopenmp -I"$(brew --prefix libomp)/include" -L"$(brew --prefix libomp)/lib" -lomp -o adaptive_sort adaptive_sort.cpp
+ * ./adaptive_sort
+ *
+ * THEORETICAL CONCEPTS:
+ *
+ * Natural Merge Sort:
+ * ------------------
+ * - MERGE.cpp's mergeSort always splits in the middle, so it does O(n log n) work even on sorted input
+ * - A natural merge sort first finds the runs already present in the data and only merges those
+ * - r runs cost O(n log r): sorted or reversed input (r = 1) is a single linear scan
+ *
+ * Run Detection in Parallel:
+ * -------------------------
+ * - Every thread scans its own slice; runs crossing a slice boundary are joined afterwards
+ * - Strictly descending runs are reversed in place (strict, so equal elements keep their order)
+ *
+ * Galloping:
+ * ---------
+ * - When one run keeps winning the merge, binary search finds how far it keeps winning
+ * - That whole block is then moved at once, so merging interleaved blocks costs O(log block) compares each
+ *
+ * SAMPLE INPUT/OUTPUT:
+ * ------------------
+ *
+ * Input:
+ *   1000000                      (Array size)
+ *
+ * Output:
+ *   Input            mergeSort (MERGE.cpp)   parallel_stable_sort   parallel_adaptive_sort
+ *   sorted           0.122567 s              0.044395 s             0.00158187 s
+ *   reversed         0.117673 s              0.040248 s             0.00222358 s
+ *   nearly sorted    0.117285 s              0.037931 s             0.0278311 s
+ *   sawtooth         0.094899 s              0.035442 s             0.00592584 s
+ *   random           0.198516 s              0.028785 s             0.0304216 s
+ *
+ *   All results sorted: yes
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <random>
+#include <algorithm>
+#include <omp.h>
+#include "adaptive_sort.hpp"
+using namespace std;
+
+// Baseline: the top-down merge sort from MERGE.cpp, on a vector instead of a stack array
+void merge(vector<int> &arr, int low, int mid, int high)
+{
+    vector<int> left(arr.begin() + low, arr.begin() + mid + 1);
+    vector<int> right(arr.begin() + mid + 1, arr.begin() + high + 1);
+    size_t i = 0, j = 0;
+    int k = low;
+    while (i < left.size() && j < right.size())
+        arr[k++] = (left[i] <= right[j]) ? left[i++] : right[j++];
+    while (i < left.size())
+        arr[k++] = left[i++];
+    while (j < right.size())
+        arr[k++] = right[j++];
+}
+
+void mergeSort(vector<int> &arr, int low, int high)
+{
+    if (low < high)
+    {
+        int mid = (low + high) / 2;
+        mergeSort(arr, low, mid);
+        mergeSort(arr, mid + 1, high);
+        merge(arr, low, mid, high);
+    }
+}
+
+vector<int> makeInput(const string &kind, int n)
+{
+    mt19937 rng(7);
+    vector<int> arr(n);
+    for (int i = 0; i < n; i++)
+        arr[i] = i;
+
+    if (kind == "reversed")
+        reverse(arr.begin(), arr.end());
+    else if (kind == "nearly sorted")
+        for (int s = 0; s < n / 100; s++) // 1% random swaps
+            swap(arr[rng() % n], arr[rng() % n]);
+    else if (kind == "sawtooth")
+        for (int i = 0; i < n; i += 20000) // alternating ascending/descending runs of 10000
+            reverse(arr.begin() + min(n, i + 10000), arr.begin() + min(n, i + 20000));
+    else if (kind == "random")
+        shuffle(arr.begin(), arr.end(), rng);
+    return arr;
+}
+
+template <class F>
+double timeIt(vector<int> arr, F sortFn, bool &ok)
+{
+    double start = omp_get_wtime();
+    sortFn(arr);
+    double elapsed = omp_get_wtime() - start;
+    ok = ok && is_sorted(arr.begin(), arr.end());
+    return elapsed;
+}
+
+int main()
+{
+    int n;
+    cout << "Enter the size of the array: ";
+    cin >> n;
+
+    if (n <= 0)
+    {
+        cout << "Invalid array size!" << endl;
+        return 1;
+    }
+
+    cout << "\n"
+         << left << setw(17) << "Input" << setw(24) << "mergeSort (MERGE.cpp)" << setw(23)
+         << "parallel_stable_sort" << "parallel_adaptive_sort" << endl;
+
+    bool ok = true;
+    for (string kind : {"sorted", "reversed", "nearly sorted", "sawtooth", "random"})
+    {
+        vector<int> arr = makeInput(kind, n);
+        double t_base = timeIt(arr, [&](vector<int> &a) { mergeSort(a, 0, n - 1); }, ok);
+        double t_stable = timeIt(arr, [](vector<int> &a) { hpc::parallel_stable_sort(a); }, ok);
+        double t_adapt = timeIt(arr, [](vector<int> &a) { hpc::parallel_adaptive_sort(a); }, ok);
+        cout << left << setw(17) << kind << setw(24) << to_string(t_base) + " s" << setw(23)
+             << to_string(t_stable) + " s" << t_adapt << " s" << endl;
+    }
+
+    cout << "\nAll results sorted: " << (ok ? "yes" : "no") << endl;
+    return 0;
+}
@@ -0,0 +1,351 @@
+/*
+ * Adaptive (Natural / TimSort-style) Parallel Sort (header-only) using OpenMP
+ * ==========================================================================
+ *
+ * Sorts in time proportional to how unsorted the input is. Already sorted or fully
+ * reversed input takes one linear scan; nearly sorted input costs O(n log r) for r
+ * runs; random input costs the same as hpc::parallel_stable_sort.
+ *
+ * USAGE:
+ *
+ *   #include "adaptive_sort.hpp"
+ *
+ *   hpc::parallel_adaptive_sort(arr.begin(), arr.end());
+ *   hpc::parallel_adaptive_sort(orders, less<>(), [](const Order &o) { return o.time; });
+ *
+ * COMPILATION:
+ *   g++ -std=c++20 -O2 -fopenmp -o program program.cpp
+ *
+ * ALGORITHM:
+ * ---------
+ * 1. Run detection (parallel): each thread scans its slice for maximal non-descending
+ *    runs and strictly descending runs.
+ * 2. Runs that continue across slice boundaries are joined (sequential, O(runs)).
+ * 3. Descending runs are reversed in place (parallel). Strictly descending only, so
+ *    equal elements never swap and the sort stays stable.
+ * 4. Neighbouring runs that are already in order are coalesced. One run left: done.
+ * 5. If runs average fewer than min_run_length elements there is no order to exploit and
+ *    the input goes to hpc::parallel_stable_sort; detection stops as soon as a slice sees
+ *    that many runs, so random input pays for only part of one scan. Otherwise short runs
+ *    are grouped into blocks of at least min_block elements and each block is sorted.
+ * 6. Runs are merged pairwise, level by level, ping-ponging with one buffer. Each pair
+ *    merge is split into tasks by binary search, and every piece uses a galloping merge
+ *    that copies whole blocks once one side keeps winning.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <ranges>
+#include <utility>
+#include <vector>
+#include <omp.h>
+#include "parallel_sort.hpp"
+
+namespace hpc
+{
+
+namespace detail
+{
+
+// Inputs whose runs average fewer elements than this go to the regular stable sort.
+constexpr std::ptrdiff_t min_run_length = 8;
+
+// Short runs are grouped and sorted together until a block holds this many elements.
+constexpr std::ptrdiff_t min_block = 256;
+
+// Consecutive wins by one side before the merge switches to galloping.
+constexpr int min_gallop = 7;
+
+struct sorted_run
+{
+    std::ptrdiff_t begin;
+    std::ptrdiff_t end;
+    bool descending;
+
+    std::ptrdiff_t size() const { return end - begin; }
+};
+
+// First position in [first, last) whose element is greater than value, found by
+// exponential then binary search from the front.
+template <class It, class T, class Less>
+It gallop_upper(It first, It last, const T &value, const Less &less)
+{
+    const std::ptrdiff_t n = last - first;
+    std::ptrdiff_t lo = 0, hi = 1;
+    while (hi < n && !less(value, first[hi]))
+    {
+        lo = hi;
+        hi = 2 * hi + 1;
+    }
+    return std::upper_bound(first + lo, first + std::min(hi, n), value, less);
+}
+
+// First position in [first, last) whose element is not less than value.
+template <class It, class T, class Less>
+It gallop_lower(It first, It last, const T &value, const Less &less)
+{
+    const std::ptrdiff_t n = last - first;
+    std::ptrdiff_t lo = 0, hi = 1;
+    while (hi < n && less(first[hi], value))
+    {
+        lo = hi;
+        hi = 2 * hi + 1;
+    }
+    return std::lower_bound(first + lo, first + std::min(hi, n), value, less);
+}
+
+// Stable merge that moves whole blocks once either side wins min_gallop times in a row.
+struct gallop_merge
+{
+    template <class SrcIt, class DstIt, class Less>
+    void operator()(SrcIt a, SrcIt a_end, SrcIt b, SrcIt b_end, DstIt out, const Less &less) const
+    {
+        int a_wins = 0, b_wins = 0;
+        while (a != a_end && b != b_end)
+        {
+            if (a_wins >= min_gallop)
+            {
+                SrcIt stop = gallop_upper(a, a_end, *b, less);
+                out = std::move(a, stop, out);
+                a = stop;
+                a_wins = 0;
+            }
+            else if (b_wins >= min_gallop)
+            {
+                SrcIt stop = gallop_lower(b, b_end, *a, less);
+                out = std::move(b, stop, out);
+                b = stop;
+                b_wins = 0;
+            }
+            else if (less(*b, *a))
+            {
+                *out++ = std::move(*b++);
+                b_wins++;
+                a_wins = 0;
+            }
+            else
+            {
+                *out++ = std::move(*a++);
+                a_wins++;
+                b_wins = 0;
+            }
+        }
+        out = std::move(a, a_end, out);
+        std::move(b, b_end, out);
+    }
+};
+
+// Returns the runs of [first, first + n), or nothing if some slice has runs averaging
+// fewer than min_run_length elements (the caller then sorts without using runs).
+template <class RandomIt, class Less>
+std::vector<sorted_run> detect_runs(RandomIt first, std::ptrdiff_t n, const Less &less)
+{
+    const int threads = static_cast<int>(std::clamp<std::ptrdiff_t>(n / parallel_cutoff, 1, omp_get_max_threads()));
+    std::vector<std::vector<sorted_run>> local(threads);
+    bool unordered = false;
+
+#pragma omp parallel num_threads(threads)
+    {
+        const int nt = omp_get_num_threads();
+        const int t = omp_get_thread_num();
+        const std::ptrdiff_t lo = n * t / nt;
+        const std::ptrdiff_t hi = n * (t + 1) / nt;
+        std::vector<sorted_run> &runs = local[t];
+        const std::size_t max_runs = (hi - lo) / min_run_length + 1;
+
+        for (std::ptrdiff_t i = lo; i < hi;)
+        {
+            if (runs.size() > max_runs)
+            {
+#pragma omp atomic write
+                unordered = true;
+                break;
+            }
+            std::ptrdiff_t j = i + 1;
+            bool descending = j < hi && less(first[j], first[i]);
+            if (descending)
+                while (j < hi && less(first[j], first[j - 1]))
+                    j++;
+            else
+                while (j < hi && !less(first[j], first[j - 1]))
+                    j++;
+            runs.push_back({i, j, descending});
+            i = j;
+        }
+    }
+
+    // Join runs that carry on across a slice boundary. A one-element run can take
+    // either direction.
+    std::vector<sorted_run> runs;
+    if (unordered)
+        return runs;
+    for (auto &slice : local)
+        for (const sorted_run &r : slice)
+        {
+            if (!runs.empty())
+            {
+                sorted_run &p = runs.back();
+                const bool p_free = p.size() == 1, r_free = r.size() == 1;
+                const bool in_order = !less(first[r.begin], first[p.end - 1]);
+                if ((!p.descending || p_free) && (!r.descending || r_free) && in_order)
+                {
+                    p = {p.begin, r.end, false};
+                    continue;
+                }
+                if ((p.descending || p_free) && (r.descending || r_free) && !in_order)
+                {
+                    p = {p.begin, r.end, true};
+                    continue;
+                }
+            }
+            runs.push_back(r);
+        }
+    return runs;
+}
+
+template <class RandomIt>
+void reverse_runs(RandomIt first, const std::vector<sorted_run> &runs)
+{
+    std::vector<const sorted_run *> small;
+    for (const sorted_run &r : runs)
+    {
+        if (!r.descending)
+            continue;
+        if (r.size() <= parallel_cutoff)
+        {
+            small.push_back(&r);
+            continue;
+        }
+        const std::ptrdiff_t half = r.size() / 2;
+#pragma omp parallel for
+        for (std::ptrdiff_t i = 0; i < half; i++)
+            std::iter_swap(first + r.begin + i, first + r.end - 1 - i);
+    }
+
+#pragma omp parallel for schedule(dynamic)
+    for (std::size_t i = 0; i < small.size(); i++)
+        std::reverse(first + small[i]->begin, first + small[i]->end);
+}
+
+// Merges runs pairwise from src into dst; an unpaired last run is moved across as is.
+template <class SrcIt, class DstIt, class Less>
+std::vector<sorted_run> merge_level(SrcIt src, DstIt dst, const std::vector<sorted_run> &runs, const Less &less)
+{
+    std::vector<sorted_run> merged;
+    for (std::size_t i = 0; i < runs.size(); i += 2)
+    {
+        const sorted_run a = runs[i];
+        if (i + 1 == runs.size())
+        {
+#pragma omp task
+            std::move(src + a.begin, src + a.end, dst + a.begin);
+            merged.push_back(a);
+            break;
+        }
+        const sorted_run b = runs[i + 1];
+#pragma omp task
+        parallel_merge(src + a.begin, src + a.end, src + b.begin, src + b.end, dst + a.begin, less,
+                       parallel_cutoff, gallop_merge{});
+        merged.push_back({a.begin, b.end, false});
+    }
+#pragma omp taskwait
+    return merged;
+}
+
+template <class RandomIt, class Compare, class KeyFn>
+void adaptive_sort(RandomIt first, RandomIt last, const Compare &comp, const KeyFn &key)
+{
+    using T = std::iter_value_t<RandomIt>;
+    const std::ptrdiff_t n = last - first;
+    if (n < 2)
+        return;
+
+    const key_compare<Compare, KeyFn> less{comp, key};
+    std::vector<sorted_run> detected = detect_runs(first, n, less);
+    if (detected.empty())
+    {
+        parallel_stable_sort(first, last, comp, key);
+        return;
+    }
+    reverse_runs(first, detected);
+
+    // Every run is ascending now; coalesce the ones that already meet in order.
+    std::vector<sorted_run> runs;
+    for (const sorted_run &r : detected)
+    {
+        if (!runs.empty() && !less(first[r.begin], first[runs.back().end - 1]))
+            runs.back().end = r.end;
+        else
+            runs.push_back({r.begin, r.end, false});
+    }
+    if (runs.size() == 1)
+        return;
+    if (static_cast<std::ptrdiff_t>(runs.size()) > n / min_run_length)
+    {
+        parallel_stable_sort(first, last, comp, key);
+        return;
+    }
+
+    // Group consecutive short runs into blocks and sort each block.
+    std::vector<sorted_run> blocks, to_sort;
+    for (const sorted_run &r : runs)
+    {
+        const bool short_run = r.size() < min_block;
+        if (short_run && !blocks.empty() && blocks.back().descending && blocks.back().size() < min_block)
+        {
+            blocks.back().end = r.end; // still filling a block of short runs
+            continue;
+        }
+        blocks.push_back({r.begin, r.end, short_run}); // `descending` marks "needs sorting"
+    }
+    for (sorted_run &b : blocks)
+        if (b.descending)
+        {
+            to_sort.push_back(b);
+            b.descending = false;
+        }
+#pragma omp parallel for schedule(dynamic)
+    for (std::size_t i = 0; i < to_sort.size(); i++)
+        std::stable_sort(first + to_sort[i].begin, first + to_sort[i].end, less);
+
+    std::vector<T> buffer(n);
+    bool in_buffer = false;
+#pragma omp parallel
+    {
+#pragma omp single
+        while (blocks.size() > 1)
+        {
+            blocks = in_buffer ? merge_level(buffer.begin(), first, blocks, less)
+                               : merge_level(first, buffer.begin(), blocks, less);
+            in_buffer = !in_buffer;
+        }
+    }
+
+    if (in_buffer)
+    {
+#pragma omp parallel for
+        for (std::ptrdiff_t i = 0; i < n; i++)
+            first[i] = std::move(buffer[i]);
+    }
+}
+
+} // namespace detail
+
+// Stable sort that finishes in linear time on sorted, reversed or few-run input.
+template <std::random_access_iterator RandomIt, class Compare = std::less<>, class KeyFn = identity_key>
+void parallel_adaptive_sort(RandomIt first, RandomIt last, Compare comp = {}, KeyFn key = {})
+{
+    detail::adaptive_sort(first, last, comp, key);
+}
+
+template <std::ranges::random_access_range Range, class Compare = std::less<>, class KeyFn = identity_key>
+void parallel_adaptive_sort(Range &&range, Compare comp = {}, KeyFn key = {})
+{
+    parallel_adaptive_sort(std::ranges::begin(range), std::ranges::end(range), comp, key);
+}
+
+} // namespace hpc
@@ -0,0 +1,149 @@
+/*
+ * Block Odd-Even Sort Benchmark using odd_even_sort.hpp
+ * =====================================================
+ *
+ * COMPILATION & EXECUTION:
+ *
+ * For Ubuntu:
+ * -----------
+ * g++ -std=c++20 -O2 -fopenmp -o block_odd_even block_odd_even.cpp
+ * ./block_odd_even
+ *
+ * For macOS:
+ * ----------
+ * g++ -std=c++20 -O2 -Xpreprocessor -fopenmp -I"$(brew --prefix libomp)/include" -L"$(brew --prefix libomp)/lib" -lomp -o block_odd_even block_odd_even.cpp
+ * ./block_odd_even
+ *
+ * THEORETICAL CONCEPTS:
+ *
+ * Element Odd-Even Transposition (baselines):
+ * ------------------------------------------
+ * - bubble_sort_odd_even (bubble.cpp) and parallelBubbleSort (bub_mer.cpp) run up to n phases
+ * - Every phase opens a new #pragma omp parallel for, so n fork/joins for n elements
+ * - Each phase does n/2 single compare-swaps: O(n^2) work in total
+ *
+ * Block Odd-Even Merge-Split:
+ * --------------------------
+ * - p threads each own one block of n/p elements and sort it locally: O((n/p) log(n/p))
+ * - Only p phases are needed; in each, neighbouring blocks merge and split: O(n/p) per phase
+ * - Total O((n/p) log(n/p) + n) per thread instead of O(n^2 / p)
+ * - One parallel region for the whole sort; phases are separated by barriers, or by
+ *   point-to-point flags where each thread only waits for its current partner
+ *
+ * SAMPLE INPUT/OUTPUT:
+ * ------------------
+ *
+ * Input:
+ *   20000                        (Array size)
+ *
+ * Output (4 threads on one core):
+ *   Threads: 4
+ *   bubble_sort_odd_even (bubble.cpp):   1.18553 s   sorted: yes
+ *   parallelBubbleSort (bub_mer.cpp):    1.1797 s   sorted: yes
+ *   block_odd_even_sort (barrier):       0.00234102 s   sorted: yes
+ *   block_odd_even_sort (flags):         0.00204355 s   sorted: yes
+ *   std::sort (reference):               0.00166403 s
+ */
+
+#include <iostream>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <omp.h>
+#include "odd_even_sort.hpp"
+using namespace std;
+
+// Baseline from bubble.cpp: odd-even transposition, one parallel for per phase
+void bubble_sort_odd_even(vector<int> &arr)
+{
+    bool isSorted = false;
+    int n = arr.size();
+
+    while (!isSorted)
+    {
+        isSorted = true;
+
+#pragma omp parallel for reduction(&& : isSorted)
+        for (int i = 0; i < n - 1; i += 2)
+        {
+            if (arr[i] > arr[i + 1])
+            {
+                swap(arr[i], arr[i + 1]);
+                isSorted = false;
+            }
+        }
+
+#pragma omp parallel for reduction(&& : isSorted)
+        for (int i = 1; i < n - 1; i += 2)
+        {
+            if (arr[i] > arr[i + 1])
+            {
+                swap(arr[i], arr[i + 1]);
+                isSorted = false;
+            }
+        }
+    }
+}
+
+// Baseline from bub_mer.cpp: always n phases
+void parallelBubbleSort(int *a, int n)
+{
+    for (int i = 0; i < n; i++)
+    {
+        int first = i % 2;
+#pragma omp parallel for shared(a, first)
+        for (int j = first; j < n - 1; j += 2)
+        {
+            if (a[j] > a[j + 1])
+            {
+                swap(a[j], a[j + 1]);
+            }
+        }
+    }
+}
+
+template <class F>
+void run(const char *label, const vector<int> &input, const vector<int> &expected, F sortFn)
+{
+    vector<int> arr = input;
+    double start = omp_get_wtime();
+    sortFn(arr);
+    double end = omp_get_wtime();
+    cout << label << end - start << " s   sorted: " << (arr == expected ? "yes" : "no") << endl;
+}
+
+int main()
+{
+    int n;
+    cout << "Enter the size of the array: ";
+    cin >> n;
+
+    if (n <= 0)
+    {
+        cout << "Invalid array size!" << endl;
+        return 1;
+    }
+
+    mt19937 rng(11);
+    vector<int> arr(n);
+    for (int &x : arr)
+        x = rng() % 1000000;
+
+    vector<int> expected = arr;
+    double start = omp_get_wtime();
+    sort(expected.begin(), expected.end());
+    double t_ref = omp_get_wtime() - start;
+
+    cout << "\nThreads: " << omp_get_max_threads() << endl;
+    run("bubble_sort_odd_even (bubble.cpp):   ", arr, expected, [](vector<int> &a) { bubble_sort_odd_even(a); });
+    run("parallelBubbleSort (bub_mer.cpp):    ", arr, expected, [](vector<int> &a) { parallelBubbleSort(a.data(), a.size()); });
+    run("block_odd_even_sort (barrier):       ", arr, expected, [](vector<int> &a) {
+        hpc::block_odd_even_sort(a.begin(), a.end(), less<>(), hpc::identity_key(), hpc::odd_even_sync::barrier);
+    });
+    run("block_odd_even_sort (flags):         ", arr, expected, [](vector<int> &a) {
+        hpc::block_odd_even_sort(a.begin(), a.end(), less<>(), hpc::identity_key(), hpc::odd_even_sync::flags);
+    });
+    cout << "std::sort (reference):               " << t_ref << " s" << endl;
+
+    return 0;
+}
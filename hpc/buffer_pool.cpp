@@ -0,0 +1,180 @@
+/*
+ * Page Faults and Buffer Reuse in Repeated Benchmarks using buffer_pool.hpp
+ * =========================================================================
+ *
+ * COMPILATION & EXECUTION:
+ *
+ * For Ubuntu:
+ * -----------
+ * g++ -std=c++20 -O2 -fopenmp -o buffer_pool buffer_pool.cpp
+ * ./buffer_pool
+ *
+ * For macOS:
+ * ----------
+ * g++ -std=c++20 -O2 -Xpreprocessor -fopenmp -I"$(brew --prefix libomp)/include" -L"$(brew --prefix libomp)/lib" -lomp -o buffer_pool buffer_pool.cpp
+ * ./buffer_pool
+ *
+ * THEORETICAL CONCEPTS:
+ *
+ * Page Faults:
+ * -----------
+ * - new int[n] only reserves addresses. The first write to each 4 KB page traps into the
+ *   kernel, which zeroes a page and maps it: a few hundred nanoseconds to a microsecond
+ *   per page, before the program has done any work on it
+ * - A large block is handed back to the kernel on delete[] and faulted in again by the
+ *   next new[], so a benchmark that allocates per run pays those faults on every run
+ *
+ * Huge Pages:
+ * ----------
+ * - A 2 MB page replaces 512 4 KB pages: one fault instead of 512, and one TLB entry
+ *   covers 2 MB instead of 4 KB, so streaming loops stop missing the TLB every 4 KB
+ *
+ * First Touch:
+ * -----------
+ * - On a NUMA machine a page is placed on the node of the thread that faults it in.
+ *   Prefaulting with the same static schedule as the compute loops puts each thread's
+ *   slice in its own node's memory; a serial fill puts everything on one node
+ *
+ * Measured Here:
+ * -------------
+ * - Each iteration allocates n ints, fills them in parallel, sums them in parallel and
+ *   frees them. "first" is iteration 1, "steady" the best of the rest, "faults" the minor
+ *   page faults over all iterations (getrusage)
+ *
+ * SAMPLE INPUT/OUTPUT:
+ * ------------------
+ *
+ * Input:
+ *   67108864                     (Number of ints, 256 MB)
+ *   10                           (Iterations)
+ *
+ * Output (single core):
+ *   Threads: 1, 268.44 MB per buffer, 10 iterations
+ *
+ *   allocator                      first ms    steady ms     faults   check
+ *   new int[n]                      213.708      197.115     655378   ok
+ *   std::vector<int>(n)             252.455      231.721     655370   ok
+ *   pool, 4 KB pages                263.967      116.736      65536   ok
+ *   pool, transparent huge pages    404.176      118.150        128   ok
+ *   pool, THP + prefault            168.858       81.379        128   ok
+ *
+ * new[] and std::vector fault in all 65536 pages on every iteration (vector also zeroes
+ * them first); the pools fault only on the first and then reuse the same memory, about
+ * twice as fast per iteration. Huge pages take the faults from 65536 to 128, but faulted
+ * in one at a time from a serial loop a 2 MB page is slow to clear; prefaulting them in
+ * the pool (in parallel on a multi-core machine) makes the first iteration the fastest.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <memory>
+#include <omp.h>
+#include <sys/resource.h>
+#include "buffer_pool.hpp"
+using namespace std;
+
+long minorFaults()
+{
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_minflt;
+}
+
+// Parallel fill and sum: the work every iteration does on its fresh buffer.
+long long fillAndSum(int *nums, long long n)
+{
+#pragma omp parallel for schedule(static)
+    for (long long i = 0; i < n; i++)
+        nums[i] = static_cast<int>(i & 1023);
+    long long sum = 0;
+#pragma omp parallel for schedule(static) reduction(+ : sum)
+    for (long long i = 0; i < n; i++)
+        sum += nums[i];
+    return sum;
+}
+
+// allocate() returns a buffer holder; run() calls it once per iteration.
+template <class Allocate>
+void run(const string &name, long long n, int iterations, long long expected, Allocate &&allocate)
+{
+    double first = 0, steady = 1e30;
+    bool ok = true;
+    const long faults = minorFaults();
+    for (int it = 0; it < iterations; it++)
+    {
+        double start = omp_get_wtime();
+        {
+            auto buffer = allocate();
+            ok &= fillAndSum(buffer.get(), n) == expected;
+        }
+        double t = omp_get_wtime() - start;
+        if (it == 0)
+            first = t;
+        else
+            steady = min(steady, t);
+    }
+    cout << left << setw(31) << name << right << fixed << setprecision(3) << setw(9) << first * 1e3 << setw(13)
+         << steady * 1e3 << setw(11) << minorFaults() - faults << "   " << (ok ? "ok" : "WRONG") << endl;
+}
+
+// Adapts the other allocators to run()'s get().
+struct vectorHolder
+{
+    vector<int> v;
+    int *get() { return v.data(); }
+};
+
+struct pooledHolder
+{
+    hpc::pooled_buffer<int> b;
+    int *get() { return b.data(); }
+};
+
+int main()
+{
+    long long n;
+    int iterations;
+    cout << "Enter the number of ints: ";
+    cin >> n;
+    cout << "Enter the number of iterations: ";
+    cin >> iterations;
+
+    if (n <= 0 || iterations < 2)
+    {
+        cout << "Invalid input!" << endl;
+        return 1;
+    }
+
+    long long expected = 0;
+    for (long long i = 0; i < n; i++)
+        expected += i & 1023;
+
+    cout << "\nThreads: " << omp_get_max_threads() << ", " << fixed << setprecision(2) << n * sizeof(int) / 1e6
+         << " MB per buffer, " << iterations << " iterations\n" << endl;
+    cout << left << setw(31) << "allocator" << right << setw(9) << "first ms" << setw(13) << "steady ms" << setw(11)
+         << "faults" << "   check" << endl;
+
+    const size_t count = static_cast<size_t>(n);
+    run("new int[n]", n, iterations, expected, [&] { return unique_ptr<int[]>(new int[count]); });
+    run("std::vector<int>(n)", n, iterations, expected, [&] { return vectorHolder{vector<int>(count)}; });
+
+    struct config
+    {
+        string name;
+        hpc::buffer_options options;
+    };
+    const config configs[] = {
+        {"pool, 4 KB pages", {.pages = hpc::huge_pages::none, .prefault = false}},
+        {"pool, transparent huge pages", {.pages = hpc::huge_pages::transparent, .prefault = false}},
+        {"pool, THP + prefault", {.pages = hpc::huge_pages::transparent, .prefault = true}},
+    };
+    for (const config &c : configs)
+    {
+        hpc::buffer_pool pool(c.options);
+        run(c.name, n, iterations, expected, [&] { return pooledHolder{pool.acquire<int>(count)}; });
+    }
+    return 0;
+}
@@ -0,0 +1,390 @@
+/*
+ * Aligned, Huge-Page Backed Buffer Pool (header-only) using mmap and OpenMP
+ * =========================================================================
+ *
+ * An array from new[] is 16-byte aligned, backed by 4 KB pages, and not in memory until
+ * first written. The first pass over a large array then pays a page fault per 4 KB and a
+ * TLB miss per page, and whichever loop touches a page first decides which NUMA node it
+ * lives on. This pool maps buffers itself, so it can align them, back them with 2 MB
+ * pages, fault them in up front with the same threads that will use them, and hand the
+ * same memory out again.
+ *
+ * USAGE:
+ *
+ *   #include "buffer_pool.hpp"
+ *
+ *   hpc::pooled_buffer<int> nums = hpc::buffer_pool::global().acquire<int>(length);
+ *   hpc::parallel_fill_uniform(nums.begin(), nums.end(), 1, 1000, seed);
+ *   int_stats s = hpc::fused_stats(nums.data(), nums.size());
+ *   // going out of scope returns the memory to the pool; the next acquire reuses it
+ *
+ *   hpc::buffer_pool pool({.alignment = 4096, .pages = hpc::huge_pages::hugetlb});
+ *   void *raw = pool.allocate(bytes);   // untyped, for cudaMalloc-style interfaces
+ *   pool.deallocate(raw);
+ *   pool.stats().print(std::cout);
+ *
+ * COMPILATION:
+ *   g++ -std=c++20 -O2 -fopenmp -o program program.cpp
+ *
+ * PAGES:
+ * -----
+ * - huge_pages::none: ordinary 4 KB pages.
+ * - huge_pages::transparent (default): buffers of 2 MB and more are mapped 2 MB aligned
+ *   and marked MADV_HUGEPAGE, so the kernel backs them with 2 MB pages whenever it has
+ *   them. Works with transparent_hugepage set to "always" or "madvise" (the usual default);
+ *   with "never" the buffer silently stays on 4 KB pages.
+ * - huge_pages::hugetlb: MAP_HUGETLB, from the pages reserved in /proc/sys/vm/nr_hugepages.
+ *   Guaranteed 2 MB pages, but only as many as the administrator reserved; when none are
+ *   left the pool falls back to transparent and counts it in stats().hugetlb_fallbacks.
+ * A 2 MB page covers 512 4 KB pages: one fault and one TLB entry instead of 512.
+ *
+ * PREFAULTING:
+ * -----------
+ * - With prefault (default), a new mapping is touched once per page by an OpenMP parallel
+ *   for with a static schedule before it is handed out. That is the split every parallel
+ *   loop in this directory uses (a contiguous slice per thread), so on a NUMA machine each
+ *   slice is placed on the node of the thread that will work on it (first-touch policy).
+ *   Pinning (OMP_PROC_BIND=close, OMP_PLACES=cores) keeps threads where their pages are.
+ * - Recycled buffers are already resident and are not touched again.
+ *
+ * RECYCLING:
+ * ---------
+ * - Freed buffers are kept, best fit first: a request is served by the smallest cached
+ *   buffer that is at least as large and at most twice as large. Contents are not cleared:
+ *   a fresh buffer is zero, a recycled one holds whatever its last user left.
+ * - At most max_cached bytes are kept; trim() unmaps everything cached.
+ * - All members are thread-safe.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <new>
+#include <ostream>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <omp.h>
+
+namespace hpc
+{
+
+enum class huge_pages
+{
+    none,
+    transparent,
+    hugetlb
+};
+
+struct buffer_options
+{
+    std::size_t alignment = 64;                          // power of two; page alignment or more is free
+    huge_pages pages = huge_pages::transparent;          // for buffers of huge_page_bytes and more
+    bool prefault = true;                                // parallel first touch of new mappings
+    std::size_t max_cached = std::size_t(4) << 30;      // bytes kept for reuse
+};
+
+struct buffer_pool_stats
+{
+    std::size_t maps = 0;              // buffers mapped from the kernel
+    std::size_t reuses = 0;            // buffers served from the cache
+    std::size_t huge_maps = 0;         // mappings with MADV_HUGEPAGE or MAP_HUGETLB
+    std::size_t hugetlb_fallbacks = 0; // MAP_HUGETLB failed, transparent used instead
+    std::size_t bytes_in_use = 0;
+    std::size_t bytes_cached = 0;
+    double prefault_seconds = 0;
+
+    void print(std::ostream &os) const
+    {
+        os << "Mapped: " << maps << " (huge pages: " << huge_maps << ", hugetlb fallbacks: " << hugetlb_fallbacks
+           << ")\nReused: " << reuses << "\nIn use: " << bytes_in_use / 1e6 << " MB, cached: " << bytes_cached / 1e6
+           << " MB\nPrefault: " << prefault_seconds << " seconds\n";
+    }
+};
+
+namespace detail
+{
+
+// x86-64 and AArch64 (4 KB granule) PMD size.
+constexpr std::size_t huge_page_bytes = std::size_t(2) << 20;
+
+// Below this a parallel prefault costs more than it saves.
+constexpr std::size_t prefault_grain = std::size_t(16) << 20;
+
+inline std::size_t system_page_bytes()
+{
+    static const std::size_t bytes = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    return bytes;
+}
+
+constexpr std::size_t round_up(std::size_t n, std::size_t unit)
+{
+    return (n + unit - 1) / unit * unit;
+}
+
+struct pool_block
+{
+    void *base = nullptr;
+    std::size_t bytes = 0;
+    bool huge = false;
+};
+
+// One write per page, each thread its static slice.
+inline void prefault(void *base, std::size_t bytes, std::size_t page)
+{
+    char *p = static_cast<char *>(base);
+    const long long pages = static_cast<long long>(bytes / page);
+    const int threads = bytes >= prefault_grain ? omp_get_max_threads() : 1;
+#pragma omp parallel for num_threads(threads) if (threads > 1) schedule(static)
+    for (long long i = 0; i < pages; i++)
+        p[i * page] = 0;
+}
+
+} // namespace detail
+
+class buffer_pool
+{
+public:
+    explicit buffer_pool(buffer_options options = {}) : options_(options)
+    {
+        options_.alignment = std::max<std::size_t>(options_.alignment, 64);
+    }
+
+    buffer_pool(const buffer_pool &) = delete;
+    buffer_pool &operator=(const buffer_pool &) = delete;
+
+    // Cached buffers are unmapped; buffers still handed out stay mapped.
+    ~buffer_pool() { trim(); }
+
+    // Process-wide pool with the default options.
+    static buffer_pool &global()
+    {
+        static buffer_pool pool;
+        return pool;
+    }
+
+    const buffer_options &options() const noexcept { return options_; }
+
+    // At least `bytes` bytes aligned to options().alignment. Throws std::bad_alloc.
+    void *allocate(std::size_t bytes)
+    {
+        const bool huge = options_.pages != huge_pages::none && bytes >= detail::huge_page_bytes;
+        const std::size_t granule = huge ? detail::huge_page_bytes : detail::system_page_bytes();
+        const std::size_t size = detail::round_up(std::max<std::size_t>(bytes, 1), granule);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = cached_.lower_bound(size);
+            if (it != cached_.end() && it->first <= 2 * size && it->second.base != nullptr &&
+                reinterpret_cast<std::uintptr_t>(it->second.base) % options_.alignment == 0)
+            {
+                detail::pool_block block = it->second;
+                cached_.erase(it);
+                stats_.bytes_cached -= block.bytes;
+                stats_.bytes_in_use += block.bytes;
+                stats_.reuses++;
+                in_use_.emplace(block.base, block);
+                return block.base;
+            }
+        }
+
+        detail::pool_block block = map(size, huge);
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.maps++;
+        stats_.huge_maps += block.huge;
+        stats_.bytes_in_use += block.bytes;
+        in_use_.emplace(block.base, block);
+        return block.base;
+    }
+
+    // Returns a buffer from allocate() to the cache (or unmaps it if the cache is full).
+    // nullptr is ignored.
+    void deallocate(void *p)
+    {
+        if (!p)
+            return;
+        detail::pool_block block;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = in_use_.find(p);
+            if (it == in_use_.end())
+                return;
+            block = it->second;
+            in_use_.erase(it);
+            stats_.bytes_in_use -= block.bytes;
+            if (stats_.bytes_cached + block.bytes <= options_.max_cached)
+            {
+                cached_.emplace(block.bytes, block);
+                stats_.bytes_cached += block.bytes;
+                return;
+            }
+        }
+        ::munmap(block.base, block.bytes);
+    }
+
+    // Typed, returned to the pool when it goes out of scope.
+    template <class T>
+    class buffer;
+
+    template <class T>
+    buffer<T> acquire(std::size_t count);
+
+    // Unmaps every cached buffer.
+    void trim()
+    {
+        std::multimap<std::size_t, detail::pool_block> cached;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            cached.swap(cached_);
+            stats_.bytes_cached = 0;
+        }
+        for (auto &entry : cached)
+            ::munmap(entry.second.base, entry.second.bytes);
+    }
+
+    buffer_pool_stats stats() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stats_;
+    }
+
+private:
+    // `size` bytes (a multiple of the granule) at options_.alignment, or at 2 MB for huge
+    // mappings: over-map by the alignment and unmap the slack on both sides.
+    detail::pool_block map(std::size_t size, bool huge)
+    {
+        const std::size_t page = detail::system_page_bytes();
+        detail::pool_block block{nullptr, size, false};
+
+#ifdef MAP_HUGETLB
+        if (huge && options_.pages == huge_pages::hugetlb)
+        {
+            void *p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (p != MAP_FAILED && reinterpret_cast<std::uintptr_t>(p) % options_.alignment == 0)
+            {
+                block = {p, size, true};
+                finish(block, detail::huge_page_bytes);
+                return block;
+            }
+            if (p != MAP_FAILED)
+                ::munmap(p, size);
+            std::lock_guard<std::mutex> lock(mutex_);
+            stats_.hugetlb_fallbacks++;
+        }
+#endif
+
+        const std::size_t align = std::max(options_.alignment, huge ? detail::huge_page_bytes : page);
+        const std::size_t slack = align > page ? align : 0;
+        void *raw = ::mmap(nullptr, size + slack, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw == MAP_FAILED)
+            throw std::bad_alloc();
+        char *start = static_cast<char *>(raw);
+        char *aligned = reinterpret_cast<char *>(detail::round_up(reinterpret_cast<std::uintptr_t>(start), align));
+        if (aligned > start)
+            ::munmap(start, aligned - start);
+        if (start + size + slack > aligned + size)
+            ::munmap(aligned + size, start + size + slack - (aligned + size));
+        block.base = aligned;
+
+#ifdef MADV_HUGEPAGE
+        if (huge)
+            block.huge = ::madvise(aligned, size, MADV_HUGEPAGE) == 0;
+#endif
+        finish(block, block.huge ? detail::huge_page_bytes : page);
+        return block;
+    }
+
+    void finish(const detail::pool_block &block, std::size_t page)
+    {
+        if (!options_.prefault)
+            return;
+        const double start = omp_get_wtime();
+        detail::prefault(block.base, block.bytes, page);
+        const double elapsed = omp_get_wtime() - start;
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.prefault_seconds += elapsed;
+    }
+
+    buffer_options options_;
+    mutable std::mutex mutex_;
+    std::multimap<std::size_t, detail::pool_block> cached_; // by size, for best fit
+    std::unordered_map<void *, detail::pool_block> in_use_;
+    buffer_pool_stats stats_;
+};
+
+// count elements of T from a pool, returned to it on destruction. Move-only. T must be a
+// trivial type: no constructors or destructors run, and the contents start as whatever
+// the memory holds (zero when freshly mapped).
+template <class T>
+class buffer_pool::buffer
+{
+    static_assert(std::is_trivial_v<T>, "pooled buffers hold raw memory: T must be trivial");
+
+public:
+    using value_type = T;
+
+    buffer() = default;
+    buffer(buffer_pool &pool, std::size_t count)
+        : pool_(&pool), data_(static_cast<T *>(pool.allocate(count * sizeof(T)))), size_(count)
+    {
+    }
+    buffer(buffer &&other) noexcept
+        : pool_(std::exchange(other.pool_, nullptr)), data_(std::exchange(other.data_, nullptr)),
+          size_(std::exchange(other.size_, 0))
+    {
+    }
+    buffer &operator=(buffer &&other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            pool_ = std::exchange(other.pool_, nullptr);
+            data_ = std::exchange(other.data_, nullptr);
+            size_ = std::exchange(other.size_, 0);
+        }
+        return *this;
+    }
+    ~buffer() { reset(); }
+
+    // Returns the memory to the pool now.
+    void reset()
+    {
+        if (pool_)
+            pool_->deallocate(data_);
+        pool_ = nullptr;
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    std::size_t size() const noexcept { return size_; }
+    T *data() noexcept { return data_; }
+    const T *data() const noexcept { return data_; }
+    T &operator[](std::size_t i) { return data_[i]; }
+    const T &operator[](std::size_t i) const { return data_[i]; }
+    T *begin() noexcept { return data_; }
+    T *end() noexcept { return data_ + size_; }
+    const T *begin() const noexcept { return data_; }
+    const T *end() const noexcept { return data_ + size_; }
+
+private:
+    buffer_pool *pool_ = nullptr;
+    T *data_ = nullptr;
+    std::size_t size_ = 0;
+};
+
+template <class T>
+buffer_pool::buffer<T> buffer_pool::acquire(std::size_t count)
+{
+    return buffer<T>(*this, count);
+}
+
+template <class T>
+using pooled_buffer = buffer_pool::buffer<T>;
+
+} // namespace hpc
@@ -0,0 +1,189 @@
+/*
+ * Parsing the dl/ Data Sets vs Mapping their Columnar Cache using columnar.hpp
+ * ============================================================================
+ *
+ * COMPILATION & EXECUTION:
+ *
+ * For Ubuntu:
+ * -----------
+ * g++ -std=c++20 -O2 -fopenmp -o columnar columnar.cpp
+ * ./columnar
+ *
+ * For macOS:
+ * ----------
+ * g++ -std=c++20 -O2 -Xpreprocessor -fopenmp -I"$(brew --prefix libomp)/include" -L"$(brew --prefix libomp)/lib" -lomp -o columnar columnar.cpp
+ * ./columnar
+ *
+ * Copies the data sets of the dl/ directory to a temporary directory, opens each with
+ * cached_csv twice (the first open converts, the second maps) and sums one column. Then
+ * does the same for Google_Stock_Price_Train.csv with its rows repeated to production size.
+ *
+ * THEORETICAL CONCEPTS:
+ *
+ * Parse Once:
+ * ----------
+ * - Text has to be parsed on every load: a few hundred MB/s at best. A file of raw column
+ *   arrays is already in the layout the code wants, so loading it is mapping it: the time
+ *   no longer grows with the file, and the pages come in as the columns are first read
+ *
+ * Projection:
+ * ----------
+ * - Each column is one contiguous blob, so a job that needs 1 of 7 columns touches 1/7 of
+ *   the file. In a CSV every row holds every column and the whole file has to be read
+ *
+ * SAMPLE INPUT/OUTPUT:
+ * ------------------
+ *
+ * Input:
+ *   ../dl                        (Directory with the data sets)
+ *   2000                         (Times to repeat the stock rows)
+ *
+ * Output (single core):
+ *   Threads: 1
+ *
+ *   data set (summed column)           rows cols   CSV MB  .col MB   parse ms convert ms  open ms   sum ms
+ *   HousingData (MEDV)                  506   14     0.04     0.06      0.757      1.022    0.040    0.004
+ *   1_boston_housing (MEDV)             506   14     0.04     0.06      0.635      0.726    0.027    0.002
+ *   Google_Stock_Price (Close)         1384    7     0.10     0.08      1.043      1.382    0.034    0.005
+ *   letter-recognition (c1)           20000   17     0.71     2.79     11.266     15.347    0.070    0.070
+ *   Stock x 2000 (Close)            2768000    7   209.09   157.43   1177.013   1360.287    0.158    6.885
+ *
+ *   Stock x 2000: 2013-01-02 to 2018-06-29, Close in [349.16, 1175.84], from the header alone
+ *
+ * Converting costs one parse plus a sequential write, and is paid once. After that the
+ * 209 MB stock file opens in 0.16 ms instead of 1.2 s of parsing, and the sum reads
+ * only the 22 MB Close column at 3 GB/s. The cache file was just written, so its pages were
+ * still in memory; from a cold disk the sum instead waits on reading that one column,
+ * never the other six. letter-recognition's cache is four times its text: its 0-15
+ * values take two bytes as text and eight as int64, the price of arrays usable in place.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <filesystem>
+#include <vector>
+#include <string>
+#include <omp.h>
+#include "columnar.hpp"
+using namespace std;
+
+// Sum of the non-null values of a numeric column: touches every page of the column.
+double columnSum(const hpc::columnar_column &c)
+{
+    double sum = 0;
+    const long long n = (long long)c.rows;
+#pragma omp parallel for reduction(+ : sum)
+    for (long long r = 0; r < n; r++)
+        if (!c.is_null(r))
+            sum += c.type == hpc::column_type::float64 ? c.doubles[r] : double(c.ints[r]);
+    return sum;
+}
+
+struct Timings
+{
+    double parse, convert, open, scan;
+    size_t csvBytes, cacheBytes, rows, columns;
+};
+
+// Times read_csv, the first cached_csv (converts), the second (maps) and a one-column sum.
+Timings measure(const filesystem::path &csv, const hpc::csv_options &opts, const string &column)
+{
+    Timings t;
+    filesystem::remove(hpc::columnar_cache_path(csv));
+    double start = omp_get_wtime();
+    const hpc::csv_table table = hpc::read_csv(csv, opts);
+    t.parse = omp_get_wtime() - start;
+
+    start = omp_get_wtime();
+    {
+        hpc::columnar_file converted = hpc::cached_csv(csv, opts);
+    }
+    t.convert = omp_get_wtime() - start;
+
+    start = omp_get_wtime();
+    hpc::columnar_file file = hpc::cached_csv(csv, opts, {column});
+    t.open = omp_get_wtime() - start;
+    start = omp_get_wtime();
+    volatile double sink = columnSum(file.column(column));
+    (void)sink;
+    t.scan = omp_get_wtime() - start;
+
+    t.csvBytes = filesystem::file_size(csv);
+    t.cacheBytes = file.bytes();
+    t.rows = file.rows();
+    t.columns = table.columns.size();
+    return t;
+}
+
+void printRow(const string &name, const Timings &t)
+{
+    cout << left << setw(30) << name << right << setw(9) << t.rows << setw(5) << t.columns << setprecision(2)
+         << setw(9) << t.csvBytes / 1e6 << setw(9) << t.cacheBytes / 1e6 << setprecision(3) << setw(11)
+         << t.parse * 1e3 << setw(11) << t.convert * 1e3 << setw(9) << t.open * 1e3 << setw(9) << t.scan * 1e3
+         << endl;
+}
+
+int main()
+{
+    string dir;
+    size_t repeat;
+    cout << "Enter the directory with the data sets: ";
+    cin >> dir;
+    cout << "Enter the times to repeat the stock rows: ";
+    cin >> repeat;
+
+    const vector<string> files = {"HousingData.csv", "1_boston_housing.csv", "Google_Stock_Price_Train.csv",
+                                  "letter-recognition.data"};
+    bool found = true;
+    for (const string &f : files)
+        found = found && filesystem::is_regular_file(filesystem::path(dir) / f);
+    if (!cin || repeat < 1 || !found)
+    {
+        cout << "Invalid input!" << endl;
+        return 1;
+    }
+
+    const filesystem::path work = filesystem::temp_directory_path() / "columnar_demo";
+    filesystem::create_directories(work);
+    for (const string &f : files)
+        filesystem::copy_file(filesystem::path(dir) / f, work / f, filesystem::copy_options::overwrite_existing);
+
+    cout << "\nThreads: " << omp_get_max_threads() << "\n" << endl;
+    cout << left << setw(30) << "data set (summed column)" << right << setw(9) << "rows" << setw(5) << "cols"
+         << setw(9) << "CSV MB" << setw(9) << ".col MB" << setw(11) << "parse ms" << setw(11) << "convert ms"
+         << setw(9) << "open ms" << setw(9) << "sum ms" << endl;
+    cout << fixed;
+
+    hpc::csv_options withHeader, noHeader;
+    noHeader.header = false;
+    printRow("HousingData (MEDV)", measure(work / files[0], withHeader, "MEDV"));
+    printRow("1_boston_housing (MEDV)", measure(work / files[1], withHeader, "MEDV"));
+    printRow("Google_Stock_Price (Close)", measure(work / files[2], withHeader, "Close"));
+    printRow("letter-recognition (c1)", measure(work / files[3], noHeader, "c1"));
+
+    // The stock rows repeat times, header once.
+    const filesystem::path big = work / "Google_Stock_Price_Repeated.csv";
+    {
+        ifstream in(work / files[2], ios::binary);
+        string body((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+        const size_t split = body.find('\n') + 1;
+        if (body.back() != '\n')
+            body += '\n';
+        ofstream out(big, ios::binary);
+        out << body.substr(0, split);
+        for (size_t i = 0; i < repeat; i++)
+            out.write(body.data() + split, body.size() - split);
+    }
+    printRow("Stock x " + to_string(repeat) + " (Close)", measure(big, withHeader, "Close"));
+
+    // min / max come from the column entries: no value is read.
+    const hpc::columnar_file all = hpc::cached_csv(big);
+    const hpc::columnar_column &date = all.column("Date");
+    cout << "\nStock x " << repeat << ": " << hpc::format_date(date.min_int) << " to "
+         << hpc::format_date(date.max_int) << ", Close in [" << setprecision(2) << all.column("Close").min << ", "
+         << all.column("Close").max << "], from the header alone" << endl;
+
+    filesystem::remove_all(work);
+    return 0;
+}
@@ -0,0 +1,478 @@
+/*
+ * Binary Columnar Cache (header-only): Parse a CSV Once, mmap the Columns After
+ * =============================================================================
+ *
+ * Stores a parsed csv_table (csv.hpp) as one file of raw column arrays behind a small
+ * header. Opening the file maps it and checks the header; the column arrays are used in
+ * place, without copying or parsing, so a data set opens in the same time whatever its
+ * size, and a job that reads two columns only ever faults in the pages of those two.
+ *
+ * USAGE:
+ *
+ *   #include "columnar.hpp"
+ *
+ *   // First run parses the CSV and writes HousingData.csv.col; later runs only map it.
+ *   hpc::columnar_file f = hpc::cached_csv("../dl/HousingData.csv");
+ *   const hpc::columnar_column &medv = f.column("MEDV");
+ *   medv.doubles[i];  medv.is_null(i);  medv.min;  medv.max;   // std::span into the mapping
+ *
+ *   // Projection: only these columns, in this order.
+ *   hpc::columnar_file g = hpc::cached_csv("../dl/Google_Stock_Price_Train.csv", {}, {"Date", "Close"});
+ *
+ *   hpc::csv_options opts;
+ *   opts.header = false;
+ *   hpc::columnar_file l = hpc::cached_csv("../dl/letter-recognition.data", opts);
+ *
+ *   hpc::write_columnar(table, "table.col");                       // explicit conversion
+ *   hpc::columnar_file t("table.col", {"c0", "c5"});
+ *
+ * COMPILATION:
+ *   g++ -std=c++20 -O2 -fopenmp -o program program.cpp
+ *
+ * FILE LAYOUT (little-endian):
+ * ---------------------------
+ *   columnar_header   magic "HPCCOL1", version, column count, row count, file size, and a
+ *                     hash of the csv_options the table was parsed with
+ *   columnar_entry    one per column: type, name, null count, min / max, and the offset and
+ *                     size of its three blobs: values, string offsets, validity bitmap
+ *   names             the column names, back to back
+ *   blobs             each starting on a 64-byte boundary
+ *
+ * - Values: int64 / date as int64, float64 as double, string as the concatenated chars.
+ *   String columns add rows + 1 uint64 offsets into the chars. The validity bitmap is the
+ *   csv_column one: bit r % 64 of word r / 64 is set when row r has a value.
+ * - min / max cover the non-null values: int64 and date in min_int / max_int (and, rounded,
+ *   in min / max), float64 in min / max, string byte lengths in min_int / max_int. They
+ *   let a job skip a file (or a column) that cannot hold the values it looks for.
+ * - A mapping starts on a page boundary, so every blob is 64-byte aligned in memory and
+ *   can be read with aligned SIMD loads.
+ *
+ * CONVERT ONCE:
+ * ------------
+ * - cached_csv uses <file>.col next to the CSV when it exists, is newer than the CSV,
+ *   opens cleanly and was parsed with the same options (header, delimiter, quote,
+ *   na_values, types, infer_rows); otherwise it parses the CSV and writes the cache. The
+ *   file is written to a temporary name and renamed into place, so a crash never leaves
+ *   half a cache.
+ *
+ * ERROR HANDLING:
+ * --------------
+ * - A file that is not a columnar file, is of another version or is cut short throws
+ *   std::runtime_error; an unknown column name throws std::invalid_argument.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+#include <omp.h>
+#include "csv.hpp"
+
+namespace hpc
+{
+
+// One column of a columnar_file; the spans point into the mapping.
+struct columnar_column
+{
+    std::string_view name;
+    column_type type = column_type::float64;
+    std::size_t rows = 0;
+    std::size_t nulls = 0;
+    bool has_range = false;             // false when every value is null
+    double min = 0, max = 0;            // float64, int64, date
+    std::int64_t min_int = 0, max_int = 0; // int64, date; string: byte lengths
+    std::span<const double> doubles;
+    std::span<const std::int64_t> ints;
+    std::span<const std::uint64_t> offsets;
+    std::string_view chars;
+    std::span<const std::uint64_t> valid;
+
+    bool is_null(std::size_t row) const { return !(valid[row >> 6] >> (row & 63) & 1); }
+    std::string_view string_at(std::size_t row) const
+    {
+        return chars.substr(offsets[row], offsets[row + 1] - offsets[row]);
+    }
+};
+
+namespace detail
+{
+
+constexpr char columnar_magic[8] = {'H', 'P', 'C', 'C', 'O', 'L', '1', '\0'};
+constexpr std::uint32_t columnar_version = 2;
+constexpr std::size_t columnar_align = 64;
+
+struct columnar_header
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t columns;
+    std::uint64_t rows;
+    std::uint64_t bytes;   // whole file, to catch truncation
+    std::uint64_t options; // columnar_options_hash of the csv_options used to parse
+};
+
+struct columnar_blob
+{
+    std::uint64_t offset; // from the start of the file
+    std::uint64_t bytes;
+};
+
+struct columnar_entry
+{
+    std::uint32_t type;
+    std::uint32_t name_bytes;
+    std::uint64_t name_offset;
+    std::uint64_t nulls;
+    std::uint64_t has_range;
+    std::int64_t min_int, max_int;
+    double min, max;
+    columnar_blob values, offsets, valid;
+};
+
+static_assert(sizeof(columnar_header) == 40 && sizeof(columnar_entry) == 112,
+              "columnar file structs must have no padding");
+
+// FNV-1a over the csv_options that change what gets parsed (not level: every SIMD level
+// gives the same table).
+inline std::uint64_t columnar_options_hash(const csv_options &opts)
+{
+    std::uint64_t h = 14695981039346656037ull;
+    auto bytes = [&](const void *p, std::size_t n) {
+        for (std::size_t i = 0; i < n; i++)
+            h = (h ^ static_cast<const unsigned char *>(p)[i]) * 1099511628211ull;
+    };
+    auto text = [&](const std::string &s) {
+        const std::uint64_t n = s.size();
+        bytes(&n, sizeof n);
+        bytes(s.data(), s.size());
+    };
+    const std::uint64_t fields[] = {static_cast<unsigned char>(opts.delimiter), static_cast<unsigned char>(opts.quote),
+                                    opts.header, opts.infer_rows, opts.na_values.size(), opts.types.size()};
+    bytes(fields, sizeof fields);
+    for (const std::string &na : opts.na_values)
+        text(na);
+    for (const auto &[name, type] : opts.types)
+    {
+        text(name);
+        const std::uint64_t t = static_cast<std::uint64_t>(type);
+        bytes(&t, sizeof t);
+    }
+    return h;
+}
+
+inline std::uint64_t columnar_round_up(std::uint64_t n)
+{
+    return (n + columnar_align - 1) / columnar_align * columnar_align;
+}
+
+// min / max of the non-null values of a column, in parallel.
+inline void columnar_range(const csv_column &c, std::size_t rows, columnar_entry &e)
+{
+    e.has_range = rows > c.nulls;
+    if (!e.has_range)
+        return;
+    const long long n = static_cast<long long>(rows);
+    auto present = [&](long long r) { return c.valid[r >> 6] >> (r & 63) & 1; };
+    if (c.type == column_type::float64)
+    {
+        double lo = std::numeric_limits<double>::infinity(), hi = -lo;
+#pragma omp parallel for schedule(static) reduction(min : lo) reduction(max : hi) if (n > (1 << 16))
+        for (long long r = 0; r < n; r++)
+            if (present(r))
+            {
+                lo = std::min(lo, c.doubles[r]);
+                hi = std::max(hi, c.doubles[r]);
+            }
+        e.min = lo;
+        e.max = hi;
+        return;
+    }
+    std::int64_t lo = std::numeric_limits<std::int64_t>::max(), hi = std::numeric_limits<std::int64_t>::min();
+    const bool strings = c.type == column_type::string;
+#pragma omp parallel for schedule(static) reduction(min : lo) reduction(max : hi) if (n > (1 << 16))
+    for (long long r = 0; r < n; r++)
+        if (present(r))
+        {
+            const std::int64_t v = strings ? static_cast<std::int64_t>(c.offsets[r + 1] - c.offsets[r]) : c.ints[r];
+            lo = std::min(lo, v);
+            hi = std::max(hi, v);
+        }
+    e.min_int = lo;
+    e.max_int = hi;
+    e.min = static_cast<double>(lo);
+    e.max = static_cast<double>(hi);
+}
+
+inline void columnar_pad(std::ofstream &out, std::uint64_t &at, std::uint64_t to)
+{
+    static const char zeros[columnar_align] = {};
+    out.write(zeros, static_cast<std::streamsize>(to - at));
+    at = to;
+}
+
+} // namespace detail
+
+// Writes table to path in the columnar format (to path.tmp first, then renamed). opts are
+// the options table was parsed with; cached_csv converts again when they change.
+inline void write_columnar(const csv_table &table, const std::filesystem::path &path, const csv_options &opts = {})
+{
+    if constexpr (std::endian::native != std::endian::little)
+        throw std::runtime_error("write_columnar: only little-endian hosts are supported");
+
+    const std::size_t columns = table.columns.size(), rows = table.rows;
+    std::vector<detail::columnar_entry> entries(columns);
+    std::uint64_t at = sizeof(detail::columnar_header) + columns * sizeof(detail::columnar_entry);
+    for (std::size_t c = 0; c < columns; c++)
+    {
+        entries[c].name_offset = at;
+        entries[c].name_bytes = static_cast<std::uint32_t>(table.columns[c].name.size());
+        at += entries[c].name_bytes;
+    }
+    auto place = [&](std::uint64_t bytes) {
+        at = detail::columnar_round_up(at);
+        const detail::columnar_blob blob{at, bytes};
+        at += bytes;
+        return blob;
+    };
+    for (std::size_t c = 0; c < columns; c++)
+    {
+        const csv_column &col = table.columns[c];
+        detail::columnar_entry &e = entries[c];
+        e.type = static_cast<std::uint32_t>(col.type);
+        e.nulls = col.nulls;
+        detail::columnar_range(col, rows, e);
+        if (col.type == column_type::string)
+        {
+            e.values = place(col.chars.size());
+            e.offsets = place((rows + 1) * sizeof(std::uint64_t));
+        }
+        else
+        {
+            e.values = place(rows * sizeof(std::int64_t)); // double and int64 alike
+            e.offsets = {0, 0};
+        }
+        e.valid = place((rows + 63) / 64 * sizeof(std::uint64_t));
+    }
+    const std::uint64_t bytes = at;
+
+    detail::columnar_header header{};
+    std::memcpy(header.magic, detail::columnar_magic, sizeof header.magic);
+    header.version = detail::columnar_version;
+    header.columns = static_cast<std::uint32_t>(columns);
+    header.rows = rows;
+    header.bytes = bytes;
+    header.options = detail::columnar_options_hash(opts);
+
+    std::filesystem::path temp = path;
+    temp += ".tmp";
+    {
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        if (!out)
+            throw std::runtime_error("write_columnar: cannot create " + temp.string());
+        out.write(reinterpret_cast<const char *>(&header), sizeof header);
+        out.write(reinterpret_cast<const char *>(entries.data()),
+                  static_cast<std::streamsize>(columns * sizeof(detail::columnar_entry)));
+        for (const csv_column &col : table.columns)
+            out.write(col.name.data(), static_cast<std::streamsize>(col.name.size()));
+        at = entries.empty() ? sizeof header : entries.back().name_offset + entries.back().name_bytes;
+        auto blob = [&](const detail::columnar_blob &b, const void *data) {
+            detail::columnar_pad(out, at, b.offset);
+            out.write(static_cast<const char *>(data), static_cast<std::streamsize>(b.bytes));
+            at += b.bytes;
+        };
+        for (std::size_t c = 0; c < columns; c++)
+        {
+            const csv_column &col = table.columns[c];
+            if (col.type == column_type::string)
+            {
+                blob(entries[c].values, col.chars.data());
+                blob(entries[c].offsets, col.offsets.data());
+            }
+            else
+                blob(entries[c].values, col.type == column_type::float64
+                                            ? static_cast<const void *>(col.doubles.data())
+                                            : static_cast<const void *>(col.ints.data()));
+            blob(entries[c].valid, col.valid.data());
+        }
+        if (!out.flush())
+            throw std::runtime_error("write_columnar: cannot write " + temp.string());
+    }
+    std::filesystem::rename(temp, path);
+}
+
+// A columnar file mapped read-only; columns() are views into the mapping.
+class columnar_file
+{
+public:
+    // Maps path and keeps the named columns in that order, or all of them if none are
+    // named. Only the kept columns are prefetched.
+    explicit columnar_file(const std::filesystem::path &path, const std::vector<std::string> &projection = {})
+        : file_(path)
+    {
+        if constexpr (std::endian::native != std::endian::little)
+            throw std::runtime_error("columnar_file: only little-endian hosts are supported");
+        const std::string name = path.string();
+        const char *base = file_.data();
+        detail::columnar_header header;
+        if (file_.size() < sizeof header)
+            throw std::runtime_error("columnar_file: " + name + " is too short");
+        std::memcpy(&header, base, sizeof header);
+        if (std::memcmp(header.magic, detail::columnar_magic, sizeof header.magic) != 0)
+            throw std::runtime_error("columnar_file: " + name + " is not a columnar file");
+        if (header.version != detail::columnar_version)
+            throw std::runtime_error("columnar_file: " + name + " has version " + std::to_string(header.version));
+        if (header.bytes != file_.size() ||
+            sizeof header + std::uint64_t(header.columns) * sizeof(detail::columnar_entry) > file_.size())
+            throw std::runtime_error("columnar_file: " + name + " is truncated");
+        // Every row takes 8 bytes of values or string offsets per column, so no real file has
+        // more rows than bytes; the check also keeps the blob sizes below from wrapping.
+        if (header.rows > file_.size())
+            throw std::runtime_error("columnar_file: " + name + " claims " + std::to_string(header.rows) + " rows");
+        rows_ = header.rows;
+        options_ = header.options;
+
+        auto inside = [&](const detail::columnar_blob &b) {
+            return b.offset <= file_.size() && b.bytes <= file_.size() - b.offset;
+        };
+        std::vector<columnar_column> all(header.columns);
+        for (std::uint32_t c = 0; c < header.columns; c++)
+        {
+            detail::columnar_entry e;
+            std::memcpy(&e, base + sizeof header + c * sizeof e, sizeof e);
+            const std::uint64_t words = (rows_ + 63) / 64;
+            const bool strings = e.type == static_cast<std::uint32_t>(column_type::string);
+            if (e.type > static_cast<std::uint32_t>(column_type::string) || !inside({e.name_offset, e.name_bytes}) ||
+                !inside(e.values) || !inside(e.offsets) || !inside(e.valid) ||
+                e.valid.bytes != words * sizeof(std::uint64_t) ||
+                (strings ? e.offsets.bytes != (rows_ + 1) * sizeof(std::uint64_t)
+                         : e.values.bytes != rows_ * sizeof(std::int64_t)))
+                throw std::runtime_error("columnar_file: " + name + " has a malformed column " + std::to_string(c));
+
+            columnar_column &col = all[c];
+            col.name = std::string_view(base + e.name_offset, e.name_bytes);
+            col.type = static_cast<column_type>(e.type);
+            col.rows = rows_;
+            col.nulls = e.nulls;
+            col.has_range = e.has_range != 0;
+            col.min = e.min;
+            col.max = e.max;
+            col.min_int = e.min_int;
+            col.max_int = e.max_int;
+            col.valid = {reinterpret_cast<const std::uint64_t *>(base + e.valid.offset), words};
+            if (strings)
+            {
+                col.chars = std::string_view(base + e.values.offset, e.values.bytes);
+                col.offsets = {reinterpret_cast<const std::uint64_t *>(base + e.offsets.offset), rows_ + 1};
+            }
+            else if (col.type == column_type::float64)
+                col.doubles = {reinterpret_cast<const double *>(base + e.values.offset), rows_};
+            else
+                col.ints = {reinterpret_cast<const std::int64_t *>(base + e.values.offset), rows_};
+        }
+
+        if (projection.empty())
+            columns_ = std::move(all);
+        else
+            for (const std::string &want : projection)
+            {
+                const auto it = std::find_if(all.begin(), all.end(),
+                                             [&](const columnar_column &c) { return c.name == want; });
+                if (it == all.end())
+                    throw std::invalid_argument("columnar_file: " + name + " has no column " + want);
+                columns_.push_back(*it);
+            }
+        for (const columnar_column &c : columns_)
+        {
+            prefetch(c.valid.data(), c.valid.size_bytes());
+            prefetch(c.doubles.data(), c.doubles.size_bytes());
+            prefetch(c.ints.data(), c.ints.size_bytes());
+            prefetch(c.offsets.data(), c.offsets.size_bytes());
+            prefetch(c.chars.data(), c.chars.size());
+        }
+    }
+
+    std::size_t rows() const { return rows_; }
+    const std::vector<columnar_column> &columns() const { return columns_; }
+    std::size_t bytes() const { return file_.size(); }
+    std::uint64_t options_hash() const { return options_; }
+
+    const columnar_column &column(std::string_view name) const
+    {
+        for (const columnar_column &c : columns_)
+            if (c.name == name)
+                return c;
+        throw std::invalid_argument("columnar_file: no column " + std::string(name));
+    }
+
+private:
+    // MADV_WILLNEED over the pages of [p, p + n): read ahead without blocking.
+    static void prefetch(const void *p, std::size_t n)
+    {
+        if (n == 0)
+            return;
+        const std::uintptr_t page = static_cast<std::uintptr_t>(::sysconf(_SC_PAGESIZE));
+        const std::uintptr_t first = reinterpret_cast<std::uintptr_t>(p) / page * page;
+        ::madvise(reinterpret_cast<void *>(first), reinterpret_cast<std::uintptr_t>(p) + n - first, MADV_WILLNEED);
+    }
+
+    mapped_file file_;
+    std::size_t rows_ = 0;
+    std::uint64_t options_ = 0;
+    std::vector<columnar_column> columns_;
+};
+
+// Path of the cache cached_csv keeps for a CSV file: the CSV path plus ".col".
+inline std::filesystem::path columnar_cache_path(const std::filesystem::path &csv)
+{
+    std::filesystem::path cache = csv;
+    cache += ".col";
+    return cache;
+}
+
+// Opens the columnar cache of csv, converting the CSV first if the cache is missing,
+// older than the CSV, unreadable or parsed with other options. Without the CSV an
+// existing cache with matching options is used as is.
+inline columnar_file cached_csv(const std::filesystem::path &csv, const csv_options &opts = {},
+                                const std::vector<std::string> &projection = {})
+{
+    namespace fs = std::filesystem;
+    const fs::path cache = columnar_cache_path(csv);
+    std::error_code cache_error, csv_error;
+    const auto cache_time = fs::last_write_time(cache, cache_error);
+    const auto csv_time = fs::last_write_time(csv, csv_error); // no CSV: the cache is all there is
+    if (!cache_error && (csv_error || cache_time >= csv_time))
+    {
+        // Checked before the projection, whose names may only exist under these options.
+        detail::columnar_header header{};
+        std::ifstream in(cache, std::ios::binary);
+        in.read(reinterpret_cast<char *>(&header), sizeof header);
+        if (in && header.version == detail::columnar_version &&
+            header.options == detail::columnar_options_hash(opts))
+        {
+            try
+            {
+                return columnar_file(cache, projection);
+            }
+            catch (const std::runtime_error &)
+            {
+                // Damaged: convert again below.
+            }
+        }
+    }
+    write_columnar(read_csv(csv, opts), cache, opts);
+    return columnar_file(cache, projection);
+}
+
+} // namespace hpc
@@ -0,0 +1,226 @@
+/*
+ * Parallel CSV Reader vs getline + stod using csv.hpp
+ * ===================================================
+ *
+ * COMPILATION & EXECUTION:
+ *
+ * For Ubuntu:
+ * -----------
+ * g++ -std=c++20 -O2 -fopenmp -o csv csv.cpp
+ * ./csv
+ *
+ * For macOS:
+ * ----------
+ * g++ -std=c++20 -O2 -Xpreprocessor -fopenmp -I"$(brew --prefix libomp)/include" -L"$(brew --prefix libomp)/lib" -lomp -o csv csv.cpp
+ * ./csv
+ *
+ * Reads one of the dl/ data sets, prints the inferred schema, then writes the data rows
+ * repeated to a temporary file of production size and times reading it both ways.
+ *
+ * THEORETICAL CONCEPTS:
+ *
+ * Where the Time Goes:
+ * -------------------
+ * - The usual loop copies each line into a std::string, splits it into more strings and
+ *   converts each with stod: several allocations per field, and strtod is slow because it
+ *   handles every locale and rounding corner
+ * - csv.hpp never copies a numeric field: it maps the file, finds the row ends with 64-byte
+ *   SIMD compares and parses each field in place into its column
+ *
+ * Parallel Row Boundaries:
+ * -----------------------
+ * - A thread starting mid-file cannot tell if it is inside a quoted field. Counting the
+ *   quotes in every chunk first (one popcount per 64 bytes) and scanning the counts tells
+ *   each thread its starting state, so both passes run in parallel
+ *
+ * SAMPLE INPUT/OUTPUT:
+ * ------------------
+ *
+ * Input:
+ *   ../dl/Google_Stock_Price_Train.csv  (CSV file)
+ *   2000                                (Times to repeat the data rows)
+ *
+ * Output (single core):
+ *   ../dl/Google_Stock_Price_Train.csv: 1384 rows, 7 columns, SIMD AVX-512
+ *   column        type        nulls  first value
+ *   Date          date            0  2013-01-02
+ *   Open          float64         0  357.386
+ *   High          float64         0  361.151
+ *   Low           float64         0  355.96
+ *   Close         float64         0  359.288
+ *   Adj Close     float64         0  359.288
+ *   Volume        int64           0  5115500
+ *
+ *   Check: nested call reads all rows OK, 1e400 / -1e400 -> inf / -inf OK
+ *
+ *   Repeated 2000 times: 209.1 MB, 2768000 rows, threads 1
+ *
+ *   reader                       seconds      MB/s   speedup
+ *   getline + stod                4.6118      45.3      1.0x
+ *   read_csv (csv.hpp)            1.0156     205.9      4.5x
+ *
+ *   read_csv, last run: row boundaries 0.1029 s, parsing 0.9086 s; getline + stod converted 19376000 values
+ *
+ * read_csv is 4.5x faster on one core. Finding the row ends takes a tenth of its time, at
+ * 2 GB/s with the page faults of the first pass over the mapping included; the rest is
+ * parsing, which has no serial step and so scales with the cores, like the row search.
+ * HousingData.csv (quoted "0" in chas, more short fields per byte) parses at 130-160 MB/s,
+ * still 5x the loop. The loop's count of 7 values per row shows a quieter problem: stod
+ * reads the date "2013-01-02" as 2013 and reports no error, where read_csv infers a date
+ * column and stores days since 1970.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <vector>
+#include <string>
+#include <cmath>
+#include <omp.h>
+#include "csv.hpp"
+using namespace std;
+
+// Best of 3 runs.
+template <class F>
+double bestOf3(F &&f)
+{
+    double best = 1e30;
+    for (int rep = 0; rep < 3; rep++)
+    {
+        double start = omp_get_wtime();
+        f();
+        best = min(best, omp_get_wtime() - start);
+    }
+    return best;
+}
+
+// The loop csv.hpp replaces: one string per line and per field, stod for the numbers.
+// Returns the number of values converted.
+size_t getlineStod(const string &path)
+{
+    ifstream in(path);
+    string line, field;
+    vector<vector<double>> columns;
+    size_t values = 0;
+    getline(in, line); // header
+    while (getline(in, line))
+    {
+        stringstream fields(line);
+        for (size_t c = 0; getline(fields, field, ','); c++)
+        {
+            if (columns.size() <= c)
+                columns.emplace_back();
+            if (!field.empty() && field.front() == '"')
+                field = field.substr(1, field.size() - 2);
+            try
+            {
+                columns[c].push_back(stod(field));
+                values++;
+            }
+            catch (const exception &)
+            {
+                columns[c].push_back(0); // dates, NA
+            }
+        }
+    }
+    return values;
+}
+
+// First non-null value of the column, as text.
+string sample(const hpc::csv_column &c, size_t rows)
+{
+    for (size_t r = 0; r < rows; r++)
+        if (!c.is_null(r))
+            switch (c.type)
+            {
+            case hpc::column_type::int64:
+                return to_string(c.ints[r]);
+            case hpc::column_type::float64:
+            {
+                ostringstream out;
+                out << c.doubles[r];
+                return out.str();
+            }
+            case hpc::column_type::date:
+                return hpc::format_date(c.ints[r]);
+            default:
+                return string(c.string_at(r));
+            }
+    return "null";
+}
+
+int main()
+{
+    string path;
+    size_t repeat;
+    cout << "Enter the CSV file: ";
+    cin >> path;
+    cout << "Enter the times to repeat the data rows: ";
+    cin >> repeat;
+
+    if (!cin || repeat < 1 || !filesystem::is_regular_file(path))
+    {
+        cout << "Invalid input!" << endl;
+        return 1;
+    }
+
+    const hpc::csv_table table = hpc::read_csv(path);
+    cout << "\n" << path << ": " << table.rows << " rows, " << table.columns.size() << " columns, SIMD "
+         << hpc::simd_level_name(hpc::detail::csv_level(hpc::detected_simd_level())) << endl;
+    cout << left << setw(14) << "column" << setw(10) << "type" << right << setw(7) << "nulls" << "  first value"
+         << endl;
+    for (const hpc::csv_column &c : table.columns)
+        cout << left << setw(14) << c.name << setw(10) << hpc::column_type_name(c.type) << right << setw(7) << c.nulls
+             << "  " << sample(c, table.rows) << endl;
+
+    // Called from inside a parallel region the reader gets a smaller team than it asks
+    // for, and must still read every row; out-of-range numbers saturate to +-inf.
+    size_t nestedRows[2] = {0, 0};
+#pragma omp parallel num_threads(2)
+    nestedRows[omp_get_thread_num()] = hpc::read_csv(path).rows;
+    const hpc::csv_table huge = hpc::parse_csv("x\n1e400\n-1e400\n");
+    const bool nestedOk = nestedRows[0] == table.rows && (omp_get_max_threads() < 2 || nestedRows[1] == table.rows);
+    const bool hugeOk = isinf(huge.columns[0].doubles[0]) && huge.columns[0].doubles[1] < 0 &&
+                        isinf(huge.columns[0].doubles[1]);
+    cout << "\nCheck: nested call reads all rows " << (nestedOk ? "OK" : "FAILED") << ", 1e400 / -1e400 -> inf / -inf "
+         << (hugeOk ? "OK" : "FAILED") << endl;
+
+    // The header once, then the data rows repeat times.
+    const filesystem::path big = filesystem::temp_directory_path() / "csv_repeated.csv";
+    {
+        ifstream in(path, ios::binary);
+        string header, body((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+        const size_t split = body.find('\n') + 1;
+        header = body.substr(0, split);
+        body.erase(0, split);
+        if (!body.empty() && body.back() != '\n')
+            body += '\n';
+        ofstream out(big, ios::binary);
+        out << header;
+        for (size_t i = 0; i < repeat; i++)
+            out << body;
+    }
+    const double mb = filesystem::file_size(big) / 1e6;
+
+    hpc::csv_table repeated;
+    const double tCsv = bestOf3([&] { repeated = hpc::read_csv(big); });
+    size_t values = 0;
+    const double tLine = bestOf3([&] { values = getlineStod(big.string()); });
+
+    cout << "\nRepeated " << repeat << " times: " << fixed << setprecision(1) << mb << " MB, " << repeated.rows
+         << " rows, threads " << repeated.stats.threads << "\n" << endl;
+    cout << left << setw(26) << "reader" << right << setw(10) << "seconds" << setw(10) << "MB/s" << setw(10)
+         << "speedup" << endl;
+    cout << left << setw(26) << "getline + stod" << right << setprecision(4) << setw(10) << tLine << setprecision(1)
+         << setw(10) << mb / tLine << setw(9) << 1.0 << "x" << endl;
+    cout << left << setw(26) << "read_csv (csv.hpp)" << right << setprecision(4) << setw(10) << tCsv
+         << setprecision(1) << setw(10) << mb / tCsv << setw(9) << tLine / tCsv << "x" << endl;
+    cout << "\nread_csv, last run: row boundaries " << setprecision(4) << repeated.stats.index_seconds
+         << " s, parsing " << repeated.stats.parse_seconds << " s; getline + stod converted " << values << " values"
+         << endl;
+
+    filesystem::remove(big);
+    return 0;
+}
@@ -0,0 +1,1039 @@
+/*
+ * Parallel CSV Reader (header-only): mmap, SIMD Row Boundaries, Typed Columns using OpenMP
+ * ========================================================================================
+ *
+ * Reads a CSV file into one typed array per column (int64, float64, date or string) with
+ * a null bitmap each, the layout numeric code wants instead of rows of strings. The file
+ * is memory-mapped, split into chunks that threads scan for row boundaries with SIMD
+ * compares, and the rows are parsed in parallel straight into the column arrays.
+ *
+ * USAGE:
+ *
+ *   #include "csv.hpp"
+ *
+ *   hpc::csv_table t = hpc::read_csv("../dl/HousingData.csv");
+ *   const hpc::csv_column &medv = t.column("MEDV");          // float64: medv.doubles[i]
+ *   if (!medv.is_null(i)) ...
+ *   t.column("Date").ints[i];                                 // date: days since 1970-01-01
+ *   hpc::format_date(t.column("Date").ints[i]);               // "2013-01-02"
+ *   t.stats.print(cout);                                      // MB/s, time per stage
+ *
+ *   hpc::csv_options opts;
+ *   opts.header = false;                                      // letter-recognition.data
+ *   opts.types = {{"c0", hpc::column_type::string}};          // override inferred types
+ *   hpc::csv_table letters = hpc::read_csv("letter-recognition.data", opts);
+ *
+ *   hpc::csv_table s = hpc::parse_csv("a,b\n1,2\n");          // from memory
+ *
+ * COMPILATION:
+ *   g++ -std=c++20 -O2 -fopenmp -o program program.cpp
+ *
+ * FORMAT:
+ * ------
+ * - RFC 4180: fields separated by opts.delimiter, optionally quoted with opts.quote; a
+ *   quoted field may hold delimiters, newlines and doubled quotes (""). Quotes are removed
+ *   before a value is parsed, so "0" is the integer 0.
+ * - Rows end with \n or \r\n; blank lines are skipped. Without a header the columns are
+ *   named c0, c1, ...
+ * - A field that is empty or one of opts.na_values ("NA", "N/A", "NaN", "null", ...) is
+ *   null. A row with fewer fields than the header leaves the rest null; one with more
+ *   throws std::runtime_error, as does a quote left open at the end of the file.
+ *
+ * TYPES:
+ * -----
+ * - Inferred from the first opts.infer_rows data rows: int64 if every value there is an
+ *   integer, float64 if every value is a number, date if every value is YYYY-MM-DD,
+ *   string otherwise (all null: float64). opts.types overrides a column by name.
+ * - An int64 column that meets a non-integer number further down is re-parsed as
+ *   float64. Any other value that does not parse as the column type becomes null and is
+ *   counted in csv_stats::bad_values.
+ *
+ * ROW BOUNDARIES:
+ * --------------
+ * - A newline ends a row only outside quotes, and whether a byte is inside quotes depends
+ *   on every quote before it. Pass 1: each thread counts the quotes in its chunk, and an
+ *   exclusive scan of the counts gives each chunk's state at its first byte. Pass 2: each
+ *   thread turns 64 bytes at a time into a quote bitmask and a newline bitmask (one
+ *   AVX-512BW compare each, or two AVX2 compares + movemask), prefix-XORs the quote mask
+ *   into an inside-quotes mask, and keeps the newlines outside it (as in simdjson).
+ *
+ * NUMBERS:
+ * -------
+ * - Integers: sign and up to 18 digits, accumulated directly.
+ * - Floats: the digits go into a 64-bit integer and the exponent is counted. When the
+ *   integer is below 2^53 and the power of ten at most 10^22, both are exact doubles and
+ *   one multiply or divide gives the correctly rounded result (Clinger's fast path),
+ *   which covers the data sets here. Anything else goes to std::from_chars.
+ *
+ * PARALLELIZATION:
+ * ---------------
+ * - Rows are split between threads in multiples of 64, so each thread owns whole words
+ *   of every null bitmap. String columns are collected per thread and concatenated once
+ *   their offsets are known.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <omp.h>
+#include "fused_stats.hpp"
+#include "scan.hpp"
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+namespace hpc
+{
+
+enum class column_type
+{
+    int64,
+    float64,
+    date, // days since 1970-01-01, in csv_column::ints
+    string
+};
+
+inline const char *column_type_name(column_type type)
+{
+    switch (type)
+    {
+    case column_type::int64:
+        return "int64";
+    case column_type::float64:
+        return "float64";
+    case column_type::date:
+        return "date";
+    default:
+        return "string";
+    }
+}
+
+struct csv_options
+{
+    char delimiter = ',';
+    char quote = '"';
+    bool header = true;
+    std::size_t infer_rows = 1000;
+    std::vector<std::string> na_values = {"NA", "N/A", "NaN", "nan", "NULL", "null", "None", "#N/A"};
+    std::vector<std::pair<std::string, column_type>> types; // by column name, beats inference
+    simd_level level = detected_simd_level();
+};
+
+struct csv_column
+{
+    std::string name;
+    column_type type = column_type::float64;
+    std::vector<double> doubles;       // float64
+    std::vector<std::int64_t> ints;    // int64, date
+    std::vector<std::size_t> offsets;  // string: rows + 1 offsets into chars
+    std::string chars;
+    std::vector<std::uint64_t> valid;  // bit r % 64 of word r / 64: row r has a value
+    std::size_t nulls = 0;
+
+    bool is_null(std::size_t row) const { return !(valid[row >> 6] >> (row & 63) & 1); }
+    std::string_view string_at(std::size_t row) const
+    {
+        return std::string_view(chars).substr(offsets[row], offsets[row + 1] - offsets[row]);
+    }
+};
+
+struct csv_stats
+{
+    std::size_t bytes = 0;
+    std::size_t rows = 0;
+    std::size_t columns = 0;
+    std::size_t bad_values = 0;    // did not parse as their column's type: null
+    std::size_t promoted = 0;      // int64 columns re-parsed as float64
+    int threads = 0;
+    double index_seconds = 0;      // both boundary passes
+    double parse_seconds = 0;      // type inference and parsing
+    double seconds = 0;            // whole read, mapping included
+
+    double bandwidth() const { return seconds > 0 ? bytes / seconds / 1e6 : 0.0; } // MB/s
+
+    void print(std::ostream &os) const
+    {
+        os << "Bytes: " << bytes << ", rows: " << rows << ", columns: " << columns << "\n"
+           << "Threads: " << threads << "\n"
+           << "Time: " << seconds << " seconds (row boundaries " << index_seconds << ", parsing " << parse_seconds
+           << ")\n"
+           << "Throughput: " << bandwidth() << " MB/s\n"
+           << "Bad values: " << bad_values << ", int64 columns promoted to float64: " << promoted << "\n";
+    }
+};
+
+struct csv_table
+{
+    std::size_t rows = 0;
+    std::vector<csv_column> columns;
+    csv_stats stats;
+
+    const csv_column &column(std::string_view name) const
+    {
+        for (const csv_column &c : columns)
+            if (c.name == name)
+                return c;
+        throw std::invalid_argument("csv_table: no column " + std::string(name));
+    }
+};
+
+// Read-only mapping of a whole file; empty files map to nothing.
+class mapped_file
+{
+public:
+    explicit mapped_file(const std::filesystem::path &path)
+    {
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw std::runtime_error("mapped_file: cannot open " + path.string());
+        struct stat st;
+        if (::fstat(fd, &st) != 0)
+        {
+            ::close(fd);
+            throw std::runtime_error("mapped_file: cannot stat " + path.string());
+        }
+        size_ = static_cast<std::size_t>(st.st_size);
+        if (size_ > 0)
+        {
+            void *p = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED)
+            {
+                ::close(fd);
+                throw std::runtime_error("mapped_file: mmap failed for " + path.string());
+            }
+            data_ = static_cast<const char *>(p);
+        }
+        ::close(fd);
+    }
+    ~mapped_file()
+    {
+        if (data_)
+            ::munmap(const_cast<char *>(data_), size_);
+    }
+    mapped_file(mapped_file &&other) noexcept
+        : data_(std::exchange(other.data_, nullptr)), size_(std::exchange(other.size_, 0))
+    {
+    }
+    mapped_file &operator=(mapped_file &&other) noexcept
+    {
+        std::swap(data_, other.data_);
+        std::swap(size_, other.size_);
+        return *this;
+    }
+
+    const char *data() const { return data_; }
+    std::size_t size() const { return size_; }
+    std::string_view view() const { return {data_, size_}; }
+
+    // MADV_SEQUENTIAL / MADV_WILLNEED / MADV_RANDOM hint for the whole mapping.
+    void advise(int advice) const
+    {
+        if (data_)
+            ::madvise(const_cast<char *>(data_), size_, advice);
+    }
+
+private:
+    const char *data_ = nullptr;
+    std::size_t size_ = 0;
+};
+
+// Days since 1970-01-01 of a proleptic Gregorian date (H. Hinnant's days_from_civil).
+constexpr std::int64_t days_from_civil(std::int64_t y, unsigned m, unsigned d)
+{
+    y -= m <= 2;
+    const std::int64_t era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(y - era * 400);
+    const unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<std::int64_t>(doe) - 719468;
+}
+
+// "YYYY-MM-DD" of days since 1970-01-01.
+inline std::string format_date(std::int64_t days)
+{
+    days += 719468;
+    const std::int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    const unsigned doe = static_cast<unsigned>(days - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    const unsigned d = doy - (153 * mp + 2) / 5 + 1;
+    const unsigned m = mp < 10 ? mp + 3 : mp - 9;
+    const std::int64_t y = static_cast<std::int64_t>(yoe) + era * 400 + (m <= 2);
+    char out[32];
+    std::snprintf(out, sizeof out, "%04lld-%02u-%02u", static_cast<long long>(y), m, d);
+    return out;
+}
+
+namespace detail
+{
+
+// Each thread scans at least this many bytes.
+constexpr std::size_t csv_grain = std::size_t(1) << 20;
+
+inline int csv_threads(std::size_t bytes)
+{
+    return static_cast<int>(std::clamp<std::size_t>(bytes / csv_grain, 1, omp_get_max_threads()));
+}
+
+inline double csv_seconds(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// ---- Row boundaries ----
+
+// Bit i set: an odd number of quotes at bits 0..i, i.e. byte i is inside quotes (or is
+// the opening quote).
+inline std::uint64_t prefix_xor(std::uint64_t x)
+{
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+}
+
+struct scalar_csv_masks
+{
+    static void masks(const char *p, char quote, std::uint64_t &quotes, std::uint64_t &newlines)
+    {
+        quotes = newlines = 0;
+        for (int i = 0; i < 64; i++)
+        {
+            quotes |= std::uint64_t(p[i] == quote) << i;
+            newlines |= std::uint64_t(p[i] == '\n') << i;
+        }
+    }
+};
+
+#ifdef HPC_X86_SIMD
+
+struct avx2_csv_masks
+{
+    __attribute__((target("avx2"))) static void masks(const char *p, char quote, std::uint64_t &quotes,
+                                                      std::uint64_t &newlines)
+    {
+        const __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        const __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + 32));
+        const __m256i q = _mm256_set1_epi8(quote), nl = _mm256_set1_epi8('\n');
+        const std::uint32_t q_lo = _mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, q));
+        const std::uint32_t q_hi = _mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, q));
+        const std::uint32_t nl_lo = _mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, nl));
+        const std::uint32_t nl_hi = _mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, nl));
+        quotes = q_lo | std::uint64_t(q_hi) << 32;
+        newlines = nl_lo | std::uint64_t(nl_hi) << 32;
+    }
+};
+
+struct avx512_csv_masks
+{
+    __attribute__((target("avx512f,avx512bw"))) static void masks(const char *p, char quote, std::uint64_t &quotes,
+                                                                  std::uint64_t &newlines)
+    {
+        const __m512i v = _mm512_loadu_si512(p);
+        quotes = _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8(quote));
+        newlines = _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('\n'));
+    }
+};
+
+#endif // HPC_X86_SIMD
+
+// Quotes in [p, p + n).
+template <class Masks>
+inline std::size_t count_quotes(const char *p, std::size_t n, char quote)
+{
+    std::size_t count = 0, i = 0;
+    std::uint64_t q, nl;
+    for (; i + 64 <= n; i += 64)
+    {
+        Masks::masks(p + i, quote, q, nl);
+        count += static_cast<std::size_t>(__builtin_popcountll(q));
+    }
+    for (; i < n; i++)
+        count += p[i] == quote;
+    return count;
+}
+
+// Appends the offsets (from p) of the newlines in [p, p + n) that lie outside quotes;
+// `inside` is the quote state at p.
+template <class Masks>
+inline void find_row_ends(const char *p, std::size_t n, char quote, bool inside, std::size_t base,
+                          std::vector<std::size_t> &ends)
+{
+    std::uint64_t carry = inside ? ~std::uint64_t(0) : 0;
+    std::size_t i = 0;
+    std::uint64_t q, nl;
+    for (; i + 64 <= n; i += 64)
+    {
+        Masks::masks(p + i, quote, q, nl);
+        const std::uint64_t quoted = prefix_xor(q) ^ carry;
+        carry = static_cast<std::uint64_t>(static_cast<std::int64_t>(quoted) >> 63);
+        for (std::uint64_t m = nl & ~quoted; m; m &= m - 1)
+            ends.push_back(base + i + static_cast<std::size_t>(__builtin_ctzll(m)));
+    }
+    bool in = carry != 0;
+    for (; i < n; i++)
+    {
+        if (p[i] == quote)
+            in = !in;
+        else if (p[i] == '\n' && !in)
+            ends.push_back(base + i);
+    }
+}
+
+#ifdef HPC_X86_SIMD
+__attribute__((target("avx2"), flatten)) inline std::size_t count_quotes_avx2(const char *p, std::size_t n, char quote)
+{
+    return count_quotes<avx2_csv_masks>(p, n, quote);
+}
+
+__attribute__((target("avx512f,avx512bw"), flatten)) inline std::size_t count_quotes_avx512(const char *p,
+                                                                                          std::size_t n, char quote)
+{
+    return count_quotes<avx512_csv_masks>(p, n, quote);
+}
+
+__attribute__((target("avx2"), flatten)) inline void find_row_ends_avx2(const char *p, std::size_t n, char quote,
+                                                                        bool inside, std::size_t base,
+                                                                        std::vector<std::size_t> &ends)
+{
+    find_row_ends<avx2_csv_masks>(p, n, quote, inside, base, ends);
+}
+
+__attribute__((target("avx512f,avx512bw"), flatten)) inline void find_row_ends_avx512(
+    const char *p, std::size_t n, char quote, bool inside, std::size_t base, std::vector<std::size_t> &ends)
+{
+    find_row_ends<avx512_csv_masks>(p, n, quote, inside, base, ends);
+}
+#endif
+
+inline simd_level csv_level(simd_level level)
+{
+    level = std::min(level, detected_simd_level());
+#ifdef HPC_X86_SIMD
+    if (level == simd_level::avx512 && !__builtin_cpu_supports("avx512bw"))
+        level = simd_level::avx2;
+#endif
+    return level;
+}
+
+struct row_span
+{
+    std::size_t begin, end; // end excludes the \n (and a \r before it)
+};
+
+// Spans of the non-blank rows of text. Asks for `threads` threads; team is set to the
+// number the runtime gave (fewer inside another parallel region).
+inline std::vector<row_span> index_rows(std::string_view text, char quote, simd_level level, int threads,
+                                        int &team)
+{
+    const char *data = text.data();
+    const std::size_t size = text.size();
+    std::vector<std::size_t> quote_counts(threads + 1, 0);
+    std::vector<std::vector<std::size_t>> ends(threads);
+    level = csv_level(level);
+    team = 1;
+
+#pragma omp parallel num_threads(threads) if (threads > 1)
+    {
+        const int t = omp_get_thread_num(), nt = omp_get_num_threads();
+        const std::size_t chunk = (size + nt - 1) / nt;
+        const std::size_t first = std::min(size, chunk * t), last = std::min(size, first + chunk);
+        std::size_t count;
+#ifdef HPC_X86_SIMD
+        if (level == simd_level::avx512)
+            count = count_quotes_avx512(data + first, last - first, quote);
+        else if (level == simd_level::avx2)
+            count = count_quotes_avx2(data + first, last - first, quote);
+        else
+#endif
+            count = count_quotes<scalar_csv_masks>(data + first, last - first, quote);
+        quote_counts[t + 1] = count;
+#pragma omp barrier
+#pragma omp single
+        {
+            team = nt;
+            for (int i = 0; i < nt; i++)
+                quote_counts[i + 1] += quote_counts[i];
+        }
+
+        const bool inside = quote_counts[t] & 1;
+        ends[t].reserve((last - first) / 64);
+#ifdef HPC_X86_SIMD
+        if (level == simd_level::avx512)
+            find_row_ends_avx512(data + first, last - first, quote, inside, first, ends[t]);
+        else if (level == simd_level::avx2)
+            find_row_ends_avx2(data + first, last - first, quote, inside, first, ends[t]);
+        else
+#endif
+            find_row_ends<scalar_csv_masks>(data + first, last - first, quote, inside, first, ends[t]);
+    }
+    if (quote_counts[team] & 1)
+        throw std::runtime_error("read_csv: quoted field not closed at the end of the file");
+
+    // Row k of chunk t starts after the previous newline, wherever it was found.
+    std::vector<std::size_t> base(team + 1, 0);
+    for (int t = 0; t < team; t++)
+        base[t + 1] = base[t] + ends[t].size();
+    std::size_t last_end = 0;
+    for (int t = team - 1; t >= 0; t--)
+        if (!ends[t].empty())
+        {
+            last_end = ends[t].back();
+            break;
+        }
+    const bool tail = base[team] == 0 ? size > 0 : last_end + 1 < size;
+    std::vector<row_span> rows(base[team] + tail);
+    std::size_t blanks = 0;
+
+    // One chunk per iteration, so any team size covers all of them.
+#pragma omp parallel for schedule(static) num_threads(team) if (team > 1) reduction(+ : blanks)
+    for (int t = 0; t < team; t++)
+    {
+        std::size_t begin = 0;
+        for (int s = t - 1; s >= 0; s--)
+            if (!ends[s].empty())
+            {
+                begin = ends[s].back() + 1;
+                break;
+            }
+        for (std::size_t k = 0; k < ends[t].size(); k++)
+        {
+            std::size_t end = ends[t][k];
+            const std::size_t next = end + 1;
+            if (end > begin && data[end - 1] == '\r')
+                end--;
+            rows[base[t] + k] = {begin, end};
+            blanks += end == begin;
+            begin = next;
+        }
+    }
+    if (tail)
+    {
+        const std::size_t begin = base[team] ? last_end + 1 : 0;
+        std::size_t end = size;
+        if (end > begin && data[end - 1] == '\r')
+            end--;
+        rows.back() = {begin, end};
+        blanks += end == begin;
+    }
+    if (blanks)
+        rows.erase(std::remove_if(rows.begin(), rows.end(), [](const row_span &r) { return r.begin == r.end; }),
+                   rows.end());
+    return rows;
+}
+
+// ---- Fields ----
+
+// Calls f(field, quoted) for each field of the row, unquoted (doubled quotes left in).
+// Returns the number of fields, stopping after `limit`.
+template <class F>
+inline std::size_t for_each_field(const char *p, const char *end, char delimiter, char quote, std::size_t limit,
+                                  F &&f)
+{
+    std::size_t count = 0;
+    for (;;)
+    {
+        if (count == limit)
+            return count + (p <= end ? 1 : 0);
+        if (p < end && *p == quote)
+        {
+            const char *begin = ++p;
+            for (;;)
+            {
+                const char *q = static_cast<const char *>(std::memchr(p, quote, end - p));
+                if (!q)
+                {
+                    p = end;
+                    break;
+                }
+                if (q + 1 < end && q[1] == quote)
+                {
+                    p = q + 2;
+                    continue;
+                }
+                p = q;
+                break;
+            }
+            f(std::string_view(begin, p - begin), true);
+            count++;
+            p = p < end ? p + 1 : end; // past the closing quote
+            const char *d = static_cast<const char *>(std::memchr(p, delimiter, end - p));
+            if (!d)
+                return count;
+            p = d + 1;
+        }
+        else
+        {
+            // Numeric fields are a few bytes: a plain loop beats a memchr call.
+            const char *d = p;
+            while (d < end && *d != delimiter)
+                d++;
+            f(std::string_view(p, d - p), false);
+            count++;
+            if (d == end)
+                return count;
+            p = d + 1;
+        }
+    }
+}
+
+// ---- Values ----
+
+inline bool is_digit(char c) { return static_cast<unsigned char>(c - '0') < 10; }
+
+inline bool parse_int64(std::string_view s, std::int64_t &out)
+{
+    const char *p = s.data(), *end = p + s.size();
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+        negative = *p++ == '-';
+    if (p == end || end - p > 18)
+        return false;
+    std::int64_t v = 0;
+    for (; p < end; p++)
+    {
+        if (!is_digit(*p))
+            return false;
+        v = v * 10 + (*p - '0');
+    }
+    out = negative ? -v : v;
+    return true;
+}
+
+inline constexpr double exact_powers_of_ten[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+                                                 1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+                                                 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+inline bool parse_double(std::string_view s, double &out)
+{
+    const char *p = s.data(), *end = p + s.size();
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+        negative = *p++ == '-';
+    const char *number = p;
+    std::uint64_t mantissa = 0; // wraps past 19 digits, which go to from_chars anyway
+    for (; p < end && is_digit(*p); p++)
+        mantissa = mantissa * 10 + (*p - '0');
+    std::ptrdiff_t digits = p - number;
+    int exponent = 0;
+    if (p < end && *p == '.')
+    {
+        const char *fraction = ++p;
+        for (; p < end && is_digit(*p); p++)
+            mantissa = mantissa * 10 + (*p - '0');
+        exponent = -static_cast<int>(p - fraction);
+        digits += p - fraction;
+    }
+    if (digits == 0)
+        return false;
+    if (p < end && (*p == 'e' || *p == 'E'))
+    {
+        p++;
+        bool negative_exponent = false;
+        if (p < end && (*p == '-' || *p == '+'))
+            negative_exponent = *p++ == '-';
+        if (p == end || !is_digit(*p))
+            return false;
+        int e = 0;
+        for (; p < end && is_digit(*p); p++)
+            e = std::min(e * 10 + (*p - '0'), 100000);
+        exponent += negative_exponent ? -e : e;
+    }
+    if (p != end)
+        return false;
+
+    if (digits <= 19 && mantissa <= (std::uint64_t(1) << 53) && exponent >= -22 && exponent <= 22)
+    {
+        double v = static_cast<double>(mantissa);
+        v = exponent < 0 ? v / exact_powers_of_ten[-exponent] : v * exact_powers_of_ten[exponent];
+        out = negative ? -v : v;
+        return true;
+    }
+    double v;
+    const auto [ptr, ec] = std::from_chars(number, end, v);
+    if (ptr != end || (ec != std::errc() && ec != std::errc::result_out_of_range))
+        return false;
+    if (ec == std::errc::result_out_of_range) // from_chars leaves v alone; strtod gives inf or 0
+        v = std::strtod(std::string(number, end).c_str(), nullptr);
+    out = negative ? -v : v;
+    return true;
+}
+
+// "YYYY-MM-DD" with a real month and day.
+inline bool parse_date(std::string_view s, std::int64_t &days)
+{
+    if (s.size() != 10 || s[4] != '-' || s[7] != '-')
+        return false;
+    for (int i : {0, 1, 2, 3, 5, 6, 8, 9})
+        if (!is_digit(s[i]))
+            return false;
+    const int y = (s[0] - '0') * 1000 + (s[1] - '0') * 100 + (s[2] - '0') * 10 + (s[3] - '0');
+    const unsigned m = (s[5] - '0') * 10 + (s[6] - '0'), d = (s[8] - '0') * 10 + (s[9] - '0');
+    static constexpr unsigned month_days[] = {31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    if (m < 1 || m > 12 || d < 1 || d > month_days[m - 1])
+        return false;
+    if (m == 2 && d == 29 && !(y % 4 == 0 && (y % 100 != 0 || y % 400 == 0)))
+        return false;
+    days = days_from_civil(y, m, d);
+    return true;
+}
+
+inline bool is_na(std::string_view s, const std::vector<std::string> &na_values)
+{
+    if (s.empty())
+        return true;
+    if (is_digit(s[0]) || ((s[0] == '-' || s[0] == '.') && s.size() > 1))
+        return false;
+    for (const std::string &na : na_values)
+        if (s == na)
+            return true;
+    return false;
+}
+
+// Doubled quotes of a quoted field, made single.
+inline void append_unquoted(std::string &out, std::string_view s, bool quoted, char quote)
+{
+    if (!quoted || s.find(quote) == std::string_view::npos)
+    {
+        out.append(s);
+        return;
+    }
+    for (std::size_t i = 0; i < s.size(); i++)
+    {
+        out.push_back(s[i]);
+        if (s[i] == quote && i + 1 < s.size() && s[i + 1] == quote)
+            i++;
+    }
+}
+
+// Most specific type that holds every non-null sample value.
+inline std::vector<column_type> infer_types(std::string_view text, const std::vector<row_span> &rows,
+                                            std::size_t first, std::size_t columns, const csv_options &opts)
+{
+    std::vector<char> any(columns, 0), ints(columns, 1), floats(columns, 1), dates(columns, 1);
+    const std::size_t last = std::min(rows.size(), first + opts.infer_rows);
+    for (std::size_t r = first; r < last; r++)
+    {
+        std::size_t c = 0;
+        for_each_field(text.data() + rows[r].begin, text.data() + rows[r].end, opts.delimiter, opts.quote,
+                       columns, [&](std::string_view field, bool) {
+                           if (c < columns && !is_na(field, opts.na_values))
+                           {
+                               std::int64_t i;
+                               double d;
+                               any[c] = 1;
+                               ints[c] &= parse_int64(field, i);
+                               floats[c] &= ints[c] || parse_double(field, d);
+                               dates[c] &= parse_date(field, i);
+                           }
+                           c++;
+                       });
+    }
+    std::vector<column_type> types(columns);
+    for (std::size_t c = 0; c < columns; c++)
+        types[c] = !any[c]     ? column_type::float64
+                   : ints[c]   ? column_type::int64
+                   : floats[c] ? column_type::float64
+                   : dates[c]  ? column_type::date
+                               : column_type::string;
+    return types;
+}
+
+// Per-thread results of the parse pass.
+struct csv_partial
+{
+    std::vector<std::string> chars;   // per string column
+    std::vector<char> promote;        // per column: int64 met a float
+    std::vector<std::size_t> bad;     // per column
+    std::exception_ptr error;
+};
+
+// Where parse_rows writes one column: raw pointers, so the field loop does not go
+// through the column's vectors.
+struct column_out
+{
+    column_type type;
+    double *doubles;
+    std::int64_t *ints;
+    std::size_t *lengths; // offsets + 1
+    std::uint64_t *valid;
+    std::uint64_t word;   // validity bits of the current 64 rows
+};
+
+// Parses column `only` of rows [first, last) (all columns when only == columns) into
+// table. first is a multiple of 64, so whole bitmap words are written.
+inline void parse_rows(std::string_view text, const std::vector<row_span> &rows, std::size_t data_first,
+                       std::size_t first, std::size_t last, csv_table &table, const csv_options &opts,
+                       csv_partial &partial, std::size_t only)
+{
+    const std::size_t columns = table.columns.size();
+    std::vector<column_out> outs(columns);
+    for (std::size_t c = 0; c < columns; c++)
+    {
+        csv_column &column = table.columns[c];
+        outs[c] = {column.type, column.doubles.data(), column.ints.data(),
+                   column.offsets.empty() ? nullptr : column.offsets.data() + 1, column.valid.data(), 0};
+    }
+    const std::size_t limit = only < columns ? only + 1 : columns;
+    for (std::size_t r = first; r < last; r++)
+    {
+        const row_span span = rows[data_first + r];
+        const std::uint64_t bit = std::uint64_t(1) << (r & 63);
+        std::size_t c = 0;
+        const std::size_t fields = for_each_field(
+            text.data() + span.begin, text.data() + span.end, opts.delimiter, opts.quote, limit,
+            [&](std::string_view field, bool quoted) {
+                const std::size_t col = c++;
+                if (col >= columns || (only < columns && col != only) || is_na(field, opts.na_values))
+                    return;
+                column_out &out = outs[col];
+                bool ok = true;
+                switch (out.type)
+                {
+                case column_type::int64:
+                    if (!parse_int64(field, out.ints[r]))
+                    {
+                        double d;
+                        ok = false;
+                        if (parse_double(field, d))
+                            partial.promote[col] = 1;
+                        else
+                            partial.bad[col]++;
+                    }
+                    break;
+                case column_type::float64:
+                    ok = parse_double(field, out.doubles[r]);
+                    partial.bad[col] += !ok;
+                    break;
+                case column_type::date:
+                    ok = parse_date(field, out.ints[r]);
+                    partial.bad[col] += !ok;
+                    break;
+                case column_type::string:
+                {
+                    std::string &chars = partial.chars[col];
+                    const std::size_t before = chars.size();
+                    append_unquoted(chars, field, quoted, opts.quote);
+                    out.lengths[r] = chars.size() - before;
+                    break;
+                }
+                }
+                out.word |= ok ? bit : 0;
+            });
+        if (fields > columns)
+            throw std::runtime_error("read_csv: data row " + std::to_string(r + 1) + " has more than " +
+                                     std::to_string(columns) + " fields");
+        if ((r & 63) == 63 || r + 1 == last)
+            for (column_out &out : outs)
+            {
+                out.valid[r >> 6] |= out.word;
+                out.word = 0;
+            }
+    }
+}
+
+// Rows [first, last) of thread t of `threads`, in whole bitmap words.
+inline std::pair<std::size_t, std::size_t> csv_row_range(std::size_t rows, int t, int threads)
+{
+    const std::size_t words = (rows + 63) / 64, per = (words + threads - 1) / threads;
+    return {std::min(rows, per * t * 64), std::min(rows, per * (t + 1) * 64)};
+}
+
+inline void csv_allocate(csv_column &column, std::size_t rows)
+{
+    column.doubles.clear();
+    column.ints.clear();
+    column.offsets.clear();
+    column.chars.clear();
+    if (column.type == column_type::float64)
+        column.doubles.resize(rows);
+    else if (column.type == column_type::string)
+        column.offsets.assign(rows + 1, 0);
+    else
+        column.ints.resize(rows);
+    column.valid.assign((rows + 63) / 64, 0);
+}
+
+// Runs parse_rows on every thread of the team (at most `threads`), then joins strings,
+// counts nulls and collects errors. promote and bad are per column.
+inline void csv_parse_pass(std::string_view text, const std::vector<row_span> &rows, std::size_t data_first,
+                           csv_table &table, const csv_options &opts, int threads, std::size_t only,
+                           std::vector<char> &promote, std::vector<std::size_t> &bad)
+{
+    const std::size_t n = table.rows, columns = table.columns.size();
+    std::vector<csv_partial> partials(threads);
+    for (csv_partial &p : partials)
+    {
+        p.chars.resize(columns);
+        p.promote.assign(columns, 0);
+        p.bad.assign(columns, 0);
+    }
+    int team = 1;
+
+#pragma omp parallel num_threads(threads) if (threads > 1)
+    {
+        const int t = omp_get_thread_num(), nt = omp_get_num_threads();
+#pragma omp single nowait
+        team = nt;
+        const auto [first, last] = csv_row_range(n, t, nt);
+        try
+        {
+            parse_rows(text, rows, data_first, first, last, table, opts, partials[t], only);
+        }
+        catch (...)
+        {
+            partials[t].error = std::current_exception();
+        }
+    }
+
+    promote.assign(columns, 0);
+    bad.assign(columns, 0);
+    for (const csv_partial &p : partials)
+    {
+        if (p.error)
+            std::rethrow_exception(p.error);
+        for (std::size_t c = 0; c < columns; c++)
+        {
+            promote[c] |= p.promote[c];
+            bad[c] += p.bad[c];
+        }
+    }
+
+    for (std::size_t c = 0; c < columns; c++)
+    {
+        if (only < columns && c != only)
+            continue;
+        csv_column &column = table.columns[c];
+        if (column.type == column_type::string)
+        {
+            parallel_inclusive_scan(column.offsets.begin() + 1, column.offsets.end(), column.offsets.begin() + 1);
+            column.chars.resize(column.offsets[n]);
+            for (int t = 0; t < team; t++)
+            {
+                const std::string &part = partials[t].chars[c];
+                std::memcpy(column.chars.data() + column.offsets[csv_row_range(n, t, team).first], part.data(),
+                            part.size());
+            }
+        }
+        std::size_t set = 0;
+        for (std::uint64_t w : column.valid)
+            set += static_cast<std::size_t>(__builtin_popcountll(w));
+        column.nulls = n - set;
+    }
+}
+
+} // namespace detail
+
+// Parses CSV text (the whole file) into typed columns.
+inline csv_table parse_csv(std::string_view text, const csv_options &opts = {})
+{
+    const auto start = std::chrono::steady_clock::now();
+    csv_table table;
+    const int threads = detail::csv_threads(text.size());
+    table.stats.bytes = text.size();
+
+    const std::vector<detail::row_span> rows =
+        detail::index_rows(text, opts.quote, opts.level, threads, table.stats.threads);
+    table.stats.index_seconds = detail::csv_seconds(start);
+    const auto parse_start = std::chrono::steady_clock::now();
+
+    // Column names: the header row, or c0, c1, ... as many as the first row has fields.
+    std::vector<std::string> names;
+    if (!rows.empty())
+        detail::for_each_field(text.data() + rows[0].begin, text.data() + rows[0].end, opts.delimiter, opts.quote,
+                               std::numeric_limits<std::size_t>::max(), [&](std::string_view field, bool quoted) {
+                                   std::string name;
+                                   if (opts.header)
+                                       detail::append_unquoted(name, field, quoted, opts.quote);
+                                   else
+                                       name = "c" + std::to_string(names.size());
+                                   names.push_back(std::move(name));
+                               });
+    const std::size_t data_first = opts.header && !rows.empty() ? 1 : 0;
+    table.rows = rows.size() - data_first;
+    std::vector<column_type> types = detail::infer_types(text, rows, data_first, names.size(), opts);
+    for (const auto &[name, type] : opts.types)
+    {
+        const auto it = std::find(names.begin(), names.end(), name);
+        if (it == names.end())
+            throw std::invalid_argument("read_csv: no column " + name + " to set the type of");
+        types[it - names.begin()] = type;
+    }
+
+    table.columns.resize(names.size());
+    for (std::size_t c = 0; c < names.size(); c++)
+    {
+        table.columns[c].name = std::move(names[c]);
+        table.columns[c].type = types[c];
+        detail::csv_allocate(table.columns[c], table.rows);
+    }
+    const int parse_threads = std::clamp<int>(static_cast<int>(table.rows / 4096), 1, threads);
+    std::vector<char> promote;
+    std::vector<std::size_t> bad;
+    detail::csv_parse_pass(text, rows, data_first, table, opts, parse_threads, table.columns.size(), promote, bad);
+
+    // int64 columns holding non-integers further down than the sample: again as float64.
+    for (std::size_t c = 0; c < table.columns.size(); c++)
+        if (promote[c])
+        {
+            table.columns[c].type = column_type::float64;
+            detail::csv_allocate(table.columns[c], table.rows);
+            std::vector<char> unused;
+            std::vector<std::size_t> bad_float;
+            detail::csv_parse_pass(text, rows, data_first, table, opts, parse_threads, c, unused, bad_float);
+            bad[c] = bad_float[c];
+            table.stats.promoted++;
+        }
+    for (std::size_t b : bad)
+        table.stats.bad_values += b;
+
+    table.stats.rows = table.rows;
+    table.stats.columns = table.columns.size();
+    table.stats.parse_seconds = detail::csv_seconds(parse_start);
+    table.stats.seconds = detail::csv_seconds(start);
+    return table;
+}
+
+// Maps the file and parses it; the time includes the page faults of the first pass.
+inline csv_table read_csv(const std::filesystem::path &path, const csv_options &opts = {})
+{
+    const auto start = std::chrono::steady_clock::now();
+    mapped_file file(path);
+    file.advise(MADV_SEQUENTIAL);
+    csv_table table = parse_csv(file.view(), opts);
+    table.stats.seconds = detail::csv_seconds(start);
+    return table;
+}
+
+} // namespace hpc
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
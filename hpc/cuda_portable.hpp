@@ -0,0 +1,312 @@
+/*
+ * Portable CUDA Kernel Layer (header-only): __global__ Kernels on CPU or GPU
+ * ==========================================================================
+ *
+ * Lets the .cu programs in this directory build and run without a GPU. With nvcc the
+ * header is a thin wrapper over the CUDA runtime; with a plain C++ compiler it supplies
+ * the pieces of CUDA those programs use (__global__, dim3, threadIdx / blockIdx /
+ * blockDim / gridDim, cudaMalloc / cudaMemcpy / cudaFree) and runs each kernel launch on
+ * the persistent CPU thread pool from thread_pool.hpp.
+ *
+ * USAGE:
+ *
+ *   #include "cuda_portable.hpp"
+ *
+ *   __global__ void add(int *A, int *B, int *C, int size) { ... }   // unchanged
+ *
+ *   hpc::launch<add>(blocksPerGrid, threadsPerBlock, X, Y, Z, N);   // was add<<<...>>>(X, Y, Z, N)
+ *   hpc::launch<gpuMM>(grid, threadBlock, dA, dB, dC, N);           // dim3 works too
+ *
+ * Every launch prints one line to std::clog: kernel, configuration, wall time and where it
+ * ran. hpc::launch_reporting() = false turns that off; hpc::last_launch() keeps the numbers.
+ *
+ * COMPILATION:
+ *   CPU:  g++ -std=c++20 -O2 -fopenmp -x c++ -o program program.cu
+ *   CUDA: nvcc -std=c++17 -Xcompiler -fopenmp -o program program.cu
+ * (-x c++ because g++ does not know the .cu extension.) Notebooks using the nvcc4jupyter
+ * plugin still need `%%cu` as the first line of the cell; it is not part of the files.
+ *
+ * CPU EXECUTION MODEL:
+ * -------------------
+ * - The grid is flattened and split over the pool in contiguous runs of blocks, at least
+ *   4096 CUDA threads per task, so tiny launches run on the calling thread alone.
+ * - Inside a block, CUDA threads run as a loop with threadIdx.x innermost: neighbouring
+ *   CUDA threads touch neighbouring addresses, which on the CPU is unit-stride access
+ *   (what coalescing is on the GPU).
+ * - The index variables are thread_local, one set per CPU thread. The compiler therefore
+ *   cannot vectorize across CUDA threads; per-thread loops inside a kernel still vectorize.
+ * - Not supported: __syncthreads, __shared__, atomics, streams. Kernels that use them fail
+ *   to compile here rather than run wrongly.
+ *
+ * ERROR HANDLING:
+ * --------------
+ * - As in CUDA, calls return cudaError_t and a bad launch (a block over 1024 threads, an
+ *   empty grid) is reported by cudaGetLastError(); the kernel does not run.
+ * - cudaMalloc returns cudaErrorMemoryAllocation when the host allocation fails.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <string_view>
+
+#ifdef __CUDACC__
+
+#include <cuda_runtime.h>
+
+#else
+
+#include <cstdlib>
+#include <cstring>
+#include "buffer_pool.hpp"
+#include "thread_pool.hpp"
+
+#define __global__
+#define __device__
+#define __host__
+
+struct uint3
+{
+    unsigned int x, y, z;
+};
+
+struct dim3
+{
+    unsigned int x, y, z;
+    constexpr dim3(unsigned int vx = 1, unsigned int vy = 1, unsigned int vz = 1) : x(vx), y(vy), z(vz) {}
+};
+
+// One copy per CPU thread: each runs its own share of CUDA threads.
+inline thread_local uint3 threadIdx;
+inline thread_local uint3 blockIdx;
+inline thread_local dim3 blockDim;
+inline thread_local dim3 gridDim;
+
+enum cudaError_t
+{
+    cudaSuccess = 0,
+    cudaErrorInvalidValue = 1,
+    cudaErrorMemoryAllocation = 2,
+    cudaErrorInvalidConfiguration = 9
+};
+
+enum cudaMemcpyKind
+{
+    cudaMemcpyHostToHost = 0,
+    cudaMemcpyHostToDevice = 1,
+    cudaMemcpyDeviceToHost = 2,
+    cudaMemcpyDeviceToDevice = 3,
+    cudaMemcpyDefault = 4
+};
+
+namespace hpc::detail
+{
+
+inline cudaError_t &last_cuda_error()
+{
+    thread_local cudaError_t error = cudaSuccess;
+    return error;
+}
+
+inline cudaError_t set_cuda_error(cudaError_t error)
+{
+    if (error != cudaSuccess)
+        last_cuda_error() = error;
+    return error;
+}
+
+} // namespace hpc::detail
+
+// "Device" memory is host memory from buffer_pool::global(): page aligned (cudaMalloc
+// guarantees 256), on huge pages when large, and recycled by the next cudaMalloc.
+template <class T>
+cudaError_t cudaMalloc(T **ptr, std::size_t bytes)
+{
+    if (!ptr)
+        return hpc::detail::set_cuda_error(cudaErrorInvalidValue);
+    try
+    {
+        *ptr = static_cast<T *>(hpc::buffer_pool::global().allocate(bytes));
+    }
+    catch (const std::bad_alloc &)
+    {
+        *ptr = nullptr;
+        return hpc::detail::set_cuda_error(cudaErrorMemoryAllocation);
+    }
+    return cudaSuccess;
+}
+
+inline cudaError_t cudaFree(void *ptr)
+{
+    hpc::buffer_pool::global().deallocate(ptr);
+    return cudaSuccess;
+}
+
+inline cudaError_t cudaMemcpy(void *dst, const void *src, std::size_t bytes, cudaMemcpyKind)
+{
+    if (bytes != 0 && (!dst || !src))
+        return hpc::detail::set_cuda_error(cudaErrorInvalidValue);
+    std::memmove(dst, src, bytes);
+    return cudaSuccess;
+}
+
+inline cudaError_t cudaMemset(void *dst, int value, std::size_t bytes)
+{
+    std::memset(dst, value, bytes);
+    return cudaSuccess;
+}
+
+// Launches are synchronous on the CPU, so there is never anything to wait for.
+inline cudaError_t cudaDeviceSynchronize()
+{
+    return cudaSuccess;
+}
+
+inline cudaError_t cudaGetLastError()
+{
+    cudaError_t error = hpc::detail::last_cuda_error();
+    hpc::detail::last_cuda_error() = cudaSuccess;
+    return error;
+}
+
+inline const char *cudaGetErrorString(cudaError_t error)
+{
+    switch (error)
+    {
+    case cudaSuccess:
+        return "no error";
+    case cudaErrorInvalidValue:
+        return "invalid argument";
+    case cudaErrorMemoryAllocation:
+        return "out of memory";
+    case cudaErrorInvalidConfiguration:
+        return "invalid configuration argument";
+    }
+    return "unknown error";
+}
+
+#endif // __CUDACC__
+
+namespace hpc
+{
+
+struct launch_record
+{
+    std::string_view kernel;
+    dim3 grid, block;
+    double milliseconds = 0;
+    int cpu_threads = 0; // 0: ran on the GPU
+};
+
+inline bool &launch_reporting()
+{
+    static bool enabled = true;
+    return enabled;
+}
+
+inline launch_record &last_launch()
+{
+    thread_local launch_record record;
+    return record;
+}
+
+namespace detail
+{
+
+// "add" out of GCC/Clang's "... [with auto Kernel = add; Args = ...]".
+template <auto Kernel>
+std::string_view kernel_name()
+{
+    std::string_view s = __PRETTY_FUNCTION__;
+    const std::size_t at = s.find("Kernel = ");
+    if (at == std::string_view::npos)
+        return "kernel";
+    s.remove_prefix(at + 9);
+    return s.substr(0, s.find_first_of(";]"));
+}
+
+inline void report_launch(const launch_record &r)
+{
+    last_launch() = r;
+    if (!launch_reporting())
+        return;
+    const std::ios_base::fmtflags flags = std::clog.flags();
+    const std::streamsize precision = std::clog.precision(3);
+    std::clog << "[launch] " << r.kernel << "<<<(" << r.grid.x << "," << r.grid.y << "," << r.grid.z << "), ("
+              << r.block.x << "," << r.block.y << "," << r.block.z << ")>>> " << std::fixed << r.milliseconds
+              << " ms on ";
+    if (r.cpu_threads > 0)
+        std::clog << r.cpu_threads << " CPU thread" << (r.cpu_threads > 1 ? "s" : "") << std::endl;
+    else
+        std::clog << "the GPU" << std::endl;
+    std::clog.flags(flags);
+    std::clog.precision(precision);
+}
+
+#ifndef __CUDACC__
+
+// CUDA threads per pool task: below this a launch is not worth waking other threads.
+constexpr std::ptrdiff_t launch_grain = 4096;
+
+#endif
+
+} // namespace detail
+
+// Kernel<<<grid, block>>>(args...), timed. On the GPU the launch is followed by a
+// synchronization so the time covers the kernel, not just the enqueue.
+template <auto Kernel, class... Args>
+void launch(dim3 grid, dim3 block, Args... args)
+{
+    launch_record record{detail::kernel_name<Kernel>(), grid, block};
+#ifdef __CUDACC__
+    cudaEvent_t start, stop;
+    cudaEventCreate(&start);
+    cudaEventCreate(&stop);
+    cudaEventRecord(start);
+    Kernel<<<grid, block>>>(args...);
+    cudaEventRecord(stop);
+    cudaEventSynchronize(stop);
+    float ms = 0;
+    cudaEventElapsedTime(&ms, start, stop);
+    cudaEventDestroy(start);
+    cudaEventDestroy(stop);
+    record.milliseconds = ms;
+#else
+    const std::size_t per_block = std::size_t(block.x) * block.y * block.z;
+    const std::size_t blocks = std::size_t(grid.x) * grid.y * grid.z;
+    if (per_block == 0 || per_block > 1024 || blocks == 0)
+    {
+        detail::set_cuda_error(cudaErrorInvalidConfiguration);
+        return;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    thread_pool &pool = thread_pool::global();
+    const std::ptrdiff_t grain = std::max<std::ptrdiff_t>(1, detail::launch_grain / std::ptrdiff_t(per_block));
+    record.cpu_threads = detail::pool_threads(pool, std::ptrdiff_t(blocks), grain);
+    parallel_for_blocks(
+        pool, 0, std::ptrdiff_t(blocks),
+        [&](std::ptrdiff_t lo, std::ptrdiff_t hi) {
+            blockDim = block;
+            gridDim = grid;
+            for (std::ptrdiff_t b = lo; b < hi; b++)
+            {
+                blockIdx = {unsigned(b % grid.x), unsigned(b / grid.x % grid.y), unsigned(b / grid.x / grid.y)};
+                for (unsigned z = 0; z < block.z; z++)
+                    for (unsigned y = 0; y < block.y; y++)
+                        for (unsigned x = 0; x < block.x; x++)
+                        {
+                            threadIdx = {x, y, z};
+                            Kernel(args...);
+                        }
+            }
+        },
+        grain);
+    record.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+#endif
+    detail::report_launch(record);
+}
+
+} // namespace hpc
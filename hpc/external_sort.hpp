@@ -0,0 +1,425 @@
+/*
+ * External-Memory Parallel Sort (header-only) using OpenMP
+ * =======================================================
+ *
+ * Sorts a binary file of fixed-size records that does not fit in RAM.
+ *
+ * USAGE:
+ *
+ *   #include "external_sort.hpp"
+ *
+ *   hpc::external_sort_options opts;
+ *   opts.memory_budget = size_t(2) << 30;          // 2 GiB
+ *   opts.temp_dir = "/scratch/tmp";
+ *   hpc::external_sort_stats stats = hpc::external_sort<long long>("batch.bin", "batch.sorted.bin", opts);
+ *   stats.print(cout);
+ *
+ * COMPILATION:
+ *   g++ -std=c++20 -O2 -fopenmp -o program program.cpp
+ *
+ * ALGORITHM:
+ * ---------
+ * 1. Run formation: the input is streamed in chunks; each chunk is sorted in memory with
+ *    hpc::parallel_sort and written out as a sorted run. Two chunk buffers alternate:
+ *    while one is being sorted, a background thread writes the previous run from the
+ *    other buffer and reads the next chunk into it (double-buffered asynchronous I/O).
+ * 2. Merge: up to `fan_in` runs are merged at once with a loser tree (k-1 comparisons
+ *    spread over log2(k) levels per output record). If there are more runs than the
+ *    memory budget can give a read buffer each, intermediate merge passes combine groups
+ *    of runs into longer runs first. Output is written with a double-buffered async writer.
+ *
+ * MEMORY BUDGET:
+ * -------------
+ * - Run formation uses three chunk-sized areas: two I/O buffers plus the scratch buffer
+ *   of the in-memory sort engine, so each chunk is memory_budget / 3 bytes.
+ * - A merge of k runs gives each run memory_budget / (k + 2) bytes of read buffer; the
+ *   remaining two shares are the output double buffer.
+ *
+ * ERROR HANDLING:
+ * --------------
+ * - I/O failures throw std::runtime_error. Temporary run files are removed on success.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <ostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "parallel_sort.hpp"
+
+namespace hpc
+{
+
+struct external_sort_options
+{
+    std::size_t memory_budget = std::size_t(256) << 20;                      // bytes
+    std::filesystem::path temp_dir = std::filesystem::temp_directory_path(); // sorted runs go here
+    std::size_t min_block_bytes = std::size_t(1) << 20;                      // smallest read buffer per run when merging
+};
+
+struct external_sort_stats
+{
+    std::size_t records = 0;
+    std::size_t runs = 0;        // sorted runs produced by run formation
+    int passes = 0;              // passes over the data: run formation + every merge pass
+    std::size_t bytes_read = 0;
+    std::size_t bytes_written = 0;
+    double run_seconds = 0;      // run formation wall time
+    double merge_seconds = 0;    // all merge passes wall time
+
+    double seconds() const { return run_seconds + merge_seconds; }
+
+    // Bytes read plus bytes written per second of wall time, in MB/s.
+    double io_bandwidth() const
+    {
+        return seconds() > 0 ? (bytes_read + bytes_written) / seconds() / 1e6 : 0.0;
+    }
+
+    void print(std::ostream &os) const
+    {
+        os << "Records: " << records << "\n"
+           << "Sorted runs: " << runs << "\n"
+           << "Passes over data: " << passes << " (1 run formation + " << passes - 1 << " merge)\n"
+           << "Run formation time: " << run_seconds << " seconds\n"
+           << "Merge time: " << merge_seconds << " seconds\n"
+           << "Bytes read: " << bytes_read << ", bytes written: " << bytes_written << "\n"
+           << "I/O bandwidth: " << io_bandwidth() << " MB/s\n";
+    }
+};
+
+namespace detail
+{
+
+inline double seconds_since(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+template <class T>
+std::size_t read_records(std::ifstream &in, std::vector<T> &buffer, std::size_t capacity)
+{
+    in.read(reinterpret_cast<char *>(buffer.data()), capacity * sizeof(T));
+    if (in.bad())
+        throw std::runtime_error("external_sort: read failed");
+    return static_cast<std::size_t>(in.gcount()) / sizeof(T);
+}
+
+template <class T>
+void write_records(const std::filesystem::path &path, const std::vector<T> &buffer, std::size_t count)
+{
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char *>(buffer.data()), count * sizeof(T));
+    if (!out)
+        throw std::runtime_error("external_sort: cannot write " + path.string());
+}
+
+// Sequential reader over one sorted run with a fixed-size block buffer.
+template <class T>
+class run_reader
+{
+public:
+    run_reader(const std::filesystem::path &path, std::size_t block_records)
+        : in_(path, std::ios::binary), buffer_(std::max<std::size_t>(block_records, 1))
+    {
+        if (!in_)
+            throw std::runtime_error("external_sort: cannot open run " + path.string());
+        refill();
+    }
+
+    bool empty() const { return pos_ == len_; }
+    const T &front() const { return buffer_[pos_]; }
+    std::size_t bytes_read() const { return bytes_read_; }
+
+    void pop()
+    {
+        if (++pos_ == len_)
+            refill();
+    }
+
+private:
+    void refill()
+    {
+        len_ = read_records(in_, buffer_, buffer_.size());
+        pos_ = 0;
+        bytes_read_ += len_ * sizeof(T);
+    }
+
+    std::ifstream in_;
+    std::vector<T> buffer_;
+    std::size_t pos_ = 0;
+    std::size_t len_ = 0;
+    std::size_t bytes_read_ = 0;
+};
+
+// Appends records to a file; a full block is handed to a background write while the
+// other block keeps filling.
+template <class T>
+class async_writer
+{
+public:
+    async_writer(const std::filesystem::path &path, std::size_t block_records)
+        : out_(path, std::ios::binary | std::ios::trunc), block_(std::max<std::size_t>(block_records, 1))
+    {
+        if (!out_)
+            throw std::runtime_error("external_sort: cannot create " + path.string());
+        active_.reserve(block_);
+        flushing_.reserve(block_);
+    }
+
+    ~async_writer()
+    {
+        if (pending_.valid())
+            pending_.wait();
+    }
+
+    void push(const T &value)
+    {
+        active_.push_back(value);
+        if (active_.size() == block_)
+            flush();
+    }
+
+    void close()
+    {
+        flush();
+        pending_.get();
+        out_.close();
+        if (!out_)
+            throw std::runtime_error("external_sort: write failed");
+    }
+
+    std::size_t bytes_written() const { return bytes_written_; }
+
+private:
+    void flush()
+    {
+        if (pending_.valid())
+            pending_.get();
+        std::swap(active_, flushing_);
+        active_.clear();
+        bytes_written_ += flushing_.size() * sizeof(T);
+        pending_ = std::async(std::launch::async, [this] {
+            out_.write(reinterpret_cast<const char *>(flushing_.data()), flushing_.size() * sizeof(T));
+            if (!out_)
+                throw std::runtime_error("external_sort: write failed");
+        });
+    }
+
+    std::ofstream out_;
+    std::size_t block_;
+    std::vector<T> active_, flushing_;
+    std::future<void> pending_;
+    std::size_t bytes_written_ = 0;
+};
+
+// Tournament tree of losers over k run readers. tree_[0] holds the current winner;
+// internal node i holds the loser of the match played there.
+template <class T, class Less>
+class loser_tree
+{
+public:
+    loser_tree(std::vector<run_reader<T>> &runs, const Less &less)
+        : runs_(runs), less_(less), k_(static_cast<int>(runs.size())), tree_(std::max(k_, 1))
+    {
+        tree_[0] = k_ == 1 ? 0 : build(1);
+    }
+
+    bool empty() const { return runs_[tree_[0]].empty(); }
+    const T &top() const { return runs_[tree_[0]].front(); }
+
+    void pop()
+    {
+        int winner = tree_[0];
+        runs_[winner].pop();
+        for (int node = (winner + k_) / 2; node >= 1; node /= 2)
+            if (beats(tree_[node], winner))
+                std::swap(tree_[node], winner);
+        tree_[0] = winner;
+    }
+
+private:
+    // True if run a's head goes out before run b's. Exhausted runs lose every match and
+    // ties go to the lower run index, which keeps the merge stable.
+    bool beats(int a, int b) const
+    {
+        if (runs_[a].empty())
+            return false;
+        if (runs_[b].empty())
+            return true;
+        if (less_(runs_[a].front(), runs_[b].front()))
+            return true;
+        if (less_(runs_[b].front(), runs_[a].front()))
+            return false;
+        return a < b;
+    }
+
+    // Leaves are nodes k..2k-1 (leaf i is run i - k); returns the winner of the subtree.
+    int build(int node)
+    {
+        if (node >= k_)
+            return node - k_;
+        int left = build(2 * node);
+        int right = build(2 * node + 1);
+        if (beats(left, right))
+        {
+            tree_[node] = right;
+            return left;
+        }
+        tree_[node] = left;
+        return right;
+    }
+
+    std::vector<run_reader<T>> &runs_;
+    Less less_;
+    int k_;
+    std::vector<int> tree_;
+};
+
+template <class T, class Less>
+void merge_runs(const std::vector<std::filesystem::path> &inputs, const std::filesystem::path &output,
+                std::size_t memory_budget, const Less &less, external_sort_stats &stats)
+{
+    const std::size_t share = std::max<std::size_t>(memory_budget / (inputs.size() + 2) / sizeof(T), 1);
+
+    std::vector<run_reader<T>> runs;
+    runs.reserve(inputs.size());
+    for (const auto &path : inputs)
+        runs.emplace_back(path, share);
+
+    async_writer<T> writer(output, share);
+    loser_tree<T, Less> tree(runs, less);
+    while (!tree.empty())
+    {
+        writer.push(tree.top());
+        tree.pop();
+    }
+    writer.close();
+
+    for (const auto &run : runs)
+        stats.bytes_read += run.bytes_read();
+    stats.bytes_written += writer.bytes_written();
+}
+
+} // namespace detail
+
+// Sorts the records of type T in `input` (raw binary, native layout) into `output`.
+template <class T, class Compare = std::less<>, class KeyFn = identity_key>
+external_sort_stats external_sort(const std::filesystem::path &input, const std::filesystem::path &output,
+                                  const external_sort_options &opts = {}, Compare comp = {}, KeyFn key = {})
+{
+    static_assert(std::is_trivially_copyable_v<T>, "external_sort writes records as raw bytes");
+    namespace fs = std::filesystem;
+
+    external_sort_stats stats;
+    const std::uintmax_t file_bytes = fs::file_size(input);
+    if (file_bytes % sizeof(T) != 0)
+        throw std::runtime_error("external_sort: file size is not a multiple of the record size");
+    stats.records = file_bytes / sizeof(T);
+
+    std::ifstream in(input, std::ios::binary);
+    if (!in)
+        throw std::runtime_error("external_sort: cannot open " + input.string());
+
+    // Unique prefix so concurrent sorts can share a temp directory.
+    const std::string prefix = "hpc_extsort_" + std::to_string(std::random_device{}()) + "_";
+    int run_id = 0;
+    auto run_path = [&] { return opts.temp_dir / (prefix + std::to_string(run_id++) + ".run"); };
+
+    // ---- Run formation --------------------------------------------------------------
+    auto start = std::chrono::steady_clock::now();
+    const std::size_t chunk = std::max<std::size_t>(opts.memory_budget / 3 / sizeof(T), 1);
+    std::vector<T> current(chunk), other(chunk);
+    std::vector<fs::path> runs;
+
+    std::size_t current_len = detail::read_records(in, current, chunk);
+    stats.bytes_read += current_len * sizeof(T);
+    std::size_t other_len = 0;
+    std::future<void> io = std::async(std::launch::async, [&] {
+        other_len = detail::read_records(in, other, chunk);
+    });
+
+    while (current_len > 0)
+    {
+        parallel_sort(current.begin(), current.begin() + current_len, comp, key);
+
+        io.get();
+        stats.bytes_read += other_len * sizeof(T);
+        fs::path path = run_path();
+        runs.push_back(path);
+        stats.bytes_written += current_len * sizeof(T);
+
+        // `current` becomes the I/O buffer: write its run, then load the chunk after next.
+        std::swap(current, other);
+        std::swap(current_len, other_len);
+        io = std::async(std::launch::async, [&, path, len = other_len] {
+            detail::write_records(path, other, len);
+            other_len = detail::read_records(in, other, chunk);
+        });
+    }
+    io.get();
+    std::vector<T>().swap(current);
+    std::vector<T>().swap(other);
+    stats.runs = runs.size();
+    stats.passes = 1;
+    stats.run_seconds = detail::seconds_since(start);
+
+    // ---- Merge passes ---------------------------------------------------------------
+    start = std::chrono::steady_clock::now();
+    const detail::key_compare<Compare, KeyFn> less{comp, key};
+    const std::size_t fan_in = std::max<std::size_t>(opts.memory_budget / opts.min_block_bytes, 4) - 2;
+
+    while (runs.size() > fan_in)
+    {
+        std::vector<fs::path> next;
+        for (std::size_t i = 0; i < runs.size(); i += fan_in)
+        {
+            std::vector<fs::path> group(runs.begin() + i, runs.begin() + std::min(i + fan_in, runs.size()));
+            fs::path path = run_path();
+            detail::merge_runs<T>(group, path, opts.memory_budget, less, stats);
+            for (const auto &p : group)
+                fs::remove(p);
+            next.push_back(path);
+        }
+        runs.swap(next);
+        stats.passes++;
+    }
+
+    if (runs.empty())
+    {
+        std::ofstream empty(output, std::ios::binary | std::ios::trunc);
+        if (!empty)
+            throw std::runtime_error("external_sort: cannot create " + output.string());
+    }
+    else if (runs.size() == 1)
+    {
+        // Already one sorted run: move it into place instead of copying it.
+        std::error_code ec;
+        fs::rename(runs[0], output, ec);
+        if (ec)
+        {
+            fs::copy_file(runs[0], output, fs::copy_options::overwrite_existing);
+            fs::remove(runs[0]);
+        }
+    }
+    else
+    {
+        detail::merge_runs<T>(runs, output, opts.memory_budget, less, stats);
+        for (const auto &p : runs)
+            fs::remove(p);
+        stats.passes++;
+    }
+    stats.merge_seconds = detail::seconds_since(start);
+    return stats;
+}
+
+} // namespace hpc
@@ -0,0 +1,210 @@
+/*
+ * Fused Single-Pass Statistics Benchmark using fused_stats.hpp
+ * ============================================================
+ *
+ * COMPILATION & EXECUTION:
+ *
+ * For Ubuntu:
+ * -----------
+ * g++ -std=c++20 -O2 -fopenmp -o fused_stats fused_stats.cpp
+ * ./fused_stats
+ *
+ * For macOS:
+ * ----------
+ * g++ -std=c++20 -O2 -Xpreprocessor -fopenmp -I"$(brew --prefix libomp)/include" -L"$(brew --prefix libomp)/lib" -lomp -o fused_stats fused_stats.cpp
+ * ./fused_stats
+ *
+ * THEORETICAL CONCEPTS:
+ *
+ * Why fuse:
+ * --------
+ * - min, max and sum each do one comparison or add per element, far less than the time to
+ *   load that element from DRAM, so each loop runs at memory speed, not compute speed
+ * - MIN_MAX_mine.cpp runs parallelMin, parallelMax, parallelSum and parallelAvg (which calls
+ *   parallelSum again): four passes over the array and four fork/joins
+ * - Reading the data once and updating all results from the same register does the same
+ *   arithmetic for a quarter of the memory traffic
+ *
+ * SIMD Lanes:
+ * ----------
+ * - AVX2 holds 8 ints per register, AVX-512 holds 16; one instruction updates all lanes
+ * - The sum lanes are widened to 64 bits, because a 32-bit int sum overflows once the
+ *   array sum passes 2^31 (ops.cpp's int sum is wrong from about 4 million elements)
+ * - The kernel is picked at run time with __builtin_cpu_supports, so one binary runs
+ *   everywhere and still uses AVX-512 where it exists
+ *
+ * Bandwidth:
+ * ---------
+ * - GB/s = array bytes / time. A memory-bound kernel is as fast as it can be once that is
+ *   close to the machine's peak memory bandwidth
+ * - Enter the peak from the hardware spec (channels x MT/s x 8 bytes), or 0 to measure a
+ *   parallel memcpy (read + write bytes) as the reference instead
+ *
+ * SAMPLE INPUT/OUTPUT:
+ * ------------------
+ *
+ * Input:
+ *   100000000                    (Number of elements)
+ *   0                            (Peak memory bandwidth in GB/s, 0 = measure)
+ *
+ * Output (single core, so every speedup here comes from fewer passes and wider lanes):
+ *   Measured copy bandwidth: 14.61 GB/s
+ *   Threads: 1, SIMD: AVX-512
+ *
+ *   4 separate passes       0.396433 s      1.01 GB/s    6.91% of peak
+ *   fused, scalar           0.116209 s      3.44 GB/s   23.56% of peak
+ *   fused, AVX2             0.055640 s      7.19 GB/s   49.21% of peak
+ *   fused, AVX-512          0.049914 s      8.01 GB/s   54.85% of peak
+ *
+ *   Min: -1000000
+ *   Max: 1000000
+ *   Sum: -20539065113
+ *   Average: -205.3907
+ *   Count: 100000000
+ *   All kernels agree: yes
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <cstring>
+#include <string>
+#include <algorithm>
+#include <omp.h>
+#include "fused_stats.hpp"
+using namespace std;
+
+// Four separate passes, as in MIN_MAX_mine.cpp (with a 64-bit sum so the results compare)
+int parallelMin(const int nums[], int length)
+{
+    int minVal = nums[0];
+#pragma omp parallel for reduction(min : minVal)
+    for (int i = 0; i < length; i++)
+        minVal = (nums[i] < minVal) ? nums[i] : minVal;
+    return minVal;
+}
+
+int parallelMax(const int nums[], int length)
+{
+    int maxVal = nums[0];
+#pragma omp parallel for reduction(max : maxVal)
+    for (int i = 0; i < length; i++)
+        maxVal = (nums[i] > maxVal) ? nums[i] : maxVal;
+    return maxVal;
+}
+
+long long parallelSum(const int nums[], int length)
+{
+    long long sum = 0;
+#pragma omp parallel for reduction(+ : sum)
+    for (int i = 0; i < length; i++)
+        sum += nums[i];
+    return sum;
+}
+
+double parallelAvg(const int nums[], int length)
+{
+    return static_cast<double>(parallelSum(nums, length)) / length;
+}
+
+// Best-of-5 time of fn
+template <class Fn>
+double bestTime(const Fn &fn)
+{
+    double best = 1e30;
+    for (int rep = 0; rep < 5; rep++)
+    {
+        double start = omp_get_wtime();
+        fn();
+        best = min(best, omp_get_wtime() - start);
+    }
+    return best;
+}
+
+// Parallel memcpy of `bytes`, counting read + write traffic
+double measureCopyBandwidth(size_t bytes)
+{
+    vector<char> src(bytes, 1), dst(bytes, 0);
+    double t = bestTime([&] {
+#pragma omp parallel
+        {
+            size_t nt = omp_get_num_threads(), tid = omp_get_thread_num();
+            size_t lo = bytes * tid / nt, hi = bytes * (tid + 1) / nt;
+            memcpy(dst.data() + lo, src.data() + lo, hi - lo);
+        }
+    });
+    return 2.0 * bytes / t / 1e9;
+}
+
+void report(const char *name, double seconds, double bytes, double peak)
+{
+    double gbps = bytes / seconds / 1e9;
+    cout << left << setw(24) << name << right << fixed << setprecision(6) << seconds << " s  " << setprecision(2)
+         << setw(8) << gbps << " GB/s  " << setw(6) << 100.0 * gbps / peak << "% of peak" << endl;
+}
+
+int main()
+{
+    int length;
+    double peak;
+
+    cout << "Enter number of elements: ";
+    cin >> length;
+    cout << "Enter peak memory bandwidth in GB/s (0 to measure): ";
+    cin >> peak;
+
+    if (length <= 0)
+    {
+        cout << "Invalid array size!" << endl;
+        return 1;
+    }
+
+    vector<int> nums(length);
+    mt19937 rng(42);
+    for (int &x : nums)
+        x = static_cast<int>(rng() % 2000001) - 1000000;
+
+    if (peak <= 0)
+    {
+        peak = measureCopyBandwidth(max<size_t>(nums.size() * sizeof(int), size_t(64) << 20));
+        cout << "\nMeasured copy bandwidth: " << fixed << setprecision(2) << peak << " GB/s" << endl;
+    }
+    cout << "Threads: " << omp_get_max_threads() << ", SIMD: " << hpc::simd_level_name(hpc::detected_simd_level())
+         << "\n" << endl;
+
+    const double bytes = double(length) * sizeof(int);
+    int pMin = 0, pMax = 0;
+    long long pSum = 0;
+    double pAvg = 0;
+    double tSeparate = bestTime([&] {
+        pMin = parallelMin(nums.data(), length);
+        pMax = parallelMax(nums.data(), length);
+        pSum = parallelSum(nums.data(), length);
+        pAvg = parallelAvg(nums.data(), length);
+    });
+    report("4 separate passes", tSeparate, bytes, peak);
+
+    hpc::int_stats fused[3];
+    const hpc::simd_level levels[3] = {hpc::simd_level::scalar, hpc::simd_level::avx2, hpc::simd_level::avx512};
+    for (int l = 0; l < 3; l++)
+    {
+        if (levels[l] > hpc::detected_simd_level())
+            continue;
+        double t = bestTime([&] { fused[l] = hpc::fused_stats(nums.data(), nums.size(), levels[l]); });
+        string name = string("fused, ") + hpc::simd_level_name(levels[l]);
+        report(name.c_str(), t, bytes, peak);
+    }
+
+    const hpc::int_stats &s = fused[0];
+    cout << "\nMin: " << s.min << "\nMax: " << s.max << "\nSum: " << s.sum << "\nAverage: " << setprecision(4)
+         << s.mean() << "\nCount: " << s.count << endl;
+
+    bool match = s.min == pMin && s.max == pMax && s.sum == pSum && s.mean() == pAvg;
+    for (int l = 1; l < 3; l++)
+        if (levels[l] <= hpc::detected_simd_level())
+            match = match && fused[l].min == s.min && fused[l].max == s.max && fused[l].sum == s.sum &&
+                    fused[l].count == s.count;
+    cout << "All kernels agree: " << (match ? "yes" : "no") << endl;
+    return 0;
+}
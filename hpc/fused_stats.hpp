@@ -0,0 +1,248 @@
+/*
+ * Fused Min / Max / Sum / Mean / Count Kernel (header-only) using OpenMP and SIMD
+ * ===============================================================================
+ *
+ * ops.cpp, min_max.cpp and MIN_MAX_mine.cpp compute min, max, sum and average with one
+ * parallel loop each, so the array is streamed from memory four times. This kernel reads
+ * every element once and updates all statistics from the same register.
+ *
+ * USAGE:
+ *
+ *   #include "fused_stats.hpp"
+ *
+ *   hpc::int_stats s = hpc::fused_stats(nums, length);
+ *   cout << s.min << " " << s.max << " " << s.sum << " " << s.mean() << " " << s.count;
+ *
+ *   hpc::fused_stats(nums, length, hpc::simd_level::scalar);   // force a kernel
+ *
+ * COMPILATION:
+ *   g++ -std=c++20 -O2 -fopenmp -o program program.cpp
+ *
+ * No -mavx2 / -mavx512f needed: the SIMD kernels are compiled with per-function target
+ * attributes, and the best one the CPU supports is picked at run time. On non-x86
+ * machines only the scalar kernel exists.
+ *
+ * KERNELS:
+ * -------
+ * - AVX-512: 16 int32 lanes per load; min/max on int32 lanes, and each half is widened to
+ *   8 int64 lanes for the sum, so the sum cannot overflow (ops.cpp sums into an int).
+ * - AVX2: the same with 8 int32 lanes and 4 int64 lanes.
+ * - Scalar: plain loop with a 64-bit sum.
+ * Every thread runs the kernel over its own contiguous slice; the per-thread results sit
+ * on separate cache lines and are combined once at the end.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <omp.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HPC_X86_SIMD 1
+#endif
+
+namespace hpc
+{
+
+struct int_stats
+{
+    int min = INT_MAX;
+    int max = INT_MIN;
+    long long sum = 0;
+    std::size_t count = 0;
+
+    double mean() const { return count ? static_cast<double>(sum) / count : 0.0; }
+};
+
+enum class simd_level
+{
+    scalar,
+    avx2,
+    avx512
+};
+
+inline const char *simd_level_name(simd_level level)
+{
+    switch (level)
+    {
+    case simd_level::avx512:
+        return "AVX-512";
+    case simd_level::avx2:
+        return "AVX2";
+    default:
+        return "scalar";
+    }
+}
+
+// Widest instruction set this CPU supports (checked once).
+inline simd_level detected_simd_level()
+{
+#ifdef HPC_X86_SIMD
+    static const simd_level level = __builtin_cpu_supports("avx512f")  ? simd_level::avx512
+                                    : __builtin_cpu_supports("avx2") ? simd_level::avx2
+                                                                     : simd_level::scalar;
+    return level;
+#else
+    return simd_level::scalar;
+#endif
+}
+
+namespace detail
+{
+
+// Each thread gets at least this many elements (64 KB).
+constexpr std::size_t stats_grain = 1 << 14;
+
+inline int_stats combine_stats(int_stats a, const int_stats &b)
+{
+    a.min = std::min(a.min, b.min);
+    a.max = std::max(a.max, b.max);
+    a.sum += b.sum;
+    a.count += b.count;
+    return a;
+}
+
+inline int_stats stats_scalar(const int *data, std::size_t n)
+{
+    int_stats s;
+    for (std::size_t i = 0; i < n; i++)
+    {
+        s.min = std::min(s.min, data[i]);
+        s.max = std::max(s.max, data[i]);
+        s.sum += data[i];
+    }
+    s.count = n;
+    return s;
+}
+
+#ifdef HPC_X86_SIMD
+
+__attribute__((target("avx2"))) inline int_stats stats_avx2(const int *data, std::size_t n)
+{
+    __m256i vmin = _mm256_set1_epi32(INT_MAX);
+    __m256i vmax = _mm256_set1_epi32(INT_MIN);
+    __m256i sum_lo = _mm256_setzero_si256(), sum_hi = _mm256_setzero_si256();
+
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+        vmin = _mm256_min_epi32(vmin, v);
+        vmax = _mm256_max_epi32(vmax, v);
+        sum_lo = _mm256_add_epi64(sum_lo, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(v)));
+        sum_hi = _mm256_add_epi64(sum_hi, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(v, 1)));
+    }
+
+    alignas(32) int mins[8], maxs[8];
+    alignas(32) long long sums[4];
+    _mm256_store_si256(reinterpret_cast<__m256i *>(mins), vmin);
+    _mm256_store_si256(reinterpret_cast<__m256i *>(maxs), vmax);
+    _mm256_store_si256(reinterpret_cast<__m256i *>(sums), _mm256_add_epi64(sum_lo, sum_hi));
+
+    int_stats s = stats_scalar(data + i, n - i);
+    for (int lane = 0; lane < 8; lane++)
+    {
+        s.min = std::min(s.min, mins[lane]);
+        s.max = std::max(s.max, maxs[lane]);
+    }
+    for (int lane = 0; lane < 4; lane++)
+        s.sum += sums[lane];
+    s.count = n;
+    return s;
+}
+
+// GCC 12's avx512fintrin.h trips -Wmaybe-uninitialized on its own _mm512_undefined_epi32.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+__attribute__((target("avx512f"))) inline int_stats stats_avx512(const int *data, std::size_t n)
+{
+    __m512i vmin = _mm512_set1_epi32(INT_MAX);
+    __m512i vmax = _mm512_set1_epi32(INT_MIN);
+    __m512i sum_lo = _mm512_setzero_si512(), sum_hi = _mm512_setzero_si512();
+
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        __m512i v = _mm512_loadu_si512(data + i);
+        vmin = _mm512_min_epi32(vmin, v);
+        vmax = _mm512_max_epi32(vmax, v);
+        sum_lo = _mm512_add_epi64(sum_lo, _mm512_cvtepi32_epi64(_mm512_castsi512_si256(v)));
+        sum_hi = _mm512_add_epi64(sum_hi, _mm512_cvtepi32_epi64(_mm512_extracti64x4_epi64(v, 1)));
+    }
+
+    alignas(64) int mins[16], maxs[16];
+    alignas(64) long long sums[8];
+    _mm512_store_si512(mins, vmin);
+    _mm512_store_si512(maxs, vmax);
+    _mm512_store_si512(sums, _mm512_add_epi64(sum_lo, sum_hi));
+
+    int_stats s = stats_scalar(data + i, n - i);
+    for (int lane = 0; lane < 16; lane++)
+    {
+        s.min = std::min(s.min, mins[lane]);
+        s.max = std::max(s.max, maxs[lane]);
+    }
+    for (int lane = 0; lane < 8; lane++)
+        s.sum += sums[lane];
+    s.count = n;
+    return s;
+}
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#endif
+
+inline int_stats stats_kernel(const int *data, std::size_t n, simd_level level)
+{
+#ifdef HPC_X86_SIMD
+    if (level == simd_level::avx512)
+        return stats_avx512(data, n);
+    if (level == simd_level::avx2)
+        return stats_avx2(data, n);
+#endif
+    return stats_scalar(data, n);
+}
+
+// One thread's partial result alone on a cache line.
+struct alignas(64) padded_stats
+{
+    int_stats value;
+};
+
+} // namespace detail
+
+// Min, max, 64-bit sum and count of data[0 .. n) in one parallel pass. A level the CPU
+// does not support falls back to the detected one.
+inline int_stats fused_stats(const int *data, std::size_t n, simd_level level = detected_simd_level())
+{
+    level = std::min(level, detected_simd_level());
+    const int threads = static_cast<int>(
+        std::clamp<std::size_t>(n / detail::stats_grain, 1, static_cast<std::size_t>(omp_get_max_threads())));
+    if (threads == 1)
+        return detail::stats_kernel(data, n, level);
+
+    std::vector<detail::padded_stats> partial(threads);
+#pragma omp parallel num_threads(threads)
+    {
+        const std::size_t nt = omp_get_num_threads();
+        const std::size_t t = omp_get_thread_num();
+        // Slice boundaries rounded to 16 elements so every vector load stays aligned alike.
+        const std::size_t begin = (n * t / nt) & ~std::size_t(15);
+        const std::size_t end = t + 1 == nt ? n : (n * (t + 1) / nt) & ~std::size_t(15);
+        partial[t].value = detail::stats_kernel(data + begin, end - begin, level);
+    }
+
+    int_stats total;
+    for (const detail::padded_stats &p : partial)
+        total = detail::combine_stats(total, p.value);
+    return total;
+}
+
+} // namespace hpc
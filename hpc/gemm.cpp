@@ -0,0 +1,184 @@
+/*
+ * Cache-Blocked SIMD Matrix Multiplication on the CPU using gemm.hpp
+ * ==================================================================
+ *
+ * COMPILATION & EXECUTION:
+ *
+ * For Ubuntu:
+ * -----------
+ * g++ -std=c++20 -O2 -fopenmp -o gemm gemm.cpp
+ * ./gemm
+ *
+ * For macOS:
+ * ----------
+ * g++ -std=c++20 -O2 -Xpreprocessor -fopenmp -I"$(brew --prefix libomp)/include" -L"$(brew --prefix libomp)/lib" -lomp -o gemm gemm.cpp
+ * ./gemm
+ *
+ * THEORETICAL CONCEPTS:
+ *
+ * From One Thread per Element to Blocked GEMM:
+ * -------------------------------------------
+ * - matrix_mul.cu gives each GPU thread one C[row][col] and a k-loop over a row of A and
+ *   a column of B. On a CPU the same loop (i-j-k) walks B column-wise: every access is a
+ *   cache miss, and each loaded element is used once
+ * - Reordering to i-k-j (the OpenMP baseline below) makes the inner loop unit-stride and
+ *   vectorizable, but still streams all of B through the cache for every row of A
+ * - GEMM does 2mnk flops on mk + kn + mn data, so each element could be reused up to
+ *   n times. Blocking for registers, L1, L2 and L3 is what turns that reuse into speed
+ *
+ * Register Blocking:
+ * -----------------
+ * - The micro-kernel keeps a 12 x 32 tile of C in 24 AVX-512 registers. Each step loads
+ *   2 vectors of B, broadcasts 12 values of A and issues 24 FMAs: 14 loads per 24 FMAs
+ *   instead of 2 loads per FMA, so the FMA units, not the loads, set the pace
+ *
+ * Peak:
+ * ----
+ * - Peak = cores x clock x FMA units x SIMD lanes x 2 (a fused multiply-add is 2 flops)
+ * - Measured here by running independent FMA chains in the same registers, so it includes
+ *   the clock the CPU really holds under AVX-512 load. int32 uses mullo + add (no integer
+ *   FMA), which issues on fewer ports and has a lower peak
+ *
+ * SAMPLE INPUT/OUTPUT:
+ * ------------------
+ *
+ * Input:
+ *   1024                         (Matrix size n)
+ *
+ * Output (single core, AVX-512; a shared VM, so the peak itself moves by ~10% between runs):
+ *   Threads: 1, kernels: AVX-512
+ *   Measured peak (GFLOP/s): float 133.6, double 66.8, int32 42.4
+ *
+ *   Type    Shape (m x n, k)            i-k-j s  GFLOP/s     gemm s  GFLOP/s   of peak   check
+ *   float   square n x n x n             0.2365      9.1     0.0224     95.9     71.8%   match
+ *   float   tall   4n x n/4, k = n       0.1493     14.4     0.0221     97.2     72.8%   match
+ *   float   wide   n/4 x 4n, k = n       0.2957      7.3     0.0259     82.9     62.1%   match
+ *   float   rank-64 update  k = 64       0.0102     13.1     0.0013     99.6     74.6%   match
+ *   float   deep   n/4 x n/4, k = 8n     0.1137      9.4     0.0125     86.1     64.5%   match
+ *   double  square n x n x n             0.5078      4.2     0.0450     47.8     71.5%   match
+ *   double  tall   4n x n/4, k = n       0.4602      4.7     0.0420     51.2     76.6%   match
+ *   double  wide   n/4 x 4n, k = n       1.0753      2.0     0.0534     40.2     60.2%   match
+ *   double  rank-64 update  k = 64       0.0186      7.2     0.0038     34.9     52.2%   match
+ *   double  deep   n/4 x n/4, k = 8n     0.3578      3.0     0.0243     44.2     66.1%   match
+ *   int32   square n x n x n             0.3198      6.7     0.0520     41.3     97.6%   match
+ *   int32   tall   4n x n/4, k = n       0.3253      6.6     0.0521     41.2     97.3%   match
+ *   int32   wide   n/4 x 4n, k = n       0.4055      5.3     0.0586     36.7     86.5%   match
+ *   int32   rank-64 update  k = 64       0.0187      7.2     0.0036     37.6     88.7%   match
+ *   int32   deep   n/4 x n/4, k = 8n     0.1881      5.7     0.0282     38.1     89.9%   match
+ *
+ * Blocking is worth 10x over the vectorized i-k-j loop. The wide and double shapes lose
+ * the most: their B blocks are larger, so more time goes into packing per flop.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <omp.h>
+#include "gemm.hpp"
+#include "random.hpp"
+using namespace std;
+
+struct Shape
+{
+    string name;
+    size_t m, n, k;
+};
+
+// C = A * B, i-k-j order: a unit-stride, vectorized inner loop, but no blocking.
+template <class T>
+void baseline(const vector<T> &A, const vector<T> &B, vector<T> &C, size_t m, size_t n, size_t k)
+{
+#pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < m; i++)
+    {
+        T *c = &C[i * n];
+        for (size_t j = 0; j < n; j++)
+            c[j] = 0;
+        for (size_t p = 0; p < k; p++)
+        {
+            const T a = A[i * k + p];
+            const T *b = &B[p * n];
+#pragma omp simd
+            for (size_t j = 0; j < n; j++)
+                c[j] += a * b[j];
+        }
+    }
+}
+
+template <class T>
+vector<T> smallIntegers(size_t count, uint64_t seed)
+{
+    // Integers in [-4, 4]: every product and partial sum is exact in float and double,
+    // so the blocked result must match the baseline bit for bit whatever the order.
+    vector<int> v(count);
+    hpc::parallel_fill_uniform(v.begin(), v.end(), -4, 4, seed);
+    return vector<T>(v.begin(), v.end());
+}
+
+template <class T>
+void run(const string &type, const vector<Shape> &shapes, double peak)
+{
+    for (const Shape &s : shapes)
+    {
+        vector<T> A = smallIntegers<T>(s.m * s.k, 1), B = smallIntegers<T>(s.k * s.n, 2);
+        vector<T> C(s.m * s.n), R(s.m * s.n);
+        const double flops = 2.0 * s.m * s.n * s.k;
+
+        double start = omp_get_wtime();
+        baseline(A, B, R, s.m, s.n, s.k);
+        double tBase = omp_get_wtime() - start;
+
+        // Best of 3: the first call also pays for page faults on C and the packing buffers.
+        double tGemm = 1e30;
+        for (int rep = 0; rep < 3; rep++)
+        {
+            start = omp_get_wtime();
+            hpc::gemm(s.m, s.n, s.k, T(1), A.data(), s.k, B.data(), s.n, T(0), C.data(), s.n);
+            tGemm = min(tGemm, omp_get_wtime() - start);
+        }
+
+        cout << left << setw(8) << type << setw(26) << s.name << right << setprecision(4) << setw(9) << tBase
+             << setprecision(1) << setw(9) << flops / tBase / 1e9 << setprecision(4) << setw(11) << tGemm
+             << setprecision(1) << setw(9) << flops / tGemm / 1e9 << setw(9) << 100 * flops / tGemm / 1e9 / peak
+             << "%   " << (C == R ? "match" : "MISMATCH") << endl;
+    }
+}
+
+int main()
+{
+    size_t n;
+    cout << "Enter the matrix size: ";
+    cin >> n;
+
+    if (n < 8)
+    {
+        cout << "Invalid matrix size!" << endl;
+        return 1;
+    }
+
+    const int threads = omp_get_max_threads();
+    const hpc::simd_level level = hpc::detected_simd_level();
+    const double peak32 = hpc::simd_peak_gflops<float>(), peak64 = hpc::simd_peak_gflops<double>(),
+                 peakInt = hpc::simd_peak_gflops<int32_t>();
+    cout << fixed << setprecision(1);
+    cout << "\nThreads: " << threads << ", kernels: " << hpc::simd_level_name(level) << endl;
+    cout << "Measured peak (GFLOP/s): float " << peak32 << ", double " << peak64 << ", int32 " << peakInt << "\n"
+         << endl;
+
+    const vector<Shape> shapes = {
+        {"square n x n x n", n, n, n},
+        {"tall   4n x n/4, k = n", 4 * n, n / 4, n},
+        {"wide   n/4 x 4n, k = n", n / 4, 4 * n, n},
+        {"rank-64 update  k = 64", n, n, 64},
+        {"deep   n/4 x n/4, k = 8n", n / 4, n / 4, 8 * n},
+    };
+
+    cout << left << setw(8) << "Type" << setw(26) << "Shape (m x n, k)" << right << setw(9) << "i-k-j s" << setw(9)
+         << "GFLOP/s" << setw(11) << "gemm s" << setw(9) << "GFLOP/s" << setw(10) << "of peak" << "   check" << endl;
+    run<float>("float", shapes, peak32);
+    run<double>("double", shapes, peak64);
+    run<int32_t>("int32", shapes, peakInt);
+    return 0;
+}
@@ -0,0 +1,562 @@
+/*
+ * Cache-Blocked SIMD Multi-Threaded Matrix Multiply (header-only) using OpenMP
+ * ============================================================================
+ *
+ * C = alpha * A * B + beta * C for row-major int32, float and double matrices, in the
+ * style of GotoBLAS / BLIS: the operands are cut into blocks sized for each cache level,
+ * copied ("packed") into contiguous panels, and multiplied by a register-blocked SIMD
+ * micro-kernel that keeps an MR x NR tile of C in vector registers for the whole inner loop.
+ *
+ * USAGE:
+ *
+ *   #include "gemm.hpp"
+ *
+ *   hpc::matmul(A, B, C, n);                              // square: C = A * B
+ *   hpc::gemm(m, n, k, 1.0f, A, k, B, n, 0.0f, C, n);     // C (m x n) = A (m x k) * B (k x n)
+ *   hpc::gemm(m, n, k, 2.0, A, lda, B, ldb, 1.0, C, ldc); // C += 2 A B on sub-matrices
+ *   hpc::gemm(..., hpc::simd_level::avx2);                // force a kernel (capped at the CPU's)
+ *
+ * COMPILATION:
+ *   g++ -std=c++20 -O2 -fopenmp -o program program.cpp
+ * No -mavx2 / -mavx512f needed: the micro-kernels are compiled with per-function target
+ * attributes and picked at run time, as in fused_stats.hpp.
+ *
+ * ALGORITHM:
+ * ---------
+ *   for jc in N step NC:            B block  KC x NC  -> L3 (packed once, shared)
+ *     for pc in K step KC:
+ *       for ic in M step MC:        A block  MC x KC  -> L2 (packed per thread)
+ *         for jr in NC step NR:     B sliver KC x NR  -> L1
+ *           for ir in MC step MR:   micro-kernel: MR x NR tile of C in registers,
+ *                                   KC rank-1 updates (broadcast A, load B, FMA)
+ * - Packing turns strided row-major reads into unit-stride streams and pads edges with
+ *   zeros, so the micro-kernel never branches on the matrix shape.
+ * - beta is applied on the first KC block only; later blocks accumulate into C.
+ *
+ * MICRO-KERNELS (MR x NR):
+ * -----------------------
+ * - AVX-512: 12 x 32 float / int32, 12 x 16 double - 24 accumulators out of 32 registers
+ * - AVX2:    6 x 16 float / int32,  6 x 8 double  - 12 accumulators out of 16 registers
+ * - Scalar:  4 x 4, for other CPUs
+ * int32 has no FMA: it is mullo + add, which wraps on overflow like the CUDA kernel.
+ *
+ * PARALLELIZATION:
+ * ---------------
+ * - All threads pack the shared B block together, then share the (MC block, column group)
+ *   macro-tiles with a dynamic schedule. When M has fewer MC blocks than there are threads,
+ *   the columns are split into groups so every thread still gets a tile.
+ * - Threads: clamp(m * n * k / 2^18, 1, omp_get_max_threads()), so small products stay serial;
+ *   one when called from inside a parallel region that cannot nest.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <omp.h>
+#include "fused_stats.hpp"
+
+// The generic kernel templates take and return vector registers; GCC warns about their ABI
+// although they are only ever inlined into callers compiled for the right ISA. GCC 12's
+// avx512fintrin.h also trips -Wmaybe-uninitialized on its own _mm512_undefined_* values.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpsabi"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+namespace hpc
+{
+
+namespace detail
+{
+
+constexpr std::size_t gemm_grain = std::size_t(1) << 18;
+
+// Cache budgets for the packed blocks: A in half a 512 KB L2, B in a 4 MB slice of L3.
+constexpr std::size_t gemm_kc = 256;
+constexpr std::size_t gemm_l2_bytes = std::size_t(256) << 10;
+constexpr std::size_t gemm_l3_bytes = std::size_t(4) << 20;
+
+// One thread per gemm_grain multiply-adds, up to omp_get_max_threads(). Inside a region
+// that cannot nest (a strassen.hpp task, say) the team would be one thread anyway.
+inline int gemm_threads(double work)
+{
+    const int available = omp_get_active_level() < omp_get_max_active_levels() ? omp_get_max_threads() : 1;
+    return static_cast<int>(std::clamp<double>(work / gemm_grain, 1, available));
+}
+
+struct gemm_free
+{
+    void operator()(void *p) const { std::free(p); }
+};
+
+template <class T>
+std::unique_ptr<T, gemm_free> gemm_buffer(std::size_t count)
+{
+    const std::size_t bytes = (count * sizeof(T) + 63) / 64 * 64;
+    T *p = static_cast<T *>(std::aligned_alloc(64, std::max<std::size_t>(bytes, 64)));
+    if (!p)
+        throw std::bad_alloc();
+    return std::unique_ptr<T, gemm_free>(p);
+}
+
+// One "vector" of one element: the scalar kernel runs the same template as the SIMD ones.
+template <class T>
+struct scalar_vec
+{
+    using value_type = T;
+    using reg = T;
+    static constexpr int width = 1;
+    static reg zero() { return T(0); }
+    static reg set1(T x) { return x; }
+    static reg load(const T *p) { return *p; }
+    static void store(T *p, reg v) { *p = v; }
+    static reg mul(reg a, reg b) { return a * b; }
+    static reg fmadd(reg a, reg b, reg c) { return a * b + c; }
+};
+
+// Micro-kernel: acc(MR x NR) = sum over p < kc of a[p * MR + i] * b[p * NR + j], then
+// C = alpha * acc + beta * C on the m x n corner that lies inside the matrix.
+// Only ever instantiated inside a target-attributed, flattened caller.
+template <class V, int MR, int NV>
+inline void micro_tile(std::size_t kc, const typename V::value_type *a, const typename V::value_type *b,
+                       typename V::value_type *c, std::size_t ldc, typename V::value_type alpha,
+                       typename V::value_type beta, int m, int n)
+{
+    using T = typename V::value_type;
+    constexpr int W = V::width, NR = NV * W;
+    typename V::reg acc[MR][NV];
+
+#pragma GCC unroll 16
+    for (int i = 0; i < MR; i++)
+#pragma GCC unroll 4
+        for (int j = 0; j < NV; j++)
+            acc[i][j] = V::zero();
+
+    // The C tile is only touched after the kc loop; start fetching it now.
+    for (int i = 0; i < MR; i++)
+    {
+        __builtin_prefetch(c + i * ldc, 1);
+        __builtin_prefetch(c + i * ldc + NR - 1, 1);
+    }
+
+    for (std::size_t p = 0; p < kc; p++, a += MR, b += NR)
+    {
+        typename V::reg bv[NV];
+#pragma GCC unroll 4
+        for (int j = 0; j < NV; j++)
+            bv[j] = V::load(b + j * W);
+#pragma GCC unroll 16
+        for (int i = 0; i < MR; i++)
+        {
+            const typename V::reg av = V::set1(a[i]);
+#pragma GCC unroll 4
+            for (int j = 0; j < NV; j++)
+                acc[i][j] = V::fmadd(av, bv[j], acc[i][j]);
+        }
+    }
+
+    const typename V::reg va = V::set1(alpha), vb = V::set1(beta);
+    if (m == MR && n == NR)
+    {
+#pragma GCC unroll 16
+        for (int i = 0; i < MR; i++)
+#pragma GCC unroll 4
+            for (int j = 0; j < NV; j++)
+            {
+                T *out = c + i * ldc + j * W;
+                // beta == 0 must not read C: it may be uninitialized (or NaN).
+                V::store(out, beta == T(0) ? V::mul(va, acc[i][j]) : V::fmadd(vb, V::load(out), V::mul(va, acc[i][j])));
+            }
+        return;
+    }
+
+    alignas(64) T tile[MR * NR];
+#pragma GCC unroll 16
+    for (int i = 0; i < MR; i++)
+#pragma GCC unroll 4
+        for (int j = 0; j < NV; j++)
+            V::store(tile + i * NR + j * W, V::mul(va, acc[i][j]));
+    for (int i = 0; i < m; i++)
+        for (int j = 0; j < n; j++)
+            c[i * ldc + j] = beta == T(0) ? tile[i * NR + j] : tile[i * NR + j] + beta * c[i * ldc + j];
+}
+
+template <class T>
+struct scalar_gemm_kernel
+{
+    using value_type = T;
+    static constexpr int mr = 4, nr = 4;
+    static void tile(std::size_t kc, const T *a, const T *b, T *c, std::size_t ldc, T alpha, T beta, int m, int n)
+    {
+        micro_tile<scalar_vec<T>, mr, 4>(kc, a, b, c, ldc, alpha, beta, m, n);
+    }
+};
+
+#ifdef HPC_X86_SIMD
+
+// The vector wrappers are plain functions with the ISA as target attribute; they inline
+// into the flattened kernel entry points below, which carry the same attribute.
+
+struct avx2_f32
+{
+    using value_type = float;
+    using reg = __m256;
+    static constexpr int width = 8;
+    __attribute__((target("avx2,fma"))) static reg zero() { return _mm256_setzero_ps(); }
+    __attribute__((target("avx2,fma"))) static reg set1(float x) { return _mm256_set1_ps(x); }
+    __attribute__((target("avx2,fma"))) static reg load(const float *p) { return _mm256_loadu_ps(p); }
+    __attribute__((target("avx2,fma"))) static void store(float *p, reg v) { _mm256_storeu_ps(p, v); }
+    __attribute__((target("avx2,fma"))) static reg mul(reg a, reg b) { return _mm256_mul_ps(a, b); }
+    __attribute__((target("avx2,fma"))) static reg fmadd(reg a, reg b, reg c) { return _mm256_fmadd_ps(a, b, c); }
+};
+
+struct avx2_f64
+{
+    using value_type = double;
+    using reg = __m256d;
+    static constexpr int width = 4;
+    __attribute__((target("avx2,fma"))) static reg zero() { return _mm256_setzero_pd(); }
+    __attribute__((target("avx2,fma"))) static reg set1(double x) { return _mm256_set1_pd(x); }
+    __attribute__((target("avx2,fma"))) static reg load(const double *p) { return _mm256_loadu_pd(p); }
+    __attribute__((target("avx2,fma"))) static void store(double *p, reg v) { _mm256_storeu_pd(p, v); }
+    __attribute__((target("avx2,fma"))) static reg mul(reg a, reg b) { return _mm256_mul_pd(a, b); }
+    __attribute__((target("avx2,fma"))) static reg fmadd(reg a, reg b, reg c) { return _mm256_fmadd_pd(a, b, c); }
+};
+
+struct avx2_i32
+{
+    using value_type = std::int32_t;
+    using reg = __m256i;
+    static constexpr int width = 8;
+    __attribute__((target("avx2"))) static reg zero() { return _mm256_setzero_si256(); }
+    __attribute__((target("avx2"))) static reg set1(std::int32_t x) { return _mm256_set1_epi32(x); }
+    __attribute__((target("avx2"))) static reg load(const std::int32_t *p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)); }
+    __attribute__((target("avx2"))) static void store(std::int32_t *p, reg v) { _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), v); }
+    __attribute__((target("avx2"))) static reg mul(reg a, reg b) { return _mm256_mullo_epi32(a, b); }
+    __attribute__((target("avx2"))) static reg fmadd(reg a, reg b, reg c) { return _mm256_add_epi32(_mm256_mullo_epi32(a, b), c); }
+};
+
+struct avx512_f32
+{
+    using value_type = float;
+    using reg = __m512;
+    static constexpr int width = 16;
+    __attribute__((target("avx512f"))) static reg zero() { return _mm512_setzero_ps(); }
+    __attribute__((target("avx512f"))) static reg set1(float x) { return _mm512_set1_ps(x); }
+    __attribute__((target("avx512f"))) static reg load(const float *p) { return _mm512_loadu_ps(p); }
+    __attribute__((target("avx512f"))) static void store(float *p, reg v) { _mm512_storeu_ps(p, v); }
+    __attribute__((target("avx512f"))) static reg mul(reg a, reg b) { return _mm512_mul_ps(a, b); }
+    __attribute__((target("avx512f"))) static reg fmadd(reg a, reg b, reg c) { return _mm512_fmadd_ps(a, b, c); }
+};
+
+struct avx512_f64
+{
+    using value_type = double;
+    using reg = __m512d;
+    static constexpr int width = 8;
+    __attribute__((target("avx512f"))) static reg zero() { return _mm512_setzero_pd(); }
+    __attribute__((target("avx512f"))) static reg set1(double x) { return _mm512_set1_pd(x); }
+    __attribute__((target("avx512f"))) static reg load(const double *p) { return _mm512_loadu_pd(p); }
+    __attribute__((target("avx512f"))) static void store(double *p, reg v) { _mm512_storeu_pd(p, v); }
+    __attribute__((target("avx512f"))) static reg mul(reg a, reg b) { return _mm512_mul_pd(a, b); }
+    __attribute__((target("avx512f"))) static reg fmadd(reg a, reg b, reg c) { return _mm512_fmadd_pd(a, b, c); }
+};
+
+struct avx512_i32
+{
+    using value_type = std::int32_t;
+    using reg = __m512i;
+    static constexpr int width = 16;
+    __attribute__((target("avx512f"))) static reg zero() { return _mm512_setzero_si512(); }
+    __attribute__((target("avx512f"))) static reg set1(std::int32_t x) { return _mm512_set1_epi32(x); }
+    __attribute__((target("avx512f"))) static reg load(const std::int32_t *p) { return _mm512_loadu_si512(p); }
+    __attribute__((target("avx512f"))) static void store(std::int32_t *p, reg v) { _mm512_storeu_si512(p, v); }
+    __attribute__((target("avx512f"))) static reg mul(reg a, reg b) { return _mm512_mullo_epi32(a, b); }
+    __attribute__((target("avx512f"))) static reg fmadd(reg a, reg b, reg c) { return _mm512_add_epi32(_mm512_mullo_epi32(a, b), c); }
+};
+
+template <class V, int MR, int NV>
+struct avx2_gemm_kernel
+{
+    using value_type = typename V::value_type;
+    static constexpr int mr = MR, nr = NV * V::width;
+    __attribute__((target("avx2,fma"), flatten)) static void tile(std::size_t kc, const value_type *a,
+                                                                  const value_type *b, value_type *c,
+                                                                  std::size_t ldc, value_type alpha,
+                                                                  value_type beta, int m, int n)
+    {
+        micro_tile<V, MR, NV>(kc, a, b, c, ldc, alpha, beta, m, n);
+    }
+};
+
+template <class V, int MR, int NV>
+struct avx512_gemm_kernel
+{
+    using value_type = typename V::value_type;
+    static constexpr int mr = MR, nr = NV * V::width;
+    __attribute__((target("avx512f"), flatten)) static void tile(std::size_t kc, const value_type *a,
+                                                                 const value_type *b, value_type *c,
+                                                                 std::size_t ldc, value_type alpha,
+                                                                 value_type beta, int m, int n)
+    {
+        micro_tile<V, MR, NV>(kc, a, b, c, ldc, alpha, beta, m, n);
+    }
+};
+
+#endif // HPC_X86_SIMD
+
+// Copies rows [0, mc) x columns [0, kc) of A into MR-row panels, column by column:
+// panel r holds a[(r * MR + i) * lda + p] at r * MR * kc + p * MR + i, zero-padded.
+template <int MR, class T>
+void pack_a(std::size_t mc, std::size_t kc, const T *a, std::size_t lda, T *out)
+{
+    for (std::size_t r = 0; r < mc; r += MR, out += MR * kc)
+    {
+        const int rows = static_cast<int>(std::min<std::size_t>(MR, mc - r));
+        for (std::size_t p = 0; p < kc; p++)
+            for (int i = 0; i < MR; i++)
+                out[p * MR + i] = i < rows ? a[(r + i) * lda + p] : T(0);
+    }
+}
+
+// Copies columns [j, j + NR) of the kc x nc block of B into one NR-wide panel, row by row.
+template <int NR, class T>
+void pack_b_panel(std::size_t kc, std::size_t cols, const T *b, std::size_t ldb, T *out)
+{
+    for (std::size_t p = 0; p < kc; p++, out += NR)
+    {
+        const T *row = b + p * ldb;
+        for (std::size_t j = 0; j < cols; j++)
+            out[j] = row[j];
+        for (std::size_t j = cols; j < NR; j++)
+            out[j] = T(0);
+    }
+}
+
+template <class Kernel, class T = typename Kernel::value_type>
+void gemm_blocked(std::size_t m, std::size_t n, std::size_t k, T alpha, const T *a, std::size_t lda, const T *b,
+                  std::size_t ldb, T beta, T *c, std::size_t ldc)
+{
+    constexpr std::size_t MR = Kernel::mr, NR = Kernel::nr;
+    const std::size_t kc_max = std::min(gemm_kc, k);
+    const std::size_t nc_max = std::min(std::max(gemm_l3_bytes / (gemm_kc * sizeof(T)) / NR, std::size_t(1)) * NR,
+                                        (n + NR - 1) / NR * NR);
+    const int threads = gemm_threads(double(m) * double(n) * double(k));
+
+    // MC: fill half the L2, but shrink it so there are at least `threads` row blocks when M allows.
+    std::size_t mc = std::max(gemm_l2_bytes / (gemm_kc * sizeof(T)) / MR, std::size_t(1)) * MR;
+    mc = std::min(mc, std::max((m + threads - 1) / threads + MR - 1, MR) / MR * MR);
+    const std::size_t row_blocks = (m + mc - 1) / mc;
+
+    auto b_pack = gemm_buffer<T>(kc_max * nc_max);
+
+#pragma omp parallel num_threads(threads) if (threads > 1)
+    {
+        auto a_pack = gemm_buffer<T>(mc * kc_max);
+
+        for (std::size_t jc = 0; jc < n; jc += nc_max)
+        {
+            const std::size_t nc = std::min(nc_max, n - jc);
+            const std::size_t panels = (nc + NR - 1) / NR;
+            // Column groups per row block, so that row_blocks * groups >= threads.
+            const std::size_t groups = std::min(panels, (threads + row_blocks - 1) / row_blocks);
+
+            for (std::size_t pc = 0; pc < k; pc += kc_max)
+            {
+                const std::size_t kc = std::min(kc_max, k - pc);
+                const T beta_block = pc == 0 ? beta : T(1);
+
+#pragma omp for schedule(static)
+                for (std::size_t jp = 0; jp < panels; jp++)
+                    pack_b_panel<NR>(kc, std::min(NR, nc - jp * NR), b + pc * ldb + jc + jp * NR, ldb,
+                                     b_pack.get() + jp * NR * kc);
+
+                std::size_t packed = row_blocks; // row block currently in a_pack
+#pragma omp for schedule(dynamic)
+                for (std::size_t item = 0; item < row_blocks * groups; item++)
+                {
+                    const std::size_t ib = item / groups, g = item % groups;
+                    const std::size_t ic = ib * mc, mcur = std::min(mc, m - ic);
+                    if (packed != ib)
+                    {
+                        pack_a<MR>(mcur, kc, a + ic * lda + pc, lda, a_pack.get());
+                        packed = ib;
+                    }
+                    for (std::size_t jp = panels * g / groups; jp < panels * (g + 1) / groups; jp++)
+                        for (std::size_t ir = 0; ir < mcur; ir += MR)
+                            Kernel::tile(kc, a_pack.get() + ir * kc, b_pack.get() + jp * NR * kc,
+                                         c + (ic + ir) * ldc + jc + jp * NR, ldc, alpha, beta_block,
+                                         static_cast<int>(std::min(MR, mcur - ir)),
+                                         static_cast<int>(std::min(NR, nc - jp * NR)));
+                }
+            }
+        }
+    }
+}
+
+template <class T>
+inline constexpr bool gemm_type = std::is_same_v<T, std::int32_t> || std::is_same_v<T, float> || std::is_same_v<T, double>;
+
+// Best kernel the CPU and `level` allow; AVX2 float/double also need FMA.
+inline simd_level gemm_level(simd_level level, bool needs_fma)
+{
+    level = std::min(level, detected_simd_level());
+#ifdef HPC_X86_SIMD
+    if (level == simd_level::avx2 && needs_fma && !__builtin_cpu_supports("fma"))
+        level = simd_level::scalar;
+#endif
+    return level;
+}
+
+} // namespace detail
+
+// C (m x n) = alpha * A (m x k) * B (k x n) + beta * C, all row-major with leading
+// dimensions lda >= k, ldb >= n, ldc >= n. With beta == 0, C is not read.
+template <class T>
+void gemm(std::size_t m, std::size_t n, std::size_t k, T alpha, const T *a, std::size_t lda, const T *b,
+          std::size_t ldb, T beta, T *c, std::size_t ldc, simd_level level = detected_simd_level())
+{
+    static_assert(detail::gemm_type<T>, "hpc::gemm supports int32_t, float and double");
+    if (m == 0 || n == 0)
+        return;
+    if (k == 0)
+    {
+        for (std::size_t i = 0; i < m; i++)
+            for (std::size_t j = 0; j < n; j++)
+                c[i * ldc + j] = beta == T(0) ? T(0) : beta * c[i * ldc + j];
+        return;
+    }
+
+    level = detail::gemm_level(level, !std::is_integral_v<T>);
+#ifdef HPC_X86_SIMD
+    if constexpr (std::is_same_v<T, float>)
+    {
+        if (level == simd_level::avx512)
+            return detail::gemm_blocked<detail::avx512_gemm_kernel<detail::avx512_f32, 12, 2>>(m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+        if (level == simd_level::avx2)
+            return detail::gemm_blocked<detail::avx2_gemm_kernel<detail::avx2_f32, 6, 2>>(m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+    }
+    else if constexpr (std::is_same_v<T, double>)
+    {
+        if (level == simd_level::avx512)
+            return detail::gemm_blocked<detail::avx512_gemm_kernel<detail::avx512_f64, 12, 2>>(m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+        if (level == simd_level::avx2)
+            return detail::gemm_blocked<detail::avx2_gemm_kernel<detail::avx2_f64, 6, 2>>(m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+    }
+    else
+    {
+        if (level == simd_level::avx512)
+            return detail::gemm_blocked<detail::avx512_gemm_kernel<detail::avx512_i32, 12, 2>>(m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+        if (level == simd_level::avx2)
+            return detail::gemm_blocked<detail::avx2_gemm_kernel<detail::avx2_i32, 6, 2>>(m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+    }
+#endif
+    detail::gemm_blocked<detail::scalar_gemm_kernel<T>>(m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+}
+
+// C = A * B for n x n row-major matrices (the CUDA `multiply` kernel's contract).
+template <class T>
+void matmul(const T *a, const T *b, T *c, std::size_t n, simd_level level = detected_simd_level())
+{
+    gemm(n, n, n, T(1), a, n, b, n, T(0), c, n, level);
+}
+
+namespace detail
+{
+
+template <class V, int Chains>
+inline double peak_chains(std::size_t iterations)
+{
+    using T = typename V::value_type;
+    typename V::reg acc[Chains];
+#pragma GCC unroll 32
+    for (int i = 0; i < Chains; i++)
+        acc[i] = V::set1(T(i));
+    // Opaque to the optimizer, so fmadd(acc, 1, 1) is not folded into an add.
+    T one = T(1);
+    asm volatile("" : "+m"(one));
+    const typename V::reg x = V::set1(one), y = V::set1(one);
+    const double start = omp_get_wtime();
+    for (std::size_t it = 0; it < iterations; it++)
+    {
+#pragma GCC unroll 32
+        for (int i = 0; i < Chains; i++)
+            acc[i] = V::fmadd(acc[i], x, y);
+    }
+    const double seconds = omp_get_wtime() - start;
+    alignas(64) T sink[Chains * V::width];
+    for (int i = 0; i < Chains; i++)
+        V::store(sink + i * V::width, acc[i]);
+    asm volatile("" : : "r"(sink) : "memory");
+    return 2.0 * iterations * Chains * V::width / seconds / 1e9;
+}
+
+template <class T>
+double peak_scalar(std::size_t iterations)
+{
+    return peak_chains<scalar_vec<T>, 12>(iterations);
+}
+
+#ifdef HPC_X86_SIMD
+template <class V>
+__attribute__((target("avx2,fma"), flatten)) double peak_avx2(std::size_t iterations)
+{
+    return peak_chains<V, 12>(iterations);
+}
+
+template <class V>
+__attribute__((target("avx512f"), flatten)) double peak_avx512(std::size_t iterations)
+{
+    return peak_chains<V, 24>(iterations);
+}
+#endif
+
+} // namespace detail
+
+// Multiply-add throughput of `threads` threads running independent FMA chains in the
+// registers gemm uses (mullo + add for int32), in GFLOP/s. This is the practical peak:
+// cores x clock x FMA ports x lanes x 2, with the clock the CPU actually sustains under
+// vector load, so GEMM efficiency is measured against what the machine can really do.
+template <class T>
+double simd_peak_gflops(simd_level level = detected_simd_level(), int threads = omp_get_max_threads())
+{
+    static_assert(detail::gemm_type<T>, "hpc::simd_peak_gflops supports int32_t, float and double");
+    level = detail::gemm_level(level, !std::is_integral_v<T>);
+    constexpr std::size_t iterations = 20'000'000;
+    double total = 0;
+#pragma omp parallel num_threads(std::max(threads, 1)) reduction(+ : total)
+    {
+        double rate = 0;
+#ifdef HPC_X86_SIMD
+        if constexpr (std::is_same_v<T, float>)
+            rate = level == simd_level::avx512 ? detail::peak_avx512<detail::avx512_f32>(iterations)
+                   : level == simd_level::avx2 ? detail::peak_avx2<detail::avx2_f32>(iterations)
+                                               : 0;
+        else if constexpr (std::is_same_v<T, double>)
+            rate = level == simd_level::avx512 ? detail::peak_avx512<detail::avx512_f64>(iterations)
+                   : level == simd_level::avx2 ? detail::peak_avx2<detail::avx2_f64>(iterations)
+                                               : 0;
+        else
+            rate = level == simd_level::avx512 ? detail::peak_avx512<detail::avx512_i32>(iterations)
+                   : level == simd_level::avx2 ? detail::peak_avx2<detail::avx2_i32>(iterations)
+                                               : 0;
+#endif
+        if (rate == 0)
+            rate = detail::peak_scalar<T>(iterations / 4);
+        total += rate;
+    }
+    return total;
+}
+
+} // namespace hpc
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
@@ -0,0 +1,666 @@
+/*
+ * Batched Small-Matrix Multiply (header-only): Fixed-Size SIMD Kernels using OpenMP
+ * =================================================================================
+ *
+ * C[i] = alpha * A[i] * B[i] + beta * C[i] for thousands of small row-major matrices at
+ * once (int32, float, double). hpc::gemm is built for large products: for a 4 x 4 or
+ * 16 x 16 matrix, packing, blocking and starting threads cost more than the arithmetic.
+ * Here the batch is the unit of work: one call, one parallel region, and a kernel whose
+ * loops are all compile-time constants.
+ *
+ * USAGE:
+ *
+ *   #include "gemm_batched.hpp"
+ *
+ *   // Strided: matrix i of A starts at A + i * stride_a (likewise B, C)
+ *   hpc::gemm_strided_batched(m, n, k, 1.0f, A, lda, stride_a, B, ldb, stride_b,
+ *                             0.0f, C, ldc, stride_c, batch);
+ *
+ *   // Pointer arrays: matrix i of A is a[i]
+ *   hpc::gemm_batched(m, n, k, 1.0f, a, lda, b, ldb, 0.0f, c, ldc, batch);
+ *
+ *   // Sizes known at compile time (contiguous matrices, lda = K, ldb = ldc = N)
+ *   hpc::gemm_strided_batched<8, 8, 8>(1.0f, A, 64, B, 64, 0.0f, C, 64, batch);
+ *   hpc::gemm_batched<4, 4, 4>(1.0f, a, b, 0.0f, c, batch);
+ *
+ *   // Compact layout: groups of 64 / sizeof(T) matrices interleaved element by element
+ *   std::vector<float> ca(hpc::compact_size<float>(m, k, batch)), ...;
+ *   hpc::compact_pack(m, k, A, lda, stride_a, batch, ca.data());        // likewise B
+ *   hpc::gemm_compact_batched(m, n, k, 1.0f, ca.data(), cb.data(), 0.0f, cc.data(), batch);
+ *   hpc::compact_unpack(m, n, cc.data(), C, ldc, stride_c, batch);
+ *
+ * COMPILATION:
+ *   g++ -std=c++20 -O2 -fopenmp -o program program.cpp
+ * As in gemm.hpp, the SIMD kernels carry target attributes and are picked at run time.
+ *
+ * KERNELS:
+ * -------
+ * - Runtime sizes with m == n == k in {4, 8, 16, 32, 64} go to the fixed-size kernels
+ *   below; other shapes use the template versions directly, or fall back to a vectorized
+ *   i-k-j loop (hpc::gemm for matrices over 64).
+ * - Row kernel: one matrix at a time, a block of rows x N columns of C in registers, K
+ *   fully known, no packing. The vector is the widest of 512, 256 and 128 bits whose
+ *   width divides N, so 16 x 16 float on AVX-512 is 16 rows of one register each and
+ *   4 x 4 float is 4 rows of one SSE register.
+ * - Compact kernel: lane l of every register belongs to matrix l of a group, so even a
+ *   4 x 4 product fills whole AVX-512 registers. The caller packs A and B once with
+ *   compact_pack; that transposition costs more than one multiply, so the layout pays off
+ *   for operands that are reused or produced in it.
+ *
+ * PARALLELIZATION:
+ * ---------------
+ * - The batch is split into one contiguous range per thread (whole groups for the compact
+ *   layout); threads as in gemm.hpp, one per 2^18 multiply-adds.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <omp.h>
+#include "gemm.hpp"
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpsabi"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+namespace hpc
+{
+
+namespace detail
+{
+
+// Matrix i of a batch: base + i * stride, or ptrs[i].
+template <class P>
+struct strided_batch
+{
+    P base;
+    std::size_t stride;
+    P operator()(std::size_t i) const { return base + i * stride; }
+};
+
+template <class P>
+struct pointer_batch
+{
+    const P *ptrs;
+    P operator()(std::size_t i) const { return ptrs[i]; }
+};
+
+// Largest power of two <= x (x >= 1).
+constexpr int batched_pow2_floor(int x)
+{
+    int p = 1;
+    while (p * 2 <= x)
+        p *= 2;
+    return p;
+}
+
+// Rows [i0, i0 + RB) x vector columns [j0, j0 + CV) of one C, all K terms in registers.
+template <class V, int RB, int CV, int K>
+inline void batched_row_block(const typename V::value_type *a, std::size_t lda, const typename V::value_type *b,
+                              std::size_t ldb, typename V::value_type *c, std::size_t ldc,
+                              typename V::value_type alpha, typename V::value_type beta)
+{
+    using T = typename V::value_type;
+    constexpr int W = V::width;
+    typename V::reg acc[RB][CV];
+#pragma GCC unroll 16
+    for (int r = 0; r < RB; r++)
+#pragma GCC unroll 16
+        for (int j = 0; j < CV; j++)
+            acc[r][j] = V::zero();
+
+#pragma GCC unroll 4
+    for (int p = 0; p < K; p++)
+    {
+        typename V::reg bv[CV];
+#pragma GCC unroll 16
+        for (int j = 0; j < CV; j++)
+            bv[j] = V::load(b + p * ldb + j * W);
+#pragma GCC unroll 16
+        for (int r = 0; r < RB; r++)
+        {
+            const typename V::reg av = V::set1(a[r * lda + p]);
+#pragma GCC unroll 16
+            for (int j = 0; j < CV; j++)
+                acc[r][j] = V::fmadd(av, bv[j], acc[r][j]);
+        }
+    }
+
+    const typename V::reg va = V::set1(alpha), vb = V::set1(beta);
+#pragma GCC unroll 16
+    for (int r = 0; r < RB; r++)
+#pragma GCC unroll 16
+        for (int j = 0; j < CV; j++)
+        {
+            T *out = c + r * ldc + j * W;
+            V::store(out, beta == T(0) ? V::mul(va, acc[r][j]) : V::fmadd(vb, V::load(out), V::mul(va, acc[r][j])));
+        }
+}
+
+// One M x N x K product, N a multiple of the vector width. Budget: accumulators that fit
+// in the register file next to the B vectors.
+template <class V, int Budget, int M, int N, int K>
+inline void batched_rows(const typename V::value_type *a, std::size_t lda, const typename V::value_type *b,
+                         std::size_t ldb, typename V::value_type *c, std::size_t ldc, typename V::value_type alpha,
+                         typename V::value_type beta)
+{
+    constexpr int W = V::width, NV = N / W;
+    constexpr int CV = batched_pow2_floor(std::min(NV, Budget / 2 > 0 ? Budget / 2 : 1));
+    constexpr int RB = std::min(batched_pow2_floor(std::max(Budget / CV, 1)), batched_pow2_floor(M));
+    for (int j0 = 0; j0 + CV <= NV; j0 += CV)
+    {
+        int i = 0;
+        for (; i + RB <= M; i += RB)
+            batched_row_block<V, RB, CV, K>(a + i * lda, lda, b + j0 * W, ldb, c + i * ldc + j0 * W, ldc, alpha, beta);
+        for (; i < M; i++)
+            batched_row_block<V, 1, CV, K>(a + i * lda, lda, b + j0 * W, ldb, c + i * ldc + j0 * W, ldc, alpha, beta);
+    }
+    // NV not a multiple of CV (only for template sizes like N = 3 W)
+    for (int j0 = NV / CV * CV; j0 < NV; j0++)
+        for (int i = 0; i < M; i++)
+            batched_row_block<V, 1, 1, K>(a + i * lda, lda, b + j0 * W, ldb, c + i * ldc + j0 * W, ldc, alpha, beta);
+}
+
+// Any shape: vectorized i-k-j for small matrices, hpc::gemm (one thread here) for larger.
+// Not inlined into the flattened kernels, which would otherwise pull in all of gemm.
+template <class T, class A, class B, class C>
+__attribute__((noinline)) void batched_generic(std::size_t first, std::size_t last, std::size_t m, std::size_t n, std::size_t k, T alpha, A a,
+                     std::size_t lda, B b, std::size_t ldb, T beta, C c, std::size_t ldc, simd_level level)
+{
+    for (std::size_t x = first; x < last; x++)
+    {
+        const T *ax = a(x), *bx = b(x);
+        T *cx = c(x);
+        if (std::min({m, n, k}) > 64)
+        {
+            gemm(m, n, k, alpha, ax, lda, bx, ldb, beta, cx, ldc, level);
+            continue;
+        }
+        for (std::size_t i = 0; i < m; i++)
+        {
+            T *cr = cx + i * ldc;
+            for (std::size_t j = 0; j < n; j++)
+                cr[j] = beta == T(0) ? T(0) : beta * cr[j];
+            for (std::size_t p = 0; p < k; p++)
+            {
+                const T s = alpha * ax[i * lda + p];
+                const T *br = bx + p * ldb;
+#pragma omp simd
+                for (std::size_t j = 0; j < n; j++)
+                    cr[j] += s * br[j];
+            }
+        }
+    }
+}
+
+// The fixed-size kernel on matrices [first, last): C rows in the widest of V, Narrower...
+// whose width divides N (4 x 4 float uses 128-bit vectors even on AVX-512), or the
+// generic loop when none does.
+template <int Budget, int M, int N, int K, class V, class... Narrower, class T, class A, class B, class C>
+inline void batched_fixed(std::size_t first, std::size_t last, T alpha, A a, std::size_t lda, B b, std::size_t ldb,
+                          T beta, C c, std::size_t ldc)
+{
+    if constexpr (N % V::width == 0)
+    {
+        for (std::size_t x = first; x < last; x++)
+            batched_rows<V, Budget, M, N, K>(a(x), lda, b(x), ldb, c(x), ldc, alpha, beta);
+    }
+    else if constexpr (sizeof...(Narrower) > 0)
+        batched_fixed<Budget, M, N, K, Narrower...>(first, last, alpha, a, lda, b, ldb, beta, c, ldc);
+    else
+        batched_generic(first, last, std::size_t(M), std::size_t(N), std::size_t(K), alpha, a, lda, b, ldb, beta, c,
+                        ldc, simd_level::scalar);
+}
+
+// Interleaved batches: element (i, j) of every matrix in a group of G sits in one cache
+// line, G = 64 / sizeof(T), so lane l of each vector belongs to matrix l of the group.
+template <class T>
+inline constexpr std::size_t compact_group = 64 / sizeof(T);
+
+// acc(RB x CB) = rows [0, RB) x columns [0, CB) of one group's C, for the W lanes at a / b / c.
+template <class V, int RB, int CB, int N, int K>
+inline void compact_tile(const typename V::value_type *a, const typename V::value_type *b,
+                         typename V::value_type *c, typename V::value_type alpha, typename V::value_type beta)
+{
+    using T = typename V::value_type;
+    constexpr std::size_t G = compact_group<T>;
+    typename V::reg acc[RB][CB];
+#pragma GCC unroll 16
+    for (int r = 0; r < RB; r++)
+#pragma GCC unroll 16
+        for (int j = 0; j < CB; j++)
+            acc[r][j] = V::zero();
+
+#pragma GCC unroll 4
+    for (int p = 0; p < K; p++)
+    {
+        typename V::reg av[RB], bv[CB];
+#pragma GCC unroll 16
+        for (int r = 0; r < RB; r++)
+            av[r] = V::load(a + (r * K + p) * G);
+#pragma GCC unroll 16
+        for (int j = 0; j < CB; j++)
+            bv[j] = V::load(b + (p * N + j) * G);
+#pragma GCC unroll 16
+        for (int r = 0; r < RB; r++)
+#pragma GCC unroll 16
+            for (int j = 0; j < CB; j++)
+                acc[r][j] = V::fmadd(av[r], bv[j], acc[r][j]);
+    }
+
+    const typename V::reg va = V::set1(alpha), vb = V::set1(beta);
+#pragma GCC unroll 16
+    for (int r = 0; r < RB; r++)
+#pragma GCC unroll 16
+        for (int j = 0; j < CB; j++)
+        {
+            T *out = c + (r * N + j) * G;
+            V::store(out, beta == T(0) ? V::mul(va, acc[r][j]) : V::fmadd(vb, V::load(out), V::mul(va, acc[r][j])));
+        }
+}
+
+template <class V, int RB, int CB, int N, int K>
+inline void compact_row_tiles(const typename V::value_type *a, const typename V::value_type *b,
+                              typename V::value_type *c, typename V::value_type alpha, typename V::value_type beta)
+{
+    constexpr std::size_t G = compact_group<typename V::value_type>;
+    int j = 0;
+    for (; j + CB <= N; j += CB)
+        compact_tile<V, RB, CB, N, K>(a, b + j * G, c + j * G, alpha, beta);
+    for (; j < N; j++)
+        compact_tile<V, RB, 1, N, K>(a, b + j * G, c + j * G, alpha, beta);
+}
+
+// Groups [first, last) of interleaved M x K, K x N and M x N matrices. Every vector does
+// G / W independent slices of the group; an RB x CB tile of C takes RB + CB loads per
+// RB * CB FMAs.
+template <class V, int Budget, int M, int N, int K>
+inline void compact_groups(std::size_t first, std::size_t last, const typename V::value_type *a,
+                           const typename V::value_type *b, typename V::value_type *c, typename V::value_type alpha,
+                           typename V::value_type beta)
+{
+    constexpr std::size_t G = compact_group<typename V::value_type>;
+    constexpr int RB = batched_pow2_floor(std::min(M, 4)), CB = batched_pow2_floor(std::min(N, std::max(Budget / RB, 1)));
+    for (std::size_t g = first; g < last; g++)
+    {
+        const auto *ag = a + g * M * K * G, *bg = b + g * K * N * G;
+        auto *cg = c + g * M * N * G;
+        for (std::size_t s = 0; s < G; s += V::width)
+        {
+            int i = 0;
+            for (; i + RB <= M; i += RB)
+                compact_row_tiles<V, RB, CB, N, K>(ag + i * K * G + s, bg + s, cg + i * N * G + s, alpha, beta);
+            for (; i < M; i++)
+                compact_row_tiles<V, 1, CB, N, K>(ag + i * K * G + s, bg + s, cg + i * N * G + s, alpha, beta);
+        }
+    }
+}
+
+// Any shape on interleaved groups; the lane loop vectorizes.
+template <class T>
+__attribute__((noinline)) void compact_generic(std::size_t first, std::size_t last, std::size_t m, std::size_t n,
+                                               std::size_t k, T alpha, const T *a, const T *b, T beta, T *c)
+{
+    constexpr std::size_t G = compact_group<T>;
+    for (std::size_t g = first; g < last; g++)
+        for (std::size_t i = 0; i < m; i++)
+            for (std::size_t j = 0; j < n; j++)
+            {
+                T acc[G] = {};
+                for (std::size_t p = 0; p < k; p++)
+                {
+                    const T *ap = a + ((g * m + i) * k + p) * G, *bp = b + ((g * k + p) * n + j) * G;
+#pragma omp simd
+                    for (std::size_t l = 0; l < G; l++)
+                        acc[l] += ap[l] * bp[l];
+                }
+                T *cp = c + ((g * m + i) * n + j) * G;
+#pragma omp simd
+                for (std::size_t l = 0; l < G; l++)
+                    cp[l] = beta == T(0) ? alpha * acc[l] : alpha * acc[l] + beta * cp[l];
+            }
+}
+
+#ifdef HPC_X86_SIMD
+
+// 128-bit vectors, for rows of 4 floats / int32s or 2 doubles. Only used inside the
+// AVX2 and AVX-512 entry points, so they may use FMA.
+struct sse_f32
+{
+    using value_type = float;
+    using reg = __m128;
+    static constexpr int width = 4;
+    __attribute__((target("avx2,fma"))) static reg zero() { return _mm_setzero_ps(); }
+    __attribute__((target("avx2,fma"))) static reg set1(float x) { return _mm_set1_ps(x); }
+    __attribute__((target("avx2,fma"))) static reg load(const float *p) { return _mm_loadu_ps(p); }
+    __attribute__((target("avx2,fma"))) static void store(float *p, reg v) { _mm_storeu_ps(p, v); }
+    __attribute__((target("avx2,fma"))) static reg mul(reg a, reg b) { return _mm_mul_ps(a, b); }
+    __attribute__((target("avx2,fma"))) static reg fmadd(reg a, reg b, reg c) { return _mm_fmadd_ps(a, b, c); }
+};
+
+struct sse_f64
+{
+    using value_type = double;
+    using reg = __m128d;
+    static constexpr int width = 2;
+    __attribute__((target("avx2,fma"))) static reg zero() { return _mm_setzero_pd(); }
+    __attribute__((target("avx2,fma"))) static reg set1(double x) { return _mm_set1_pd(x); }
+    __attribute__((target("avx2,fma"))) static reg load(const double *p) { return _mm_loadu_pd(p); }
+    __attribute__((target("avx2,fma"))) static void store(double *p, reg v) { _mm_storeu_pd(p, v); }
+    __attribute__((target("avx2,fma"))) static reg mul(reg a, reg b) { return _mm_mul_pd(a, b); }
+    __attribute__((target("avx2,fma"))) static reg fmadd(reg a, reg b, reg c) { return _mm_fmadd_pd(a, b, c); }
+};
+
+struct sse_i32
+{
+    using value_type = std::int32_t;
+    using reg = __m128i;
+    static constexpr int width = 4;
+    __attribute__((target("avx2"))) static reg zero() { return _mm_setzero_si128(); }
+    __attribute__((target("avx2"))) static reg set1(std::int32_t x) { return _mm_set1_epi32(x); }
+    __attribute__((target("avx2"))) static reg load(const std::int32_t *p) { return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p)); }
+    __attribute__((target("avx2"))) static void store(std::int32_t *p, reg v) { _mm_storeu_si128(reinterpret_cast<__m128i *>(p), v); }
+    __attribute__((target("avx2"))) static reg mul(reg a, reg b) { return _mm_mullo_epi32(a, b); }
+    __attribute__((target("avx2"))) static reg fmadd(reg a, reg b, reg c) { return _mm_add_epi32(_mm_mullo_epi32(a, b), c); }
+};
+
+template <class T>
+struct batched_vectors;
+
+template <>
+struct batched_vectors<float>
+{
+    using sse = sse_f32;
+    using avx2 = avx2_f32;
+    using avx512 = avx512_f32;
+};
+
+template <>
+struct batched_vectors<double>
+{
+    using sse = sse_f64;
+    using avx2 = avx2_f64;
+    using avx512 = avx512_f64;
+};
+
+template <>
+struct batched_vectors<std::int32_t>
+{
+    using sse = sse_i32;
+    using avx2 = avx2_i32;
+    using avx512 = avx512_i32;
+};
+
+// 16 registers: 12 accumulators; 32 registers: 24.
+template <int M, int N, int K, class T, class A, class B, class C>
+__attribute__((target("avx2,fma"), flatten)) void batched_avx2(std::size_t first, std::size_t last, T alpha, A a,
+                                                               std::size_t lda, B b, std::size_t ldb, T beta, C c,
+                                                               std::size_t ldc)
+{
+    using Vs = batched_vectors<T>;
+    batched_fixed<12, M, N, K, typename Vs::avx2, typename Vs::sse>(first, last, alpha, a, lda, b, ldb, beta, c, ldc);
+}
+
+template <int M, int N, int K, class T, class A, class B, class C>
+__attribute__((target("avx512f"), flatten)) void batched_avx512(std::size_t first, std::size_t last, T alpha, A a,
+                                                                std::size_t lda, B b, std::size_t ldb, T beta, C c,
+                                                                std::size_t ldc)
+{
+    batched_fixed<24, M, N, K, typename batched_vectors<T>::avx512>(first, last, alpha, a, lda, b, ldb, beta, c, ldc);
+}
+
+template <int M, int N, int K, class T>
+__attribute__((target("avx2,fma"), flatten)) void compact_avx2(std::size_t first, std::size_t last, T alpha,
+                                                               const T *a, const T *b, T beta, T *c)
+{
+    compact_groups<typename batched_vectors<T>::avx2, 12, M, N, K>(first, last, a, b, c, alpha, beta);
+}
+
+template <int M, int N, int K, class T>
+__attribute__((target("avx512f"), flatten)) void compact_avx512(std::size_t first, std::size_t last, T alpha,
+                                                                const T *a, const T *b, T beta, T *c)
+{
+    compact_groups<typename batched_vectors<T>::avx512, 24, M, N, K>(first, last, a, b, c, alpha, beta);
+}
+
+#endif // HPC_X86_SIMD
+
+template <int M, int N, int K, class T, class A, class B, class C>
+void batched_entry(simd_level level, std::size_t first, std::size_t last, T alpha, A a, std::size_t lda, B b,
+                   std::size_t ldb, T beta, C c, std::size_t ldc)
+{
+#ifdef HPC_X86_SIMD
+    // Rows narrower than a 512-bit vector take the AVX2 entry: GCC 12 spills the B vector
+    // of 256-bit kernels compiled for AVX-512, at half the speed.
+    if (level == simd_level::avx512 && N % batched_vectors<T>::avx512::width == 0)
+        return batched_avx512<M, N, K>(first, last, alpha, a, lda, b, ldb, beta, c, ldc);
+    if (level >= simd_level::avx2)
+        return batched_avx2<M, N, K>(first, last, alpha, a, lda, b, ldb, beta, c, ldc);
+#endif
+    // Without SIMD kernels, wide rows do better as the compiler-vectorized loop.
+    if constexpr (N >= 16)
+        batched_generic(first, last, std::size_t(M), std::size_t(N), std::size_t(K), alpha, a, lda, b, ldb, beta, c,
+                        ldc, level);
+    else
+        batched_fixed<16, M, N, K, scalar_vec<T>>(first, last, alpha, a, lda, b, ldb, beta, c, ldc);
+}
+
+template <int M, int N, int K, class T>
+void compact_entry(simd_level level, std::size_t first, std::size_t last, T alpha, const T *a, const T *b, T beta,
+                   T *c)
+{
+#ifdef HPC_X86_SIMD
+    if (level == simd_level::avx512)
+        return compact_avx512<M, N, K>(first, last, alpha, a, b, beta, c);
+    if (level == simd_level::avx2)
+        return compact_avx2<M, N, K>(first, last, alpha, a, b, beta, c);
+#endif
+    compact_groups<scalar_vec<T>, 16, M, N, K>(first, last, a, b, c, alpha, beta);
+}
+
+// fn(first, last) on one contiguous range of [0, count) per thread.
+template <class F>
+void batched_parallel(std::size_t count, double work, F &&fn)
+{
+    const int threads = gemm_threads(work);
+    if (threads == 1)
+        return fn(std::size_t(0), count);
+#pragma omp parallel num_threads(threads)
+    {
+        const std::size_t t = omp_get_thread_num(), nt = omp_get_num_threads();
+        const std::size_t first = count * t / nt, last = count * (t + 1) / nt;
+        if (first < last)
+            fn(first, last);
+    }
+}
+
+// The sizes with a compiled kernel: fn.template operator()<S>() for m == n == k == S.
+template <class F>
+bool batched_dispatch(std::size_t m, std::size_t n, std::size_t k, F &&fn)
+{
+    if (m != n || n != k)
+        return false;
+    switch (m)
+    {
+    case 4:
+        fn.template operator()<4>();
+        return true;
+    case 8:
+        fn.template operator()<8>();
+        return true;
+    case 16:
+        fn.template operator()<16>();
+        return true;
+    case 32:
+        fn.template operator()<32>();
+        return true;
+    case 64:
+        fn.template operator()<64>();
+        return true;
+    }
+    return false;
+}
+
+template <int M, int N, int K, class T, class A, class B, class C>
+void batched_fixed_run(T alpha, A a, std::size_t lda, B b, std::size_t ldb, T beta, C c, std::size_t ldc,
+                       std::size_t batch, simd_level level)
+{
+    static_assert(gemm_type<T>, "hpc::gemm_batched supports int32_t, float and double");
+    static_assert(M > 0 && N > 0 && K > 0, "matrix dimensions must be positive");
+    level = gemm_level(level, !std::is_integral_v<T>);
+    batched_parallel(batch, double(batch) * M * N * K, [&](std::size_t first, std::size_t last) {
+        batched_entry<M, N, K>(level, first, last, alpha, a, lda, b, ldb, beta, c, ldc);
+    });
+}
+
+template <class T, class A, class B, class C>
+void batched_run(std::size_t m, std::size_t n, std::size_t k, T alpha, A a, std::size_t lda, B b, std::size_t ldb,
+                 T beta, C c, std::size_t ldc, std::size_t batch, simd_level level)
+{
+    static_assert(gemm_type<T>, "hpc::gemm_batched supports int32_t, float and double");
+    if (batch == 0 || m == 0 || n == 0)
+        return;
+    auto fixed = [&]<int S>() { batched_fixed_run<S, S, S>(alpha, a, lda, b, ldb, beta, c, ldc, batch, level); };
+    if (batched_dispatch(m, n, k, fixed))
+        return;
+    level = gemm_level(level, !std::is_integral_v<T>);
+    batched_parallel(batch, double(batch) * double(m) * double(n) * double(k), [&](std::size_t first, std::size_t last) {
+        batched_generic(first, last, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc, level);
+    });
+}
+
+} // namespace detail
+
+// C[i] (m x n) = alpha * A[i] (m x k) * B[i] (k x n) + beta * C[i] for i < batch, where
+// A[i] = a + i * stride_a and so on; row-major with leading dimensions lda, ldb, ldc.
+// With beta == 0, C is not read. The C matrices must not overlap.
+template <class T>
+void gemm_strided_batched(std::size_t m, std::size_t n, std::size_t k, T alpha, const T *a, std::size_t lda,
+                          std::size_t stride_a, const T *b, std::size_t ldb, std::size_t stride_b, T beta, T *c,
+                          std::size_t ldc, std::size_t stride_c, std::size_t batch,
+                          simd_level level = detected_simd_level())
+{
+    detail::batched_run(m, n, k, alpha, detail::strided_batch<const T *>{a, stride_a}, lda,
+                        detail::strided_batch<const T *>{b, stride_b}, ldb, beta, detail::strided_batch<T *>{c, stride_c},
+                        ldc, batch, level);
+}
+
+// The same with the matrices given as arrays of batch pointers.
+template <class T>
+void gemm_batched(std::size_t m, std::size_t n, std::size_t k, T alpha, const T *const *a, std::size_t lda,
+                  const T *const *b, std::size_t ldb, T beta, T *const *c, std::size_t ldc, std::size_t batch,
+                  simd_level level = detected_simd_level())
+{
+    detail::batched_run(m, n, k, alpha, detail::pointer_batch<const T *>{a}, lda, detail::pointer_batch<const T *>{b},
+                        ldb, beta, detail::pointer_batch<T *>{c}, ldc, batch, level);
+}
+
+// Compile-time M x N x K on contiguous matrices (lda = K, ldb = ldc = N): a kernel for
+// any size, not only the ones the runtime versions dispatch to.
+template <int M, int N, int K, class T>
+void gemm_strided_batched(T alpha, const T *a, std::size_t stride_a, const T *b, std::size_t stride_b, T beta, T *c,
+                          std::size_t stride_c, std::size_t batch, simd_level level = detected_simd_level())
+{
+    detail::batched_fixed_run<M, N, K>(alpha, detail::strided_batch<const T *>{a, stride_a}, K,
+                                       detail::strided_batch<const T *>{b, stride_b}, N, beta,
+                                       detail::strided_batch<T *>{c, stride_c}, N, batch, level);
+}
+
+template <int M, int N, int K, class T>
+void gemm_batched(T alpha, const T *const *a, const T *const *b, T beta, T *const *c, std::size_t batch,
+                  simd_level level = detected_simd_level())
+{
+    detail::batched_fixed_run<M, N, K>(alpha, detail::pointer_batch<const T *>{a}, K,
+                                       detail::pointer_batch<const T *>{b}, N, beta, detail::pointer_batch<T *>{c}, N,
+                                       batch, level);
+}
+
+// Interleaved ("compact") batches: groups of G = 64 / sizeof(T) matrices (16 float or
+// int32, 8 double) stored element by element, so that element (i, j) of matrix g * G + l
+// is at data[(g * rows * cols + i * cols + j) * G + l]. Kernels on this layout need no
+// shuffles: every lane of every vector is a different matrix. Pay the transposition once
+// with compact_pack / compact_unpack, then multiply many times.
+template <class T>
+std::size_t compact_size(std::size_t rows, std::size_t cols, std::size_t batch)
+{
+    constexpr std::size_t G = detail::compact_group<T>;
+    return (batch + G - 1) / G * rows * cols * G;
+}
+
+// Strided batch (matrix x at src + x * stride, leading dimension ld) -> compact_size
+// elements at dst; the lanes past the batch in the last group are zero.
+template <class T>
+void compact_pack(std::size_t rows, std::size_t cols, const T *src, std::size_t ld, std::size_t stride,
+                  std::size_t batch, T *dst)
+{
+    constexpr std::size_t G = detail::compact_group<T>;
+    const std::size_t groups = (batch + G - 1) / G;
+    detail::batched_parallel(groups, double(batch) * rows * cols, [&](std::size_t first, std::size_t last) {
+        for (std::size_t g = first; g < last; g++)
+        {
+            const std::size_t lanes = std::min(G, batch - g * G);
+            const T *in = src + g * G * stride;
+            T *out = dst + g * rows * cols * G;
+            if (lanes < G)
+                std::fill(out, out + rows * cols * G, T(0));
+            for (std::size_t i = 0; i < rows; i++)
+                for (std::size_t j = 0; j < cols; j++, out += G)
+                    for (std::size_t l = 0; l < lanes; l++)
+                        out[l] = in[l * stride + i * ld + j];
+        }
+    });
+}
+
+template <class T>
+void compact_unpack(std::size_t rows, std::size_t cols, const T *src, T *dst, std::size_t ld, std::size_t stride,
+                    std::size_t batch)
+{
+    constexpr std::size_t G = detail::compact_group<T>;
+    const std::size_t groups = (batch + G - 1) / G;
+    detail::batched_parallel(groups, double(batch) * rows * cols, [&](std::size_t first, std::size_t last) {
+        for (std::size_t g = first; g < last; g++)
+        {
+            const std::size_t lanes = std::min(G, batch - g * G);
+            const T *in = src + g * rows * cols * G;
+            T *out = dst + g * G * stride;
+            for (std::size_t i = 0; i < rows; i++)
+                for (std::size_t j = 0; j < cols; j++, in += G)
+                    for (std::size_t l = 0; l < lanes; l++)
+                        out[l * stride + i * ld + j] = in[l];
+        }
+    });
+}
+
+// gemm_strided_batched on compact batches (a: m x k, b: k x n, c: m x n, all packed).
+template <class T>
+void gemm_compact_batched(std::size_t m, std::size_t n, std::size_t k, T alpha, const T *a, const T *b, T beta, T *c,
+                          std::size_t batch, simd_level level = detected_simd_level())
+{
+    static_assert(detail::gemm_type<T>, "hpc::gemm_compact_batched supports int32_t, float and double");
+    constexpr std::size_t G = detail::compact_group<T>;
+    const std::size_t groups = (batch + G - 1) / G;
+    if (groups == 0 || m == 0 || n == 0)
+        return;
+    level = detail::gemm_level(level, !std::is_integral_v<T>);
+    const double work = double(groups) * G * double(m) * double(n) * double(k);
+    auto fixed = [&]<int S>() {
+        detail::batched_parallel(groups, work, [&](std::size_t first, std::size_t last) {
+            detail::compact_entry<S, S, S>(level, first, last, alpha, a, b, beta, c);
+        });
+    };
+    if (detail::batched_dispatch(m, n, k, fixed))
+        return;
+    detail::batched_parallel(groups, work, [&](std::size_t first, std::size_t last) {
+        detail::compact_generic(first, last, m, n, k, alpha, a, b, beta, c);
+    });
+}
+
+} // namespace hpc
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
@@ -0,0 +1,211 @@
+/*
+ * int8, bf16 and fp16 Matrix Multiply Throughput and Accuracy using gemm_quantized.hpp
+ * ====================================================================================
+ *
+ * COMPILATION & EXECUTION:
+ *
+ * For Ubuntu:
+ * -----------
+ * g++ -std=c++20 -O2 -fopenmp -o gemm_quantized gemm_quantized.cpp
+ * ./gemm_quantized
+ *
+ * For macOS:
+ * ----------
+ * g++ -std=c++20 -O2 -Xpreprocessor -fopenmp -I"$(brew --prefix libomp)/include" -L"$(brew --prefix libomp)/lib" -lomp -o gemm_quantized gemm_quantized.cpp
+ * ./gemm_quantized
+ *
+ * THEORETICAL CONCEPTS:
+ *
+ * Narrow Inputs, Wide Accumulators:
+ * --------------------------------
+ * - A 512-bit register holds 16 floats, 32 bf16 / fp16 or 64 int8 values. The products
+ *   need more bits than the inputs, so they are summed in int32 / fp32 lanes: vpdpbusd
+ *   adds 4 int8 products per lane (64 per instruction), vdpbf16ps 2 bf16 products
+ *   (32 per instruction), against 16 for an fp32 FMA
+ * - int8 x int8 -> int32 is exact; the loss is in quantizing the floats to 255 levels
+ *
+ * Quantization Scales:
+ * -------------------
+ * - Symmetric: x ~ s * q with q in [-127, 127] and s = max |x| / 127. One s for a whole
+ *   matrix wastes levels on every row or column whose values are smaller than the largest
+ * - Per-channel: one s per row of A and per column of B. They factor out of each dot
+ *   product, C[i][j] = s_a[i] s_b[j] sum q_a q_b, so they cost one multiply per output
+ *
+ * Test Data:
+ * ---------
+ * - A and B uniform in [-1, 1], then row i of A scaled by 2^(i % 8) and column j of B by
+ *   2^(j % 8): the uneven ranges real activations and weights have. Error is taken per
+ *   column (largest |C - C_fp32| over the largest |C_fp32| in it), worst column shown
+ *
+ * SAMPLE INPUT/OUTPUT:
+ * ------------------
+ *
+ * Input:
+ *   2048                         (Matrix size n, n x n times n x n)
+ *
+ * Output (single core, AVX-512 with VNNI and BF16):
+ *   Threads: 1, 2048 x 2048 x 2048
+ *   Measured peak (GFLOP/s): fp32 FMA 136.2, bf16 dot product 68.0
+ *
+ *   inputs -> output          kernel                      seconds  GFLOP/s  vs fp32      error
+ *   fp32                      AVX-512                      0.2263     75.9    1.00x  reference
+ *   bf16 -> fp32              AVX-512 fp32, widened        0.2335     73.6    0.97x   4.10e-03
+ *   fp16 -> fp32              AVX-512 fp32, widened        0.2406     71.4    0.94x   4.63e-04
+ *   int8 -> int32             AVX-512 VNNI                 0.1207    142.3    1.87x      exact
+ *   int8, per-tensor scales   AVX-512 VNNI                 0.1140    150.6    1.98x   8.98e-01
+ *   int8, per-channel scales  AVX-512 VNNI                 0.1269    135.4    1.78x   9.55e-03
+ *   fp32                      AVX2                         0.3549     48.4    0.64x   0.00e+00
+ *   bf16 -> fp32              AVX2 fp32, widened           0.3875     44.3    0.58x   4.10e-03
+ *   int8 -> int32             AVX2 vpmaddwd                0.3506     49.0    0.65x      exact
+ *
+ * GFLOP/s counts 2 n^3 operations whatever their type. This core issues vpdpbusd on one
+ * port against two for FMAs, so VNNI's 4x products per instruction make 2x, and int8 runs
+ * at 1.9x fp32. It issues vdpbf16ps only every other cycle (half the FMA peak above), so
+ * gemm_bf16 picked the widened fp32 kernel: bf16 and fp16 inputs then cost what fp32 does
+ * and save half the memory. With one scale per tensor the columns scaled by 1 keep only a
+ * couple of int8 levels and lose everything (error 0.9); per-channel scales give every
+ * column all 255 levels and 1% error. On AVX2, vpmaddwd int8 matches the fp32 kernel.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <vector>
+#include <string>
+#include <cmath>
+#include <sstream>
+#include <cstdint>
+#include <omp.h>
+#include "gemm_quantized.hpp"
+#include "random.hpp"
+using namespace std;
+
+// Best of 3 runs, after one warm-up.
+template <class F>
+double bestOf3(F &&f)
+{
+    f();
+    double best = 1e30;
+    for (int rep = 0; rep < 3; rep++)
+    {
+        double start = omp_get_wtime();
+        f();
+        best = min(best, omp_get_wtime() - start);
+    }
+    return best;
+}
+
+// Worst column: largest |C - R| in a column over the largest |R| in it.
+double relativeError(const vector<float> &C, const vector<float> &R, size_t n)
+{
+    vector<double> err(n, 0), scale(n, 0);
+    for (size_t i = 0; i < C.size(); i++)
+    {
+        err[i % n] = max(err[i % n], fabs(double(C[i]) - R[i]));
+        scale[i % n] = max(scale[i % n], fabs(double(R[i])));
+    }
+    double worst = 0;
+    for (size_t j = 0; j < n; j++)
+        worst = max(worst, err[j] / scale[j]);
+    return worst;
+}
+
+int main()
+{
+    size_t n;
+    cout << "Enter the matrix size: ";
+    cin >> n;
+
+    if (n < 16)
+    {
+        cout << "Invalid matrix size!" << endl;
+        return 1;
+    }
+
+    const size_t nn = n * n;
+    const double flops = 2.0 * n * n * n;
+    vector<float> A(nn), B(nn), R(nn), C(nn);
+    hpc::parallel_fill_uniform(A.begin(), A.end(), -1.0f, 1.0f, 1);
+    hpc::parallel_fill_uniform(B.begin(), B.end(), -1.0f, 1.0f, 2);
+    for (size_t i = 0; i < n; i++)
+        for (size_t j = 0; j < n; j++)
+        {
+            A[i * n + j] *= 1 << i % 8;
+            B[i * n + j] *= 1 << j % 8;
+        }
+
+    vector<hpc::bf16> Ab(nn), Bb(nn);
+    vector<hpc::fp16> Ah(nn), Bh(nn);
+    hpc::convert_float(nn, A.data(), Ab.data());
+    hpc::convert_float(nn, B.data(), Bb.data());
+    hpc::convert_float(nn, A.data(), Ah.data());
+    hpc::convert_float(nn, B.data(), Bh.data());
+
+    vector<int8_t> At(nn), Bt(nn), Ac(nn), Bc(nn);
+    const vector<float> sAt = hpc::quantize_int8(n, n, A.data(), n, At.data(), n, hpc::quant_axis::tensor);
+    const vector<float> sBt = hpc::quantize_int8(n, n, B.data(), n, Bt.data(), n, hpc::quant_axis::tensor);
+    const vector<float> sAc = hpc::quantize_int8(n, n, A.data(), n, Ac.data(), n, hpc::quant_axis::rows);
+    const vector<float> sBc = hpc::quantize_int8(n, n, B.data(), n, Bc.data(), n, hpc::quant_axis::columns);
+
+    // Exact reference for int8 -> int32: the same integers through the int32 gemm.
+    vector<int32_t> Ai(At.begin(), At.end()), Bi(Bt.begin(), Bt.end()), Ri(nn), Ci(nn);
+    hpc::gemm(n, n, n, 1, Ai.data(), n, Bi.data(), n, 0, Ri.data(), n);
+
+    cout << "\nThreads: " << omp_get_max_threads() << ", " << n << " x " << n << " x " << n << endl;
+    cout << "Measured peak (GFLOP/s): fp32 FMA " << fixed << setprecision(1) << hpc::simd_peak_gflops<float>()
+         << ", bf16 dot product " << hpc::bf16_dot_peak_gflops() << "\n" << endl;
+    cout << left << setw(26) << "inputs -> output" << setw(26) << "kernel" << right << setw(9) << "seconds" << setw(9)
+         << "GFLOP/s" << setw(9) << "vs fp32" << setw(11) << "error" << endl;
+
+    double tFloat = 0;
+    auto report = [&](const string &name, const string &kernel, double seconds, const string &error) {
+        cout << left << setw(26) << name << setw(26) << kernel << right << fixed << setprecision(4) << setw(9)
+             << seconds << setprecision(1) << setw(9) << flops / seconds / 1e9 << setprecision(2) << setw(8)
+             << tFloat / seconds << "x" << setw(11) << error << endl;
+    };
+    auto errorOf = [&](const vector<float> &X) {
+        ostringstream out;
+        out << scientific << setprecision(2) << relativeError(X, R, n);
+        return out.str();
+    };
+
+    const hpc::simd_level level = hpc::detected_simd_level();
+    tFloat = bestOf3([&] { hpc::gemm(n, n, n, 1.0f, A.data(), n, B.data(), n, 0.0f, R.data(), n); });
+    report("fp32", hpc::simd_level_name(level), tFloat, "reference");
+
+    double t = bestOf3([&] { hpc::gemm_bf16(n, n, n, 1.0f, Ab.data(), n, Bb.data(), n, 0.0f, C.data(), n); });
+    report("bf16 -> fp32", hpc::half_kernel_name<hpc::bf16>(), t, errorOf(C));
+
+    t = bestOf3([&] { hpc::gemm_fp16(n, n, n, 1.0f, Ah.data(), n, Bh.data(), n, 0.0f, C.data(), n); });
+    report("fp16 -> fp32", hpc::half_kernel_name<hpc::fp16>(), t, errorOf(C));
+
+    t = bestOf3([&] { hpc::gemm_int8(n, n, n, At.data(), n, Bt.data(), n, Ci.data(), n); });
+    report("int8 -> int32", hpc::int8_kernel_name(), t, Ci == Ri ? "exact" : "MISMATCH");
+
+    t = bestOf3([&] {
+        hpc::gemm_int8(n, n, n, 1.0f, At.data(), n, {sAt.data(), hpc::quant_axis::tensor}, Bt.data(), n,
+                       {sBt.data(), hpc::quant_axis::tensor}, 0.0f, C.data(), n);
+    });
+    report("int8, per-tensor scales", hpc::int8_kernel_name(), t, errorOf(C));
+
+    t = bestOf3([&] {
+        hpc::gemm_int8(n, n, n, 1.0f, Ac.data(), n, {sAc.data(), hpc::quant_axis::rows}, Bc.data(), n,
+                       {sBc.data(), hpc::quant_axis::columns}, 0.0f, C.data(), n);
+    });
+    report("int8, per-channel scales", hpc::int8_kernel_name(), t, errorOf(C));
+
+    // The fallbacks a CPU without AVX-512 runs.
+    if (level == hpc::simd_level::avx512)
+    {
+        const hpc::simd_level avx2 = hpc::simd_level::avx2;
+        t = bestOf3([&] { hpc::gemm(n, n, n, 1.0f, A.data(), n, B.data(), n, 0.0f, C.data(), n, avx2); });
+        report("fp32", hpc::simd_level_name(avx2), t, errorOf(C));
+
+        t = bestOf3([&] { hpc::gemm_bf16(n, n, n, 1.0f, Ab.data(), n, Bb.data(), n, 0.0f, C.data(), n, avx2); });
+        report("bf16 -> fp32", hpc::half_kernel_name<hpc::bf16>(avx2), t, errorOf(C));
+
+        t = bestOf3([&] { hpc::gemm_int8(n, n, n, At.data(), n, Bt.data(), n, Ci.data(), n, avx2); });
+        report("int8 -> int32", hpc::int8_kernel_name(avx2), t, Ci == Ri ? "exact" : "MISMATCH");
+    }
+    return 0;
+}
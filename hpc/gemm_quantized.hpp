@@ -0,0 +1,972 @@
+/*
+ * Quantized and Mixed-Precision Matrix Multiply (header-only): int8, bf16, fp16 using OpenMP
+ * ==========================================================================================
+ *
+ * Inference GEMMs do not need 32-bit inputs: weights and activations quantized to int8, or
+ * rounded to bfloat16 / IEEE half, keep enough precision when the products are accumulated
+ * in int32 / fp32. Narrower inputs mean more multiply-adds per instruction (4x int8, 2x
+ * bf16 per fp32 lane on AVX-512) and half or a quarter of the bytes to pack and cache. The
+ * blocking, packing and threading are gemm.hpp's; the micro-kernels take packed pairs or
+ * quads of narrow values per 32-bit lane.
+ *
+ * USAGE:
+ *
+ *   #include "gemm_quantized.hpp"
+ *
+ *   // int8 x int8 -> int32, exact: C (m x n) = A (m x k) * B (k x n)
+ *   hpc::gemm_int8(m, n, k, A8, k, B8, n, C32, n);
+ *
+ *   // Quantize float matrices and multiply back to float: C = alpha * dequant(A8 * B8) + beta * C
+ *   std::vector<float> sa = hpc::quantize_int8(m, k, A, k, A8, k, hpc::quant_axis::rows);    // per row
+ *   std::vector<float> sb = hpc::quantize_int8(k, n, B, n, B8, n, hpc::quant_axis::columns); // per channel
+ *   hpc::gemm_int8(m, n, k, 1.0f, A8, k, {sa.data(), hpc::quant_axis::rows},
+ *                  B8, n, {sb.data(), hpc::quant_axis::columns}, 0.0f, C, n);
+ *
+ *   // bf16 / fp16 inputs, fp32 accumulation and output
+ *   std::vector<hpc::bf16> A16(m * k), B16(k * n);
+ *   hpc::convert_float(m * k, A, A16.data());
+ *   hpc::gemm_bf16(m, n, k, 1.0f, A16.data(), k, B16.data(), n, 0.0f, C, n);
+ *   hpc::gemm_fp16(m, n, k, 1.0f, A16h, k, B16h, n, 0.0f, C, n);
+ *
+ * COMPILATION:
+ *   g++ -std=c++20 -O2 -fopenmp -o program program.cpp
+ * As in gemm.hpp, the kernels carry target attributes and are picked at run time.
+ *
+ * KERNELS:
+ * -------
+ * - int8, AVX-512 VNNI: vpdpbusd adds four u8 x s8 products into each int32 lane, 64
+ *   multiply-adds per instruction. It wants one unsigned operand, so A is packed as
+ *   a + 128 and every column of B gets its compensation 128 * sum(b) subtracted at the end.
+ * - int8, AVX-512BW / AVX2 without VNNI: both operands are widened to int16 when packing
+ *   and vpmaddwd adds pairs of exact 16-bit products. (vpmaddubsw would take bytes
+ *   directly but saturates its int16 pair sums.)
+ * - bf16, AVX-512 BF16: vdpbf16ps adds two bf16 products into each fp32 lane. That is
+ *   only faster if it issues at more than half the rate of the two FMA ports, which not
+ *   every core does, so the two are timed once on first use (a few ms).
+ * - bf16 otherwise, and fp16 everywhere: the values are widened to fp32 while packing and
+ *   run through gemm.hpp's fp32 kernels. AVX-512 FP16 arithmetic accumulates in fp16, which
+ *   is not this contract, so it is not used. The gain is then in memory, not arithmetic.
+ * - Tiles are 12 x 32 on AVX-512 and 6 x 16 on AVX2, as in gemm.hpp; K is blocked in 1 KB
+ *   per packed row (1024 int8, 512 int16 / bf16, 256 fp32), so partial int32 sums of a block
+ *   stay below 2^24 and convert to float exactly.
+ *
+ * SCALES:
+ * ------
+ * - quantize_int8 is symmetric: q = round(x / s), s = max |x| / 127, per tensor, per row or
+ *   per column. Per-channel means per output channel: rows of A (one scale per token or
+ *   sample) and columns of B (one per output feature) factor out of every dot product,
+ *   C[i][j] = s_a[i] * s_b[j] * sum q_a q_b, and are applied in the kernel's epilogue.
+ *   Scales along K (columns of A, rows of B) do not factor out and are rejected.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+#include <omp.h>
+#include "gemm.hpp"
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpsabi"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+namespace hpc
+{
+
+namespace detail
+{
+
+// Round to nearest even; NaN stays NaN.
+inline std::uint16_t float_to_bf16(float x)
+{
+    std::uint32_t u;
+    std::memcpy(&u, &x, sizeof u);
+    if ((u & 0x7fffffffu) > 0x7f800000u)
+        return static_cast<std::uint16_t>((u >> 16) | 0x40u);
+    u += 0x7fffu + ((u >> 16) & 1u);
+    return static_cast<std::uint16_t>(u >> 16);
+}
+
+inline float bf16_to_float(std::uint16_t h)
+{
+    const std::uint32_t u = std::uint32_t(h) << 16;
+    float x;
+    std::memcpy(&x, &u, sizeof x);
+    return x;
+}
+
+// Round to nearest even, overflow to infinity, subnormal halves included.
+inline std::uint16_t float_to_fp16(float x)
+{
+    std::uint32_t u;
+    std::memcpy(&u, &x, sizeof u);
+    const std::uint32_t sign = (u >> 16) & 0x8000u;
+    u &= 0x7fffffffu;
+    if (u >= 0x7f800000u) // infinity, NaN
+        return static_cast<std::uint16_t>(sign | 0x7c00u | (u > 0x7f800000u ? 0x200u : 0u));
+    if (u >= 0x477ff000u) // 65520 and up round to infinity
+        return static_cast<std::uint16_t>(sign | 0x7c00u);
+    if (u < 0x38800000u) // below 2^-14: adding 0.5f leaves the rounded subnormal in the low bits
+    {
+        float f;
+        std::memcpy(&f, &u, sizeof f);
+        f += 0.5f;
+        std::memcpy(&u, &f, sizeof u);
+        return static_cast<std::uint16_t>(sign | (u - 0x3f000000u));
+    }
+    // Rebias the exponent (127 -> 15) and round 23 mantissa bits to 10.
+    u += 0xc8000fffu + ((u >> 13) & 1u);
+    return static_cast<std::uint16_t>(sign | (u >> 13));
+}
+
+inline float fp16_to_float(std::uint16_t h)
+{
+    const std::uint32_t sign = std::uint32_t(h & 0x8000u) << 16, magnitude = h & 0x7fffu;
+    std::uint32_t u;
+    if (magnitude >= 0x7c00u)
+        u = 0x7f800000u | ((magnitude & 0x3ffu) << 13);
+    else
+    {
+        // The half's bits shifted into a float are the value times 2^-112 (subnormals too).
+        u = magnitude << 13;
+        float f;
+        std::memcpy(&f, &u, sizeof f);
+        f *= 0x1p112f;
+        std::memcpy(&u, &f, sizeof u);
+    }
+    u |= sign;
+    float x;
+    std::memcpy(&x, &u, sizeof x);
+    return x;
+}
+
+} // namespace detail
+
+// bfloat16: the upper half of a float (8-bit exponent, 7-bit mantissa).
+struct bf16
+{
+    std::uint16_t bits;
+
+    bf16() = default;
+    explicit bf16(float x) : bits(detail::float_to_bf16(x)) {}
+    explicit operator float() const { return detail::bf16_to_float(bits); }
+};
+
+// IEEE 754 binary16 (5-bit exponent, 10-bit mantissa).
+struct fp16
+{
+    std::uint16_t bits;
+
+    fp16() = default;
+    explicit fp16(float x) : bits(detail::float_to_fp16(x)) {}
+    explicit operator float() const { return detail::fp16_to_float(bits); }
+};
+
+template <class T>
+concept half_float = std::is_same_v<T, bf16> || std::is_same_v<T, fp16>;
+
+// Which scales an int8 matrix carries: one, one per row, or one per column.
+enum class quant_axis
+{
+    tensor,
+    rows,
+    columns
+};
+
+struct quant_scales
+{
+    const float *values = nullptr;
+    quant_axis axis = quant_axis::tensor;
+};
+
+// dst[i] = round-to-nearest-even(src[i]); in parallel for large n.
+template <half_float T>
+void convert_float(std::size_t n, const float *src, T *dst)
+{
+    const long long len = static_cast<long long>(n);
+#pragma omp parallel for simd if (n >= (std::size_t(1) << 18))
+    for (long long i = 0; i < len; i++)
+        dst[i] = T(src[i]);
+}
+
+template <half_float T>
+void convert_float(std::size_t n, const T *src, float *dst)
+{
+    const long long len = static_cast<long long>(n);
+#pragma omp parallel for simd if (n >= (std::size_t(1) << 18))
+    for (long long i = 0; i < len; i++)
+        dst[i] = float(src[i]);
+}
+
+// Symmetric int8 quantization of a rows x cols float matrix: q = round(x / s) in
+// [-127, 127], s = max |x| / 127 over the whole matrix, each row, or each column.
+// Returns the scales (1, rows or cols of them); x == s * q up to rounding.
+inline std::vector<float> quantize_int8(std::size_t rows, std::size_t cols, const float *x, std::size_t ldx,
+                                        std::int8_t *q, std::size_t ldq, quant_axis axis)
+{
+    const std::size_t count = axis == quant_axis::tensor ? 1 : axis == quant_axis::rows ? rows : cols;
+    std::vector<float> scale(count, 0.0f);
+    const long long nrows = static_cast<long long>(rows);
+    const bool parallel = rows * cols >= (std::size_t(1) << 16);
+
+#pragma omp parallel if (parallel)
+    {
+        std::vector<float> local(axis == quant_axis::columns ? cols : 0, 0.0f);
+        float local_max = 0;
+#pragma omp for schedule(static)
+        for (long long i = 0; i < nrows; i++)
+        {
+            const float *row = x + i * ldx;
+            float row_max = 0;
+            for (std::size_t j = 0; j < cols; j++)
+            {
+                const float v = std::fabs(row[j]);
+                row_max = std::max(row_max, v);
+                if (axis == quant_axis::columns)
+                    local[j] = std::max(local[j], v);
+            }
+            if (axis == quant_axis::rows)
+                scale[i] = row_max;
+            local_max = std::max(local_max, row_max);
+        }
+#pragma omp critical
+        {
+            if (axis == quant_axis::columns)
+                for (std::size_t j = 0; j < cols; j++)
+                    scale[j] = std::max(scale[j], local[j]);
+            else if (axis == quant_axis::tensor)
+                scale[0] = std::max(scale[0], local_max);
+        }
+    }
+
+    for (float &s : scale)
+        s = s > 0 ? s / 127.0f : 1.0f;
+
+#pragma omp parallel for schedule(static) if (parallel)
+    for (long long i = 0; i < nrows; i++)
+    {
+        const float *row = x + i * ldx;
+        std::int8_t *out = q + i * ldq;
+        const float *s = axis == quant_axis::rows ? &scale[i] : scale.data();
+        const std::size_t step = axis == quant_axis::columns ? 1 : 0;
+        for (std::size_t j = 0; j < cols; j++)
+            out[j] = static_cast<std::int8_t>(std::clamp(std::nearbyint(row[j] / s[j * step]), -127.0f, 127.0f));
+    }
+    return scale;
+}
+
+namespace detail
+{
+
+// What the micro-kernel does with its accumulators: float output gets
+// alpha * row_scale[i] * col_scale[j] * acc + beta * C (null scales are 1);
+// int32 output is overwritten by the first K block and accumulated by the rest.
+struct mixed_epilogue
+{
+    float alpha = 1, beta = 0;
+    const float *row_scale = nullptr, *col_scale = nullptr;
+};
+
+// Converters applied while packing.
+template <class P>
+struct pack_as
+{
+    template <class In>
+    static P apply(In x) { return static_cast<P>(x); }
+};
+
+struct pack_offset_u8 // a + 128 as the unsigned byte vpdpbusd expects
+{
+    static std::int8_t apply(std::int8_t x) { return static_cast<std::int8_t>(static_cast<std::uint8_t>(x) ^ 0x80u); }
+};
+
+struct pack_bits
+{
+    template <half_float T>
+    static std::uint16_t apply(T x) { return x.bits; }
+};
+
+struct pack_widened
+{
+    template <half_float T>
+    static float apply(T x) { return float(x); }
+};
+
+// Scalar "vector" for the int16-pair format, so the fallback runs the same template.
+struct scalar_madd
+{
+    using packed = std::int16_t;
+    using reg = std::int32_t;
+    using areg = const std::int16_t *;
+    using breg = const std::int16_t *;
+    using F = scalar_vec<float>;
+    using I = scalar_vec<std::int32_t>;
+    static constexpr int width = 1, kr = 2;
+    static constexpr bool compensated = false;
+    static reg zero() { return 0; }
+    static areg broadcast(const packed *a) { return a; }
+    static breg load(const packed *b) { return b; }
+    static reg dot(reg acc, areg a, breg b) { return acc + a[0] * b[0] + a[1] * b[1]; }
+    static F::reg to_float(reg v) { return static_cast<float>(v); }
+    static reg add(reg a, reg b) { return a + b; }
+    static reg sub(reg a, reg b) { return a - b; }
+};
+
+// Micro-kernel over packed groups of V::kr values: acc(MR x NR) = sum of the products,
+// then the epilogue above on the m x n corner inside C; row / col are its position in C.
+// Only ever instantiated inside a target-attributed, flattened caller.
+template <class V, int MR, int NV, class Out>
+inline void dot_tile(std::size_t groups, const typename V::packed *a, const typename V::packed *b, Out *c,
+                     std::size_t ldc, const mixed_epilogue &ep, std::size_t row, std::size_t col, bool first, int m,
+                     int n)
+{
+    constexpr int W = V::width, KR = V::kr, NR = NV * W;
+    using F = typename V::F;
+    using I = typename V::I;
+    typename V::reg acc[MR][NV];
+
+#pragma GCC unroll 16
+    for (int i = 0; i < MR; i++)
+#pragma GCC unroll 4
+        for (int j = 0; j < NV; j++)
+            acc[i][j] = V::zero();
+
+    for (int i = 0; i < MR; i++)
+    {
+        __builtin_prefetch(c + i * ldc, 1);
+        __builtin_prefetch(c + i * ldc + NR - 1, 1);
+    }
+
+    for (std::size_t p = 0; p < groups; p++, a += MR * KR, b += NR * KR)
+    {
+        typename V::breg bv[NV];
+#pragma GCC unroll 4
+        for (int j = 0; j < NV; j++)
+            bv[j] = V::load(b + j * W * KR);
+#pragma GCC unroll 16
+        for (int i = 0; i < MR; i++)
+        {
+            const typename V::areg av = V::broadcast(a + i * KR);
+#pragma GCC unroll 4
+            for (int j = 0; j < NV; j++)
+                acc[i][j] = V::dot(acc[i][j], av, bv[j]);
+        }
+    }
+
+    // b now points just past the panel, at its per-column compensation.
+    if constexpr (V::compensated)
+    {
+        const std::int32_t *comp = reinterpret_cast<const std::int32_t *>(b);
+#pragma GCC unroll 4
+        for (int j = 0; j < NV; j++)
+        {
+            const typename I::reg cj = I::load(comp + j * W);
+#pragma GCC unroll 16
+            for (int i = 0; i < MR; i++)
+                acc[i][j] = V::sub(acc[i][j], cj);
+        }
+    }
+
+    const bool full = m == MR && n == NR;
+    if constexpr (std::is_same_v<Out, std::int32_t>)
+    {
+        if (full)
+        {
+#pragma GCC unroll 16
+            for (int i = 0; i < MR; i++)
+#pragma GCC unroll 4
+                for (int j = 0; j < NV; j++)
+                {
+                    std::int32_t *out = c + i * ldc + j * W;
+                    I::store(out, first ? acc[i][j] : V::add(acc[i][j], I::load(out)));
+                }
+            return;
+        }
+        alignas(64) std::int32_t tile[MR * NR];
+        for (int i = 0; i < MR; i++)
+            for (int j = 0; j < NV; j++)
+                I::store(tile + i * NR + j * W, acc[i][j]);
+        for (int i = 0; i < m; i++)
+            for (int j = 0; j < n; j++)
+                c[i * ldc + j] = first ? tile[i * NR + j] : c[i * ldc + j] + tile[i * NR + j];
+    }
+    else
+    {
+        const float beta = first ? ep.beta : 1.0f;
+        if (full)
+        {
+            typename F::reg scale[NV];
+#pragma GCC unroll 4
+            for (int j = 0; j < NV; j++)
+                scale[j] = ep.col_scale ? F::load(ep.col_scale + col + j * W) : F::set1(1.0f);
+            const typename F::reg vb = F::set1(beta);
+#pragma GCC unroll 16
+            for (int i = 0; i < MR; i++)
+            {
+                const typename F::reg va = F::set1(ep.row_scale ? ep.alpha * ep.row_scale[row + i] : ep.alpha);
+#pragma GCC unroll 4
+                for (int j = 0; j < NV; j++)
+                {
+                    float *out = c + i * ldc + j * W;
+                    const typename F::reg v = F::mul(F::mul(va, scale[j]), V::to_float(acc[i][j]));
+                    // beta == 0 must not read C: it may be uninitialized (or NaN).
+                    F::store(out, beta == 0.0f ? v : F::fmadd(vb, F::load(out), v));
+                }
+            }
+            return;
+        }
+        alignas(64) float tile[MR * NR];
+        for (int i = 0; i < MR; i++)
+            for (int j = 0; j < NV; j++)
+                F::store(tile + i * NR + j * W, V::to_float(acc[i][j]));
+        for (int i = 0; i < m; i++)
+        {
+            const float ai = ep.row_scale ? ep.alpha * ep.row_scale[row + i] : ep.alpha;
+            for (int j = 0; j < n; j++)
+            {
+                const float v = ai * (ep.col_scale ? ep.col_scale[col + j] : 1.0f) * tile[i * NR + j];
+                c[i * ldc + j] = beta == 0.0f ? v : v + beta * c[i * ldc + j];
+            }
+        }
+    }
+}
+
+template <int MR, int NV>
+struct scalar_madd_kernel
+{
+    using packed_type = std::int16_t;
+    static constexpr int mr = MR, nr = NV, kr = 2;
+    static constexpr bool compensated = false;
+    template <class Out>
+    static void tile(std::size_t groups, const packed_type *a, const packed_type *b, Out *c, std::size_t ldc,
+                     const mixed_epilogue &ep, std::size_t row, std::size_t col, bool first, int m, int n)
+    {
+        dot_tile<scalar_madd, MR, NV>(groups, a, b, c, ldc, ep, row, col, first, m, n);
+    }
+};
+
+// fp32 kernels of gemm.hpp behind the mixed interface, for operands widened while packing.
+template <class FloatKernel>
+struct widened_kernel
+{
+    using packed_type = float;
+    static constexpr int mr = FloatKernel::mr, nr = FloatKernel::nr, kr = 1;
+    static constexpr bool compensated = false;
+    static void tile(std::size_t kc, const float *a, const float *b, float *c, std::size_t ldc,
+                     const mixed_epilogue &ep, std::size_t, std::size_t, bool first, int m, int n)
+    {
+        FloatKernel::tile(kc, a, b, c, ldc, ep.alpha, first ? ep.beta : 1.0f, m, n);
+    }
+};
+
+#ifdef HPC_X86_SIMD
+
+struct avx512_vnni_u8s8
+{
+    using packed = std::int8_t;
+    using reg = __m512i;
+    using areg = __m512i;
+    using breg = __m512i;
+    using F = avx512_f32;
+    using I = avx512_i32;
+    static constexpr int width = 16, kr = 4;
+    static constexpr bool compensated = true;
+    __attribute__((target("avx512f,avx512bw,avx512vnni"))) static reg zero() { return _mm512_setzero_si512(); }
+    __attribute__((target("avx512f,avx512bw,avx512vnni"))) static areg broadcast(const packed *a)
+    {
+        std::int32_t quad;
+        std::memcpy(&quad, a, sizeof quad);
+        return _mm512_set1_epi32(quad);
+    }
+    __attribute__((target("avx512f,avx512bw,avx512vnni"))) static breg load(const packed *b) { return _mm512_loadu_si512(b); }
+    __attribute__((target("avx512f,avx512bw,avx512vnni"))) static reg dot(reg acc, areg a, breg b) { return _mm512_dpbusd_epi32(acc, a, b); }
+    __attribute__((target("avx512f,avx512bw,avx512vnni"))) static F::reg to_float(reg v) { return _mm512_cvtepi32_ps(v); }
+    __attribute__((target("avx512f,avx512bw,avx512vnni"))) static reg add(reg a, reg b) { return _mm512_add_epi32(a, b); }
+    __attribute__((target("avx512f,avx512bw,avx512vnni"))) static reg sub(reg a, reg b) { return _mm512_sub_epi32(a, b); }
+};
+
+struct avx512_madd_s16
+{
+    using packed = std::int16_t;
+    using reg = __m512i;
+    using areg = __m512i;
+    using breg = __m512i;
+    using F = avx512_f32;
+    using I = avx512_i32;
+    static constexpr int width = 16, kr = 2;
+    static constexpr bool compensated = false;
+    __attribute__((target("avx512f,avx512bw"))) static reg zero() { return _mm512_setzero_si512(); }
+    __attribute__((target("avx512f,avx512bw"))) static areg broadcast(const packed *a)
+    {
+        std::int32_t pair;
+        std::memcpy(&pair, a, sizeof pair);
+        return _mm512_set1_epi32(pair);
+    }
+    __attribute__((target("avx512f,avx512bw"))) static breg load(const packed *b) { return _mm512_loadu_si512(b); }
+    __attribute__((target("avx512f,avx512bw"))) static reg dot(reg acc, areg a, breg b) { return _mm512_add_epi32(acc, _mm512_madd_epi16(a, b)); }
+    __attribute__((target("avx512f,avx512bw"))) static F::reg to_float(reg v) { return _mm512_cvtepi32_ps(v); }
+    __attribute__((target("avx512f,avx512bw"))) static reg add(reg a, reg b) { return _mm512_add_epi32(a, b); }
+    __attribute__((target("avx512f,avx512bw"))) static reg sub(reg a, reg b) { return _mm512_sub_epi32(a, b); }
+};
+
+struct avx2_madd_s16
+{
+    using packed = std::int16_t;
+    using reg = __m256i;
+    using areg = __m256i;
+    using breg = __m256i;
+    using F = avx2_f32;
+    using I = avx2_i32;
+    static constexpr int width = 8, kr = 2;
+    static constexpr bool compensated = false;
+    __attribute__((target("avx2,fma"))) static reg zero() { return _mm256_setzero_si256(); }
+    __attribute__((target("avx2,fma"))) static areg broadcast(const packed *a)
+    {
+        std::int32_t pair;
+        std::memcpy(&pair, a, sizeof pair);
+        return _mm256_set1_epi32(pair);
+    }
+    __attribute__((target("avx2,fma"))) static breg load(const packed *b) { return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b)); }
+    __attribute__((target("avx2,fma"))) static reg dot(reg acc, areg a, breg b) { return _mm256_add_epi32(acc, _mm256_madd_epi16(a, b)); }
+    __attribute__((target("avx2,fma"))) static F::reg to_float(reg v) { return _mm256_cvtepi32_ps(v); }
+    __attribute__((target("avx2,fma"))) static reg add(reg a, reg b) { return _mm256_add_epi32(a, b); }
+    __attribute__((target("avx2,fma"))) static reg sub(reg a, reg b) { return _mm256_sub_epi32(a, b); }
+};
+
+struct avx512_bf16_dot
+{
+    using packed = std::uint16_t;
+    using reg = __m512;
+    using areg = __m512i;
+    using breg = __m512i;
+    using F = avx512_f32;
+    using I = avx512_i32;
+    static constexpr int width = 16, kr = 2;
+    static constexpr bool compensated = false;
+    __attribute__((target("avx512f,avx512bw,avx512bf16"))) static reg zero() { return _mm512_setzero_ps(); }
+    __attribute__((target("avx512f,avx512bw,avx512bf16"))) static areg broadcast(const packed *a)
+    {
+        std::int32_t pair;
+        std::memcpy(&pair, a, sizeof pair);
+        return _mm512_set1_epi32(pair);
+    }
+    __attribute__((target("avx512f,avx512bw,avx512bf16"))) static breg load(const packed *b) { return _mm512_loadu_si512(b); }
+    __attribute__((target("avx512f,avx512bw,avx512bf16"))) static reg dot(reg acc, areg a, breg b)
+    {
+        return _mm512_dpbf16_ps(acc, (__m512bh)a, (__m512bh)b);
+    }
+    __attribute__((target("avx512f,avx512bw,avx512bf16"))) static F::reg to_float(reg v) { return v; }
+};
+
+template <int MR, int NV>
+struct vnni_kernel
+{
+    using packed_type = std::int8_t;
+    static constexpr int mr = MR, nr = NV * 16, kr = 4;
+    static constexpr bool compensated = true;
+    template <class Out>
+    __attribute__((target("avx512f,avx512bw,avx512vnni"), flatten)) static void
+    tile(std::size_t groups, const packed_type *a, const packed_type *b, Out *c, std::size_t ldc,
+         const mixed_epilogue &ep, std::size_t row, std::size_t col, bool first, int m, int n)
+    {
+        dot_tile<avx512_vnni_u8s8, MR, NV>(groups, a, b, c, ldc, ep, row, col, first, m, n);
+    }
+};
+
+template <int MR, int NV>
+struct avx512_madd_kernel
+{
+    using packed_type = std::int16_t;
+    static constexpr int mr = MR, nr = NV * 16, kr = 2;
+    static constexpr bool compensated = false;
+    template <class Out>
+    __attribute__((target("avx512f,avx512bw"), flatten)) static void
+    tile(std::size_t groups, const packed_type *a, const packed_type *b, Out *c, std::size_t ldc,
+         const mixed_epilogue &ep, std::size_t row, std::size_t col, bool first, int m, int n)
+    {
+        dot_tile<avx512_madd_s16, MR, NV>(groups, a, b, c, ldc, ep, row, col, first, m, n);
+    }
+};
+
+template <int MR, int NV>
+struct avx2_madd_kernel
+{
+    using packed_type = std::int16_t;
+    static constexpr int mr = MR, nr = NV * 8, kr = 2;
+    static constexpr bool compensated = false;
+    template <class Out>
+    __attribute__((target("avx2,fma"), flatten)) static void
+    tile(std::size_t groups, const packed_type *a, const packed_type *b, Out *c, std::size_t ldc,
+         const mixed_epilogue &ep, std::size_t row, std::size_t col, bool first, int m, int n)
+    {
+        dot_tile<avx2_madd_s16, MR, NV>(groups, a, b, c, ldc, ep, row, col, first, m, n);
+    }
+};
+
+template <int MR, int NV>
+struct bf16_dot_kernel
+{
+    using packed_type = std::uint16_t;
+    static constexpr int mr = MR, nr = NV * 16, kr = 2;
+    static constexpr bool compensated = false;
+    __attribute__((target("avx512f,avx512bw,avx512bf16"), flatten)) static void
+    tile(std::size_t groups, const packed_type *a, const packed_type *b, float *c, std::size_t ldc,
+         const mixed_epilogue &ep, std::size_t row, std::size_t col, bool first, int m, int n)
+    {
+        dot_tile<avx512_bf16_dot, MR, NV>(groups, a, b, c, ldc, ep, row, col, first, m, n);
+    }
+};
+
+// vdpbf16ps in place of an FMA, for peak_chains: two products per lane.
+struct avx512_bf16_peak
+{
+    using value_type = float;
+    using reg = __m512;
+    static constexpr int width = 16;
+    __attribute__((target("avx512f,avx512bw,avx512bf16"))) static reg set1(float x) { return _mm512_set1_ps(x); }
+    __attribute__((target("avx512f,avx512bw,avx512bf16"))) static void store(float *p, reg v) { _mm512_storeu_ps(p, v); }
+    __attribute__((target("avx512f,avx512bw,avx512bf16"))) static reg fmadd(reg acc, reg x, reg y)
+    {
+        return _mm512_dpbf16_ps(acc, (__m512bh)_mm512_castps_si512(x), (__m512bh)_mm512_castps_si512(y));
+    }
+};
+
+__attribute__((target("avx512f,avx512bw,avx512bf16"), flatten)) inline double peak_bf16_dot(std::size_t iterations)
+{
+    return 2 * peak_chains<avx512_bf16_peak, 24>(iterations);
+}
+
+#endif // HPC_X86_SIMD
+
+// Rows [0, mc) x columns [0, kc) of A into MR-row panels of KR-element groups: group p
+// of row i of a panel is at (p * MR + i) * KR. K is padded to a multiple of KR.
+template <int MR, int KR, class Convert, class P, class In>
+void pack_a_groups(std::size_t mc, std::size_t kc, const In *a, std::size_t lda, P *out)
+{
+    const std::size_t groups = (kc + KR - 1) / KR;
+    const P pad = Convert::apply(In{});
+    for (std::size_t r = 0; r < mc; r += MR, out += MR * groups * KR)
+    {
+        const int rows = static_cast<int>(std::min<std::size_t>(MR, mc - r));
+        for (std::size_t p = 0; p < groups; p++)
+            for (int i = 0; i < MR; i++)
+                for (int t = 0; t < KR; t++)
+                {
+                    const std::size_t kk = p * KR + t;
+                    out[(p * MR + i) * KR + t] = i < rows && kk < kc ? Convert::apply(a[(r + i) * lda + kk]) : pad;
+                }
+    }
+}
+
+// Columns [0, cols) of a kc-row block of B into one NR-wide panel: group p of column j
+// at (p * NR + j) * KR, zero-padded. A compensated panel is followed by NR int32:
+// 128 * (the column's sum), which the VNNI kernel subtracts.
+template <int NR, int KR, bool Compensated, class Convert, class P, class In>
+void pack_b_groups(std::size_t kc, std::size_t cols, const In *b, std::size_t ldb, P *out)
+{
+    const std::size_t groups = (kc + KR - 1) / KR;
+    for (std::size_t p = 0; p < groups; p++)
+        for (int t = 0; t < KR; t++)
+        {
+            const std::size_t kk = p * KR + t;
+            for (std::size_t j = 0; j < NR; j++)
+                out[(p * NR + j) * KR + t] = kk < kc && j < cols ? Convert::apply(b[kk * ldb + j]) : P(0);
+        }
+    if constexpr (Compensated)
+    {
+        std::int32_t comp[NR] = {};
+        for (std::size_t p = 0; p < groups; p++)
+            for (std::size_t j = 0; j < NR; j++)
+                for (int t = 0; t < KR; t++)
+                    comp[j] += out[(p * NR + j) * KR + t];
+        for (std::size_t j = 0; j < NR; j++)
+            comp[j] *= 128;
+        std::memcpy(out + groups * KR * NR, comp, sizeof comp);
+    }
+}
+
+// gemm.hpp's blocked loop nest for narrow inputs: In is packed as Kernel::packed_type
+// through ConvertA / ConvertB, and K blocks hold 1 KB of packed values per row.
+template <class Kernel, class ConvertA, class ConvertB, class In, class Out>
+void mixed_blocked(std::size_t m, std::size_t n, std::size_t k, const In *a, std::size_t lda, const In *b,
+                   std::size_t ldb, Out *c, std::size_t ldc, const mixed_epilogue &ep)
+{
+    using P = typename Kernel::packed_type;
+    constexpr std::size_t MR = Kernel::mr, NR = Kernel::nr, KR = Kernel::kr;
+    constexpr std::size_t kc_block = gemm_kc * sizeof(float) / sizeof(P);
+    constexpr std::size_t comp_elems = Kernel::compensated ? NR * sizeof(std::int32_t) / sizeof(P) : 0;
+    const std::size_t kc_max = std::min(kc_block, k);
+    const std::size_t groups_max = (kc_max + KR - 1) / KR;
+    const std::size_t nc_max = std::min(std::max(gemm_l3_bytes / (kc_block * sizeof(P)) / NR, std::size_t(1)) * NR,
+                                        (n + NR - 1) / NR * NR);
+    const int threads = gemm_threads(double(m) * double(n) * double(k));
+
+    std::size_t mc = std::max(gemm_l2_bytes / (kc_block * sizeof(P)) / MR, std::size_t(1)) * MR;
+    mc = std::min(mc, std::max((m + threads - 1) / threads + MR - 1, MR) / MR * MR);
+    const std::size_t row_blocks = (m + mc - 1) / mc;
+
+    const std::size_t panel_max = groups_max * KR * NR + comp_elems;
+    auto b_pack = gemm_buffer<P>(nc_max / NR * panel_max);
+
+#pragma omp parallel num_threads(threads) if (threads > 1)
+    {
+        auto a_pack = gemm_buffer<P>(mc * groups_max * KR);
+
+        for (std::size_t jc = 0; jc < n; jc += nc_max)
+        {
+            const std::size_t nc = std::min(nc_max, n - jc);
+            const std::size_t panels = (nc + NR - 1) / NR;
+            const std::size_t col_groups = std::min(panels, (threads + row_blocks - 1) / row_blocks);
+
+            for (std::size_t pc = 0; pc < k; pc += kc_max)
+            {
+                const std::size_t kc = std::min(kc_max, k - pc);
+                const std::size_t groups = (kc + KR - 1) / KR;
+                const std::size_t panel = groups * KR * NR + comp_elems;
+
+#pragma omp for schedule(static)
+                for (std::size_t jp = 0; jp < panels; jp++)
+                    pack_b_groups<NR, KR, Kernel::compensated, ConvertB>(
+                        kc, std::min(NR, nc - jp * NR), b + pc * ldb + jc + jp * NR, ldb, b_pack.get() + jp * panel);
+
+                std::size_t packed = row_blocks;
+#pragma omp for schedule(dynamic)
+                for (std::size_t item = 0; item < row_blocks * col_groups; item++)
+                {
+                    const std::size_t ib = item / col_groups, g = item % col_groups;
+                    const std::size_t ic = ib * mc, mcur = std::min(mc, m - ic);
+                    if (packed != ib)
+                    {
+                        pack_a_groups<MR, KR, ConvertA>(mcur, kc, a + ic * lda + pc, lda, a_pack.get());
+                        packed = ib;
+                    }
+                    for (std::size_t jp = panels * g / col_groups; jp < panels * (g + 1) / col_groups; jp++)
+                        for (std::size_t ir = 0; ir < mcur; ir += MR)
+                            Kernel::tile(groups, a_pack.get() + ir * groups * KR,
+                                         b_pack.get() + jp * panel, c + (ic + ir) * ldc + jc + jp * NR, ldc, ep,
+                                         ic + ir, jc + jp * NR, pc == 0, static_cast<int>(std::min(MR, mcur - ir)),
+                                         static_cast<int>(std::min(NR, nc - jp * NR)));
+                }
+            }
+        }
+    }
+}
+
+enum class int8_path
+{
+    vnni512,
+    madd512,
+    madd256,
+    scalar
+};
+
+inline int8_path select_int8(simd_level level)
+{
+    level = gemm_level(level, true); // the float epilogue uses FMA
+#ifdef HPC_X86_SIMD
+    if (level == simd_level::avx512 && __builtin_cpu_supports("avx512bw"))
+        return __builtin_cpu_supports("avx512vnni") ? int8_path::vnni512 : int8_path::madd512;
+    if (level >= simd_level::avx2)
+        return int8_path::madd256;
+#endif
+    return int8_path::scalar;
+}
+
+// Whether gemm_bf16 runs the vdpbf16ps kernel at `level` (otherwise fp32 FMA on widened
+// values). Two products per instruction only pay if the instruction issues at more than
+// half the FMA rate: it matches two FMA ports on Cooper Lake, but some cores issue it once
+// every other cycle, at a quarter of the FMA rate. So the two are timed once, on one core.
+inline bool bf16_native(simd_level level)
+{
+#ifdef HPC_X86_SIMD
+    if (gemm_level(level, true) != simd_level::avx512 || !__builtin_cpu_supports("avx512bw") ||
+        !__builtin_cpu_supports("avx512bf16"))
+        return false;
+    constexpr std::size_t iterations = std::size_t(1) << 18;
+    static const bool pays = peak_bf16_dot(iterations) > 1.1 * peak_avx512<avx512_f32>(iterations);
+    return pays;
+#else
+    (void)level;
+    return false;
+#endif
+}
+
+template <class Out>
+void gemm_int8_run(std::size_t m, std::size_t n, std::size_t k, const std::int8_t *a, std::size_t lda,
+                   const std::int8_t *b, std::size_t ldb, Out *c, std::size_t ldc, const mixed_epilogue &ep,
+                   simd_level level)
+{
+    switch (select_int8(level))
+    {
+#ifdef HPC_X86_SIMD
+    case int8_path::vnni512:
+        return mixed_blocked<vnni_kernel<12, 2>, pack_offset_u8, pack_as<std::int8_t>>(m, n, k, a, lda, b, ldb, c, ldc, ep);
+    case int8_path::madd512:
+        return mixed_blocked<avx512_madd_kernel<12, 2>, pack_as<std::int16_t>, pack_as<std::int16_t>>(m, n, k, a, lda, b, ldb, c, ldc, ep);
+    case int8_path::madd256:
+        return mixed_blocked<avx2_madd_kernel<6, 2>, pack_as<std::int16_t>, pack_as<std::int16_t>>(m, n, k, a, lda, b, ldb, c, ldc, ep);
+#endif
+    default:
+        return mixed_blocked<scalar_madd_kernel<4, 4>, pack_as<std::int16_t>, pack_as<std::int16_t>>(m, n, k, a, lda, b, ldb, c, ldc, ep);
+    }
+}
+
+template <half_float T>
+void gemm_half_run(std::size_t m, std::size_t n, std::size_t k, const T *a, std::size_t lda, const T *b,
+                   std::size_t ldb, float *c, std::size_t ldc, const mixed_epilogue &ep, simd_level level)
+{
+    level = gemm_level(level, true);
+#ifdef HPC_X86_SIMD
+    if constexpr (std::is_same_v<T, bf16>)
+        if (bf16_native(level))
+            return mixed_blocked<bf16_dot_kernel<12, 2>, pack_bits, pack_bits>(m, n, k, a, lda, b, ldb, c, ldc, ep);
+    if (level == simd_level::avx512)
+        return mixed_blocked<widened_kernel<avx512_gemm_kernel<avx512_f32, 12, 2>>, pack_widened, pack_widened>(m, n, k, a, lda, b, ldb, c, ldc, ep);
+    if (level == simd_level::avx2)
+        return mixed_blocked<widened_kernel<avx2_gemm_kernel<avx2_f32, 6, 2>>, pack_widened, pack_widened>(m, n, k, a, lda, b, ldb, c, ldc, ep);
+#endif
+    mixed_blocked<widened_kernel<scalar_gemm_kernel<float>>, pack_widened, pack_widened>(m, n, k, a, lda, b, ldb, c, ldc, ep);
+}
+
+// C = beta * C when there is nothing to multiply.
+inline void scale_output(std::size_t m, std::size_t n, float beta, float *c, std::size_t ldc)
+{
+    for (std::size_t i = 0; i < m; i++)
+        for (std::size_t j = 0; j < n; j++)
+            c[i * ldc + j] = beta == 0.0f ? 0.0f : beta * c[i * ldc + j];
+}
+
+} // namespace detail
+
+// C (m x n) = A (m x k) * B (k x n) in exact int32 arithmetic, all row-major with
+// leading dimensions lda >= k, ldb >= n, ldc >= n. Sums wrap past int32 like hpc::gemm's.
+inline void gemm_int8(std::size_t m, std::size_t n, std::size_t k, const std::int8_t *a, std::size_t lda,
+                      const std::int8_t *b, std::size_t ldb, std::int32_t *c, std::size_t ldc,
+                      simd_level level = detected_simd_level())
+{
+    if (m == 0 || n == 0)
+        return;
+    if (k == 0)
+    {
+        for (std::size_t i = 0; i < m; i++)
+            std::fill(c + i * ldc, c + i * ldc + n, 0);
+        return;
+    }
+    detail::gemm_int8_run(m, n, k, a, lda, b, ldb, c, ldc, {}, level);
+}
+
+// C = alpha * (s_a * A) (s_b * B) + beta * C with A, B quantized: s_a per tensor or per
+// row of A, s_b per tensor or per column of B. With beta == 0, C is not read.
+inline void gemm_int8(std::size_t m, std::size_t n, std::size_t k, float alpha, const std::int8_t *a,
+                      std::size_t lda, quant_scales a_scales, const std::int8_t *b, std::size_t ldb,
+                      quant_scales b_scales, float beta, float *c, std::size_t ldc,
+                      simd_level level = detected_simd_level())
+{
+    if (!a_scales.values || !b_scales.values)
+        throw std::invalid_argument("gemm_int8: missing scales");
+    if (a_scales.axis == quant_axis::columns || b_scales.axis == quant_axis::rows)
+        throw std::invalid_argument("gemm_int8: scales along K (columns of A, rows of B) do not factor out");
+    if (m == 0 || n == 0)
+        return;
+    if (k == 0)
+        return detail::scale_output(m, n, beta, c, ldc);
+
+    detail::mixed_epilogue ep;
+    ep.alpha = alpha * (a_scales.axis == quant_axis::tensor ? a_scales.values[0] : 1.0f) *
+               (b_scales.axis == quant_axis::tensor ? b_scales.values[0] : 1.0f);
+    ep.beta = beta;
+    ep.row_scale = a_scales.axis == quant_axis::rows ? a_scales.values : nullptr;
+    ep.col_scale = b_scales.axis == quant_axis::columns ? b_scales.values : nullptr;
+    detail::gemm_int8_run(m, n, k, a, lda, b, ldb, c, ldc, ep, level);
+}
+
+// C = alpha * A * B + beta * C with bf16 / fp16 inputs, products accumulated in fp32.
+template <half_float T>
+void gemm_half(std::size_t m, std::size_t n, std::size_t k, float alpha, const T *a, std::size_t lda, const T *b,
+               std::size_t ldb, float beta, float *c, std::size_t ldc, simd_level level = detected_simd_level())
+{
+    if (m == 0 || n == 0)
+        return;
+    if (k == 0)
+        return detail::scale_output(m, n, beta, c, ldc);
+    detail::mixed_epilogue ep;
+    ep.alpha = alpha;
+    ep.beta = beta;
+    detail::gemm_half_run(m, n, k, a, lda, b, ldb, c, ldc, ep, level);
+}
+
+inline void gemm_bf16(std::size_t m, std::size_t n, std::size_t k, float alpha, const bf16 *a, std::size_t lda,
+                      const bf16 *b, std::size_t ldb, float beta, float *c, std::size_t ldc,
+                      simd_level level = detected_simd_level())
+{
+    gemm_half(m, n, k, alpha, a, lda, b, ldb, beta, c, ldc, level);
+}
+
+inline void gemm_fp16(std::size_t m, std::size_t n, std::size_t k, float alpha, const fp16 *a, std::size_t lda,
+                      const fp16 *b, std::size_t ldb, float beta, float *c, std::size_t ldc,
+                      simd_level level = detected_simd_level())
+{
+    gemm_half(m, n, k, alpha, a, lda, b, ldb, beta, c, ldc, level);
+}
+
+// Multiply-add throughput of vdpbf16ps on `threads` threads, in GFLOP/s counted as in
+// simd_peak_gflops (two products per lane, four flops); 0 without AVX-512 BF16.
+inline double bf16_dot_peak_gflops(int threads = omp_get_max_threads())
+{
+    double total = 0;
+#ifdef HPC_X86_SIMD
+    if (!__builtin_cpu_supports("avx512bw") || !__builtin_cpu_supports("avx512bf16"))
+        return 0;
+#pragma omp parallel num_threads(std::max(threads, 1)) reduction(+ : total)
+    total += detail::peak_bf16_dot(20'000'000 / 4);
+#else
+    (void)threads;
+#endif
+    return total;
+}
+
+// The kernel gemm_int8 / gemm_bf16 / gemm_fp16 run at `level` on this CPU.
+inline const char *int8_kernel_name(simd_level level = detected_simd_level())
+{
+    switch (detail::select_int8(level))
+    {
+    case detail::int8_path::vnni512:
+        return "AVX-512 VNNI";
+    case detail::int8_path::madd512:
+        return "AVX-512BW vpmaddwd";
+    case detail::int8_path::madd256:
+        return "AVX2 vpmaddwd";
+    default:
+        return "scalar";
+    }
+}
+
+template <half_float T>
+const char *half_kernel_name(simd_level level = detected_simd_level())
+{
+    if (std::is_same_v<T, bf16> && detail::bf16_native(level))
+        return "AVX-512 BF16";
+    switch (detail::gemm_level(level, true))
+    {
+    case simd_level::avx512:
+        return "AVX-512 fp32, widened";
+    case simd_level::avx2:
+        return "AVX2 fp32, widened";
+    default:
+        return "scalar fp32, widened";
+    }
+}
+
+} // namespace hpc
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
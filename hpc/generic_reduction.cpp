@@ -0,0 +1,267 @@
+/*
+ * Generic Parallel Reduction Demo using reduce.hpp
+ * ================================================
+ *
+ * COMPILATION & EXECUTION:
+ *
+ * For Ubuntu:
+ * -----------
+ * g++ -std=c++20 -O2 -fopenmp -o generic_reduction generic_reduction.cpp
+ * ./generic_reduction
+ *
+ * For macOS:
+ * ----------
+ * g++ -std=c++20 -O2 -Xpreprocessor -fopenmp -I"$(brew --prefix libomp)/include" -L"$(brew --prefix libomp)/lib" -lomp -o generic_reduction generic_reduction.cpp
+ * ./generic_reduction
+ *
+ * THEORETICAL CONCEPTS:
+ *
+ * Reductions as Monoids:
+ * ---------------------
+ * - parallel_reduction.cpp hard-codes min, max, sum and average on vector<int>
+ * - Any associative combine with an identity (a monoid) reduces in parallel the same way:
+ *   every thread folds its slice, then the partials are combined
+ * - argmin carries (value, index); variance carries (count, mean, M2); a composition of
+ *   functions carries the composed function. None of these fit OpenMP's reduction clause
+ *
+ * Order Matters, Commutativity Does Not:
+ * -------------------------------------
+ * - Composing affine maps f(x) = a*x + b is associative but not commutative
+ * - The framework keeps slices and partials in input order, so it still gets the right answer
+ *
+ * Welford / Chan Variance:
+ * -----------------------
+ * - sum(x^2)/n - mean^2 cancels catastrophically when the mean is large compared to the spread
+ * - Welford updates mean and M2 incrementally; Chan's formula merges two (count, mean, M2) triples
+ *
+ * False Sharing and the Tree Combine:
+ * ----------------------------------
+ * - Per-thread partials sit on separate 64-byte cache lines, so threads never invalidate each other
+ * - Partials are combined pairwise in log2(p) rounds instead of one thread walking all p
+ *
+ * SAMPLE INPUT/OUTPUT:
+ * ------------------
+ *
+ * Input:
+ *   20000000                     (Array size)
+ *
+ * Output (single core; the point is matching hand-written OpenMP, not speedup):
+ *   Threads: 1
+ *
+ *   sum (int -> int64)    hand-written:  0.0219 s   hpc::parallel_reduce:  0.0146 s   match
+ *   min                   hand-written:  0.0219 s   hpc::parallel_reduce:  0.0227 s   match
+ *   max                   hand-written:  0.0219 s   hpc::parallel_reduce:  0.0230 s   match
+ *   argmin (std::)        hand-written:  0.0651 s   hpc::parallel_reduce:  0.0211 s   match
+ *   argmax (std::)        hand-written:  0.0668 s   hpc::parallel_reduce:  0.0198 s   match
+ *   product (double)      hand-written:  0.0407 s   hpc::parallel_reduce:  0.0482 s   match
+ *   xor                   hand-written:  0.0208 s   hpc::parallel_reduce:  0.0204 s   match
+ *   variance              hand-written:  0.0294 s   hpc::parallel_reduce:  0.0365 s   match
+ *       exact 83347.007069, naive sum of squares -270976.000000, Welford 83347.007069 (stddev 288.698817)
+ *   priciest order        hand-written:  0.0475 s   hpc::parallel_reduce:  0.0744 s   match
+ *   affine composition    hand-written:  0.1440 s   hpc::parallel_reduce:  0.1452 s   match
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <deque>
+#include <random>
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <omp.h>
+#include "reduce.hpp"
+using namespace std;
+
+struct Order
+{
+    long long id;
+    double price;
+};
+
+// f(x) = a*x + b (mod p); composing two gives another affine map
+struct Affine
+{
+    long long a, b;
+};
+
+const long long MOD = 1000000007;
+
+// Apply f first, then g
+Affine compose(const Affine &f, const Affine &g)
+{
+    return {g.a * f.a % MOD, (g.a * f.b + g.b) % MOD};
+}
+
+template <class Fn>
+double timeIt(const Fn &fn)
+{
+    double best = 1e30;
+    for (int rep = 0; rep < 3; rep++)
+    {
+        double start = omp_get_wtime();
+        fn();
+        best = min(best, omp_get_wtime() - start);
+    }
+    return best;
+}
+
+void row(const string &name, double tHand, double tGeneric, bool ok)
+{
+    cout << left << setw(22) << name << right << fixed << setprecision(4) << "hand-written: " << setw(7) << tHand
+         << " s   hpc::parallel_reduce: " << setw(7) << tGeneric << " s   " << (ok ? "match" : "MISMATCH") << endl;
+}
+
+int main()
+{
+    int n;
+    cout << "Enter the size of the array: ";
+    cin >> n;
+
+    if (n <= 0)
+    {
+        cout << "Invalid array size!" << endl;
+        return 1;
+    }
+
+    mt19937_64 rng(42);
+    vector<int> ints(n);
+    vector<double> doubles(n), near_one(n);
+    vector<Order> orders(n);
+    vector<Affine> maps(n);
+    for (int i = 0; i < n; i++)
+    {
+        ints[i] = static_cast<int>(rng() % 2000001) - 1000000;
+        doubles[i] = 1e9 + (rng() % 1000000) / 1000.0; // large mean, small spread
+        near_one[i] = 1.0 + ((rng() % 2001) - 1000.0) * 1e-9;
+        orders[i] = {i, (rng() % 10000000) / 100.0};
+        maps[i] = {static_cast<long long>(rng() % MOD), static_cast<long long>(rng() % MOD)};
+    }
+
+    cout << "\nThreads: " << omp_get_max_threads() << "\n" << endl;
+
+    // Sum
+    long long handSum = 0, sum = 0;
+    double tHand = timeIt([&] {
+        long long s = 0;
+#pragma omp parallel for reduction(+ : s)
+        for (int i = 0; i < n; i++)
+            s += ints[i];
+        handSum = s;
+    });
+    double tGen = timeIt([&] { sum = hpc::parallel_reduce(ints, hpc::reducers::sum<long long>()); });
+    row("sum (int -> int64)", tHand, tGen, sum == handSum);
+
+    // Min / max
+    int handMin = 0, handMax = 0, mn = 0, mx = 0;
+    tHand = timeIt([&] {
+        int m = INT_MAX;
+#pragma omp parallel for reduction(min : m)
+        for (int i = 0; i < n; i++)
+            m = ints[i] < m ? ints[i] : m;
+        handMin = m;
+    });
+    tGen = timeIt([&] { mn = hpc::parallel_reduce(ints, hpc::reducers::min<int>()); });
+    row("min", tHand, tGen, mn == handMin);
+    tHand = timeIt([&] {
+        int m = INT_MIN;
+#pragma omp parallel for reduction(max : m)
+        for (int i = 0; i < n; i++)
+            m = ints[i] > m ? ints[i] : m;
+        handMax = m;
+    });
+    tGen = timeIt([&] { mx = hpc::parallel_reduce(ints, hpc::reducers::max<int>()); });
+    row("max", tHand, tGen, mx == handMax);
+
+    // Argmin / argmax against the sequential standard algorithms
+    hpc::indexed_value<int> amin, amax;
+    tHand = timeIt([&] { handMin = int(min_element(ints.begin(), ints.end()) - ints.begin()); });
+    tGen = timeIt([&] { amin = hpc::parallel_reduce(ints, hpc::reducers::argmin<int>()); });
+    row("argmin (std::)", tHand, tGen, amin.index == size_t(handMin));
+    tHand = timeIt([&] { handMax = int(max_element(ints.begin(), ints.end()) - ints.begin()); });
+    tGen = timeIt([&] { amax = hpc::parallel_reduce(ints, hpc::reducers::argmax<int>()); });
+    row("argmax (std::)", tHand, tGen, amax.index == size_t(handMax));
+
+    // Product
+    double handProd = 1, prod = 1;
+    tHand = timeIt([&] {
+        double p = 1;
+#pragma omp parallel for reduction(* : p)
+        for (int i = 0; i < n; i++)
+            p *= near_one[i];
+        handProd = p;
+    });
+    tGen = timeIt([&] { prod = hpc::parallel_reduce(near_one, hpc::reducers::product<double>()); });
+    row("product (double)", tHand, tGen, fabs(prod - handProd) <= 1e-9 * fabs(handProd));
+
+    // Bitwise xor
+    unsigned handXor = 0, x = 0;
+    tHand = timeIt([&] {
+        unsigned v = 0;
+#pragma omp parallel for reduction(^ : v)
+        for (int i = 0; i < n; i++)
+            v ^= unsigned(ints[i]);
+        handXor = v;
+    });
+    tGen = timeIt([&] {
+        x = hpc::parallel_reduce(ints, hpc::make_reduction(0u, bit_xor<unsigned>(),
+                                                           [](unsigned &acc, int v) { acc ^= unsigned(v); }));
+    });
+    row("xor", tHand, tGen, x == handXor);
+
+    // Variance: naive sum of squares vs Welford
+    double naiveVar = 0;
+    hpc::moments m;
+    tHand = timeIt([&] {
+        double s = 0, sq = 0;
+#pragma omp parallel for reduction(+ : s, sq)
+        for (int i = 0; i < n; i++)
+        {
+            s += doubles[i];
+            sq += doubles[i] * doubles[i];
+        }
+        naiveVar = sq / n - (s / n) * (s / n);
+    });
+    tGen = timeIt([&] { m = hpc::parallel_reduce(doubles, hpc::reducers::welford()); });
+    double exactMean = 0, exactVar = 0;
+    for (double v : doubles)
+        exactMean += v;
+    exactMean /= n;
+    for (double v : doubles)
+        exactVar += (v - exactMean) * (v - exactMean);
+    exactVar /= n;
+    row("variance", tHand, tGen, fabs(m.variance() - exactVar) <= 1e-6 * exactVar);
+    cout << "    exact " << setprecision(6) << exactVar << ", naive sum of squares " << naiveVar << ", Welford "
+         << m.variance() << " (stddev " << m.stddev() << ")" << endl;
+
+    // Custom monoid on a struct: most expensive order, reduced from a deque (no SIMD kernel)
+    deque<Order> orderQueue(orders.begin(), orders.end());
+    auto priciest = hpc::make_reduction(
+        Order{-1, -1.0}, [](const Order &a, const Order &b) { return b.price > a.price ? b : a; },
+        [](Order &acc, const Order &o) {
+            if (o.price > acc.price)
+                acc = o;
+        });
+    Order best{}, handBest{};
+    tHand = timeIt([&] {
+        handBest = *max_element(orders.begin(), orders.end(),
+                                [](const Order &a, const Order &b) { return a.price < b.price; });
+    });
+    tGen = timeIt([&] { best = hpc::parallel_reduce(orderQueue, priciest); });
+    row("priciest order", tHand, tGen, best.id == handBest.id);
+
+    // Non-commutative monoid: compose n affine maps in order
+    Affine handComp{1, 0}, comp{1, 0};
+    tHand = timeIt([&] {
+        Affine f{1, 0};
+        for (const Affine &g : maps)
+            f = compose(f, g);
+        handComp = f;
+    });
+    tGen = timeIt([&] {
+        comp = hpc::parallel_reduce(maps, hpc::make_reduction(Affine{1, 0}, compose,
+                                                              [](Affine &acc, const Affine &g) { acc = compose(acc, g); }));
+    });
+    row("affine composition", tHand, tGen, comp.a == handComp.a && comp.b == handComp.b);
+    return 0;
+}
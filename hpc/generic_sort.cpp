@@ -0,0 +1,157 @@
+/*
+ * Generic Parallel Sort Demo using parallel_sort.hpp
+ * ==================================================
+ *
+ * INSTALLATION INSTRUCTIONS:
+ *
+ * For Ubuntu:
+ * -----------
+ * sudo apt-get update
+ * sudo apt-get install g++
+ * sudo apt-get install libomp-dev
+ *
+ * For macOS:
+ * ----------
+ * brew install libomp
+ *
+ * COMPILATION & EXECUTION:
+ *
+ * For Ubuntu:
+ * -----------
+ * g++ -std=c++20 -O2 -fopenmp -o generic_sort generic_sort.cpp
+ * ./generic_sort
+ *
+ * For macOS:
+ * ----------
+ * g++ -std=c++20 -O2 -Xpreprocessor -fopenmp -I"$(brew --prefix libomp)/include" -L"$(brew --prefix libomp)/lib" -lomp -o generic_sort generic_sort.cpp
+ * ./generic_sort
+ *
+ * THEORETICAL CONCEPTS:
+ *
+ * Why one generic sort:
+ * --------------------
+ * - mergesort.cpp, MERGE.cpp, bub_mer.cpp, bubble_merge.cpp and bubble.cpp each sort only int
+ * - parallel_sort.hpp takes any element type plus a comparator and a key extractor
+ * - The same call sorts 64-bit keys, doubles, structs by a field, or an index permutation
+ *
+ * Engine Selection:
+ * ----------------
+ * - Integer/floating-point keys with less/greater: parallel LSD radix sort, O(n * key bytes)
+ * - Any other comparator: task-parallel merge sort with a parallel merge step
+ * - Element types without a default constructor: in-place task-parallel quicksort
+ * - Small inputs: std::sort / std::stable_sort, because forking threads costs more than sorting
+ *
+ * SAMPLE INPUT/OUTPUT:
+ * ------------------
+ *
+ * Input:
+ *   2000000                      (Array size)
+ *
+ * Output:
+ *   int64 keys         std::sort: 0.1432 s   hpc::parallel_sort: 0.0311 s   sorted: yes
+ *   doubles (desc)     std::sort: 0.1610 s   hpc::parallel_sort: 0.0335 s   sorted: yes
+ *   struct by price    std::stable_sort: 0.1903 s   hpc::parallel_stable_sort: 0.0526 s   sorted+stable: yes
+ *   struct by name     std::stable_sort: 0.9114 s   hpc::parallel_stable_sort: 0.2450 s   sorted+stable: yes
+ *   index permutation  hpc::sort_permutation: 0.0402 s   valid: yes
+ */
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <random>
+#include <algorithm>
+#include <omp.h>
+#include "parallel_sort.hpp"
+using namespace std;
+
+struct Order
+{
+    long long id;
+    double price;
+    string name;
+};
+
+// Times one call in seconds
+template <class F>
+double timeIt(F f)
+{
+    double start = omp_get_wtime();
+    f();
+    return omp_get_wtime() - start;
+}
+
+const char *yesNo(bool ok)
+{
+    return ok ? "yes" : "no";
+}
+
+int main()
+{
+    int n;
+    cout << "Enter the size of the array: ";
+    cin >> n;
+
+    if (n <= 0)
+    {
+        cout << "Invalid array size!" << endl;
+        return 1;
+    }
+
+    mt19937_64 rng(42);
+
+    // 64-bit keys, ascending
+    vector<long long> keys(n);
+    for (auto &k : keys)
+        k = static_cast<long long>(rng());
+    vector<long long> keys_ref = keys;
+    double t_std = timeIt([&] { sort(keys_ref.begin(), keys_ref.end()); });
+    double t_par = timeIt([&] { hpc::parallel_sort(keys.begin(), keys.end()); });
+    cout << "int64 keys         std::sort: " << t_std << " s   hpc::parallel_sort: " << t_par
+         << " s   sorted: " << yesNo(keys == keys_ref) << endl;
+
+    // doubles, descending, through the span interface
+    uniform_real_distribution<double> price(-1000.0, 1000.0);
+    vector<double> values(n);
+    for (auto &v : values)
+        v = price(rng);
+    vector<double> values_ref = values;
+    t_std = timeIt([&] { sort(values_ref.begin(), values_ref.end(), greater<>()); });
+    t_par = timeIt([&] { hpc::parallel_sort(span<double>(values), greater<>()); });
+    cout << "doubles (desc)     std::sort: " << t_std << " s   hpc::parallel_sort: " << t_par
+         << " s   sorted: " << yesNo(values == values_ref) << endl;
+
+    // structs by a key field; few distinct prices so stability is visible
+    vector<Order> orders(n);
+    for (int i = 0; i < n; i++)
+        orders[i] = {i, double(rng() % 1000) / 4, "item" + to_string(rng() % 5000)};
+    auto sameOrder = [](const vector<Order> &a, const vector<Order> &b) {
+        return equal(a.begin(), a.end(), b.begin(), b.end(),
+                     [](const Order &x, const Order &y) { return x.id == y.id; });
+    };
+
+    auto byPrice = [](const Order &o) { return o.price; };
+    vector<Order> by_price = orders, by_price_ref = orders;
+    t_std = timeIt([&] { stable_sort(by_price_ref.begin(), by_price_ref.end(),
+                                     [](const Order &a, const Order &b) { return a.price < b.price; }); });
+    t_par = timeIt([&] { hpc::parallel_stable_sort(by_price, less<>(), byPrice); });
+    cout << "struct by price    std::stable_sort: " << t_std << " s   hpc::parallel_stable_sort: " << t_par
+         << " s   sorted+stable: " << yesNo(sameOrder(by_price, by_price_ref)) << endl;
+
+    auto byName = [](const Order &o) -> const string & { return o.name; };
+    vector<Order> by_name = orders, by_name_ref = orders;
+    t_std = timeIt([&] { stable_sort(by_name_ref.begin(), by_name_ref.end(),
+                                     [](const Order &a, const Order &b) { return a.name < b.name; }); });
+    t_par = timeIt([&] { hpc::parallel_stable_sort(by_name.begin(), by_name.end(), less<>(), byName); });
+    cout << "struct by name     std::stable_sort: " << t_std << " s   hpc::parallel_stable_sort: " << t_par
+         << " s   sorted+stable: " << yesNo(sameOrder(by_name, by_name_ref)) << endl;
+
+    // index permutation of the (unsorted) prices
+    vector<size_t> perm;
+    t_par = timeIt([&] { perm = hpc::sort_permutation(orders.begin(), orders.end(), less<>(), byPrice); });
+    bool valid = true;
+    for (int i = 0; i < n; i++)
+        valid = valid && orders[perm[i]].id == by_price_ref[i].id;
+    cout << "index permutation  hpc::sort_permutation: " << t_par << " s   valid: " << yesNo(valid) << endl;
+
+    return 0;
+}
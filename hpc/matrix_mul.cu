@@ -1,5 +1,14 @@
-%%cu
+// Builds with nvcc or, through cuda_portable.hpp, as plain C++ on a CPU-only machine:
+//   nvcc -std=c++17 -Xcompiler -fopenmp -o matrix_mul matrix_mul.cu
+//   g++ -std=c++20 -O2 -fopenmp -x c++ -o matrix_mul matrix_mul.cu
+// In a notebook (nvcc4jupyter), put %%cu on the first line of the cell.
+// ./matrix_mul --roofline (or --csv, --json) times the kernel over N = 64 ... 512 instead;
+// see roofline.hpp.
 #include <iostream>
+#include "cuda_portable.hpp"
+#include "random.hpp"
+#include "buffer_pool.hpp"
+#include "roofline.hpp"
 using namespace std;
 
 
@@ -19,10 +28,8 @@ __global__ void multiply(int* A, int* B, int* C, int size) {
 }
 
 
-void initialize(int* matrix, int size) {
-    for (int i = 0; i < size * size; i++) {
-        matrix[i] = rand() % 10;
-    }
+void initialize(int* matrix, int size, int seed) {
+    hpc::parallel_fill_uniform(matrix, matrix + size * size, 0, 9, seed);
 }
 
 
@@ -37,7 +44,44 @@ void print(int* matrix, int size) {
 }
 
 
-int main() {
+// N x N int multiply for N = 64 ... 512: 2 N^3 operations, A and B read and C written once.
+int benchmark(hpc::roofline_format format) {
+    hpc::launch_reporting() = false;
+#ifdef __CUDACC__
+    hpc::roofline_report report(hpc::machine_peaks{"GPU"});
+#else
+    hpc::roofline_report report(hpc::measure_peaks());
+#endif
+    for (int N = 64; N <= 512; N *= 2) {
+        size_t matrixBytes = size_t(N) * N * sizeof(int);
+        hpc::pooled_buffer<int> A = hpc::buffer_pool::global().acquire<int>(N * N);
+        initialize(A.data(), N, 1);
+
+        int* X, * Y, * Z;
+        cudaMalloc(&X, matrixBytes);
+        cudaMalloc(&Y, matrixBytes);
+        cudaMalloc(&Z, matrixBytes);
+        cudaMemcpy(X, A.data(), matrixBytes, cudaMemcpyHostToDevice);
+        cudaMemcpy(Y, A.data(), matrixBytes, cudaMemcpyHostToDevice);
+
+        dim3 threads(16, 16);
+        dim3 blocks((N + 15) / 16, (N + 15) / 16);
+        report.measure("multiply (matrix_mul.cu)", N, 2.0 * N * N * N, 3.0 * matrixBytes,
+                       [&] { hpc::launch<multiply>(blocks, threads, X, Y, Z, N); });
+
+        cudaFree(X);
+        cudaFree(Y);
+        cudaFree(Z);
+    }
+    report.write(cout, format);
+    return 0;
+}
+
+
+int main(int argc, char** argv) {
+    if (auto format = hpc::roofline_arg(argc, argv))
+        return benchmark(*format);
+
     int* A, * B, * C;
 
     int N = 2;
@@ -46,12 +90,15 @@ int main() {
     int matrixSize = N * N;
     size_t matrixBytes = matrixSize * sizeof(int);
 
-    A = new int[matrixSize];
-    B = new int[matrixSize];
-    C = new int[matrixSize];
+    hpc::pooled_buffer<int> bufferA = hpc::buffer_pool::global().acquire<int>(matrixSize);
+    hpc::pooled_buffer<int> bufferB = hpc::buffer_pool::global().acquire<int>(matrixSize);
+    hpc::pooled_buffer<int> bufferC = hpc::buffer_pool::global().acquire<int>(matrixSize);
+    A = bufferA.data();
+    B = bufferB.data();
+    C = bufferC.data();
 
-    initialize(A, N);
-    initialize(B, N);
+    initialize(A, N, 1);
+    initialize(B, N, 2);
     cout << "Matrix A: \n";
     print(A, N);
 
@@ -82,15 +129,12 @@ int main() {
     dim3 blocks(BLOCKS, BLOCKS);
 
     // Launch kernel
-    multiply<<<blocks, threads>>>(X, Y, Z, N);
+    hpc::launch<multiply>(blocks, threads, X, Y, Z, N);
 
     cudaMemcpy(C, Z, matrixBytes, cudaMemcpyDeviceToHost);
     cout << "Multiplication of matrix A and B: \n";
     print(C, N);
 
-    delete[] A;
-    delete[] B;
-    delete[] C;
 
     cudaFree(X);
     cudaFree(Y);
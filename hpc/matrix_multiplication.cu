@@ -1,5 +1,11 @@
-%%cu
+// Builds with nvcc or, through cuda_portable.hpp, as plain C++ on a CPU-only machine:
+//   nvcc -std=c++17 -Xcompiler -fopenmp -o matrix_multiplication matrix_multiplication.cu
+//   g++ -std=c++20 -O2 -fopenmp -x c++ -o matrix_multiplication matrix_multiplication.cu
+// In a notebook (nvcc4jupyter), put %%cu on the first line of the cell.
 #include <iostream>
+#include "cuda_portable.hpp"
+#include "random.hpp"
+#include "buffer_pool.hpp"
 using namespace std;
 
 
@@ -19,10 +25,8 @@ __global__ void multiply(int* A, int* B, int* C, int size) {
 }
 
 
-void initialize(int* matrix, int size) {
-    for (int i = 0; i < size * size; i++) {
-        matrix[i] = rand() % 10;
-    }
+void initialize(int* matrix, int size, int seed) {
+    hpc::parallel_fill_uniform(matrix, matrix + size * size, 0, 9, seed);
 }
 
 
@@ -46,12 +50,15 @@ int main() {
     int matrixSize = N * N;
     size_t matrixBytes = matrixSize * sizeof(int);
 
-    A = new int[matrixSize];
-    B = new int[matrixSize];
-    C = new int[matrixSize];
+    hpc::pooled_buffer<int> bufferA = hpc::buffer_pool::global().acquire<int>(matrixSize);
+    hpc::pooled_buffer<int> bufferB = hpc::buffer_pool::global().acquire<int>(matrixSize);
+    hpc::pooled_buffer<int> bufferC = hpc::buffer_pool::global().acquire<int>(matrixSize);
+    A = bufferA.data();
+    B = bufferB.data();
+    C = bufferC.data();
 
-    initialize(A, N);
-    initialize(B, N);
+    initialize(A, N, 1);
+    initialize(B, N, 2);
     cout << "Matrix A: \n";
     print(A, N);
 
@@ -82,15 +89,12 @@ int main() {
     dim3 blocks(BLOCKS, BLOCKS);
 
     // Launch kernel
-    multiply<<<blocks, threads>>>(X, Y, Z, N);
+    hpc::launch<multiply>(blocks, threads, X, Y, Z, N);
 
     cudaMemcpy(C, Z, matrixBytes, cudaMemcpyDeviceToHost);
     cout << "Multiplication of matrix A and B: \n";
     print(C, N);
 
-    delete[] A;
-    delete[] B;
-    delete[] C;
 
     cudaFree(X);
     cudaFree(Y);
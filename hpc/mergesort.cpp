@@ -26,6 +26,11 @@
  * g++ -Xpreprocessor -fopenmp -I"$(brew --prefix libomp)/include" -L"$(brew --prefix libomp)/lib" -lomp -o mergesort mergesort.cpp
  * ./mergesort
  *
+ * CUTOFF THRESHOLD:
+ *
+ * The cutoff threshold comes from the tuning profile written by sort_tune.cpp
+ * (hpc_sort_profile.txt, or the path in HPC_SORT_PROFILE); without one it is 8192.
+ *
  * THEORETICAL CONCEPTS:
  *
  * Merge Sort:
@@ -43,6 +48,7 @@
  * - The #pragma omp single ensures only one thread creates the initial tasks
  * - The #pragma omp parallel creates the team of threads
  * - Dynamic cutoff threshold avoids creating tasks for small subarrays
+ * - The threshold is measured per machine by sort_tune instead of typed in by hand
  *
  * Implementation Analysis:
  * ----------------------
@@ -70,9 +76,9 @@
  * Input:
  *   9                            (Array size)
  *   5 2 9 1 7 6 8 3 4           (Array elements)
- *   1000                         (Cutoff threshold)
  *
  * Output:
+ *   Cutoff threshold (from hpc_sort_profile.txt): 65536
  *   Original array: 5 2 9 1 7 6 8 3 4
  *   Sequential merge sort time: 0.000123 seconds
  *   Sorted array (sequential): 1 2 3 4 5 6 7 8 9
@@ -84,6 +90,8 @@
 #include <vector>
 #include <omp.h>
 #include <climits> // For INT_MAX
+#include <algorithm>
+#include "sort_profile.hpp"
 using namespace std;
 
 // Merge two sorted subarrays into one sorted array
@@ -148,10 +156,11 @@ void merge_sort(vector<int> &arr, int l, int r, int cutoff)
         }
         else
         {
-            // Use parallel tasks for larger arrays
-#pragma omp task
+            // Use parallel tasks for larger arrays (arr must be shared, otherwise
+            // each task sorts its own copy)
+#pragma omp task shared(arr)
             merge_sort(arr, l, m, cutoff);
-#pragma omp task
+#pragma omp task shared(arr)
             merge_sort(arr, m + 1, r, cutoff);
 
             // Synchronize tasks before merging
@@ -189,11 +198,11 @@ int main()
         cin >> arr[i];
     }
 
-    // Get cutoff threshold for task creation
-    cout << "Enter cutoff threshold for parallel tasks (recommended: 1000 for small arrays): ";
-    cin >> cutoff;
+    // Cutoff threshold for task creation, measured by sort_tune
+    cutoff = static_cast<int>(min<ptrdiff_t>(hpc::active_sort_profile().cutoff, INT_MAX));
+    cout << "\nCutoff threshold (from " << hpc::sort_profile_path() << "): " << cutoff << endl;
 
-    cout << "\nOriginal array: ";
+    cout << "Original array: ";
     for (int num : arr)
         cout << num << " ";
     cout << endl;
@@ -227,8 +236,9 @@ int main()
     return 0;
 }
 
+// Cutoff threshold (from hpc_sort_profile.txt): 65536
 // Original array: 5 2 9 1 7 6 8 3 4
-// Sequential merge sort time: 9.58443e-05 seconds
-// Sorted array (sequential): 5 2 6 8 3 4 9 1 7
-// Parallel merge sort time: 0.000562906 seconds
-// Sorted array (parallel): 5 2 6 8 3 4 9 1 7
\ No newline at end of file
+// Sequential merge sort time: 5.37e-06 seconds
+// Sorted array (sequential): 1 2 3 4 5 6 7 8 9
+// Parallel merge sort time: 1.1989e-05 seconds
+// Sorted array (parallel): 1 2 3 4 5 6 7 8 9
\ No newline at end of file
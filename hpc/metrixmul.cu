@@ -15,12 +15,18 @@
  * 1. Ensure NVIDIA CUDA Toolkit is installed.
  * 2. Save the code as metrixmul.cu (or metrixmul.cpp if nvcc is configured).
  * 3. Compile:
- *    nvcc metrixmul.cu -o metrixmul
+ *    nvcc -std=c++17 metrixmul.cu -o metrixmul
  * 4. Execute:
  *    ./metrixmul
  *    The program will prompt for a value K, where matrix size N = K * BLOCK_SIZE.
  *    (Note: The code currently hardcodes K=1, so N=2).
  *
+ * COMPILATION & EXECUTION (CPU only, no GPU or CUDA Toolkit):
+ * ----------------------------------------------------------
+ * cuda_portable.hpp runs the same kernel on a CPU thread pool:
+ *    g++ -std=c++20 -O2 -fopenmp -x c++ metrixmul.cu -o metrixmul
+ *    ./metrixmul
+ *
  * THEORETICAL CONCEPTS:
  *
  * CUDA (Compute Unified Device Architecture):
@@ -39,7 +45,9 @@
  * - `cudaMemcpy()`: Copies data between host and device memory.
  *   - `cudaMemcpyHostToDevice`: Host to Device.
  *   - `cudaMemcpyDeviceToHost`: Device to Host.
- * - Kernel Launch (`gpuMM<<<grid,threadBlock>>>`): Executes the kernel.
+ * - Kernel Launch (`gpuMM<<<grid,threadBlock>>>`): Executes the kernel. Written here as
+ *   `hpc::launch<gpuMM>(grid, threadBlock, ...)`: the same launch under nvcc, a timed
+ *   run on the CPU otherwise.
  *   - `grid`: Defines the dimensions of the grid of thread blocks (KxK blocks).
  *   - `threadBlock`: Defines the dimensions of each thread block (BLOCK_SIZExBLOCK_SIZE threads).
  * - `dim3`: A CUDA data type for specifying dimensions (e.g., for grids and blocks).
@@ -60,7 +68,7 @@
  * 6. Launch `gpuMM` kernel on the device.
  * 7. Copy result dC from device to host matrix C.
  * 8. Print input and result matrices.
- * 9. Free host memory (device memory is also implicitly freed, but explicit `cudaFree` is better).
+ * 9. Free device memory (host buffers return to the pool when they go out of scope).
  *
  * Error Handling (Simplified):
  * ----------------------------
@@ -102,7 +110,8 @@
  * Finished.
  */
 #include <iostream>
-#include <cuda.h>
+#include "cuda_portable.hpp"
+#include "buffer_pool.hpp"
 using namespace std;
 #define BLOCK_SIZE 2
 __global__ void gpuMM(float *A, float *B, float *C, int N)
@@ -129,11 +138,14 @@ int main(int argc, char *argv[])
     N = K * BLOCK_SIZE;
     cout << "\n Executing Matrix Multiplcation" << endl;
     cout << "\n Matrix size: " << N << "x" << N << endl;
-    // Allocate memory on the host
+    // Allocate memory on the host, from the buffer pool (returned to it at the end of main)
     float *hA, *hB, *hC;
-    hA = new float[N * N];
-    hB = new float[N * N];
-    hC = new float[N * N];
+    hpc::pooled_buffer<float> bufferA = hpc::buffer_pool::global().acquire<float>(N * N);
+    hpc::pooled_buffer<float> bufferB = hpc::buffer_pool::global().acquire<float>(N * N);
+    hpc::pooled_buffer<float> bufferC = hpc::buffer_pool::global().acquire<float>(N * N);
+    hA = bufferA.data();
+    hB = bufferB.data();
+    hC = bufferC.data();
     // Initialize matrices on the host
     for (int j = 0; j < N; j++)
     {
@@ -172,7 +184,7 @@ int main(int argc, char *argv[])
     cudaMemcpy(dA, hA, size, cudaMemcpyHostToDevice);
     cudaMemcpy(dB, hB, size, cudaMemcpyHostToDevice);
     // Execute the matrix multiplication kernel
-    gpuMM<<<grid, threadBlock>>>(dA, dB, dC, N);
+    hpc::launch<gpuMM>(grid, threadBlock, dA, dB, dC, N);
     // Now do the matrix multiplication on the CPU
     /*float sum;
     for (int row=0; row<N; row++){
@@ -188,7 +200,8 @@ int main(int argc, char *argv[])
     }*/
     // Allocate memory to store the GPU answer on the host
     float *C;
-    C = new float[N * N];
+    hpc::pooled_buffer<float> bufferResult = hpc::buffer_pool::global().acquire<float>(N * N);
+    C = bufferResult.data();
     // Now copy the GPU result back to CPU
     cudaMemcpy(C, dC, size, cudaMemcpyDeviceToHost);
     // Check the result and make sure it is correct
@@ -203,12 +216,6 @@ int main(int argc, char *argv[])
     }
     cout << "Finished." << endl;
 
-    // Free host memory
-    delete[] hA;
-    delete[] hB;
-    delete[] C; // This was hC in the original thought, but C is what holds GPU result.
-                // hC is currently unused if CPU block is commented.
-
     // Free device memory
     cudaFree(dA);
     cudaFree(dB);
@@ -247,14 +254,14 @@ int main(int argc, char *argv[])
  *
  * 3. Memory Management:
  *    - Host (CPU) Memory: Matrices `hA`, `hB` are initially created and populated on the CPU's RAM
- *      using `new float[N*N]`.
+ *      from `hpc::buffer_pool::global()` (aligned, reused; see buffer_pool.hpp).
  *    - Device (GPU) Memory: Memory for matrices `dA`, `dB`, `dC` on the GPU's RAM is allocated
  *      using `cudaMalloc()`.
  *    - Data Transfers:
  *        - `cudaMemcpy(dA, hA, size, cudaMemcpyHostToDevice);` copies matrix A from host to device.
  *        - `cudaMemcpy(C, dC, size, cudaMemcpyDeviceToHost);` copies the result matrix C from device back to host.
  *    - Deallocation: It's crucial to free allocated memory to prevent leaks.
- *        - `delete[]` for host memory allocated with `new[]`.
+ *        - Host buffers (`hpc::pooled_buffer`) return to the pool when they go out of scope.
  *        - `cudaFree()` for device memory allocated with `cudaMalloc()`.
  *
  * 4. The Kernel (`gpuMM` function):
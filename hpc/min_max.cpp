@@ -3,6 +3,8 @@
 #include <chrono>
 #include <cstdlib>
 #include <ctime>
+#include "random.hpp"
+#include "buffer_pool.hpp"
 using namespace std;
 using namespace std::chrono;
 
@@ -81,16 +83,13 @@ int parallelSum(int nums[], int length)
 // Main
 int main()
 {
-    srand(time(0)); // Seed random number generator
-
     int length;
     cout << "Enter number of elements: ";
     cin >> length;
 
-    int* nums = new int[length];
-    for (int i = 0; i < length; i++) {
-        nums[i] = rand() % 1000 + 1;  // Random values from 1 to 1000
-    }
+    hpc::pooled_buffer<int> buffer = hpc::buffer_pool::global().acquire<int>(length);
+    int* nums = buffer.data();
+    hpc::parallel_fill_uniform(nums, nums + length, 1, 1000, time(0)); // Random values from 1 to 1000
 
     displayArray(nums, length);
 
@@ -118,6 +117,5 @@ int main()
     cout << "Min: " << pMin << "\nMax: " << pMax << "\nSum: " << pSum << "\nAverage: " << pAvg << endl;
     cout << "Parallel execution time: " << duration_cast<microseconds>(endPar - startPar).count() << " microseconds" << endl;
 
-    delete[] nums;
     return 0;
 }
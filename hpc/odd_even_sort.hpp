@@ -0,0 +1,170 @@
+/*
+ * Block Odd-Even Merge-Split Sort (header-only) using OpenMP
+ * =========================================================
+ *
+ * The block version of the odd-even transposition sort in bubble.cpp and bub_mer.cpp.
+ * Instead of p = n single elements compared pairwise over n phases, each of the p threads
+ * owns a block of n / p elements, and neighbouring blocks do merge-split exchanges over
+ * p phases. All phases run inside one persistent parallel region.
+ *
+ * USAGE:
+ *
+ *   #include "odd_even_sort.hpp"
+ *
+ *   hpc::block_odd_even_sort(arr.begin(), arr.end());                              // barriers
+ *   hpc::block_odd_even_sort(arr.begin(), arr.end(), less<>(), hpc::identity_key(),
+ *                            hpc::odd_even_sync::flags);                           // neighbour flags
+ *
+ * COMPILATION:
+ *   g++ -std=c++20 -O2 -fopenmp -o program program.cpp
+ *
+ * ALGORITHM:
+ * ---------
+ * 1. Thread t sorts its block b_t with std::sort. Blocks hold ceil(n / p) elements except
+ *    the last; uneven blocks anywhere else would need more than p phases.
+ * 2. For phase k = 0 .. p-1, pairs (t, t+1) with t % 2 == k % 2 exchange: the lower thread
+ *    keeps the |b_t| smallest of b_t + b_t+1, the upper thread the |b_t+1| largest. Both
+ *    halves are computed at the same time (forward and backward partial merges into
+ *    private scratch), then copied back. Pairs already in order (last of b_t <= first of
+ *    b_t+1) skip the exchange.
+ * 3. After p phases the blocks are globally sorted (0-1 principle, as for single elements).
+ *
+ * SYNCHRONIZATION:
+ * ---------------
+ * - barrier: two team barriers per phase (after reading, after writing).
+ * - flags:   each thread publishes two counters, "read phase k" and "wrote phase k", on
+ *            their own cache lines and waits only for its partner. A thread can run ahead
+ *            of threads it does not talk to, so there is no team-wide stall per phase.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <thread>
+#include <vector>
+#include <omp.h>
+#include "parallel_sort.hpp"
+
+namespace hpc
+{
+
+enum class odd_even_sync
+{
+    barrier,
+    flags
+};
+
+namespace detail
+{
+
+// A phase counter alone on its cache line, so spinning on one does not slow its neighbours.
+struct alignas(64) phase_flag
+{
+    std::atomic<int> value{-1};
+};
+
+inline void wait_for_phase(const phase_flag &flag, int phase)
+{
+    for (int spins = 0; flag.value.load(std::memory_order_acquire) < phase; spins++)
+        if (spins > 1000)
+            std::this_thread::yield(); // oversubscribed: let the partner run
+}
+
+// Writes the `keep` smallest elements of the sorted runs a and b into out.
+template <class It, class OutIt, class Less>
+void merge_low(It a, It a_end, It b, It b_end, OutIt out, std::ptrdiff_t keep, const Less &less)
+{
+    for (; keep > 0; keep--)
+        *out++ = (b == b_end || (a != a_end && !less(*b, *a))) ? *a++ : *b++;
+}
+
+// Writes the `keep` largest elements of the sorted runs a and b into out, in order.
+template <class It, class OutIt, class Less>
+void merge_high(It a, It a_end, It b, It b_end, OutIt out, std::ptrdiff_t keep, const Less &less)
+{
+    OutIt dst = out + keep;
+    for (; keep > 0; keep--)
+        *--dst = (a == a_end || (b != b_end && !less(*(b_end - 1), *(a_end - 1)))) ? *--b_end : *--a_end;
+}
+
+} // namespace detail
+
+// Unstable sort of [first, last) by block odd-even merge-split exchanges.
+template <std::random_access_iterator RandomIt, class Compare = std::less<>, class KeyFn = identity_key>
+void block_odd_even_sort(RandomIt first, RandomIt last, Compare comp = {}, KeyFn key = {},
+                         odd_even_sync sync = odd_even_sync::barrier)
+{
+    using T = std::iter_value_t<RandomIt>;
+    const std::ptrdiff_t n = last - first;
+    const detail::key_compare<Compare, KeyFn> less{comp, key};
+    const int threads = static_cast<int>(std::min<std::ptrdiff_t>(omp_get_max_threads(), n / 2));
+    if (threads < 2)
+    {
+        std::sort(first, last, less);
+        return;
+    }
+
+    std::vector<detail::phase_flag> read(threads), wrote(threads);
+
+#pragma omp parallel num_threads(threads)
+    {
+        const int p = omp_get_num_threads();
+        const int t = omp_get_thread_num();
+        // Equal blocks of ceil(n / p); the last one is shorter. Merge-split on that is the
+        // same as padding it with +infinity, which keeps the p-phase bound exact.
+        const std::ptrdiff_t size = (n + p - 1) / p;
+        auto block = [&](int i) { return first + std::min<std::ptrdiff_t>(n, size * i); };
+
+        std::sort(block(t), block(t + 1), less);
+        std::vector<T> scratch(block(t + 1) - block(t));
+#pragma omp barrier
+
+        for (int phase = 0; phase < p; phase++)
+        {
+            // Partner for this phase: t+1 if t has the phase's parity, otherwise t-1.
+            const int partner = (t % 2 == phase % 2) ? t + 1 : t - 1;
+            const bool active = partner >= 0 && partner < p;
+            const bool lower = partner > t;
+            bool exchange = false;
+
+            if (active)
+            {
+                if (sync == odd_even_sync::flags)
+                    detail::wait_for_phase(wrote[partner], phase - 1);
+
+                RandomIt lo = block(std::min(t, partner)), mid = block(std::max(t, partner)),
+                         hi = block(std::max(t, partner) + 1);
+                exchange = mid != hi && less(*mid, *(mid - 1));
+                if (exchange && lower)
+                    detail::merge_low(lo, mid, mid, hi, scratch.begin(), mid - lo, less);
+                else if (exchange)
+                    detail::merge_high(lo, mid, mid, hi, scratch.begin(), hi - mid, less);
+            }
+
+            if (sync == odd_even_sync::barrier)
+            {
+#pragma omp barrier
+                if (exchange)
+                    std::copy(scratch.begin(), scratch.end(), block(t));
+#pragma omp barrier
+            }
+            else
+            {
+                // Even without an exchange the partner may still be reading my boundary
+                // element, so wait for it before moving on and possibly rewriting my block.
+                read[t].value.store(phase, std::memory_order_release);
+                if (active)
+                    detail::wait_for_phase(read[partner], phase);
+                if (exchange)
+                    std::copy(scratch.begin(), scratch.end(), block(t));
+                wrote[t].value.store(phase, std::memory_order_release);
+            }
+        }
+    }
+}
+
+} // namespace hpc
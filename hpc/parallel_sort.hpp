@@ -0,0 +1,476 @@
+/*
+ * Generic Parallel Sort Library (header-only) using OpenMP
+ * =======================================================
+ *
+ * One templated sort for every program in this folder. It sorts any random-access
+ * range (std::vector, raw array, std::span) of any element type. Elements are ordered by
+ * a comparator applied to a key taken from each element, so 64-bit keys, doubles, structs
+ * by a field and index permutations all go through the same entry points.
+ *
+ * USAGE:
+ *
+ *   #include "parallel_sort.hpp"
+ *
+ *   vector<long long> keys = ...;
+ *   hpc::parallel_sort(keys.begin(), keys.end());            // ascending
+ *   hpc::parallel_sort(span(keys), greater<>());              // descending, span interface
+ *
+ *   struct Order { long long id; double price; };
+ *   hpc::parallel_stable_sort(orders, less<>(),               // by key field, ties keep order
+ *                             [](const Order &o) { return o.price; });
+ *
+ *   vector<size_t> perm = hpc::sort_permutation(prices.begin(), prices.end());
+ *
+ * COMPILATION:
+ *
+ * For Ubuntu:
+ * -----------
+ * g++ -std=c++20 -O2 -fopenmp -o program program.cpp
+ *
+ * For macOS:
+ * ----------
+ * g++ -std=c++20 -O2 -Xpreprocessor -fopenmp -I"$(brew --prefix libomp)/include" -L"$(brew --prefix libomp)/lib" -lomp -o program program.cpp
+ *
+ * ENGINES:
+ * -------
+ * - Radix: parallel LSD radix sort with 8-bit digits and per-thread histograms.
+ *   Picked at compile time when the key is an integer or floating-point type and the
+ *   comparator is std::less or std::greater. Stable, O(n * sizeof(key)).
+ * - Merge: task-parallel merge sort. Halves are sorted as OpenMP tasks and merged with a
+ *   parallel merge (binary-search split), ping-ponging between the input and one buffer.
+ *   Stable with std::stable_sort leaves, or unstable with std::sort leaves.
+ * - Quick: task-parallel quicksort (median-of-three, three-way partition, std::sort
+ *   leaves). In place; used by parallel_sort when the element type has no default
+ *   constructor and so cannot get a scratch buffer.
+ * - Sequential: std::sort / std::stable_sort. Used below the parallel cutoff, where the
+ *   fork/join costs more than the sort (see the notes at the end of MIN_MAX_mine.cpp).
+ *
+ * TUNING:
+ * ------
+ * The cutoff, the radix threshold, merge vs quick for unstable sorts and the thread count
+ * per input size come from the profile in sort_profile.hpp. Run sort_tune once per
+ * machine to measure them; without a profile file the built-in defaults are used.
+ *
+ * REQUIREMENTS:
+ * ------------
+ * - Stable sorts and the radix engine need a scratch buffer of n elements, so the element
+ *   type must be default constructible and move assignable.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <numeric>
+#include <ranges>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <omp.h>
+#include "sort_profile.hpp"
+
+namespace hpc
+{
+
+// Default key extractor: the element itself.
+struct identity_key
+{
+    template <class T>
+    constexpr T &&operator()(T &&value) const noexcept
+    {
+        return std::forward<T>(value);
+    }
+};
+
+namespace detail
+{
+
+// Orders two elements by comparing their extracted keys.
+template <class Compare, class KeyFn>
+struct key_compare
+{
+    Compare comp;
+    KeyFn key;
+
+    template <class A, class B>
+    bool operator()(const A &a, const B &b) const
+    {
+        return comp(key(a), key(b));
+    }
+};
+
+template <class T, class KeyFn>
+using key_type_t = std::remove_cvref_t<std::invoke_result_t<const KeyFn &, const T &>>;
+
+// +1 for an ascending comparator, -1 for a descending one, 0 if radix sort cannot honour it.
+template <class Compare, class K>
+constexpr int radix_direction()
+{
+    if constexpr (std::is_same_v<Compare, std::less<>> || std::is_same_v<Compare, std::less<K>>)
+        return 1;
+    else if constexpr (std::is_same_v<Compare, std::greater<>> || std::is_same_v<Compare, std::greater<K>>)
+        return -1;
+    else
+        return 0;
+}
+
+template <class T, class Compare, class KeyFn>
+constexpr bool radix_sortable()
+{
+    using K = key_type_t<T, KeyFn>;
+    constexpr bool arithmetic_key = (std::is_integral_v<K> && !std::is_same_v<K, bool>) ||
+                                    std::is_floating_point_v<K>;
+    if constexpr (!arithmetic_key || sizeof(K) > 8)
+        return false;
+    else
+        return radix_direction<Compare, K>() != 0 && std::is_default_constructible_v<T> &&
+               std::is_move_assignable_v<T>;
+}
+
+// Maps a key onto an unsigned integer with the same ordering.
+template <class K>
+auto radix_bits(K key)
+{
+    if constexpr (std::is_floating_point_v<K>)
+    {
+        using U = std::conditional_t<sizeof(K) == 4, std::uint32_t, std::uint64_t>;
+        constexpr U sign = U(1) << (sizeof(U) * 8 - 1);
+        if (key == K(0))
+            key = K(0); // -0.0 and +0.0 compare equal, so give them one encoding
+        U bits;
+        std::memcpy(&bits, &key, sizeof(bits));
+        return (bits & sign) ? U(~bits) : U(bits | sign);
+    }
+    else
+    {
+        using U = std::make_unsigned_t<K>;
+        U bits = static_cast<U>(key);
+        if constexpr (std::is_signed_v<K>)
+            bits ^= U(1) << (sizeof(U) * 8 - 1);
+        return bits;
+    }
+}
+
+// One stable scatter pass on the byte at `shift`. Returns false (and moves nothing) when
+// every element has the same digit, since the pass would not change the order.
+template <int Direction, class SrcIt, class DstIt, class KeyFn>
+bool radix_pass(SrcIt src, DstIt dst, std::ptrdiff_t n, int shift, const KeyFn &key,
+                std::vector<std::size_t> &counts, int threads)
+{
+    auto digit = [&](const auto &value) {
+        auto bits = radix_bits(key(value));
+        if constexpr (Direction < 0)
+            bits = ~bits;
+        return static_cast<std::size_t>((bits >> shift) & 0xFF);
+    };
+    bool skip = false;
+
+#pragma omp parallel num_threads(threads)
+    {
+        const int nt = omp_get_num_threads();
+        const int t = omp_get_thread_num();
+        const std::ptrdiff_t lo = n * t / nt;
+        const std::ptrdiff_t hi = n * (t + 1) / nt;
+        std::size_t *count = &counts[t * 256];
+
+        std::fill(count, count + 256, 0);
+        for (std::ptrdiff_t i = lo; i < hi; i++)
+            count[digit(src[i])]++;
+
+#pragma omp barrier
+#pragma omp single
+        {
+            // Bucket-major, thread-minor offsets keep the scatter stable.
+            std::size_t offset = 0;
+            for (int d = 0; d < 256; d++)
+            {
+                std::size_t bucket = 0;
+                for (int u = 0; u < nt; u++)
+                {
+                    std::size_t c = counts[u * 256 + d];
+                    counts[u * 256 + d] = offset;
+                    offset += c;
+                    bucket += c;
+                }
+                if (bucket == static_cast<std::size_t>(n))
+                    skip = true;
+            }
+        }
+
+        if (!skip)
+            for (std::ptrdiff_t i = lo; i < hi; i++)
+                dst[count[digit(src[i])]++] = std::move(src[i]);
+    }
+    return !skip;
+}
+
+template <int Direction, class RandomIt, class KeyFn>
+void radix_sort(RandomIt first, RandomIt last, const KeyFn &key, int max_threads)
+{
+    using T = std::iter_value_t<RandomIt>;
+    using K = key_type_t<T, KeyFn>;
+    constexpr int passes = sizeof(decltype(radix_bits(K{})));
+
+    const std::ptrdiff_t n = last - first;
+    const int threads = static_cast<int>(std::clamp<std::ptrdiff_t>(n / radix_cutoff, 1, max_threads));
+    std::vector<T> buffer(n);
+    std::vector<std::size_t> counts(static_cast<std::size_t>(threads) * 256);
+
+    bool in_buffer = false;
+    for (int pass = 0; pass < passes; pass++)
+    {
+        bool moved = in_buffer ? radix_pass<Direction>(buffer.begin(), first, n, pass * 8, key, counts, threads)
+                               : radix_pass<Direction>(first, buffer.begin(), n, pass * 8, key, counts, threads);
+        if (moved)
+            in_buffer = !in_buffer;
+    }
+
+    if (in_buffer)
+    {
+#pragma omp parallel for num_threads(threads)
+        for (std::ptrdiff_t i = 0; i < n; i++)
+            first[i] = std::move(buffer[i]);
+    }
+}
+
+// Sequential stable merge that moves elements out of the two source runs.
+struct move_merge
+{
+    template <class SrcIt, class DstIt, class Less>
+    void operator()(SrcIt a, SrcIt a_end, SrcIt b, SrcIt b_end, DstIt out, const Less &less) const
+    {
+        std::merge(std::make_move_iterator(a), std::make_move_iterator(a_end),
+                   std::make_move_iterator(b), std::make_move_iterator(b_end), out, less);
+    }
+};
+
+// Stable merge of [a, a_end) and [b, b_end) into out, split recursively into tasks.
+// Pieces at or below the cutoff are merged by `leaf`.
+template <class SrcIt, class DstIt, class Less, class LeafMerge = move_merge>
+void parallel_merge(SrcIt a, SrcIt a_end, SrcIt b, SrcIt b_end, DstIt out, const Less &less,
+                    std::ptrdiff_t cutoff, const LeafMerge &leaf = {})
+{
+    const std::ptrdiff_t na = a_end - a;
+    const std::ptrdiff_t nb = b_end - b;
+    if (na + nb <= cutoff)
+    {
+        leaf(a, a_end, b, b_end, out, less);
+        return;
+    }
+
+    // Split the longer run at its middle; ties from the left run stay on the left.
+    SrcIt a_mid, b_mid;
+    if (na >= nb)
+    {
+        a_mid = a + na / 2;
+        b_mid = std::lower_bound(b, b_end, *a_mid, less);
+    }
+    else
+    {
+        b_mid = b + nb / 2;
+        a_mid = std::upper_bound(a, a_end, *b_mid, less);
+    }
+    DstIt out_mid = out + (a_mid - a) + (b_mid - b);
+
+#pragma omp task
+    parallel_merge(a, a_mid, b, b_mid, out, less, cutoff, leaf);
+    parallel_merge(a_mid, a_end, b_mid, b_end, out_mid, less, cutoff, leaf);
+#pragma omp taskwait
+}
+
+// Sorts [first, last). The result is left in [buffer, buffer + n) when to_buffer is set,
+// otherwise in place; alternating the flag per level avoids a copy-back after each merge.
+template <bool Stable, class RandomIt, class BufIt, class Less>
+void merge_sort_tasks(RandomIt first, RandomIt last, BufIt buffer, bool to_buffer,
+                      const Less &less, std::ptrdiff_t cutoff)
+{
+    const std::ptrdiff_t n = last - first;
+    if (n <= cutoff)
+    {
+        if constexpr (Stable)
+            std::stable_sort(first, last, less);
+        else
+            std::sort(first, last, less);
+        if (to_buffer)
+            std::move(first, last, buffer);
+        return;
+    }
+
+    const std::ptrdiff_t mid = n / 2;
+#pragma omp task
+    merge_sort_tasks<Stable>(first, first + mid, buffer, !to_buffer, less, cutoff);
+    merge_sort_tasks<Stable>(first + mid, last, buffer + mid, !to_buffer, less, cutoff);
+#pragma omp taskwait
+
+    if (to_buffer)
+        parallel_merge(first, first + mid, first + mid, last, buffer, less, cutoff);
+    else
+        parallel_merge(buffer, buffer + mid, buffer + mid, buffer + n, first, less, cutoff);
+}
+
+template <bool Stable, class RandomIt, class Less>
+void merge_sort(RandomIt first, RandomIt last, const Less &less, std::ptrdiff_t cutoff, int threads)
+{
+    std::vector<std::iter_value_t<RandomIt>> buffer(last - first);
+#pragma omp parallel num_threads(threads)
+    {
+#pragma omp single
+        merge_sort_tasks<Stable>(first, last, buffer.begin(), false, less, cutoff);
+    }
+}
+
+// In-place quicksort: the left part of every partition becomes a task, the loop keeps
+// the right part. Ranges at or below the cutoff go to std::sort.
+template <class RandomIt, class Less>
+void quick_sort_tasks(RandomIt first, RandomIt last, const Less &less, std::ptrdiff_t cutoff)
+{
+    while (last - first > cutoff)
+    {
+        RandomIt mid = first + (last - first) / 2;
+        RandomIt back = last - 1;
+        // Median of three, moved to the front so it stays put while partitioning.
+        if (less(*mid, *first))
+            std::iter_swap(mid, first);
+        if (less(*back, *mid))
+        {
+            std::iter_swap(back, mid);
+            if (less(*mid, *first))
+                std::iter_swap(mid, first);
+        }
+        std::iter_swap(first, mid);
+
+        RandomIt pivot = first;
+        RandomIt lt = std::partition(first + 1, last, [&](const auto &x) { return less(x, *pivot); });
+        std::iter_swap(first, lt - 1);
+        pivot = lt - 1;
+        RandomIt gt = std::partition(lt, last, [&](const auto &x) { return !less(*pivot, x); });
+
+        RandomIt left_end = pivot;
+#pragma omp task
+        quick_sort_tasks(first, left_end, less, cutoff);
+        first = gt;
+    }
+    std::sort(first, last, less);
+}
+
+template <class RandomIt, class Less>
+void quick_sort(RandomIt first, RandomIt last, const Less &less, std::ptrdiff_t cutoff, int threads)
+{
+#pragma omp parallel num_threads(threads)
+    {
+#pragma omp single
+        quick_sort_tasks(first, last, less, cutoff);
+    }
+}
+
+// Compile-time choice by element, key and comparator type.
+template <bool Stable, class T, class Compare, class KeyFn>
+constexpr sort_engine preferred_engine()
+{
+    if constexpr (radix_sortable<T, Compare, KeyFn>())
+        return sort_engine::radix;
+    else if constexpr (Stable || std::is_default_constructible_v<T>)
+        return sort_engine::merge;
+    else
+        return sort_engine::quick;
+}
+
+// Run-time refinement by input size and the measured tuning profile.
+template <bool Stable, class T, class Compare, class KeyFn>
+sort_engine select_engine(std::ptrdiff_t n, const sort_profile &profile)
+{
+    constexpr sort_engine engine = preferred_engine<Stable, T, Compare, KeyFn>();
+    if constexpr (engine == sort_engine::radix)
+        return n < profile.radix_min ? sort_engine::sequential : engine;
+    else if (n <= profile.cutoff || profile.threads_for(n) == 1)
+        return sort_engine::sequential;
+    else if constexpr (!Stable && engine == sort_engine::merge)
+        return profile.unstable_engine;
+    else
+        return engine;
+}
+
+template <bool Stable, class RandomIt, class Compare, class KeyFn>
+void sort_dispatch(RandomIt first, RandomIt last, const Compare &comp, const KeyFn &key)
+{
+    using T = std::iter_value_t<RandomIt>;
+    static_assert(!Stable || std::is_default_constructible_v<T>,
+                  "parallel_stable_sort needs a default-constructible element type for its buffer");
+
+    const std::ptrdiff_t n = last - first;
+    if (n < 2)
+        return;
+
+    const key_compare<Compare, KeyFn> less{comp, key};
+    const sort_profile &profile = active_sort_profile();
+    switch (select_engine<Stable, T, Compare, KeyFn>(n, profile))
+    {
+    case sort_engine::radix:
+        if constexpr (radix_sortable<T, Compare, KeyFn>())
+            radix_sort<radix_direction<Compare, key_type_t<T, KeyFn>>()>(first, last, key,
+                                                                          profile.radix_threads_for(n));
+        break;
+    case sort_engine::merge:
+        if constexpr (std::is_default_constructible_v<T>)
+            merge_sort<Stable>(first, last, less, profile.cutoff, profile.threads_for(n));
+        break;
+    case sort_engine::quick:
+        quick_sort(first, last, less, profile.cutoff, profile.threads_for(n));
+        break;
+    case sort_engine::sequential:
+        if constexpr (Stable)
+            std::stable_sort(first, last, less);
+        else
+            std::sort(first, last, less);
+        break;
+    }
+}
+
+} // namespace detail
+
+// Unstable sort of [first, last) by comp(key(a), key(b)).
+template <std::random_access_iterator RandomIt, class Compare = std::less<>, class KeyFn = identity_key>
+void parallel_sort(RandomIt first, RandomIt last, Compare comp = {}, KeyFn key = {})
+{
+    detail::sort_dispatch<false>(first, last, comp, key);
+}
+
+// Stable sort: elements with equal keys keep their input order.
+template <std::random_access_iterator RandomIt, class Compare = std::less<>, class KeyFn = identity_key>
+void parallel_stable_sort(RandomIt first, RandomIt last, Compare comp = {}, KeyFn key = {})
+{
+    detail::sort_dispatch<true>(first, last, comp, key);
+}
+
+// Range overloads: std::span, std::vector, std::array, ...
+template <std::ranges::random_access_range Range, class Compare = std::less<>, class KeyFn = identity_key>
+void parallel_sort(Range &&range, Compare comp = {}, KeyFn key = {})
+{
+    parallel_sort(std::ranges::begin(range), std::ranges::end(range), comp, key);
+}
+
+template <std::ranges::random_access_range Range, class Compare = std::less<>, class KeyFn = identity_key>
+void parallel_stable_sort(Range &&range, Compare comp = {}, KeyFn key = {})
+{
+    parallel_stable_sort(std::ranges::begin(range), std::ranges::end(range), comp, key);
+}
+
+// Returns the stable permutation that would sort [first, last): first[perm[0]] is the
+// smallest element. The input itself is not modified.
+template <std::random_access_iterator RandomIt, class Compare = std::less<>, class KeyFn = identity_key>
+std::vector<std::size_t> sort_permutation(RandomIt first, RandomIt last, Compare comp = {}, KeyFn key = {})
+{
+    std::vector<std::size_t> perm(last - first);
+    std::iota(perm.begin(), perm.end(), std::size_t(0));
+    parallel_stable_sort(perm.begin(), perm.end(), comp,
+                         [first, key](std::size_t i) -> decltype(auto) { return key(first[i]); });
+    return perm;
+}
+
+} // namespace hpc
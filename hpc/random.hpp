@@ -0,0 +1,411 @@
+/*
+ * Parallel Reproducible Random Data (header-only) using OpenMP
+ * ============================================================
+ *
+ * Fills benchmark inputs in parallel. Serial rand() is not thread-safe, differs between
+ * C libraries, and at 10^9 elements takes longer than most kernels being timed. Here every
+ * element is a pure function of (seed, index), computed by a counter-based generator, so
+ * any thread can produce any element and a fixed seed gives bit-identical data whatever
+ * the thread count or schedule.
+ *
+ * USAGE:
+ *
+ *   #include "random.hpp"
+ *
+ *   hpc::parallel_fill_uniform(nums, nums + n, 1, 1000, 42);       // ints in [1, 1000]
+ *   hpc::parallel_fill_uniform(v.begin(), v.end(), 0.0, 1.0, 42);   // doubles in [0, 1)
+ *   hpc::parallel_fill_normal(v.begin(), v.end(), 100.0, 15.0, 42); // mean 100, stddev 15
+ *   hpc::parallel_fill_zipf(v.begin(), v.end(), 10000, 1.1, 42);    // ranks 1..10000, P(k) ~ 1/k^1.1
+ *   hpc::parallel_fill_sorted(v.begin(), v.end());                   // 0, 1, 2, ...
+ *   hpc::parallel_fill_reversed(v.begin(), v.end());                 // n-1, ..., 1, 0
+ *   hpc::parallel_fill_nearly_sorted(v.begin(), v.end(), 0.01, 42);  // 1% of positions random
+ *
+ *   vector<int> data = hpc::random_vector<int>(n, hpc::distribution::zipf, 42); // benchmark defaults
+ *   hpc::parallel_fill(data.begin(), data.end(), hpc::distribution::nearly_sorted, 42);
+ *
+ *   hpc::parallel_fill_uniform<hpc::philox_rng>(v.begin(), v.end(), 0, 9, 42); // other generator
+ *
+ *   hpc::splitmix_rng rng(42);                                       // direct access
+ *   double u = hpc::to_unit(rng(i));                                 // i-th uniform in [0, 1)
+ *
+ * COMPILATION:
+ *   g++ -std=c++17 -O2 -fopenmp -o program program.cpp
+ *
+ * Only needs C++17, so the plain OpenMP programs in this folder can include it too.
+ *
+ * GENERATORS:
+ * ----------
+ * Both are counter-based: the i-th number is a keyed hash of i, so jumping to element i
+ * costs nothing and there is no state to share or split between threads.
+ * - splitmix_rng (default): the i-th output of SplitMix64 (Steele, Lea and Flood 2014),
+ *   one multiply-xorshift finalizer per number. Passes BigCrush; ~1.5 ns per number.
+ * - philox_rng: Philox4x32-10 (Salmon et al., "Parallel Random Numbers: As Easy as 1, 2,
+ *   3", SC 2011), ten rounds of 32x32->64-bit multiplies over a 128-bit counter (index,
+ *   draw, stream). The generator of cuRAND and the C++26 proposal; stronger mixing at
+ *   ~10x the cost.
+ * The seed is the key; each distribution uses its own stream, so two fills with the same
+ * seed are still independent.
+ *
+ * DISTRIBUTIONS:
+ * -------------
+ * - uniform: integers by 64x64->128-bit multiply-shift (Lemire), bias below range / 2^64;
+ *   reals from the top 53 bits.
+ * - normal: Box-Muller on two numbers of the same element.
+ * - zipf: rejection-inversion (Hormann and Derflinger 1996), O(1) per value for any
+ *   number of ranks; each rejected attempt uses the next counter, so it stays reproducible.
+ * - sorted / reversed: start + i and start + (n - 1 - i).
+ * - nearly sorted: sorted, except each position is replaced with probability `disorder`
+ *   by a uniform value in [start, start + n). Not a permutation, but shaped like a sorted
+ *   array with scattered out-of-place elements, as in adaptive_sort.cpp's inputs.
+ * Normal and Zipf call std::log/std::exp, so results are identical across thread counts
+ * but may differ in the last bit between C libraries.
+ */
+
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <omp.h>
+
+namespace hpc
+{
+
+namespace detail
+{
+
+// splitmix64 finalizer: spreads every input bit over the whole word.
+constexpr std::uint64_t mix64(std::uint64_t x)
+{
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+// Elements per thread below which a fill stays on one thread.
+constexpr std::ptrdiff_t random_grain = 1 << 14;
+
+} // namespace detail
+
+// The index-th output of the splitmix64 sequence started at seed.
+constexpr std::uint64_t splitmix64(std::uint64_t seed, std::uint64_t index = 0)
+{
+    return detail::mix64(seed + (index + 1) * 0x9e3779b97f4a7c15ULL);
+}
+
+// Both generators below are stateless functions of (seed, stream, i, draw): element i's
+// draw-th 64-bit number is the same from any thread, in any order. `draw` separates the
+// several numbers one element may need (Box-Muller, rejection attempts).
+
+// SplitMix64 as a counter-based generator: the i-th output of the sequence keyed by
+// (seed, stream). About 1.5 ns per number; the default for the fills.
+class splitmix_rng
+{
+public:
+    explicit splitmix_rng(std::uint64_t seed, std::uint32_t stream = 0) : key_(splitmix64(seed, stream)) {}
+
+    std::uint64_t operator()(std::uint64_t i, std::uint32_t draw = 0) const
+    {
+        const std::uint64_t key = draw ? detail::mix64(key_ + draw) : key_;
+        return detail::mix64(key + (i + 1) * 0x9e3779b97f4a7c15ULL);
+    }
+
+private:
+    std::uint64_t key_;
+};
+
+// Philox4x32-10: stronger mixing (a 10-round cipher), about 10x slower per number.
+class philox_rng
+{
+public:
+    explicit philox_rng(std::uint64_t seed, std::uint32_t stream = 0) : key_(seed), stream_(stream) {}
+
+    // The full 128-bit block for counter (i, draw, stream).
+    std::array<std::uint32_t, 4> block(std::uint64_t i, std::uint32_t draw = 0) const
+    {
+        std::uint32_t c0 = static_cast<std::uint32_t>(i), c1 = static_cast<std::uint32_t>(i >> 32);
+        std::uint32_t c2 = draw, c3 = stream_;
+        std::uint32_t k0 = static_cast<std::uint32_t>(key_), k1 = static_cast<std::uint32_t>(key_ >> 32);
+        for (int round = 0; round < 10; round++)
+        {
+            const std::uint64_t p0 = std::uint64_t(0xD2511F53) * c0;
+            const std::uint64_t p1 = std::uint64_t(0xCD9E8D57) * c2;
+            const std::uint32_t n0 = static_cast<std::uint32_t>(p1 >> 32) ^ c1 ^ k0;
+            const std::uint32_t n2 = static_cast<std::uint32_t>(p0 >> 32) ^ c3 ^ k1;
+            c1 = static_cast<std::uint32_t>(p1);
+            c3 = static_cast<std::uint32_t>(p0);
+            c0 = n0;
+            c2 = n2;
+            k0 += 0x9E3779B9;
+            k1 += 0xBB67AE85;
+        }
+        return {c0, c1, c2, c3};
+    }
+
+    std::uint64_t operator()(std::uint64_t i, std::uint32_t draw = 0) const
+    {
+        const auto b = block(i, draw);
+        return std::uint64_t(b[0]) | std::uint64_t(b[1]) << 32;
+    }
+
+private:
+    std::uint64_t key_;
+    std::uint32_t stream_;
+};
+
+// Uniform double in [0, 1) from the top 53 of 64 random bits.
+inline double to_unit(std::uint64_t bits)
+{
+    return (bits >> 11) * 0x1.0p-53;
+}
+
+namespace detail
+{
+
+// out[i] = gen(i) for i in [0, n), split statically over the threads. Deliberately not
+// `omp simd`: vectorized libm calls can round differently from the scalar ones used for
+// the remainder iterations, and where the remainders fall depends on the thread count.
+template <class RandomIt, class Gen>
+void parallel_generate(RandomIt first, std::ptrdiff_t n, const Gen &gen)
+{
+#pragma omp parallel for schedule(static) if (n >= 2 * random_grain)
+    for (std::ptrdiff_t i = 0; i < n; i++)
+        first[i] = gen(static_cast<std::uint64_t>(i));
+}
+
+// Uniform integer in [0, range) from 64 random bits (multiply-shift): the high 64 bits
+// of the 128-bit product. unsigned __int128 is a GCC / Clang extension; elsewhere (MSVC)
+// the product is assembled from 32-bit halves, with the same result.
+inline std::uint64_t bounded(std::uint64_t bits, std::uint64_t range)
+{
+#ifdef __SIZEOF_INT128__
+    return static_cast<std::uint64_t>((static_cast<unsigned __int128>(bits) * range) >> 64);
+#else
+    const std::uint64_t a_lo = bits & 0xffffffffu, a_hi = bits >> 32;
+    const std::uint64_t b_lo = range & 0xffffffffu, b_hi = range >> 32;
+    const std::uint64_t lo_lo = a_lo * b_lo, hi_lo = a_hi * b_lo, lo_hi = a_lo * b_hi;
+    const std::uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xffffffffu) + lo_hi;
+    return a_hi * b_hi + (hi_lo >> 32) + (cross >> 32);
+#endif
+}
+
+// Zipf sampler by rejection-inversion (the formulation used by Apache Commons RNG).
+class zipf_sampler
+{
+public:
+    zipf_sampler(std::uint64_t n, double exponent) : n_(n), s_(exponent)
+    {
+        if (n == 0 || !(exponent > 0))
+            throw std::invalid_argument("zipf: need at least one rank and a positive exponent");
+        h_x1_ = h_integral(1.5) - 1.0;
+        h_n_ = h_integral(n + 0.5);
+        shift_ = 2.0 - h_integral_inverse(h_integral(2.5) - h(2.0));
+    }
+
+    template <class Rng>
+    std::uint64_t operator()(const Rng &rng, std::uint64_t i) const
+    {
+        for (std::uint32_t attempt = 0;; attempt++)
+        {
+            const double u = h_n_ + to_unit(rng(i, attempt)) * (h_x1_ - h_n_);
+            const double x = h_integral_inverse(u);
+            double k = std::floor(x + 0.5);
+            if (k < 1)
+                k = 1;
+            else if (k > static_cast<double>(n_))
+                k = static_cast<double>(n_);
+            if (k - x <= shift_ || u >= h_integral(k + 0.5) - h(k))
+                return static_cast<std::uint64_t>(k);
+        }
+    }
+
+private:
+    // log1p(x) / x and expm1(x) / x, with series near 0.
+    static double helper1(double x) { return std::fabs(x) > 1e-8 ? std::log1p(x) / x : 1 - x * (0.5 - x * (1.0 / 3 - 0.25 * x)); }
+    static double helper2(double x) { return std::fabs(x) > 1e-8 ? std::expm1(x) / x : 1 + x * 0.5 * (1 + x / 3 * (1 + 0.25 * x)); }
+
+    double h(double x) const { return std::exp(-s_ * std::log(x)); }
+    double h_integral(double x) const
+    {
+        const double log_x = std::log(x);
+        return helper2((1 - s_) * log_x) * log_x;
+    }
+    double h_integral_inverse(double x) const
+    {
+        double t = x * (1 - s_);
+        if (t < -1)
+            t = -1; // guards against rounding just past the domain
+        return std::exp(helper1(t) * x);
+    }
+
+    std::uint64_t n_;
+    double s_;
+    double h_x1_, h_n_, shift_;
+};
+
+} // namespace detail
+
+// The fills below take the generator as an optional first template argument, e.g.
+// parallel_fill_uniform<hpc::philox_rng>(...). Each distribution uses its own stream.
+
+// Integers uniform in [lo, hi] (inclusive) or reals uniform in [lo, hi), by value type.
+template <class Rng = splitmix_rng, class RandomIt, class T>
+void parallel_fill_uniform(RandomIt first, RandomIt last, T lo, T hi, std::uint64_t seed)
+{
+    using V = typename std::iterator_traits<RandomIt>::value_type;
+    const Rng rng(seed, 1);
+    if constexpr (std::is_integral_v<V>)
+    {
+        if (hi < lo)
+            throw std::invalid_argument("parallel_fill_uniform: hi < lo");
+        const std::uint64_t range = static_cast<std::uint64_t>(hi) - static_cast<std::uint64_t>(lo) + 1; // 0: all 64 bits
+        detail::parallel_generate(first, last - first, [&](std::uint64_t i) {
+            const std::uint64_t r = range ? detail::bounded(rng(i), range) : rng(i);
+            return static_cast<V>(static_cast<std::uint64_t>(lo) + r);
+        });
+    }
+    else
+    {
+        const double a = static_cast<double>(lo), width = static_cast<double>(hi) - a;
+        detail::parallel_generate(first, last - first, [&](std::uint64_t i) { return static_cast<V>(a + width * to_unit(rng(i))); });
+    }
+}
+
+// Normal(mean, stddev) values (rounded toward zero for integer value types).
+template <class Rng = splitmix_rng, class RandomIt>
+void parallel_fill_normal(RandomIt first, RandomIt last, double mean, double stddev, std::uint64_t seed)
+{
+    using V = typename std::iterator_traits<RandomIt>::value_type;
+    const Rng rng(seed, 2);
+    detail::parallel_generate(first, last - first, [&](std::uint64_t i) {
+        const double u1 = 1.0 - to_unit(rng(i, 0)); // (0, 1], so the log is finite
+        const double u2 = to_unit(rng(i, 1));
+        return static_cast<V>(mean + stddev * std::sqrt(-2.0 * std::log(u1)) * std::cos(6.283185307179586 * u2));
+    });
+}
+
+// Ranks in [1, ranks] with P(k) proportional to 1 / k^exponent: a few very common keys
+// and a long tail, like word frequencies or request popularity.
+template <class Rng = splitmix_rng, class RandomIt>
+void parallel_fill_zipf(RandomIt first, RandomIt last, std::uint64_t ranks, double exponent, std::uint64_t seed)
+{
+    using V = typename std::iterator_traits<RandomIt>::value_type;
+    const Rng rng(seed, 3);
+    const detail::zipf_sampler zipf(ranks, exponent);
+    detail::parallel_generate(first, last - first, [&](std::uint64_t i) { return static_cast<V>(zipf(rng, i)); });
+}
+
+template <class RandomIt>
+void parallel_fill_sorted(RandomIt first, RandomIt last, typename std::iterator_traits<RandomIt>::value_type start = 0)
+{
+    using V = typename std::iterator_traits<RandomIt>::value_type;
+    detail::parallel_generate(first, last - first, [&](std::uint64_t i) { return static_cast<V>(start + static_cast<V>(i)); });
+}
+
+template <class RandomIt>
+void parallel_fill_reversed(RandomIt first, RandomIt last, typename std::iterator_traits<RandomIt>::value_type start = 0)
+{
+    using V = typename std::iterator_traits<RandomIt>::value_type;
+    const std::uint64_t n = static_cast<std::uint64_t>(last - first);
+    detail::parallel_generate(first, last - first, [&](std::uint64_t i) { return static_cast<V>(start + static_cast<V>(n - 1 - i)); });
+}
+
+// Sorted start + i, but each position is replaced with probability `disorder` by a value
+// uniform in [start, start + n).
+template <class Rng = splitmix_rng, class RandomIt>
+void parallel_fill_nearly_sorted(RandomIt first, RandomIt last, double disorder, std::uint64_t seed,
+                                 typename std::iterator_traits<RandomIt>::value_type start = 0)
+{
+    using V = typename std::iterator_traits<RandomIt>::value_type;
+    const Rng rng(seed, 4);
+    const std::uint64_t n = static_cast<std::uint64_t>(last - first);
+    detail::parallel_generate(first, last - first, [&](std::uint64_t i) {
+        const bool moved = to_unit(rng(i, 0)) < disorder;
+        const std::uint64_t pos = moved ? detail::bounded(rng(i, 1), n) : i;
+        return static_cast<V>(start + static_cast<V>(pos));
+    });
+}
+
+enum class distribution
+{
+    uniform,
+    normal,
+    zipf,
+    sorted,
+    reversed,
+    nearly_sorted
+};
+
+inline const char *distribution_name(distribution d)
+{
+    switch (d)
+    {
+    case distribution::uniform:
+        return "uniform";
+    case distribution::normal:
+        return "normal";
+    case distribution::zipf:
+        return "zipf";
+    case distribution::sorted:
+        return "sorted";
+    case distribution::reversed:
+        return "reversed";
+    case distribution::nearly_sorted:
+        return "nearly sorted";
+    }
+    return "?";
+}
+
+// Fills [first, last) with distribution d using benchmark defaults for n = last - first:
+// uniform in [0, n), normal with mean n / 2 and stddev n / 8, Zipf over n ranks with
+// exponent 1, 1% disorder.
+template <class Rng = splitmix_rng, class RandomIt>
+void parallel_fill(RandomIt first, RandomIt last, distribution d, std::uint64_t seed)
+{
+    using V = typename std::iterator_traits<RandomIt>::value_type;
+    const std::size_t n = static_cast<std::size_t>(last - first);
+    if (n == 0)
+        return;
+    switch (d)
+    {
+    case distribution::uniform:
+        if constexpr (std::is_integral_v<V>)
+            parallel_fill_uniform<Rng>(first, last, V(0), static_cast<V>(n - 1), seed);
+        else
+            parallel_fill_uniform<Rng>(first, last, V(0), static_cast<V>(n), seed);
+        break;
+    case distribution::normal:
+        parallel_fill_normal<Rng>(first, last, n / 2.0, n / 8.0, seed);
+        break;
+    case distribution::zipf:
+        parallel_fill_zipf<Rng>(first, last, n, 1.0, seed);
+        break;
+    case distribution::sorted:
+        parallel_fill_sorted(first, last);
+        break;
+    case distribution::reversed:
+        parallel_fill_reversed(first, last);
+        break;
+    case distribution::nearly_sorted:
+        parallel_fill_nearly_sorted<Rng>(first, last, 0.01, seed);
+        break;
+    }
+}
+
+template <class T, class Rng = splitmix_rng>
+std::vector<T> random_vector(std::size_t n, distribution d, std::uint64_t seed)
+{
+    std::vector<T> v(n);
+    parallel_fill<Rng>(v.begin(), v.end(), d, seed);
+    return v;
+}
+
+} // namespace hpc
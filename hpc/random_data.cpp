@@ -0,0 +1,173 @@
+/*
+ * Parallel Reproducible Random Data Generation using random.hpp
+ * =============================================================
+ *
+ * COMPILATION & EXECUTION:
+ *
+ * For Ubuntu:
+ * -----------
+ * g++ -std=c++17 -O2 -fopenmp -o random_data random_data.cpp
+ * ./random_data
+ *
+ * For macOS:
+ * ----------
+ * g++ -std=c++17 -O2 -Xpreprocessor -fopenmp -I"$(brew --prefix libomp)/include" -L"$(brew --prefix libomp)/lib" -lomp -o random_data random_data.cpp
+ * ./random_data
+ *
+ * THEORETICAL CONCEPTS:
+ *
+ * Why Not rand():
+ * --------------
+ * - rand() keeps one hidden global state: calling it from several threads is a data race
+ *   (or a lock), and the sequence differs between C libraries
+ * - A stateful generator (mt19937) per thread fixes the race, but then the data depends
+ *   on how many threads split the array, so results are not reproducible
+ *
+ * Counter-Based Generators:
+ * ------------------------
+ * - SplitMix64 and Philox compute the i-th random number directly as a keyed hash of i:
+ *   no state, no sequence to advance, any thread can produce any element in any order
+ * - Same seed => bit-identical data on 1 thread or 64, checked below with a checksum
+ *
+ * Distributions for Benchmarks:
+ * ----------------------------
+ * - uniform / normal: the usual random inputs
+ * - zipf: a few keys dominate (hash tables, group-by, caches behave very differently)
+ * - sorted / reversed / nearly sorted: best and worst cases of adaptive sorts
+ *
+ * SAMPLE INPUT/OUTPUT:
+ * ------------------
+ *
+ * Input:
+ *   100000000                    (Array size)
+ *
+ * Output (single core, so "threads" are time-sliced; the checksum is what matters):
+ *   Threads: 1
+ *
+ *   serial rand() % n                3.0840 s
+ *   serial mt19937 + uniform_int     1.9810 s
+ *   hpc uniform, philox_rng          2.7581 s
+ *   hpc uniform, splitmix_rng        0.3139 s
+ *
+ *   Distribution    Time (s)   Checksum           Same on 1/2/3/4/8 threads   First values
+ *   uniform          0.3211    b494a75203efa621   yes                         98671125 30866257 50674952 68487302 58303446
+ *   normal           4.6041    434d7e8e55293f1b   yes                         49729557 72147510 59752437 55173509 35614384
+ *   zipf             2.9050    ec8d729352fab71f   yes                         2260495 10828 28896503 807 407
+ *   sorted           0.0799    76c70deec192d358   yes                         0 1 2 3 4
+ *   reversed         0.0989    2960a1dc54a80f4e   yes                         99999999 99999998 99999997 99999996 99999995
+ *   nearly sorted    0.3214    34624b693d8723cc   yes                         0 1 2 3 4
+ *
+ *   zipf: value 1 is 5.26% of the data (expected 5.26%)
+ *   nearly sorted: 99.01% of neighbours in order
+ *
+ * Normal and Zipf are dominated by log/cos/exp; with p cores every row divides by p.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <string>
+#include <cstdint>
+#include <cstdlib>
+#include <omp.h>
+#include "random.hpp"
+using namespace std;
+
+// Order-sensitive checksum of the data
+uint64_t checksum(const vector<int> &v)
+{
+    uint64_t h = 0;
+    for (size_t i = 0; i < v.size(); i++)
+        h = hpc::splitmix64(h ^ uint32_t(v[i]), i);
+    return h;
+}
+
+int main()
+{
+    int n;
+    cout << "Enter the size of the array: ";
+    cin >> n;
+
+    if (n <= 0)
+    {
+        cout << "Invalid array size!" << endl;
+        return 1;
+    }
+
+    const int maxThreads = omp_get_max_threads();
+    cout << "\nThreads: " << maxThreads << "\n" << endl;
+    cout << fixed << setprecision(4);
+
+    // The old way: one serial generator
+    vector<int> data(n);
+    double start = omp_get_wtime();
+    srand(42);
+    for (int i = 0; i < n; i++)
+        data[i] = rand() % n;
+    cout << "serial rand() % n                " << omp_get_wtime() - start << " s" << endl;
+    start = omp_get_wtime();
+    mt19937 rng(42);
+    uniform_int_distribution<int> pick(0, n - 1);
+    for (int i = 0; i < n; i++)
+        data[i] = pick(rng);
+    cout << "serial mt19937 + uniform_int     " << omp_get_wtime() - start << " s" << endl;
+    start = omp_get_wtime();
+    hpc::parallel_fill_uniform<hpc::philox_rng>(data.begin(), data.end(), 0, n - 1, 42);
+    cout << "hpc uniform, philox_rng          " << omp_get_wtime() - start << " s" << endl;
+    start = omp_get_wtime();
+    hpc::parallel_fill_uniform(data.begin(), data.end(), 0, n - 1, 42);
+    cout << "hpc uniform, splitmix_rng        " << omp_get_wtime() - start << " s\n" << endl;
+
+    cout << left << setw(16) << "Distribution" << setw(11) << "Time (s)" << setw(19) << "Checksum" << setw(28)
+         << "Same on 1/2/3/4/8 threads" << "First values" << endl;
+
+    const uint64_t SEED = 42;
+    const hpc::distribution kinds[] = {hpc::distribution::uniform, hpc::distribution::normal,
+                                       hpc::distribution::zipf,    hpc::distribution::sorted,
+                                       hpc::distribution::reversed, hpc::distribution::nearly_sorted};
+    vector<int> zipf, nearly;
+    for (hpc::distribution kind : kinds)
+    {
+        omp_set_num_threads(maxThreads);
+        start = omp_get_wtime();
+        hpc::parallel_fill(data.begin(), data.end(), kind, SEED);
+        double t = omp_get_wtime() - start;
+        uint64_t sum = checksum(data);
+
+        // Regenerate with other thread counts: every element must come out the same
+        bool same = true;
+        for (int threads : {1, 2, 3, 4, 8})
+        {
+            omp_set_num_threads(threads);
+            same = same && checksum(hpc::random_vector<int>(n, kind, SEED)) == sum;
+        }
+
+        cout << left << setw(16) << hpc::distribution_name(kind) << right << setw(7) << t << "    " << hex
+             << setfill('0') << setw(16) << sum << dec << setfill(' ') << "   " << left << setw(28)
+             << (same ? "yes" : "NO") << right;
+        for (int i = 0; i < min(n, 5); i++)
+            cout << data[i] << " ";
+        cout << endl;
+
+        if (kind == hpc::distribution::zipf)
+            zipf = data;
+        if (kind == hpc::distribution::nearly_sorted)
+            nearly = data;
+    }
+    omp_set_num_threads(maxThreads);
+
+    // Sanity checks on the shapes: P(1) = 1 / H(n) for Zipf with exponent 1
+    long long ones = 0, inOrder = 0;
+    for (int v : zipf)
+        ones += v == 1;
+    double harmonic = 0;
+    for (int k = 1; k <= n; k++)
+        harmonic += 1.0 / k;
+    for (int i = 1; i < n; i++)
+        inOrder += nearly[i - 1] <= nearly[i];
+    cout << setprecision(2) << "\nzipf: value 1 is " << 100.0 * ones / n << "% of the data (expected "
+         << 100.0 / harmonic << "%)" << endl;
+    cout << "nearly sorted: " << 100.0 * inOrder / max(1, n - 1) << "% of neighbours in order" << endl;
+    return 0;
+}
@@ -0,0 +1,175 @@
+/*
+ * Roofline Sweep of the Vector and Matrix Kernels using roofline.hpp
+ * ==================================================================
+ *
+ * COMPILATION & EXECUTION:
+ *
+ * For Ubuntu:
+ * -----------
+ * g++ -std=c++20 -O2 -fopenmp -o roofline roofline.cpp
+ * ./roofline
+ *
+ * For macOS:
+ * ----------
+ * g++ -std=c++20 -O2 -Xpreprocessor -fopenmp -I"$(brew --prefix libomp)/include" -L"$(brew --prefix libomp)/lib" -lomp -o roofline roofline.cpp
+ * ./roofline
+ *
+ * Writes roofline.csv and roofline.json next to the program for plotting: log-log, x =
+ * intensity, y = gflops, with the roof min(peak_gflops, peak_gbs * x). The .cu programs
+ * matrix_mul.cu and vector_add.cu measure their own kernels with --roofline, --csv or --json.
+ *
+ * THEORETICAL CONCEPTS:
+ *
+ * Arithmetic Intensity:
+ * --------------------
+ * - Flops per byte of compulsory memory traffic. A sum reads 4 bytes per flop (1/4), a
+ *   triad 12 bytes per 2 flops (1/6), sparse y = A x 8 bytes per 2 flops: all far left of
+ *   the ridge point, so memory bandwidth is their roof
+ * - An n x n gemm does 2 n^3 flops on 12 n^2 bytes: n / 6 flop/byte, compute bound from
+ *   small n on
+ *
+ * Reading the Sweep:
+ * -----------------
+ * - Vectors that fit in cache run faster than the memory roof allows; the roof is for
+ *   data that has to come from DRAM, and the points fall onto it as n outgrows the cache
+ * - gemm climbs toward the FMA peak as n grows and packing / edge costs amortize
+ *
+ * SAMPLE INPUT/OUTPUT:
+ * ------------------
+ *
+ * Input:
+ *   67108864                     (Largest vector length)
+ *   2048                         (Largest matrix size)
+ *
+ * Output (single core):
+ *   Measuring peaks...
+ *   Threads: 1, AVX-512
+ *   FMA peak: 134.74 GFLOP/s
+ *   STREAM (GB/s): copy 9.70, scale 9.96, add 11.78, triad 11.73
+ *   Ridge point: 11.44 flop/byte
+ *
+ *   kernel                            size     seconds   GFLOP/s     GB/s  flop/byte      roof  % roof  bound
+ *   sum (reduce.hpp)                  4096   0.0000009      4.54     18.1      0.250       2.9   154.1  memory
+ *   sum (reduce.hpp)                 16384   0.0000036      4.55     18.2      0.250       2.9   154.4  memory
+ *   sum (reduce.hpp)                 65536   0.0000145      4.51     18.0      0.250       2.9   153.2  memory
+ *   sum (reduce.hpp)                262144   0.0000562      4.67     18.7      0.250       2.9   158.6  memory
+ *   sum (reduce.hpp)               1048576   0.0002812      3.73     14.9      0.250       2.9   126.7  memory
+ *   sum (reduce.hpp)               4194304   0.0021496      1.95      7.8      0.250       2.9    66.3  memory
+ *   sum (reduce.hpp)              16777216   0.0090308      1.86      7.4      0.250       2.9    63.1  memory
+ *   sum (reduce.hpp)              67108864   0.0312267      2.15      8.6      0.250       2.9    73.0  memory
+ *   triad (vector_expr.hpp)           4096   0.0000005     15.83     95.0      0.167       2.0   806.4  memory
+ *   triad (vector_expr.hpp)          16384   0.0000026     12.67     76.0      0.167       2.0   645.5  memory
+ *   triad (vector_expr.hpp)          65536   0.0000107     12.23     73.4      0.167       2.0   623.0  memory
+ *   triad (vector_expr.hpp)         262144   0.0001218      4.31     25.8      0.167       2.0   219.4  memory
+ *   triad (vector_expr.hpp)        1048576   0.0007244      2.90     17.4      0.167       2.0   147.5  memory
+ *   triad (vector_expr.hpp)        4194304   0.0041511      2.02     12.1      0.167       2.0   103.0  memory
+ *   triad (vector_expr.hpp)       16777216   0.0138140      2.43     14.6      0.167       2.0   123.8  memory
+ *   triad (vector_expr.hpp)       67108864   0.0520120      2.58     15.5      0.167       2.0   131.5  memory
+ *   gemm (gemm.hpp)                     64   0.0000155     33.78      3.2     10.667     125.6    26.9  memory
+ *   gemm (gemm.hpp)                    128   0.0000906     46.28      2.2     21.333     134.7    34.3  compute
+ *   gemm (gemm.hpp)                    256   0.0006164     54.44      1.3     42.667     134.7    40.4  compute
+ *   gemm (gemm.hpp)                    512   0.0027734     96.79      1.1     85.333     134.7    71.8  compute
+ *   gemm (gemm.hpp)                   1024   0.0257437     83.42      0.5    170.667     134.7    61.9  compute
+ *   gemm (gemm.hpp)                   2048   0.1909863     89.95      0.3    341.333     134.7    66.8  compute
+ *   spmv 1% (sparse.hpp)                64   0.0000010      0.08      1.4      0.060       0.7    11.5  memory
+ *   spmv 1% (sparse.hpp)               128   0.0000016      0.21      2.2      0.098       1.2    18.3  memory
+ *   spmv 1% (sparse.hpp)               256   0.0000026      0.47      3.5      0.137       1.6    29.3  memory
+ *   spmv 1% (sparse.hpp)               512   0.0000050      1.03      5.8      0.179       2.1    48.9  memory
+ *   spmv 1% (sparse.hpp)              1024   0.0000100      2.08     10.0      0.209       2.5    84.6  memory
+ *   spmv 1% (sparse.hpp)              2048   0.0000376      2.21      9.7      0.228       2.7    82.4  memory
+ *
+ *   Wrote roofline.csv and roofline.json (28 points)
+ *
+ * The ridge sits at 11 flop/byte, so every vector kernel and spmv is memory bound and
+ * gemm from n = 128 on compute bound. Up to 256K elements the sum and the triad run from
+ * cache, above the DRAM roof; from 4M elements they stream from memory. The triad then
+ * beats STREAM's triad (103-131% of roof) because vector_expr.hpp writes with streaming
+ * stores and skips the read-for-ownership that STREAM's loops pay; the sum, with only
+ * loads, reaches 65-75%. gemm levels off at 65-70% of the FMA peak, and spmv approaches
+ * its roof once the matrix is large enough to amortize the per-call overhead.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <algorithm>
+#include <vector>
+#include <string>
+#include <omp.h>
+#include "roofline.hpp"
+#include "vector_expr.hpp"
+#include "reduce.hpp"
+#include "sparse.hpp"
+#include "random.hpp"
+using namespace std;
+
+int main()
+{
+    size_t maxVector, maxMatrix;
+    cout << "Enter the largest vector length: ";
+    cin >> maxVector;
+    cout << "Enter the largest matrix size: ";
+    cin >> maxMatrix;
+
+    if (maxVector < 4096 || maxMatrix < 64)
+    {
+        cout << "Invalid input!" << endl;
+        return 1;
+    }
+
+    cout << "\nMeasuring peaks..." << endl;
+    hpc::roofline_report report(hpc::measure_peaks());
+    cout << fixed << setprecision(2);
+    report.peaks().print(cout);
+    cout << endl;
+
+    // Vectors: 4096 elements (in L1) up to maxVector (in DRAM), x4 per step.
+    {
+        hpc::vec<float> A(maxVector), B(maxVector), C(maxVector);
+        hpc::parallel_fill_uniform(B.data(), B.data() + maxVector, -1.0f, 1.0f, 1);
+        hpc::parallel_fill_uniform(C.data(), C.data() + maxVector, -1.0f, 1.0f, 2);
+        volatile float sink = 0; // keeps the sums from being optimized away
+        const float *b = B.data();
+        for (size_t n = 4096; n <= maxVector; n *= 4)
+            report.measure("sum (reduce.hpp)", n, 1.0 * n, 4.0 * n, [&] {
+                sink = hpc::parallel_reduce(b, b + n, hpc::reducers::sum<float>());
+            });
+        for (size_t n = 4096; n <= maxVector; n *= 4)
+            report.measure("triad (vector_expr.hpp)", n, 2.0 * n, 12.0 * n, [&] {
+                hpc::evaluate(A.data(), n, hpc::view(B.data(), n) + 3.0f * hpc::view(C.data(), n));
+            });
+    }
+
+    // Matrices: 64 up to maxMatrix, x2 per step.
+    for (size_t n = 64; n <= maxMatrix; n *= 2)
+    {
+        const size_t nn = n * n;
+        vector<float> A(nn), B(nn), C(nn);
+        hpc::parallel_fill_uniform(A.begin(), A.end(), -1.0f, 1.0f, 3);
+        hpc::parallel_fill_uniform(B.begin(), B.end(), -1.0f, 1.0f, 4);
+        report.measure("gemm (gemm.hpp)", n, 2.0 * n * nn, 12.0 * nn, [&] {
+            hpc::gemm(n, n, n, 1.0f, A.data(), n, B.data(), n, 0.0f, C.data(), n);
+        });
+    }
+    for (size_t n = 64; n <= maxMatrix; n *= 2)
+    {
+        // 1% non-zeros: the entries below -0.98.
+        vector<float> A(n * n), x(n), y(n);
+        hpc::parallel_fill_uniform(A.begin(), A.end(), -1.0f, 1.0f, 3);
+        hpc::parallel_fill_uniform(x.begin(), x.end(), -1.0f, 1.0f, 5);
+        for (float &a : A)
+            a = a < -0.98f ? a : 0.0f;
+        const hpc::csr_matrix<float> S = hpc::to_csr(n, n, A.data(), n);
+        const double nnz = double(S.nnz());
+        report.measure("spmv 1% (sparse.hpp)", n, 2.0 * nnz, 8.0 * nnz + 8.0 * (n + 1) + 8.0 * n,
+                       [&] { hpc::spmv(S, x.data(), y.data()); });
+    }
+
+    report.print(cout);
+
+    ofstream csv("roofline.csv"), json("roofline.json");
+    report.write_csv(csv);
+    report.write_json(json);
+    cout << "\nWrote roofline.csv and roofline.json (" << report.points().size() << " points)" << endl;
+    return 0;
+}
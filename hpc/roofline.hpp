@@ -0,0 +1,422 @@
+/*
+ * Roofline Measurements (header-only): Machine Peaks, Kernel Points, CSV / JSON Output
+ * ===================================================================================
+ *
+ * A kernel's time alone does not say whether it is any good. The roofline model bounds it
+ * by the two things the machine cannot exceed: the floating-point peak, and the memory
+ * bandwidth times the kernel's arithmetic intensity (flops per byte moved). A point below
+ * the sloped roof is limited by memory, below the flat one by compute, and its distance to
+ * the roof is what is left to gain.
+ *
+ * USAGE:
+ *
+ *   #include "roofline.hpp"
+ *
+ *   hpc::roofline_report report(hpc::measure_peaks());      // STREAM + FMA probes, ~1 s
+ *   report.measure("saxpy", n, 2.0 * n, 12.0 * n, [&] { saxpy(n, a, x, y); });
+ *   report.measure("gemm", n, 2.0 * n * n * n, 12.0 * n * n, [&] { ... });
+ *   report.print(std::cout);                                // table: GFLOP/s, GB/s, % of roof
+ *   report.write_csv(file);                                 // one row per point
+ *   report.write_json(file);                                // {"machine": {...}, "points": [...]}
+ *
+ *   if (auto format = hpc::roofline_arg(argc, argv))        // ./program --roofline | --csv | --json
+ *       report.write(std::cout, *format);
+ *
+ *   hpc::machine_peaks peaks = hpc::measure_peaks();
+ *   peaks.roof(0.25);                                       // attainable GFLOP/s at 1/4 flop/byte
+ *
+ * COMPILATION:
+ *   g++ -std=c++20 -O2 -fopenmp -o program program.cpp
+ *
+ * PEAKS:
+ * -----
+ * - Compute: simd_peak_gflops from gemm.hpp, independent FMA chains on every thread.
+ * - Memory: the four STREAM kernels (McCalpin) over three double arrays of at least four
+ *   times the last-level cache each, initialized by the threads that use them. Bytes are
+ *   counted the STREAM way, 16 per element for copy and scale, 24 for add and triad,
+ *   without the read-for-ownership of the destination. The best of the four is the roof.
+ * - Both probes run on the CPU and are left out when nvcc compiles the file: a GPU build
+ *   of the .cu programs reports its points with the peaks left empty (bound "unknown").
+ *
+ * POINTS:
+ * ------
+ * - flops and bytes are supplied by the caller: the kernel's useful operations and its
+ *   compulsory traffic (every input read once, every output written once). Integer
+ *   kernels count integer operations. A kernel that reuses data from cache beats the
+ *   memory roof computed from compulsory bytes; one that re-reads data falls short of it.
+ * - measure() runs the kernel once to warm up, repeats it enough times for each timed
+ *   batch to last a millisecond, and keeps the best of five batches.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include <omp.h>
+#ifndef __CUDACC__
+#include <unistd.h>
+#include "gemm.hpp"
+#endif
+
+namespace hpc
+{
+
+struct machine_peaks
+{
+    std::string device;   // what the peaks were measured on, e.g. "AVX-512"
+    int threads = 0;
+    double gflops = 0;    // FMA peak, float
+    double copy = 0, scale = 0, add = 0, triad = 0; // STREAM, GB/s
+    double bandwidth = 0; // best of the four
+
+    // Intensity (flop/byte) where the memory roof meets the compute roof.
+    double ridge() const { return bandwidth > 0 ? gflops / bandwidth : 0.0; }
+
+    // Attainable GFLOP/s at `intensity` flop/byte.
+    double roof(double intensity) const { return std::min(gflops, bandwidth * intensity); }
+
+    void print(std::ostream &os) const
+    {
+        os << "Threads: " << threads << ", " << device << "\n"
+           << "FMA peak: " << gflops << " GFLOP/s\n"
+           << "STREAM (GB/s): copy " << copy << ", scale " << scale << ", add " << add << ", triad " << triad << "\n"
+           << "Ridge point: " << ridge() << " flop/byte\n";
+    }
+};
+
+struct roofline_point
+{
+    std::string kernel;
+    std::size_t size = 0;
+    double seconds = 0; // per call
+    double flops = 0;   // per call
+    double bytes = 0;   // per call, compulsory traffic
+
+    double gflops() const { return seconds > 0 ? flops / seconds / 1e9 : 0.0; }
+    double bandwidth() const { return seconds > 0 ? bytes / seconds / 1e9 : 0.0; } // GB/s
+    double intensity() const { return bytes > 0 ? flops / bytes : 0.0; }
+};
+
+namespace detail
+{
+
+inline void json_string(std::ostream &os, const std::string &s)
+{
+    os << '"';
+    for (char c : s)
+    {
+        if (c == '"' || c == '\\')
+            os << '\\' << c;
+        else if (static_cast<unsigned char>(c) < 0x20)
+        {
+            char escaped[8];
+            std::snprintf(escaped, sizeof escaped, "\\u%04x", c);
+            os << escaped;
+        }
+        else
+            os << c;
+    }
+    os << '"';
+}
+
+// CSV field: quoted when it holds a comma, quote or newline.
+inline void csv_field(std::ostream &os, const std::string &s)
+{
+    if (s.find_first_of(",\"\n") == std::string::npos)
+    {
+        os << s;
+        return;
+    }
+    os << '"';
+    for (char c : s)
+        os << (c == '"' ? "\"\"" : std::string(1, c));
+    os << '"';
+}
+
+} // namespace detail
+
+enum class roofline_format
+{
+    table,
+    csv,
+    json
+};
+
+// The benchmark switch of a program: "--roofline" (table), "--csv" or "--json" as its
+// first argument; nullopt when there is none, so the program runs as usual.
+inline std::optional<roofline_format> roofline_arg(int argc, char **argv)
+{
+    if (argc < 2)
+        return std::nullopt;
+    const std::string arg = argv[1];
+    if (arg == "--roofline")
+        return roofline_format::table;
+    if (arg == "--csv")
+        return roofline_format::csv;
+    if (arg == "--json")
+        return roofline_format::json;
+    return std::nullopt;
+}
+
+class roofline_report
+{
+public:
+    explicit roofline_report(machine_peaks peaks) : peaks_(peaks) {}
+
+    const machine_peaks &peaks() const { return peaks_; }
+    const std::vector<roofline_point> &points() const { return points_; }
+
+    const roofline_point &add(roofline_point point)
+    {
+        points_.push_back(std::move(point));
+        return points_.back();
+    }
+
+    // Times f (one call of the kernel) and records it with the given work per call.
+    template <class F>
+    const roofline_point &measure(std::string kernel, std::size_t size, double flops, double bytes, F &&f)
+    {
+        constexpr double batch_seconds = 1e-3;
+        double start = omp_get_wtime();
+        f();
+        const double once = omp_get_wtime() - start;
+        const long batch = once >= batch_seconds ? 1 : static_cast<long>(std::ceil(batch_seconds / std::max(once, 1e-9)));
+        double best = 1e30;
+        for (int r = 0; r < 5; r++)
+        {
+            start = omp_get_wtime();
+            for (long i = 0; i < batch; i++)
+                f();
+            best = std::min(best, (omp_get_wtime() - start) / batch);
+        }
+        return add({std::move(kernel), size, best, flops, bytes});
+    }
+
+    // Attainable GFLOP/s for the point, and the share of it the point reached.
+    double roof(const roofline_point &p) const { return peaks_.roof(p.intensity()); }
+    double efficiency(const roofline_point &p) const { return roof(p) > 0 ? p.gflops() / roof(p) : 0.0; }
+
+    // "memory" when the point sits left of the ridge, "compute" otherwise ("unknown"
+    // without peaks).
+    const char *bound(const roofline_point &p) const
+    {
+        if (peaks_.bandwidth <= 0 || peaks_.gflops <= 0)
+            return "unknown";
+        return p.intensity() < peaks_.ridge() ? "memory" : "compute";
+    }
+
+    void print(std::ostream &os) const
+    {
+        const std::ios_base::fmtflags flags = os.flags();
+        const std::streamsize precision = os.precision();
+        os << std::left;
+        os.width(28);
+        os << "kernel" << std::right;
+        const char *heads[] = {"size", "seconds", "GFLOP/s", "GB/s", "flop/byte", "roof", "% roof"};
+        const int widths[] = {10, 12, 10, 9, 11, 10, 8};
+        for (int i = 0; i < 7; i++)
+        {
+            os.width(widths[i]);
+            os << heads[i];
+        }
+        os << "  bound\n" << std::fixed;
+        for (const roofline_point &p : points_)
+        {
+            os << std::left;
+            os.width(28);
+            os << p.kernel << std::right;
+            os.width(10);
+            os << p.size;
+            os.precision(7);
+            os.width(12);
+            os << p.seconds;
+            os.precision(2);
+            os.width(10);
+            os << p.gflops();
+            os.precision(1);
+            os.width(9);
+            os << p.bandwidth();
+            os.precision(3);
+            os.width(11);
+            os << p.intensity();
+            os.precision(1);
+            os.width(10);
+            os << roof(p);
+            os.width(8);
+            os << 100 * efficiency(p) << "  " << bound(p) << "\n";
+        }
+        os.flags(flags);
+        os.precision(precision);
+    }
+
+    // Header row, then one row per point; the machine peaks repeat on every row so each
+    // row plots on its own.
+    void write_csv(std::ostream &os) const
+    {
+        const std::ios_base::fmtflags flags = os.flags(std::ios_base::dec);
+        const std::streamsize precision = os.precision(10);
+        os << "kernel,size,seconds,flops,bytes,gflops,gbs,intensity,roof_gflops,efficiency,bound,"
+              "peak_gflops,peak_gbs,ridge\n";
+        for (const roofline_point &p : points_)
+        {
+            detail::csv_field(os, p.kernel);
+            os << ',' << p.size << ',' << p.seconds << ',' << p.flops << ',' << p.bytes << ',' << p.gflops() << ','
+               << p.bandwidth() << ',' << p.intensity() << ',' << roof(p) << ',' << efficiency(p) << ',' << bound(p)
+               << ',' << peaks_.gflops << ',' << peaks_.bandwidth << ',' << peaks_.ridge() << '\n';
+        }
+        os.flags(flags);
+        os.precision(precision);
+    }
+
+    void write_json(std::ostream &os) const
+    {
+        const std::ios_base::fmtflags flags = os.flags(std::ios_base::dec);
+        const std::streamsize precision = os.precision(10);
+        os << "{\n  \"machine\": {\"device\": ";
+        detail::json_string(os, peaks_.device);
+        os << ", \"threads\": " << peaks_.threads << ", \"peak_gflops\": " << peaks_.gflops << ", \"peak_gbs\": " << peaks_.bandwidth
+           << ", \"ridge\": " << peaks_.ridge() << ",\n              \"stream_gbs\": {\"copy\": " << peaks_.copy
+           << ", \"scale\": " << peaks_.scale << ", \"add\": " << peaks_.add << ", \"triad\": " << peaks_.triad
+           << "}},\n  \"points\": [";
+        for (std::size_t i = 0; i < points_.size(); i++)
+        {
+            const roofline_point &p = points_[i];
+            os << (i ? ",\n    " : "\n    ") << "{\"kernel\": ";
+            detail::json_string(os, p.kernel);
+            os << ", \"size\": " << p.size << ", \"seconds\": " << p.seconds << ", \"flops\": " << p.flops
+               << ", \"bytes\": " << p.bytes << ", \"gflops\": " << p.gflops() << ", \"gbs\": " << p.bandwidth()
+               << ", \"intensity\": " << p.intensity() << ", \"roof_gflops\": " << roof(p)
+               << ", \"efficiency\": " << efficiency(p) << ", \"bound\": \"" << bound(p) << "\"}";
+        }
+        os << (points_.empty() ? "]\n}\n" : "\n  ]\n}\n");
+        os.flags(flags);
+        os.precision(precision);
+    }
+
+    // The peaks and the table, the CSV or the JSON.
+    void write(std::ostream &os, roofline_format format) const
+    {
+        if (format == roofline_format::csv)
+            write_csv(os);
+        else if (format == roofline_format::json)
+            write_json(os);
+        else
+        {
+            const std::ios_base::fmtflags flags = os.flags();
+            const std::streamsize precision = os.precision(2);
+            os << std::fixed;
+            peaks_.print(os);
+            os.flags(flags);
+            os.precision(precision);
+            os << "\n";
+            print(os);
+        }
+    }
+
+private:
+    machine_peaks peaks_;
+    std::vector<roofline_point> points_;
+};
+
+#ifndef __CUDACC__
+
+namespace detail
+{
+
+// Elements per STREAM array: four times the last-level cache, at least 2^24 doubles.
+inline std::size_t stream_elements()
+{
+    long llc = 0;
+#ifdef _SC_LEVEL3_CACHE_SIZE
+    llc = sysconf(_SC_LEVEL3_CACHE_SIZE);
+    if (llc <= 0)
+        llc = sysconf(_SC_LEVEL2_CACHE_SIZE);
+#endif
+    return std::max<std::size_t>(std::size_t(1) << 24, 4 * std::size_t(std::max(llc, 0L)) / sizeof(double));
+}
+
+// Best seconds of `repeats` runs of f, after one warm-up run.
+template <class F>
+double best_seconds(int repeats, F &&f)
+{
+    f();
+    double best = 1e30;
+    for (int r = 0; r < repeats; r++)
+    {
+        const double start = omp_get_wtime();
+        f();
+        best = std::min(best, omp_get_wtime() - start);
+    }
+    return best;
+}
+
+} // namespace detail
+
+// STREAM copy / scale / add / triad over three arrays of `elements` doubles (0: four
+// times the last-level cache), best of `repeats`, in GB/s; fills those fields of peaks.
+inline void measure_stream(machine_peaks &peaks, std::size_t elements = 0, int repeats = 5,
+                           int threads = omp_get_max_threads())
+{
+    const std::size_t n = elements ? elements : detail::stream_elements();
+    const long long count = static_cast<long long>(n);
+    auto a = detail::gemm_buffer<double>(n), b = detail::gemm_buffer<double>(n), c = detail::gemm_buffer<double>(n);
+    double *pa = a.get(), *pb = b.get(), *pc = c.get();
+    const double s = 3.0;
+    threads = std::max(threads, 1);
+
+    // First touch with the schedule the kernels use.
+#pragma omp parallel for simd schedule(static) num_threads(threads)
+    for (long long i = 0; i < count; i++)
+    {
+        pa[i] = 1.0;
+        pb[i] = 2.0;
+        pc[i] = 0.0;
+    }
+
+    const double bytes2 = 16.0 * n, bytes3 = 24.0 * n;
+    peaks.copy = bytes2 / 1e9 / detail::best_seconds(repeats, [&] {
+#pragma omp parallel for simd schedule(static) num_threads(threads)
+        for (long long i = 0; i < count; i++)
+            pc[i] = pa[i];
+    });
+    peaks.scale = bytes2 / 1e9 / detail::best_seconds(repeats, [&] {
+#pragma omp parallel for simd schedule(static) num_threads(threads)
+        for (long long i = 0; i < count; i++)
+            pb[i] = s * pc[i];
+    });
+    peaks.add = bytes3 / 1e9 / detail::best_seconds(repeats, [&] {
+#pragma omp parallel for simd schedule(static) num_threads(threads)
+        for (long long i = 0; i < count; i++)
+            pc[i] = pa[i] + pb[i];
+    });
+    peaks.triad = bytes3 / 1e9 / detail::best_seconds(repeats, [&] {
+#pragma omp parallel for simd schedule(static) num_threads(threads)
+        for (long long i = 0; i < count; i++)
+            pa[i] = pb[i] + s * pc[i];
+    });
+    peaks.bandwidth = std::max({peaks.copy, peaks.scale, peaks.add, peaks.triad});
+}
+
+// Both roofs: the float FMA peak and the STREAM bandwidth.
+inline machine_peaks measure_peaks(std::size_t stream_elements = 0, simd_level level = detected_simd_level(),
+                                   int threads = omp_get_max_threads())
+{
+    machine_peaks peaks;
+    level = detail::gemm_level(level, true);
+    peaks.device = simd_level_name(level);
+    peaks.threads = std::max(threads, 1);
+    peaks.gflops = simd_peak_gflops<float>(level, peaks.threads);
+    measure_stream(peaks, stream_elements, 5, peaks.threads);
+    return peaks;
+}
+
+#endif // __CUDACC__
+
+} // namespace hpc
@@ -0,0 +1,340 @@
+/*
+ * Parallel Prefix Sum (Scan) and Stream Compaction (header-only) using OpenMP
+ * ===========================================================================
+ *
+ * The building block behind radix sort offsets, CSR row pointers and BFS frontier
+ * compaction. All entry points take an associative operator (std::plus<> by default);
+ * it does not have to be commutative, and no identity element is needed except for the
+ * exclusive scan's init.
+ *
+ * USAGE:
+ *
+ *   #include "scan.hpp"
+ *
+ *   hpc::parallel_inclusive_scan(v.begin(), v.end(), out.begin());             // running sums
+ *   hpc::parallel_exclusive_scan(v.begin(), v.end(), offsets.begin(), 0LL);     // offsets
+ *   hpc::parallel_inclusive_scan(v.begin(), v.end(), v.begin(),                  // in place,
+ *                                [](int a, int b) { return max(a, b); });       // running max
+ *   hpc::parallel_segmented_inclusive_scan(v.begin(), v.end(), starts.begin(), out.begin());
+ *   auto end = hpc::parallel_copy_if(v.begin(), v.end(), out.begin(), is_even);
+ *   vector<int> kept = hpc::parallel_filter(v, is_even);
+ *
+ * COMPILATION:
+ *   g++ -std=c++20 -O2 -fopenmp -o program program.cpp
+ *
+ * ALGORITHM (two-pass blocked, "reduce then scan"):
+ * ---------
+ * 1. Thread t reduces its contiguous slice to one partial.
+ * 2. One thread scans the p partials to get each slice's carry-in (O(p)).
+ * 3. Thread t scans its slice again, starting from its carry-in, and writes the output.
+ * The input is read twice and the output written once, with two barriers in total. For
+ * std::plus on arithmetic types over contiguous memory, passes 1 and 3 use OpenMP SIMD
+ * (`reduction(inscan, +)` and `#pragma omp scan`), which the compiler turns into an
+ * in-register log-step scan per vector. Everything works in place (out == first).
+ *
+ * Segmented scan restarts the running value wherever flags[i] is true. Stream compaction
+ * counts matches per slice, scans the counts into write offsets, then every thread copies
+ * its matches to its own output range, so the result keeps the input order.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <ranges>
+#include <type_traits>
+#include <vector>
+#include <omp.h>
+#include "reduce.hpp"
+
+namespace hpc
+{
+
+namespace detail
+{
+
+// Each thread gets at least this many elements.
+constexpr std::ptrdiff_t scan_grain = 1 << 14;
+
+inline int scan_threads(std::ptrdiff_t n)
+{
+    return static_cast<int>(std::clamp<std::ptrdiff_t>(n / scan_grain, 1, omp_get_max_threads()));
+}
+
+// True when the scan can run as an OpenMP SIMD plus-scan over raw pointers.
+template <class InIt, class OutIt, class T, class Op>
+constexpr bool simd_plus_scan()
+{
+    return std::is_arithmetic_v<T> && (std::is_same_v<Op, std::plus<>> || std::is_same_v<Op, std::plus<T>>) &&
+           std::contiguous_iterator<InIt> && std::contiguous_iterator<OutIt> &&
+           std::is_same_v<std::iter_value_t<OutIt>, T>;
+}
+
+// op-fold of [in, in + n), n >= 1.
+template <class InIt, class Op>
+auto fold_slice(InIt in, std::ptrdiff_t n, const Op &op)
+{
+    using T = std::iter_value_t<InIt>;
+    if constexpr (simd_plus_scan<InIt, T *, T, Op>())
+    {
+        const T *p = std::to_address(in);
+        T s = 0;
+#pragma omp simd reduction(+ : s)
+        for (std::ptrdiff_t i = 0; i < n; i++)
+            s += p[i];
+        return s;
+    }
+    else
+    {
+        T s = in[0];
+        for (std::ptrdiff_t i = 1; i < n; i++)
+            s = op(s, in[i]);
+        return s;
+    }
+}
+
+// Inclusive scan of one slice. Starts from `carry` if has_carry, else from in[0].
+template <class InIt, class OutIt, class T, class Op>
+void inclusive_slice(InIt in, std::ptrdiff_t n, OutIt out, T carry, bool has_carry, const Op &op)
+{
+    if constexpr (simd_plus_scan<InIt, OutIt, T, Op>())
+    {
+        const T *src = std::to_address(in);
+        T *dst = std::to_address(out);
+        T s = has_carry ? carry : T(0);
+#pragma omp simd reduction(inscan, + : s)
+        for (std::ptrdiff_t i = 0; i < n; i++)
+        {
+            s += src[i];
+#pragma omp scan inclusive(s)
+            dst[i] = s;
+        }
+    }
+    else
+    {
+        std::ptrdiff_t i = 0;
+        if (!has_carry && n > 0)
+        {
+            carry = in[0];
+            out[0] = carry;
+            i = 1;
+        }
+        for (; i < n; i++)
+        {
+            carry = op(carry, in[i]);
+            out[i] = carry;
+        }
+    }
+}
+
+// Exclusive scan of one slice starting from carry.
+template <class InIt, class OutIt, class T, class Op>
+void exclusive_slice(InIt in, std::ptrdiff_t n, OutIt out, T carry, const Op &op)
+{
+    if constexpr (simd_plus_scan<InIt, OutIt, T, Op>())
+    {
+        const T *src = std::to_address(in);
+        T *dst = std::to_address(out);
+        // The SIMD form writes dst[i] before reading src[i], so it cannot run in place.
+        if (static_cast<const void *>(src) != static_cast<const void *>(dst))
+        {
+            T s = carry;
+#pragma omp simd reduction(inscan, + : s)
+            for (std::ptrdiff_t i = 0; i < n; i++)
+            {
+                dst[i] = s;
+#pragma omp scan exclusive(s)
+                s += src[i];
+            }
+            return;
+        }
+    }
+    for (std::ptrdiff_t i = 0; i < n; i++)
+    {
+        T x = in[i];
+        out[i] = carry;
+        carry = op(carry, x);
+    }
+}
+
+} // namespace detail
+
+// out[i] = in[0] op in[1] op ... op in[i]. Returns the end of the output.
+template <std::random_access_iterator InIt, std::random_access_iterator OutIt, class Op = std::plus<>>
+OutIt parallel_inclusive_scan(InIt first, InIt last, OutIt out, Op op = {})
+{
+    using T = std::iter_value_t<InIt>;
+    const std::ptrdiff_t n = last - first;
+    const int threads = detail::scan_threads(n);
+    if (threads == 1)
+    {
+        detail::inclusive_slice(first, n, out, T{}, false, op);
+        return out + n;
+    }
+
+    std::vector<detail::cache_padded<T>> partial(threads);
+#pragma omp parallel num_threads(threads)
+    {
+        const int nt = omp_get_num_threads();
+        const int t = omp_get_thread_num();
+        const std::ptrdiff_t lo = n * t / nt, hi = n * (t + 1) / nt;
+
+        partial[t].value = detail::fold_slice(first + lo, hi - lo, op);
+#pragma omp barrier
+#pragma omp single
+        for (int u = 1; u < nt; u++) // partial[u] becomes the carry-in of slice u + 1
+            partial[u].value = op(partial[u - 1].value, partial[u].value);
+
+        detail::inclusive_slice(first + lo, hi - lo, out + lo, t > 0 ? partial[t - 1].value : T{}, t > 0, op);
+    }
+    return out + n;
+}
+
+// out[i] = init op in[0] op ... op in[i - 1] (out[0] = init). Returns the end of the output.
+template <std::random_access_iterator InIt, std::random_access_iterator OutIt, class T, class Op = std::plus<>>
+OutIt parallel_exclusive_scan(InIt first, InIt last, OutIt out, T init, Op op = {})
+{
+    const std::ptrdiff_t n = last - first;
+    const int threads = detail::scan_threads(n);
+    if (threads == 1)
+    {
+        detail::exclusive_slice(first, n, out, init, op);
+        return out + n;
+    }
+
+    std::vector<detail::cache_padded<T>> carry(threads + 1);
+#pragma omp parallel num_threads(threads)
+    {
+        const int nt = omp_get_num_threads();
+        const int t = omp_get_thread_num();
+        const std::ptrdiff_t lo = n * t / nt, hi = n * (t + 1) / nt;
+
+        carry[t + 1].value = detail::fold_slice(first + lo, hi - lo, op);
+#pragma omp barrier
+#pragma omp single
+        {
+            carry[0].value = init;
+            for (int u = 1; u <= nt; u++)
+                carry[u].value = op(carry[u - 1].value, carry[u].value);
+        }
+
+        detail::exclusive_slice(first + lo, hi - lo, out + lo, carry[t].value, op);
+    }
+    return out + n;
+}
+
+// Inclusive scan that restarts at every i where flags[i] is true (the first element always
+// starts a segment). flags is any random-access range of bool-convertible values.
+template <std::random_access_iterator InIt, std::random_access_iterator FlagIt, std::random_access_iterator OutIt,
+          class Op = std::plus<>>
+OutIt parallel_segmented_inclusive_scan(InIt first, InIt last, FlagIt flags, OutIt out, Op op = {})
+{
+    using T = std::iter_value_t<InIt>;
+    const std::ptrdiff_t n = last - first;
+
+    // Fold of the tail of a slice after its last segment start, and whether it had one.
+    struct segment_partial
+    {
+        T value{};
+        bool restarts = false;
+    };
+    auto scan_slice = [&](std::ptrdiff_t lo, std::ptrdiff_t hi, T carry, bool has_carry) {
+        for (std::ptrdiff_t i = lo; i < hi; i++)
+        {
+            carry = (has_carry && !flags[i]) ? op(carry, first[i]) : T(first[i]);
+            has_carry = true;
+            out[i] = carry;
+        }
+    };
+
+    const int threads = detail::scan_threads(n);
+    if (threads == 1)
+    {
+        scan_slice(0, n, T{}, false);
+        return out + n;
+    }
+
+    std::vector<detail::cache_padded<segment_partial>> partial(threads);
+#pragma omp parallel num_threads(threads)
+    {
+        const int nt = omp_get_num_threads();
+        const int t = omp_get_thread_num();
+        const std::ptrdiff_t lo = n * t / nt, hi = n * (t + 1) / nt;
+
+        segment_partial p{first[lo], static_cast<bool>(flags[lo])};
+        for (std::ptrdiff_t i = lo + 1; i < hi; i++)
+        {
+            if (flags[i])
+                p = {first[i], true};
+            else
+                p.value = op(p.value, first[i]);
+        }
+        partial[t].value = p;
+
+#pragma omp barrier
+#pragma omp single
+        for (int u = 1; u < nt; u++) // partial[u] becomes the carry-in of slice u + 1
+            if (!partial[u].value.restarts)
+                partial[u].value = {op(partial[u - 1].value.value, partial[u].value.value), partial[u - 1].value.restarts};
+
+        if (t == 0)
+            scan_slice(lo, hi, T{}, false);
+        else
+            scan_slice(lo, hi, partial[t - 1].value.value, true);
+    }
+    return out + n;
+}
+
+// Copies the elements satisfying pred to out, keeping their order. Returns the output end.
+// pred is called twice per element (once to count, once to copy).
+template <std::random_access_iterator InIt, std::random_access_iterator OutIt, class Pred>
+OutIt parallel_copy_if(InIt first, InIt last, OutIt out, Pred pred)
+{
+    const std::ptrdiff_t n = last - first;
+    const int threads = detail::scan_threads(n);
+    if (threads == 1)
+        return std::copy_if(first, last, out, pred);
+
+    std::vector<detail::cache_padded<std::ptrdiff_t>> offset(threads + 1, {0});
+    int team = threads; // the team can be smaller than asked for (nested regions)
+#pragma omp parallel num_threads(threads)
+    {
+        const int nt = omp_get_num_threads();
+        const int t = omp_get_thread_num();
+        const std::ptrdiff_t lo = n * t / nt, hi = n * (t + 1) / nt;
+
+        std::ptrdiff_t count = 0;
+        for (std::ptrdiff_t i = lo; i < hi; i++)
+            count += pred(first[i]) ? 1 : 0;
+        offset[t + 1].value = count;
+
+#pragma omp barrier
+#pragma omp single
+        {
+            team = nt;
+            for (int u = 1; u <= nt; u++)
+                offset[u].value += offset[u - 1].value;
+        }
+
+        OutIt dst = out + offset[t].value;
+        for (std::ptrdiff_t i = lo; i < hi; i++)
+            if (pred(first[i]))
+                *dst++ = first[i];
+    }
+    return out + offset[team].value;
+}
+
+// The elements of range satisfying pred, in order.
+template <std::ranges::random_access_range Range, class Pred>
+auto parallel_filter(Range &&range, Pred pred)
+{
+    std::vector<std::ranges::range_value_t<Range>> result(std::ranges::size(range));
+    auto end = parallel_copy_if(std::ranges::begin(range), std::ranges::end(range), result.begin(), pred);
+    result.erase(end, result.end());
+    return result;
+}
+
+} // namespace hpc
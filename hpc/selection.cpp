@@ -0,0 +1,169 @@
+/*
+ * Parallel Selection Benchmark using selection.hpp
+ * ================================================
+ *
+ * COMPILATION & EXECUTION:
+ *
+ * For Ubuntu:
+ * -----------
+ * g++ -std=c++20 -O2 -fopenmp -o selection selection.cpp
+ * ./selection
+ *
+ * For macOS:
+ * ----------
+ * g++ -std=c++20 -O2 -Xpreprocessor -fopenmp -I"$(brew --prefix libomp)/include" -L"$(brew --prefix libomp)/lib" -lomp -o selection selection.cpp
+ * ./selection
+ *
+ * THEORETICAL CONCEPTS:
+ *
+ * Selection vs Sorting:
+ * --------------------
+ * - The median, a percentile or the k smallest values need only part of the sorted order
+ * - Full sort: O(n log n). Quickselect: O(n) expected. Top-k with a heap: O(n log k)
+ *
+ * Parallel Quickselect with Sampling:
+ * ----------------------------------
+ * - A sorted random sample estimates where the target rank falls
+ * - Two pivots just around that estimate split the data into three parts in one parallel pass
+ * - The target almost always lands in the small middle part, so each round shrinks the problem a lot
+ *
+ * Per-Thread Heaps for Top-k:
+ * --------------------------
+ * - Each thread keeps its own heap of the k best values in its slice: no locks, no sharing
+ * - Only p * k candidates are left to merge at the end
+ *
+ * SAMPLE INPUT/OUTPUT:
+ * ------------------
+ *
+ * Input:
+ *   10000000                     (Array size)
+ *   100                          (k)
+ *
+ * Output (1 thread):
+ *   Full sort (parallel_merge_sort, mergesort.cpp):  2.90408 s
+ *   Full sort (hpc::parallel_sort):                  0.397287 s
+ *   Median   std::nth_element: 0.164026 s   hpc::parallel_median: 0.128671 s   match: yes
+ *   Top-k    std::partial_sort: 0.00750998 s   hpc::parallel_top_k: 0.0138107 s   match: yes
+ *   Partial  std::partial_sort: 0.00817192 s   hpc::parallel_partial_sort: 0.00654243 s   match: yes
+ */
+
+#include <iostream>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <omp.h>
+#include "selection.hpp"
+using namespace std;
+
+// Baseline from mergesort.cpp: task-parallel merge sort. shared(arr) is added to the tasks:
+// without it each task sorts its own copy of the vector (references are firstprivate).
+void merge(vector<int> &arr, int l, int m, int r)
+{
+    vector<int> L(arr.begin() + l, arr.begin() + m + 1), R(arr.begin() + m + 1, arr.begin() + r + 1);
+    size_t i = 0, j = 0;
+    int k = l;
+    while (i < L.size() && j < R.size())
+        arr[k++] = (L[i] <= R[j]) ? L[i++] : R[j++];
+    while (i < L.size())
+        arr[k++] = L[i++];
+    while (j < R.size())
+        arr[k++] = R[j++];
+}
+
+void merge_sort(vector<int> &arr, int l, int r, int cutoff)
+{
+    if (l < r)
+    {
+        int m = l + (r - l) / 2;
+        if (r - l <= cutoff)
+        {
+            merge_sort(arr, l, m, cutoff);
+            merge_sort(arr, m + 1, r, cutoff);
+        }
+        else
+        {
+#pragma omp task shared(arr)
+            merge_sort(arr, l, m, cutoff);
+#pragma omp task shared(arr)
+            merge_sort(arr, m + 1, r, cutoff);
+#pragma omp taskwait
+        }
+        merge(arr, l, m, r);
+    }
+}
+
+void parallel_merge_sort(vector<int> &arr, int cutoff)
+{
+#pragma omp parallel
+    {
+#pragma omp single
+        merge_sort(arr, 0, arr.size() - 1, cutoff);
+    }
+}
+
+template <class F>
+double timeIt(F f)
+{
+    double start = omp_get_wtime();
+    f();
+    return omp_get_wtime() - start;
+}
+
+const char *yesNo(bool ok)
+{
+    return ok ? "yes" : "no";
+}
+
+int main()
+{
+    int n, k;
+    cout << "Enter the size of the array: ";
+    cin >> n;
+    cout << "Enter k: ";
+    cin >> k;
+
+    if (n <= 0 || k <= 0 || k > n)
+    {
+        cout << "Invalid input!" << endl;
+        return 1;
+    }
+
+    mt19937 rng(5);
+    vector<int> arr(n);
+    for (int &x : arr)
+        x = rng() % 1000000000;
+
+    cout << endl;
+    vector<int> sorted = arr;
+    double t = timeIt([&] { parallel_merge_sort(sorted, 1000); });
+    cout << "Full sort (parallel_merge_sort, mergesort.cpp):  " << t << " s" << endl;
+    sorted = arr;
+    t = timeIt([&] { hpc::parallel_sort(sorted); });
+    cout << "Full sort (hpc::parallel_sort):                  " << t << " s" << endl;
+
+    // Median
+    vector<int> a = arr, b = arr;
+    int mid = (n - 1) / 2, median = 0;
+    double t_std = timeIt([&] { nth_element(a.begin(), a.begin() + mid, a.end()); });
+    double t_par = timeIt([&] { median = hpc::parallel_median(b.begin(), b.end()); });
+    cout << "Median   std::nth_element: " << t_std << " s   hpc::parallel_median: " << t_par
+         << " s   match: " << yesNo(median == sorted[mid]) << endl;
+
+    // k largest
+    vector<int> top;
+    a = arr;
+    t_std = timeIt([&] { partial_sort(a.begin(), a.begin() + k, a.end(), greater<>()); });
+    t_par = timeIt([&] { top = hpc::parallel_top_k(arr.begin(), arr.end(), k, greater<>()); });
+    cout << "Top-k    std::partial_sort: " << t_std << " s   hpc::parallel_top_k: " << t_par
+         << " s   match: " << yesNo(equal(top.begin(), top.end(), sorted.rbegin())) << endl;
+
+    // k smallest, in place
+    a = arr;
+    b = arr;
+    t_std = timeIt([&] { partial_sort(a.begin(), a.begin() + k, a.end()); });
+    t_par = timeIt([&] { hpc::parallel_partial_sort(b.begin(), b.begin() + k, b.end()); });
+    cout << "Partial  std::partial_sort: " << t_std << " s   hpc::parallel_partial_sort: " << t_par
+         << " s   match: " << yesNo(equal(b.begin(), b.begin() + k, sorted.begin())) << endl;
+
+    return 0;
+}
@@ -0,0 +1,264 @@
+/*
+ * Parallel Selection: nth_element, Top-k and Partial Sort (header-only) using OpenMP
+ * =================================================================================
+ *
+ * For the k smallest / largest values or a median, sorting everything is wasted work.
+ * These primitives take the same iterators, comparators and key extractors as
+ * parallel_sort.hpp, so they work on raw int arrays as well as templated containers.
+ *
+ * USAGE:
+ *
+ *   #include "selection.hpp"
+ *
+ *   hpc::parallel_nth_element(arr, arr + n / 2, arr + n);        // arr[n/2] is the median
+ *   int median = hpc::parallel_median(arr, arr + n);
+ *   vector<int> top = hpc::parallel_top_k(arr, arr + n, 10, greater<>()); // 10 largest, descending
+ *   hpc::parallel_partial_sort(v.begin(), v.begin() + k, v.end());        // only v[0..k) sorted
+ *
+ * COMPILATION:
+ *   g++ -std=c++20 -O2 -fopenmp -o program program.cpp
+ *
+ * ALGORITHMS:
+ * ----------
+ * - nth_element: parallel quickselect with sampling (Floyd-Rivest style). A random
+ *   sample is sorted and two pivots are taken just below and just above the target's
+ *   expected rank. One parallel three-way partition (per-thread counts, prefix offsets,
+ *   scatter through a buffer) leaves the target in the small middle band with high
+ *   probability; the search repeats on the part that holds it. Expected O(n) work.
+ * - top-k: every thread keeps a bounded heap of the k best elements of its slice; the
+ *   p heaps (p * k elements) are merged and sorted at the end. O(n log k / p + p k log k).
+ * - partial sort: nth_element at position k-1, then parallel_sort of the first k.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <random>
+#include <ranges>
+#include <stdexcept>
+#include <vector>
+#include <omp.h>
+#include "parallel_sort.hpp"
+
+namespace hpc
+{
+
+namespace detail
+{
+
+// Ranges at or below this size go to std::nth_element.
+constexpr std::ptrdiff_t select_cutoff = 1 << 15;
+
+// Sample size for pivot selection; the middle band is about 4 / sqrt(select_sample) of the range.
+constexpr std::ptrdiff_t select_sample = 4096;
+
+// Three-way partition of [first, first + n) around lo <= hi into
+// [less than lo | between | greater than hi] through `buffer`. Returns the two boundaries.
+template <class RandomIt, class T, class Less>
+std::pair<std::ptrdiff_t, std::ptrdiff_t> partition3(RandomIt first, std::ptrdiff_t n, const T &lo,
+                                                     const T &hi, const Less &less, std::vector<T> &buffer)
+{
+    const int threads = static_cast<int>(std::clamp<std::ptrdiff_t>(n / parallel_cutoff, 1, omp_get_max_threads()));
+    std::vector<std::ptrdiff_t> counts(static_cast<std::size_t>(threads) * 3);
+    std::ptrdiff_t totals[3] = {0, 0, 0};
+    auto bucket = [&](const T &x) { return less(x, lo) ? 0 : (less(hi, x) ? 2 : 1); };
+
+#pragma omp parallel num_threads(threads)
+    {
+        const int nt = omp_get_num_threads();
+        const int t = omp_get_thread_num();
+        const std::ptrdiff_t begin = n * t / nt;
+        const std::ptrdiff_t end = n * (t + 1) / nt;
+        std::ptrdiff_t *count = &counts[t * 3];
+
+        for (std::ptrdiff_t i = begin; i < end; i++)
+            count[bucket(first[i])]++;
+
+#pragma omp barrier
+#pragma omp single
+        {
+            std::ptrdiff_t offset = 0;
+            for (int b = 0; b < 3; b++)
+                for (int u = 0; u < nt; u++)
+                {
+                    std::ptrdiff_t c = counts[u * 3 + b];
+                    counts[u * 3 + b] = offset;
+                    offset += c;
+                    totals[b] += c;
+                }
+        }
+
+        for (std::ptrdiff_t i = begin; i < end; i++)
+            buffer[count[bucket(first[i])]++] = std::move(first[i]);
+
+#pragma omp barrier
+#pragma omp for
+        for (std::ptrdiff_t i = 0; i < n; i++)
+            first[i] = std::move(buffer[i]);
+    }
+    return {totals[0], totals[0] + totals[1]};
+}
+
+template <class RandomIt, class Less>
+void nth_element(RandomIt first, RandomIt nth, RandomIt last, const Less &less)
+{
+    using T = std::iter_value_t<RandomIt>;
+    std::vector<T> buffer;
+    std::mt19937_64 rng(0x5eed);
+
+    while (last - first > select_cutoff && omp_get_max_threads() > 1)
+    {
+        const std::ptrdiff_t n = last - first;
+        const std::ptrdiff_t k = nth - first;
+
+        // Pivots bracket the target's expected position in a sorted random sample.
+        std::vector<T> sample(select_sample);
+        for (T &s : sample)
+            s = first[rng() % n];
+        std::sort(sample.begin(), sample.end(), less);
+        const std::ptrdiff_t rank = k * select_sample / n;
+        const std::ptrdiff_t delta = 2 * static_cast<std::ptrdiff_t>(std::sqrt(double(select_sample)));
+        const T lo = sample[std::max<std::ptrdiff_t>(rank - delta, 0)];
+        const T hi = sample[std::min<std::ptrdiff_t>(rank + delta, select_sample - 1)];
+
+        if (buffer.size() < static_cast<std::size_t>(n))
+            buffer.resize(n);
+        auto [mid_begin, mid_end] = partition3(first, n, lo, hi, less, buffer);
+
+        RandomIt new_first = first, new_last = last;
+        if (k < mid_begin)
+            new_last = first + mid_begin;
+        else if (k >= mid_end)
+            new_first = first + mid_end;
+        else
+        {
+            new_first = first + mid_begin;
+            new_last = first + mid_end;
+            if (!less(lo, hi))
+                return; // lo == hi: the middle band is one repeated value
+        }
+        if (new_last - new_first == n)
+            break; // no progress (heavy duplicates); let std::nth_element finish
+        first = new_first;
+        last = new_last;
+    }
+    std::nth_element(first, nth, last, less);
+}
+
+// Replaces the top of a max-heap with value and sifts it down (one pass instead of the
+// two that pop_heap + push_heap take).
+template <class T, class Less>
+void replace_heap_top(std::vector<T> &heap, const T &value, const Less &less)
+{
+    const std::size_t n = heap.size();
+    std::size_t i = 0;
+    while (true)
+    {
+        std::size_t child = 2 * i + 1;
+        if (child >= n)
+            break;
+        if (child + 1 < n && less(heap[child], heap[child + 1]))
+            child++;
+        if (!less(value, heap[child]))
+            break;
+        heap[i] = std::move(heap[child]);
+        i = child;
+    }
+    heap[i] = value;
+}
+
+} // namespace detail
+
+// Rearranges [first, last) so *nth is the element a full sort would put there, everything
+// before it is not greater and everything after it is not less.
+template <std::random_access_iterator RandomIt, class Compare = std::less<>, class KeyFn = identity_key>
+void parallel_nth_element(RandomIt first, RandomIt nth, RandomIt last, Compare comp = {}, KeyFn key = {})
+{
+    if (nth == last || last - first < 2)
+        return;
+    detail::nth_element(first, nth, last, detail::key_compare<Compare, KeyFn>{comp, key});
+}
+
+// Lower median of [first, last) (the element at index (n - 1) / 2 after sorting).
+// Reorders the range. The range must not be empty (std::invalid_argument).
+template <std::random_access_iterator RandomIt, class Compare = std::less<>, class KeyFn = identity_key>
+std::iter_value_t<RandomIt> parallel_median(RandomIt first, RandomIt last, Compare comp = {}, KeyFn key = {})
+{
+    if (first == last)
+        throw std::invalid_argument("parallel_median: empty range");
+    RandomIt mid = first + (last - first - 1) / 2;
+    parallel_nth_element(first, mid, last, comp, key);
+    return *mid;
+}
+
+// Sorts only the first (middle - first) positions; the rest are left in unspecified order.
+template <std::random_access_iterator RandomIt, class Compare = std::less<>, class KeyFn = identity_key>
+void parallel_partial_sort(RandomIt first, RandomIt middle, RandomIt last, Compare comp = {}, KeyFn key = {})
+{
+    if (middle == first)
+        return;
+    if (omp_get_max_threads() == 1)
+    {
+        std::partial_sort(first, middle, last, detail::key_compare<Compare, KeyFn>{comp, key});
+        return;
+    }
+    if (middle != last)
+        parallel_nth_element(first, middle - 1, last, comp, key);
+    parallel_sort(first, middle, comp, key);
+}
+
+// Returns copies of the k first elements in comp order (the k smallest with std::less,
+// the k largest with std::greater), sorted. The input is not modified.
+template <std::random_access_iterator RandomIt, class Compare = std::less<>, class KeyFn = identity_key>
+std::vector<std::iter_value_t<RandomIt>> parallel_top_k(RandomIt first, RandomIt last, std::size_t k,
+                                                        Compare comp = {}, KeyFn key = {})
+{
+    using T = std::iter_value_t<RandomIt>;
+    const std::ptrdiff_t n = last - first;
+    const detail::key_compare<Compare, KeyFn> less{comp, key};
+    k = std::min<std::size_t>(k, n);
+    if (k == 0)
+        return {};
+
+    const int threads = static_cast<int>(std::clamp<std::ptrdiff_t>(n / detail::parallel_cutoff, 1, omp_get_max_threads()));
+    std::vector<std::vector<T>> heaps(threads);
+
+#pragma omp parallel num_threads(threads)
+    {
+        const int nt = omp_get_num_threads();
+        const int t = omp_get_thread_num();
+        std::vector<T> &heap = heaps[t]; // max-heap under `less`: front is the worst kept
+        heap.reserve(k);
+
+        for (std::ptrdiff_t i = n * t / nt; i < n * (t + 1) / nt; i++)
+        {
+            if (heap.size() < k)
+            {
+                heap.push_back(first[i]);
+                std::push_heap(heap.begin(), heap.end(), less);
+            }
+            else if (less(first[i], heap.front()))
+                detail::replace_heap_top(heap, first[i], less);
+        }
+    }
+
+    std::vector<T> result;
+    result.reserve(k * threads);
+    for (auto &heap : heaps)
+        std::move(heap.begin(), heap.end(), std::back_inserter(result));
+    std::partial_sort(result.begin(), result.begin() + k, result.end(), less);
+    result.resize(k);
+    return result;
+}
+
+template <std::ranges::random_access_range Range, class Compare = std::less<>, class KeyFn = identity_key>
+auto parallel_top_k(Range &&range, std::size_t k, Compare comp = {}, KeyFn key = {})
+{
+    return parallel_top_k(std::ranges::begin(range), std::ranges::end(range), k, comp, key);
+}
+
+} // namespace hpc
@@ -0,0 +1,169 @@
+/*
+ * Sort Tuning Profile (header-only)
+ * =================================
+ *
+ * The machine-specific knobs of the sort engines in parallel_sort.hpp: task cutoff, which
+ * engine unstable sorts use, when radix sort pays off, and how many threads each input
+ * size is worth. sort_tune.cpp measures them and writes the profile file; every later
+ * sort reads it once, on first use. Without a profile the built-in defaults apply.
+ *
+ * USAGE:
+ *
+ *   #include "sort_profile.hpp"
+ *
+ *   const hpc::sort_profile &p = hpc::active_sort_profile();   // loaded from disk once
+ *   int cutoff = p.cutoff;
+ *   int threads = p.threads_for(n);
+ *
+ * The file is hpc_sort_profile.txt in the working directory, or the path in the
+ * HPC_SORT_PROFILE environment variable. It is plain text, one setting per line:
+ *
+ *   cutoff 8192                  (task leaf size for the merge and quick engines)
+ *   radix_min 2048               (radix-sortable inputs below this go to std::sort)
+ *   unstable_engine merge        (merge or quick)
+ *   threads 65536 4              (comparison sorts of >= 65536 elements use 4 threads)
+ *   radix_threads 16384 2        (same, for the radix engine)
+ *
+ * Lines starting with '#' and unknown keys are ignored. Only needs C++17, so the plain
+ * OpenMP programs in this folder can include it too.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include <omp.h>
+
+namespace hpc
+{
+
+enum class sort_engine
+{
+    sequential,
+    merge,
+    quick,
+    radix
+};
+
+namespace detail
+{
+
+// Ranges at or below this size are sorted by one thread; a smaller task costs more to
+// schedule than it saves. Default for sort_profile::cutoff and the grain of other headers.
+constexpr std::ptrdiff_t parallel_cutoff = 1 << 13;
+
+// Below this size the 256-bucket radix passes are slower than a comparison sort.
+constexpr std::ptrdiff_t radix_cutoff = 1 << 11;
+
+// Thread count for n from a table of (smallest size, threads) rows sorted by size. Sizes
+// below the first row use the first row; an empty table means all threads.
+inline int table_threads(const std::vector<std::pair<std::ptrdiff_t, int>> &table, std::ptrdiff_t n)
+{
+    int threads = table.empty() ? omp_get_max_threads() : table.front().second;
+    for (const auto &row : table)
+        if (row.first <= n)
+            threads = row.second;
+    return std::clamp(threads, 1, omp_get_max_threads());
+}
+
+} // namespace detail
+
+struct sort_profile
+{
+    std::ptrdiff_t cutoff = detail::parallel_cutoff;
+    std::ptrdiff_t radix_min = detail::radix_cutoff;
+    sort_engine unstable_engine = sort_engine::merge;
+    std::vector<std::pair<std::ptrdiff_t, int>> threads;       // comparison engines
+    std::vector<std::pair<std::ptrdiff_t, int>> radix_threads; // radix engine
+
+    // Never more than omp_get_max_threads(), so OMP_NUM_THREADS still caps a profile
+    // that was measured on a bigger machine.
+    int threads_for(std::ptrdiff_t n) const { return detail::table_threads(threads, n); }
+    int radix_threads_for(std::ptrdiff_t n) const { return detail::table_threads(radix_threads, n); }
+};
+
+inline std::string sort_profile_path()
+{
+    const char *env = std::getenv("HPC_SORT_PROFILE");
+    return env && *env ? env : "hpc_sort_profile.txt";
+}
+
+// Reads a profile file over `profile`; settings the file does not mention keep their
+// values. Returns false if the file cannot be opened.
+inline bool load_sort_profile(const std::string &path, sort_profile &profile)
+{
+    std::ifstream in(path);
+    if (!in)
+        return false;
+
+    std::vector<std::pair<std::ptrdiff_t, int>> threads, radix_threads;
+    std::string line;
+    while (std::getline(in, line))
+    {
+        std::istringstream fields(line);
+        std::string key;
+        if (!(fields >> key) || key[0] == '#')
+            continue;
+
+        std::ptrdiff_t size;
+        int count;
+        std::string engine;
+        if (key == "cutoff" && fields >> size && size > 0)
+            profile.cutoff = size;
+        else if (key == "radix_min" && fields >> size && size >= 0)
+            profile.radix_min = size;
+        else if (key == "unstable_engine" && fields >> engine && (engine == "merge" || engine == "quick"))
+            profile.unstable_engine = engine == "merge" ? sort_engine::merge : sort_engine::quick;
+        else if (key == "threads" && fields >> size >> count && count > 0)
+            threads.emplace_back(size, count);
+        else if (key == "radix_threads" && fields >> size >> count && count > 0)
+            radix_threads.emplace_back(size, count);
+    }
+
+    std::sort(threads.begin(), threads.end());
+    std::sort(radix_threads.begin(), radix_threads.end());
+    if (!threads.empty())
+        profile.threads = std::move(threads);
+    if (!radix_threads.empty())
+        profile.radix_threads = std::move(radix_threads);
+    return true;
+}
+
+inline void save_sort_profile(const std::string &path, const sort_profile &profile)
+{
+    std::ofstream out(path);
+    if (!out)
+        throw std::runtime_error("cannot write sort profile " + path);
+
+    out << "# hpc sort tuning profile, measured with " << omp_get_max_threads() << " threads\n";
+    out << "cutoff " << profile.cutoff << "\n";
+    out << "radix_min " << profile.radix_min << "\n";
+    out << "unstable_engine " << (profile.unstable_engine == sort_engine::quick ? "quick" : "merge") << "\n";
+    for (const auto &row : profile.threads)
+        out << "threads " << row.first << " " << row.second << "\n";
+    for (const auto &row : profile.radix_threads)
+        out << "radix_threads " << row.first << " " << row.second << "\n";
+    if (!out)
+        throw std::runtime_error("cannot write sort profile " + path);
+}
+
+// The profile every sort uses. Read from sort_profile_path() on first call; assign to it
+// (before sorting starts) to override.
+inline sort_profile &active_sort_profile()
+{
+    static sort_profile profile = [] {
+        sort_profile p;
+        load_sort_profile(sort_profile_path(), p);
+        return p;
+    }();
+    return profile;
+}
+
+} // namespace hpc
@@ -0,0 +1,184 @@
+/*
+ * Sort Engine Calibration (header-only) using OpenMP
+ * ==================================================
+ *
+ * Measures the sort_profile of the current machine by timing the engines of
+ * parallel_sort.hpp directly, bypassing the profile they would normally read.
+ *
+ * USAGE:
+ *
+ *   #include "sort_tuning.hpp"
+ *
+ *   hpc::sort_tuning_options opts;              // sizes up to 1 << 22, 3 repetitions
+ *   hpc::sort_profile p = hpc::calibrate_sort(opts, cout);
+ *   hpc::save_sort_profile(hpc::sort_profile_path(), p);
+ *
+ * COMPILATION:
+ *   g++ -std=c++20 -O2 -fopenmp -o program program.cpp
+ *
+ * MEASUREMENTS (random 64-bit keys, median of the repetitions):
+ * ------------
+ * 1. Cutoff: the merge engine at the largest size on all threads, for cutoffs from 2^10
+ *    to 2^16. Then merge vs quick at the best cutoff picks the unstable engine.
+ * 2. Threads: for sizes 2^8, 2^10, ... up to the largest size, std::sort against the
+ *    comparison engine on 2, 4, ... threads and all threads. The fastest count (1 means
+ *    std::sort) becomes that size's row in the thread table.
+ * 3. Radix: the same sweep for the radix engine. radix_min is the smallest size from which
+ *    radix sort beats std::sort at every larger size measured.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iomanip>
+#include <limits>
+#include <ostream>
+#include <random>
+#include <vector>
+#include <omp.h>
+#include "parallel_sort.hpp"
+#include "sort_profile.hpp"
+
+namespace hpc
+{
+
+struct sort_tuning_options
+{
+    std::ptrdiff_t max_size = 1 << 22;
+    int repetitions = 3;
+};
+
+namespace detail
+{
+
+// Median time of `repetitions` runs of sort_fn on fresh copies of input.
+template <class SortFn>
+double median_sort_time(const std::vector<long long> &input, std::ptrdiff_t n, int repetitions,
+                        const SortFn &sort_fn)
+{
+    std::vector<long long> data(n);
+    std::vector<double> times;
+    for (int r = 0; r < repetitions; r++)
+    {
+        std::copy(input.begin(), input.begin() + n, data.begin());
+        double start = omp_get_wtime();
+        sort_fn(data);
+        times.push_back(omp_get_wtime() - start);
+    }
+    std::nth_element(times.begin(), times.begin() + times.size() / 2, times.end());
+    return times[times.size() / 2];
+}
+
+// 1, 2, 4, ... below the maximum, then the maximum itself.
+inline std::vector<int> thread_candidates()
+{
+    std::vector<int> counts;
+    const int max_threads = omp_get_max_threads();
+    for (int t = 1; t < max_threads; t *= 2)
+        counts.push_back(t);
+    counts.push_back(max_threads);
+    return counts;
+}
+
+} // namespace detail
+
+// Times the engines on this machine and returns the resulting profile. Progress and the
+// measured tables go to `log`.
+inline sort_profile calibrate_sort(const sort_tuning_options &opts, std::ostream &log)
+{
+    using detail::median_sort_time;
+    const std::ptrdiff_t max_size = std::max<std::ptrdiff_t>(opts.max_size, 1 << 10);
+    const int reps = std::max(opts.repetitions, 1);
+    const int max_threads = omp_get_max_threads();
+    const std::vector<int> thread_counts = detail::thread_candidates();
+
+    // A lambda comparator keeps the radix engine out of the comparison measurements.
+    auto less = [](long long a, long long b) { return a < b; };
+    auto std_sort = [&](std::vector<long long> &v) { std::sort(v.begin(), v.end(), less); };
+
+    std::vector<long long> input(max_size);
+    std::mt19937_64 rng(42);
+    for (long long &x : input)
+        x = static_cast<long long>(rng());
+
+    sort_profile profile;
+    log << std::fixed << std::setprecision(6);
+
+    // 1. Cutoff and unstable engine at the largest size.
+    log << "Cutoff sweep (" << max_size << " elements, " << max_threads << " threads):\n";
+    double best_time = std::numeric_limits<double>::max();
+    for (std::ptrdiff_t cutoff = 1 << 10; cutoff <= (1 << 16) && cutoff < max_size; cutoff *= 2)
+    {
+        double t = median_sort_time(input, max_size, reps, [&](std::vector<long long> &v) {
+            detail::merge_sort<false>(v.begin(), v.end(), less, cutoff, max_threads);
+        });
+        log << "  cutoff " << std::setw(6) << cutoff << ": " << t << " s\n";
+        if (t < best_time)
+        {
+            best_time = t;
+            profile.cutoff = cutoff;
+        }
+    }
+    double quick_time = median_sort_time(input, max_size, reps, [&](std::vector<long long> &v) {
+        detail::quick_sort(v.begin(), v.end(), less, profile.cutoff, max_threads);
+    });
+    profile.unstable_engine = quick_time < best_time ? sort_engine::quick : sort_engine::merge;
+    log << "  quick at cutoff " << profile.cutoff << ": " << quick_time << " s\n";
+
+    // 2 and 3. Thread count per size for the comparison and radix engines.
+    log << "Thread sweep (time of std::sort, then best engine time and threads):\n";
+    std::vector<std::ptrdiff_t> sizes;
+    for (std::ptrdiff_t n = 1 << 8; n < max_size; n *= 4)
+        sizes.push_back(n);
+    sizes.push_back(max_size);
+
+    std::vector<std::pair<std::ptrdiff_t, bool>> radix_wins;
+    for (std::ptrdiff_t n : sizes)
+    {
+        const double seq = median_sort_time(input, n, reps, std_sort);
+        double best_cmp = seq, best_radix = std::numeric_limits<double>::max();
+        int cmp_threads = 1, radix_threads = 1;
+
+        for (int threads : thread_counts)
+        {
+            if (threads > 1 && n > profile.cutoff)
+            {
+                double t = median_sort_time(input, n, reps, [&](std::vector<long long> &v) {
+                    if (profile.unstable_engine == sort_engine::quick)
+                        detail::quick_sort(v.begin(), v.end(), less, profile.cutoff, threads);
+                    else
+                        detail::merge_sort<false>(v.begin(), v.end(), less, profile.cutoff, threads);
+                });
+                if (t < best_cmp)
+                {
+                    best_cmp = t;
+                    cmp_threads = threads;
+                }
+            }
+            double t = median_sort_time(input, n, reps, [&](std::vector<long long> &v) {
+                detail::radix_sort<1>(v.begin(), v.end(), identity_key{}, threads);
+            });
+            if (t < best_radix)
+            {
+                best_radix = t;
+                radix_threads = threads;
+            }
+        }
+
+        profile.threads.emplace_back(n, cmp_threads);
+        profile.radix_threads.emplace_back(n, radix_threads);
+        radix_wins.emplace_back(n, best_radix < seq);
+        log << "  n = " << std::setw(9) << n << ": std::sort " << seq << " s | comparison " << best_cmp
+            << " s on " << cmp_threads << " | radix " << best_radix << " s on " << radix_threads << "\n";
+    }
+
+    // Radix from the smallest size of the final stretch of sizes where it won.
+    profile.radix_min = max_size + 1;
+    for (auto it = radix_wins.rbegin(); it != radix_wins.rend() && it->second; ++it)
+        profile.radix_min = it->first;
+    return profile;
+}
+
+} // namespace hpc
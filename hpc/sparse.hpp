@@ -0,0 +1,657 @@
+/*
+ * Sparse Matrices (header-only): CSR / CSC, Merge-Path SpMV and SpMM using OpenMP
+ * ===============================================================================
+ *
+ * A matrix that is mostly zeros multiplies faster when only the non-zeros are stored.
+ * CSR (compressed sparse row) keeps, row after row, the column index and value of each
+ * non-zero, plus where every row starts; CSC does the same by columns. y = A x then costs
+ * 2 nnz flops instead of 2 rows x cols, and A B (B dense, n columns) 2 nnz n.
+ *
+ * USAGE:
+ *
+ *   #include "sparse.hpp"
+ *
+ *   hpc::csr_matrix<float> A = hpc::to_csr(rows, cols, dense, cols);  // from row-major
+ *   hpc::spmv(A, x, y);                                 // y = A x
+ *   hpc::spmv(A, x, y, 2.0f, 1.0f);                     // y = 2 A x + y
+ *   hpc::spmm(A, n, B, n, C, n);                        // C (rows x n) = A B (B: cols x n)
+ *
+ *   hpc::csc_matrix<float> S = hpc::to_csc(A);          // or to_csc(rows, cols, dense, lda)
+ *   hpc::spmv(S, x, y);
+ *   hpc::to_dense(A, out, cols);
+ *
+ * COMPILATION:
+ *   g++ -std=c++20 -O2 -fopenmp -o program program.cpp
+ * As in gemm.hpp, the SIMD loops carry target attributes and are picked at run time.
+ *
+ * LAYOUT:
+ * ------
+ * - csr_matrix: row_ptr[rows + 1] (row i is [row_ptr[i], row_ptr[i + 1])), col[nnz] as
+ *   int32, values[nnz]. Columns within a row are sorted. csc_matrix is the same with rows
+ *   and columns swapped.
+ * - to_csr counts the non-zeros of every row in parallel, turns the counts into row_ptr
+ *   with scan.hpp, then fills every row in parallel. to_csc and the CSR <-> CSC
+ *   conversions are a parallel counting sort by column.
+ *
+ * LOAD BALANCE:
+ * ------------
+ * - Feature matrices are skewed: a few rows hold most non-zeros. Splitting rows evenly
+ *   leaves one thread with the long rows; splitting non-zeros evenly ignores the cost of
+ *   many empty or short rows. SpMV uses the merge-based split (Merrill & Garland, SC'16):
+ *   the row end offsets and the non-zero indices are two sorted lists, and every thread
+ *   takes an equal share of rows + nnz steps of their merge, found by binary search. A
+ *   row that straddles two threads is summed in two parts; the earlier part is added
+ *   once all threads finish.
+ * - SpMM keeps rows whole (a split row would need a carry of n values) and starts each
+ *   thread at the row the same split lands in.
+ *
+ * SIMD:
+ * ----
+ * - SpMV rows: x[col[k]] is a gather. AVX-512 gathers 16 floats / 8 doubles per
+ *   instruction and ends each row with a masked gather; AVX2 gathers 8 / 4.
+ * - SpMM rows: for each non-zero a, C[i][j..j+63] += a * B[col][j..j+63] with the 64
+ *   outputs in four registers for the whole row, so C is written once per row.
+ * - Other element types (int, ...) run the scalar loops.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+#include <omp.h>
+#include "gemm.hpp"
+#include "scan.hpp"
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpsabi"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#pragma GCC diagnostic ignored "-Wuninitialized" // _mm512_reduce_add_* starts from an undefined register
+#endif
+
+namespace hpc
+{
+
+template <class T>
+struct csr_matrix
+{
+    std::size_t rows = 0, cols = 0;
+    std::vector<std::size_t> row_ptr;  // rows + 1 offsets into col / values
+    std::vector<std::int32_t> col;     // column of each non-zero, sorted within a row
+    std::vector<T> values;
+
+    std::size_t nnz() const noexcept { return values.size(); }
+};
+
+template <class T>
+struct csc_matrix
+{
+    std::size_t rows = 0, cols = 0;
+    std::vector<std::size_t> col_ptr;  // cols + 1 offsets into row / values
+    std::vector<std::int32_t> row;     // row of each non-zero, sorted within a column
+    std::vector<T> values;
+
+    std::size_t nnz() const noexcept { return values.size(); }
+};
+
+namespace detail
+{
+
+// Each thread gets at least this many elements (non-zeros plus rows, or dense entries).
+constexpr double sparse_grain = double(1 << 15);
+
+inline int sparse_threads(double work)
+{
+    const int available = omp_get_active_level() < omp_get_max_active_levels() ? omp_get_max_threads() : 1;
+    return static_cast<int>(std::clamp<double>(work / sparse_grain, 1, available));
+}
+
+inline void check_index_range(std::size_t n, const char *what)
+{
+    if (n > static_cast<std::size_t>(std::numeric_limits<std::int32_t>::max()))
+        throw std::invalid_argument(what);
+}
+
+// Point `diagonal` steps into the merge of the row end offsets with 0, 1, ..., nnz - 1:
+// {row, k} with row + k == diagonal, rows [0, row) finished and non-zeros [0, k) consumed.
+struct merge_coord
+{
+    std::size_t row, k;
+};
+
+inline merge_coord merge_path_search(std::size_t diagonal, const std::size_t *row_end, std::size_t rows,
+                                     std::size_t nnz)
+{
+    std::size_t lo = diagonal > nnz ? diagonal - nnz : 0, hi = std::min(diagonal, rows);
+    while (lo < hi)
+    {
+        const std::size_t mid = lo + (hi - lo) / 2;
+        if (row_end[mid] <= diagonal - mid - 1)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return {lo, diagonal - lo};
+}
+
+// Thread t of `threads` starts at this point of the merge.
+inline merge_coord merge_split(int t, int threads, const std::size_t *row_end, std::size_t rows, std::size_t nnz)
+{
+    const std::size_t total = rows + nnz;
+    const std::size_t diagonal = std::min(total, (total + threads - 1) / threads * static_cast<std::size_t>(t));
+    return merge_path_search(diagonal, row_end, rows, nnz);
+}
+
+// Compressed rows -> compressed columns (or back): a counting sort by the inner index.
+// Thread t counts its share of the outer entries per inner index; a scan over (inner,
+// thread) gives every thread its own write position in each output list, so the output
+// stays sorted by outer index without atomics.
+template <class T>
+void transpose_compressed(std::size_t outer, std::size_t inner, const std::size_t *ptr, const std::int32_t *idx,
+                          const T *val, std::vector<std::size_t> &out_ptr, std::vector<std::int32_t> &out_idx,
+                          std::vector<T> &out_val)
+{
+    const std::size_t nnz = ptr[outer];
+    const int threads = sparse_threads(double(nnz + outer + inner));
+    std::vector<std::size_t> counts(static_cast<std::size_t>(threads) * inner + 1, 0);
+    out_ptr.assign(inner + 1, 0);
+    out_idx.resize(nnz);
+    out_val.resize(nnz);
+
+#pragma omp parallel num_threads(threads) if (threads > 1)
+    {
+        const int t = omp_get_thread_num(), nt = omp_get_num_threads();
+        const std::size_t first = merge_split(t, nt, ptr + 1, outer, nnz).row;
+        const std::size_t last = t + 1 == nt ? outer : merge_split(t + 1, nt, ptr + 1, outer, nnz).row;
+        std::size_t *mine = counts.data() + 1;
+
+        for (std::size_t o = first; o < last; o++)
+            for (std::size_t k = ptr[o]; k < ptr[o + 1]; k++)
+                mine[static_cast<std::size_t>(idx[k]) * nt + t]++;
+#pragma omp barrier
+#pragma omp single
+        {
+            for (std::size_t i = 1; i < counts.size(); i++)
+                counts[i] += counts[i - 1];
+            for (std::size_t i = 0; i <= inner; i++)
+                out_ptr[i] = counts[i * nt];
+        }
+
+        std::size_t *next = counts.data();
+        for (std::size_t o = first; o < last; o++)
+            for (std::size_t k = ptr[o]; k < ptr[o + 1]; k++)
+            {
+                const std::size_t at = next[static_cast<std::size_t>(idx[k]) * nt + t]++;
+                out_idx[at] = static_cast<std::int32_t>(o);
+                out_val[at] = val[k];
+            }
+    }
+}
+
+// ---- SpMV row kernels: sum of v[k] * x[c[k]] over k < n ----
+
+template <class T>
+struct scalar_gather
+{
+    static T dot(const T *v, const std::int32_t *c, const T *x, std::size_t n)
+    {
+        T sum = T(0);
+        for (std::size_t k = 0; k < n; k++)
+            sum += v[k] * x[c[k]];
+        return sum;
+    }
+};
+
+#ifdef HPC_X86_SIMD
+
+template <class T>
+struct avx512_gather;
+
+template <>
+struct avx512_gather<float>
+{
+    __attribute__((target("avx512f"))) static float dot(const float *v, const std::int32_t *c, const float *x,
+                                                        std::size_t n)
+    {
+        __m512 acc = _mm512_setzero_ps();
+        std::size_t k = 0;
+        for (; k + 16 <= n; k += 16)
+        {
+            const __m512i idx = _mm512_loadu_si512(c + k);
+            acc = _mm512_fmadd_ps(_mm512_loadu_ps(v + k), _mm512_i32gather_ps(idx, x, 4), acc);
+        }
+        if (k < n)
+        {
+            const __mmask16 m = static_cast<__mmask16>((1u << (n - k)) - 1);
+            const __m512i idx = _mm512_maskz_loadu_epi32(m, c + k);
+            const __m512 xv = _mm512_mask_i32gather_ps(_mm512_setzero_ps(), m, idx, x, 4);
+            acc = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(m, v + k), xv, acc);
+        }
+        return _mm512_reduce_add_ps(acc);
+    }
+};
+
+template <>
+struct avx512_gather<double>
+{
+    __attribute__((target("avx512f"))) static double dot(const double *v, const std::int32_t *c, const double *x,
+                                                         std::size_t n)
+    {
+        __m512d acc = _mm512_setzero_pd();
+        std::size_t k = 0;
+        for (; k + 8 <= n; k += 8)
+        {
+            const __m256i idx = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(c + k));
+            acc = _mm512_fmadd_pd(_mm512_loadu_pd(v + k), _mm512_i32gather_pd(idx, x, 8), acc);
+        }
+        if (k < n)
+        {
+            const __mmask8 m = static_cast<__mmask8>((1u << (n - k)) - 1);
+            const __m256i idx = _mm512_castsi512_si256(_mm512_maskz_loadu_epi32(m, c + k));
+            const __m512d xv = _mm512_mask_i32gather_pd(_mm512_setzero_pd(), m, idx, x, 8);
+            acc = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(m, v + k), xv, acc);
+        }
+        return _mm512_reduce_add_pd(acc);
+    }
+};
+
+template <class T>
+struct avx2_gather;
+
+template <>
+struct avx2_gather<float>
+{
+    __attribute__((target("avx2,fma"))) static float dot(const float *v, const std::int32_t *c, const float *x,
+                                                         std::size_t n)
+    {
+        __m256 acc = _mm256_setzero_ps();
+        std::size_t k = 0;
+        for (; k + 8 <= n; k += 8)
+        {
+            const __m256i idx = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(c + k));
+            acc = _mm256_fmadd_ps(_mm256_loadu_ps(v + k), _mm256_i32gather_ps(x, idx, 4), acc);
+        }
+        if (k < n)
+        {
+            const __m256i m = _mm256_cmpgt_epi32(_mm256_set1_epi32(static_cast<int>(n - k)),
+                                                 _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+            const __m256i idx = _mm256_maskload_epi32(reinterpret_cast<const int *>(c + k), m);
+            const __m256 xv = _mm256_mask_i32gather_ps(_mm256_setzero_ps(), x, idx, _mm256_castsi256_ps(m), 4);
+            acc = _mm256_fmadd_ps(_mm256_maskload_ps(v + k, m), xv, acc);
+        }
+        __m128 s = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+        s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+        s = _mm_add_ss(s, _mm_movehdup_ps(s));
+        return _mm_cvtss_f32(s);
+    }
+};
+
+template <>
+struct avx2_gather<double>
+{
+    __attribute__((target("avx2,fma"))) static double dot(const double *v, const std::int32_t *c, const double *x,
+                                                          std::size_t n)
+    {
+        __m256d acc = _mm256_setzero_pd();
+        std::size_t k = 0;
+        for (; k + 4 <= n; k += 4)
+        {
+            const __m128i idx = _mm_loadu_si128(reinterpret_cast<const __m128i *>(c + k));
+            acc = _mm256_fmadd_pd(_mm256_loadu_pd(v + k), _mm256_i32gather_pd(x, idx, 8), acc);
+        }
+        __m128d s = _mm_add_pd(_mm256_castpd256_pd128(acc), _mm256_extractf128_pd(acc, 1));
+        double sum = _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+        for (; k < n; k++)
+            sum += v[k] * x[c[k]];
+        return sum;
+    }
+};
+
+#endif // HPC_X86_SIMD
+
+// Rows [start.row, end.row) completed from non-zero start.k on, written as
+// alpha * sum + beta * y; returns the partial sum of row end.row up to end.k.
+template <class Gather, class T>
+inline T spmv_range(const csr_matrix<T> &a, const T *x, T *y, T alpha, T beta, merge_coord start, merge_coord end)
+{
+    const std::size_t *row_end = a.row_ptr.data() + 1;
+    const std::int32_t *col = a.col.data();
+    const T *val = a.values.data();
+    std::size_t k = start.k;
+    for (std::size_t i = start.row; i < end.row; i++)
+    {
+        const std::size_t stop = row_end[i];
+        const T sum = Gather::dot(val + k, col + k, x, stop - k);
+        // beta == 0 must not read y: it may be uninitialized.
+        y[i] = beta == T(0) ? alpha * sum : alpha * sum + beta * y[i];
+        k = stop;
+    }
+    return Gather::dot(val + k, col + k, x, end.k - k);
+}
+
+#ifdef HPC_X86_SIMD
+template <class T>
+__attribute__((target("avx512f"), flatten)) T spmv_range_avx512(const csr_matrix<T> &a, const T *x, T *y, T alpha,
+                                                                T beta, merge_coord start, merge_coord end)
+{
+    return spmv_range<avx512_gather<T>>(a, x, y, alpha, beta, start, end);
+}
+
+template <class T>
+__attribute__((target("avx2,fma"), flatten)) T spmv_range_avx2(const csr_matrix<T> &a, const T *x, T *y, T alpha,
+                                                               T beta, merge_coord start, merge_coord end)
+{
+    return spmv_range<avx2_gather<T>>(a, x, y, alpha, beta, start, end);
+}
+#endif
+
+template <class T>
+inline constexpr bool sparse_simd_type = std::is_same_v<T, float> || std::is_same_v<T, double>;
+
+template <class T>
+T spmv_dispatch(const csr_matrix<T> &a, const T *x, T *y, T alpha, T beta, merge_coord start, merge_coord end,
+                simd_level level)
+{
+#ifdef HPC_X86_SIMD
+    if constexpr (sparse_simd_type<T>)
+    {
+        if (level == simd_level::avx512)
+            return spmv_range_avx512(a, x, y, alpha, beta, start, end);
+        if (level == simd_level::avx2)
+            return spmv_range_avx2(a, x, y, alpha, beta, start, end);
+    }
+#endif
+    (void)level;
+    return spmv_range<scalar_gather<T>>(a, x, y, alpha, beta, start, end);
+}
+
+// ---- SpMM rows: C[i][:] = alpha * sum_k values[k] * B[col[k]][:] + beta * C[i][:] ----
+
+// B rows are visited in the order of A's columns, effectively at random: fetch the one
+// this many non-zeros ahead.
+constexpr std::size_t spmm_prefetch = 8;
+
+template <class V, int NV, class T = typename V::value_type>
+inline void spmm_rows(const csr_matrix<T> &a, std::size_t first, std::size_t last, std::size_t n, const T *b,
+                      std::size_t ldb, T *c, std::size_t ldc, T alpha, T beta)
+{
+    constexpr std::size_t W = V::width, NB = NV * W;
+    const typename V::reg va = V::set1(alpha), vb = V::set1(beta);
+    for (std::size_t i = first; i < last; i++)
+    {
+        const std::size_t k0 = a.row_ptr[i], k1 = a.row_ptr[i + 1];
+        T *out = c + i * ldc;
+        std::size_t j = 0;
+        for (; j + NB <= n; j += NB)
+        {
+            typename V::reg acc[NV];
+#pragma GCC unroll 8
+            for (int v = 0; v < NV; v++)
+                acc[v] = V::zero();
+            for (std::size_t k = k0; k < k1; k++)
+            {
+                if (k + spmm_prefetch < k1)
+                    __builtin_prefetch(b + static_cast<std::size_t>(a.col[k + spmm_prefetch]) * ldb + j);
+                const typename V::reg av = V::set1(a.values[k]);
+                const T *brow = b + static_cast<std::size_t>(a.col[k]) * ldb + j;
+#pragma GCC unroll 8
+                for (int v = 0; v < NV; v++)
+                    acc[v] = V::fmadd(av, V::load(brow + v * W), acc[v]);
+            }
+#pragma GCC unroll 8
+            for (int v = 0; v < NV; v++)
+            {
+                T *o = out + j + v * W;
+                V::store(o, beta == T(0) ? V::mul(va, acc[v]) : V::fmadd(vb, V::load(o), V::mul(va, acc[v])));
+            }
+        }
+        for (; j + W <= n; j += W)
+        {
+            typename V::reg acc = V::zero();
+            for (std::size_t k = k0; k < k1; k++)
+                acc = V::fmadd(V::set1(a.values[k]), V::load(b + static_cast<std::size_t>(a.col[k]) * ldb + j), acc);
+            V::store(out + j, beta == T(0) ? V::mul(va, acc) : V::fmadd(vb, V::load(out + j), V::mul(va, acc)));
+        }
+        for (; j < n; j++)
+        {
+            T sum = T(0);
+            for (std::size_t k = k0; k < k1; k++)
+                sum += a.values[k] * b[static_cast<std::size_t>(a.col[k]) * ldb + j];
+            out[j] = beta == T(0) ? alpha * sum : alpha * sum + beta * out[j];
+        }
+    }
+}
+
+#ifdef HPC_X86_SIMD
+template <class V>
+__attribute__((target("avx512f"), flatten)) void spmm_rows_avx512(const csr_matrix<typename V::value_type> &a,
+                                                                  std::size_t first, std::size_t last, std::size_t n,
+                                                                  const typename V::value_type *b, std::size_t ldb,
+                                                                  typename V::value_type *c, std::size_t ldc,
+                                                                  typename V::value_type alpha,
+                                                                  typename V::value_type beta)
+{
+    spmm_rows<V, 4>(a, first, last, n, b, ldb, c, ldc, alpha, beta);
+}
+
+template <class V>
+__attribute__((target("avx2,fma"), flatten)) void spmm_rows_avx2(const csr_matrix<typename V::value_type> &a,
+                                                                 std::size_t first, std::size_t last, std::size_t n,
+                                                                 const typename V::value_type *b, std::size_t ldb,
+                                                                 typename V::value_type *c, std::size_t ldc,
+                                                                 typename V::value_type alpha,
+                                                                 typename V::value_type beta)
+{
+    spmm_rows<V, 4>(a, first, last, n, b, ldb, c, ldc, alpha, beta);
+}
+#endif
+
+template <class T>
+void spmm_dispatch(const csr_matrix<T> &a, std::size_t first, std::size_t last, std::size_t n, const T *b,
+                   std::size_t ldb, T *c, std::size_t ldc, T alpha, T beta, simd_level level)
+{
+#ifdef HPC_X86_SIMD
+    if constexpr (std::is_same_v<T, float>)
+    {
+        if (level == simd_level::avx512)
+            return spmm_rows_avx512<avx512_f32>(a, first, last, n, b, ldb, c, ldc, alpha, beta);
+        if (level == simd_level::avx2)
+            return spmm_rows_avx2<avx2_f32>(a, first, last, n, b, ldb, c, ldc, alpha, beta);
+    }
+    else if constexpr (std::is_same_v<T, double>)
+    {
+        if (level == simd_level::avx512)
+            return spmm_rows_avx512<avx512_f64>(a, first, last, n, b, ldb, c, ldc, alpha, beta);
+        if (level == simd_level::avx2)
+            return spmm_rows_avx2<avx2_f64>(a, first, last, n, b, ldb, c, ldc, alpha, beta);
+    }
+#endif
+    (void)level;
+    spmm_rows<scalar_vec<T>, 4>(a, first, last, n, b, ldb, c, ldc, alpha, beta);
+}
+
+} // namespace detail
+
+// CSR copy of a row-major rows x cols matrix (leading dimension lda): every entry that
+// compares unequal to zero is kept.
+template <class T>
+csr_matrix<T> to_csr(std::size_t rows, std::size_t cols, const T *a, std::size_t lda)
+{
+    detail::check_index_range(cols, "to_csr: more than 2^31 - 1 columns");
+    csr_matrix<T> m;
+    m.rows = rows;
+    m.cols = cols;
+    m.row_ptr.assign(rows + 1, 0);
+    const long long nrows = static_cast<long long>(rows);
+    const int threads = detail::sparse_threads(double(rows) * double(cols));
+
+#pragma omp parallel for schedule(static) num_threads(threads) if (threads > 1)
+    for (long long i = 0; i < nrows; i++)
+    {
+        const T *row = a + i * lda;
+        std::size_t count = 0;
+        for (std::size_t j = 0; j < cols; j++)
+            count += row[j] != T(0);
+        m.row_ptr[i + 1] = count;
+    }
+    parallel_inclusive_scan(m.row_ptr.begin() + 1, m.row_ptr.end(), m.row_ptr.begin() + 1);
+    m.col.resize(m.row_ptr[rows]);
+    m.values.resize(m.row_ptr[rows]);
+
+#pragma omp parallel for schedule(static) num_threads(threads) if (threads > 1)
+    for (long long i = 0; i < nrows; i++)
+    {
+        const T *row = a + i * lda;
+        std::size_t k = m.row_ptr[i];
+        for (std::size_t j = 0; j < cols; j++)
+            if (row[j] != T(0))
+            {
+                m.col[k] = static_cast<std::int32_t>(j);
+                m.values[k++] = row[j];
+            }
+    }
+    return m;
+}
+
+template <class T>
+csc_matrix<T> to_csc(const csr_matrix<T> &a)
+{
+    detail::check_index_range(a.rows, "to_csc: more than 2^31 - 1 rows");
+    csc_matrix<T> m;
+    m.rows = a.rows;
+    m.cols = a.cols;
+    detail::transpose_compressed(a.rows, a.cols, a.row_ptr.data(), a.col.data(), a.values.data(), m.col_ptr, m.row,
+                                 m.values);
+    return m;
+}
+
+template <class T>
+csr_matrix<T> to_csr(const csc_matrix<T> &a)
+{
+    csr_matrix<T> m;
+    m.rows = a.rows;
+    m.cols = a.cols;
+    detail::transpose_compressed(a.cols, a.rows, a.col_ptr.data(), a.row.data(), a.values.data(), m.row_ptr, m.col,
+                                 m.values);
+    return m;
+}
+
+// CSC copy of a row-major rows x cols matrix.
+template <class T>
+csc_matrix<T> to_csc(std::size_t rows, std::size_t cols, const T *a, std::size_t lda)
+{
+    return to_csc(to_csr(rows, cols, a, lda));
+}
+
+// Writes the matrix into row-major dst (leading dimension ldd), zeros included.
+template <class T>
+void to_dense(const csr_matrix<T> &a, T *dst, std::size_t ldd)
+{
+    const long long nrows = static_cast<long long>(a.rows);
+    const int threads = detail::sparse_threads(double(a.rows) * double(a.cols));
+#pragma omp parallel for schedule(static) num_threads(threads) if (threads > 1)
+    for (long long i = 0; i < nrows; i++)
+    {
+        T *row = dst + i * ldd;
+        std::fill(row, row + a.cols, T(0));
+        for (std::size_t k = a.row_ptr[i]; k < a.row_ptr[i + 1]; k++)
+            row[a.col[k]] = a.values[k];
+    }
+}
+
+// y (rows) = alpha * A x + beta * y, x has cols entries. With beta == 0, y is not read.
+template <class T>
+void spmv(const csr_matrix<T> &a, const T *x, T *y, T alpha = T(1), T beta = T(0),
+          simd_level level = detected_simd_level())
+{
+    level = detail::gemm_level(level, true);
+    const std::size_t rows = a.rows, nnz = a.nnz();
+    if (rows == 0)
+        return;
+    const std::size_t *row_end = a.row_ptr.data() + 1;
+    const int threads = detail::sparse_threads(double(rows + nnz));
+    std::vector<detail::merge_coord> carry_at(threads);
+    std::vector<T> carry(threads, T(0));
+
+#pragma omp parallel num_threads(threads) if (threads > 1)
+    {
+        const int t = omp_get_thread_num(), nt = omp_get_num_threads();
+        const detail::merge_coord start = detail::merge_split(t, nt, row_end, rows, nnz);
+        const detail::merge_coord end = detail::merge_split(t + 1, nt, row_end, rows, nnz);
+        carry[t] = detail::spmv_dispatch(a, x, y, alpha, beta, start, end, level);
+        carry_at[t] = end;
+    }
+
+    // Rows split between threads: add the parts summed by the thread that started them.
+    for (int t = 0; t < threads; t++)
+        if (carry_at[t].row < rows)
+            y[carry_at[t].row] += alpha * carry[t];
+}
+
+// y (rows) = alpha * A x + beta * y from CSC: column j scatters x[j] into y. Threads take
+// equal shares of columns + non-zeros and accumulate into private copies of y, summed at
+// the end. The CSC form suits column access; CSR is the faster layout for A x.
+template <class T>
+void spmv(const csc_matrix<T> &a, const T *x, T *y, T alpha = T(1), T beta = T(0))
+{
+    const std::size_t rows = a.rows, cols = a.cols, nnz = a.nnz();
+    const long long nrows = static_cast<long long>(rows);
+    const int threads = detail::sparse_threads(double(cols + nnz));
+    std::vector<T> partial(static_cast<std::size_t>(threads) * rows, T(0));
+
+#pragma omp parallel num_threads(threads) if (threads > 1)
+    {
+        const int t = omp_get_thread_num(), nt = omp_get_num_threads();
+        const std::size_t first = detail::merge_split(t, nt, a.col_ptr.data() + 1, cols, nnz).row;
+        const std::size_t last = t + 1 == nt ? cols : detail::merge_split(t + 1, nt, a.col_ptr.data() + 1, cols, nnz).row;
+        T *mine = partial.data() + static_cast<std::size_t>(t) * rows;
+        for (std::size_t j = first; j < last; j++)
+        {
+            const T xj = x[j];
+            for (std::size_t k = a.col_ptr[j]; k < a.col_ptr[j + 1]; k++)
+                mine[a.row[k]] += a.values[k] * xj;
+        }
+#pragma omp barrier
+#pragma omp for schedule(static)
+        for (long long i = 0; i < nrows; i++)
+        {
+            T sum = T(0);
+            for (int s = 0; s < nt; s++)
+                sum += partial[static_cast<std::size_t>(s) * rows + i];
+            y[i] = beta == T(0) ? alpha * sum : alpha * sum + beta * y[i];
+        }
+    }
+}
+
+// C (rows x n) = alpha * A B + beta * C, B dense row-major cols x n (leading dimension
+// ldb >= n), C row-major with ldc >= n. With beta == 0, C is not read.
+template <class T>
+void spmm(const csr_matrix<T> &a, std::size_t n, const T *b, std::size_t ldb, T *c, std::size_t ldc,
+          T alpha = T(1), T beta = T(0), simd_level level = detected_simd_level())
+{
+    level = detail::gemm_level(level, !std::is_integral_v<T>);
+    const std::size_t rows = a.rows, nnz = a.nnz();
+    if (rows == 0 || n == 0)
+        return;
+    const std::size_t *row_end = a.row_ptr.data() + 1;
+    const int threads = detail::sparse_threads(double(rows + nnz) * double(n));
+
+#pragma omp parallel num_threads(threads) if (threads > 1)
+    {
+        const int t = omp_get_thread_num(), nt = omp_get_num_threads();
+        const std::size_t first = detail::merge_split(t, nt, row_end, rows, nnz).row;
+        const std::size_t last = t + 1 == nt ? rows : detail::merge_split(t + 1, nt, row_end, rows, nnz).row;
+        detail::spmm_dispatch(a, first, last, n, b, ldb, c, ldc, alpha, beta, level);
+    }
+}
+
+} // namespace hpc
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
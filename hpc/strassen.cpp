@@ -0,0 +1,171 @@
+/*
+ * Strassen-Winograd vs Blocked GEMM: Speedup and Float Accuracy using strassen.hpp
+ * ================================================================================
+ *
+ * COMPILATION & EXECUTION:
+ *
+ * For Ubuntu:
+ * -----------
+ * g++ -std=c++20 -O2 -fopenmp -o strassen strassen.cpp
+ * ./strassen
+ *
+ * For macOS:
+ * ----------
+ * g++ -std=c++20 -O2 -Xpreprocessor -fopenmp -I"$(brew --prefix libomp)/include" -L"$(brew --prefix libomp)/lib" -lomp -o strassen strassen.cpp
+ * ./strassen
+ *
+ * THEORETICAL CONCEPTS:
+ *
+ * Fewer Multiplications:
+ * ---------------------
+ * - Splitting each matrix into 2 x 2 quadrants turns one product into 8 half-size ones.
+ *   Strassen (1969) needs only 7, paid for with 18 quadrant additions; Winograd's variant
+ *   gets that down to 15
+ * - Recursing all the way gives O(n^2.807) instead of O(n^3). In practice the recursion
+ *   stops at a threshold where the blocked kernel is faster than the additions it would
+ *   take to save an eighth of its work, so each level is worth at most 8/7 = 1.14x
+ *
+ * Where the Time Goes:
+ * -------------------
+ * - A product of half size costs (1/8) 2n^3 flops at ~70% of peak; the additions cost
+ *   15 (n/2)^2 element passes at memory bandwidth. The larger n, the more the product
+ *   dominates, which is why the speedup grows with n and the threshold sits near 1024
+ *
+ * Accuracy:
+ * --------
+ * - The classic bound for C = A B is |C - fl(C)| <= k eps |A| |B| elementwise. Strassen
+ *   only satisfies a normwise bound, with a constant that grows by a small factor per
+ *   level: the S and T sums mix entries of different magnitude before they are rounded
+ * - Measured below for float against a double-precision product of the same inputs
+ *
+ * SAMPLE INPUT/OUTPUT:
+ * ------------------
+ *
+ * Input:
+ *   4096                         (Largest matrix size)
+ *
+ * Output (single core, AVX-512 kernels):
+ *   Threads: 1, kernels: AVX-512, threshold: 1024
+ *
+ *   Speedup over gemm (float, best of 3):
+ *   n        levels     gemm s   strassen s   speedup
+ *   512           0     0.0030       0.0026      1.15
+ *   1024          0     0.0228       0.0225      1.01
+ *   2048          1     0.1878       0.1728      1.09
+ *   4095          2     1.6025       1.4801      1.08
+ *   4096          2     1.6873       1.4925      1.13
+ *
+ *   Float accuracy, n = 2048 (relative to a double product of the same inputs):
+ *   levels   threshold    max |error|    normwise error
+ *   0             2048       2.91e-05          2.93e-07
+ *   1             1024       9.07e-05          7.75e-07
+ *   2              512       2.79e-04          2.04e-06
+ *   3              256       9.14e-04          5.35e-06
+ *   4              128       1.64e-03          1.01e-05
+ *
+ * Below the threshold both columns run the same gemm, so 512 and 1024 show the noise of a
+ * shared VM (~10%). Each level is worth about 1.06x here, against 1.14x in flops: the
+ * additions and the odd-size peeling (4095) take the rest. The error about triples per
+ * level, so two levels cost one decimal digit of float accuracy.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <utility>
+#include <omp.h>
+#include "strassen.hpp"
+#include "random.hpp"
+using namespace std;
+
+// Best of 3 for each, run alternately so that both see the same state of a shared machine.
+template <class F, class G>
+pair<double, double> bestOf3(F &&f, G &&g)
+{
+    double bestF = 1e30, bestG = 1e30;
+    for (int rep = 0; rep < 3; rep++)
+    {
+        double start = omp_get_wtime();
+        f();
+        bestF = min(bestF, omp_get_wtime() - start);
+        start = omp_get_wtime();
+        g();
+        bestG = min(bestG, omp_get_wtime() - start);
+    }
+    return {bestF, bestG};
+}
+
+vector<float> randomMatrix(size_t n, uint64_t seed)
+{
+    vector<float> m(n * n);
+    hpc::parallel_fill_uniform(m.begin(), m.end(), -1.0f, 1.0f, seed);
+    return m;
+}
+
+int main()
+{
+    size_t n;
+    cout << "Enter the largest matrix size: ";
+    cin >> n;
+
+    if (n < 64)
+    {
+        cout << "Invalid matrix size!" << endl;
+        return 1;
+    }
+
+    cout << "\nThreads: " << omp_get_max_threads() << ", kernels: " << hpc::simd_level_name(hpc::detected_simd_level())
+         << ", threshold: " << hpc::strassen_threshold << "\n" << endl;
+
+    // Speedup curve: powers of two up to n, then n - 1 to show the odd-size peeling.
+    vector<size_t> sizes;
+    for (size_t s = max<size_t>(n / 8, 64); s < n; s *= 2)
+        sizes.push_back(s);
+    sizes.push_back(n - 1);
+    sizes.push_back(n);
+
+    cout << "Speedup over gemm (float, best of 3):" << endl;
+    cout << left << setw(9) << "n" << right << setw(6) << "levels" << setw(11) << "gemm s" << setw(13) << "strassen s"
+         << setw(10) << "speedup" << endl;
+    for (size_t s : sizes)
+    {
+        vector<float> A = randomMatrix(s, 1), B = randomMatrix(s, 2), C(s * s);
+        hpc::strassen_workspace<float> workspace(s, s, s);
+        auto [tGemm, tStrassen] =
+            bestOf3([&] { hpc::matmul(A.data(), B.data(), C.data(), s); },
+                    [&] { hpc::strassen(s, s, s, A.data(), s, B.data(), s, C.data(), s, workspace); });
+        cout << left << setw(9) << s << right << setw(6) << hpc::detail::strassen_depth(s, s, s, hpc::strassen_threshold)
+             << fixed << setprecision(4) << setw(11) << tGemm << setw(13) << tStrassen << setprecision(2) << setw(10)
+             << tGemm / tStrassen << endl;
+    }
+
+    // Accuracy: one size, thresholds chosen to give 0, 1, 2, ... levels.
+    const size_t m = min<size_t>(n, 2048);
+    vector<float> A = randomMatrix(m, 1), B = randomMatrix(m, 2), C(m * m);
+    vector<double> Ad(A.begin(), A.end()), Bd(B.begin(), B.end()), R(m * m);
+    hpc::matmul(Ad.data(), Bd.data(), R.data(), m);
+    double norm = 0;
+    for (double r : R)
+        norm += r * r;
+    norm = sqrt(norm);
+
+    cout << "\nFloat accuracy, n = " << m << " (relative to a double product of the same inputs):" << endl;
+    cout << left << setw(9) << "levels" << right << setw(9) << "threshold" << setw(15) << "max |error|" << setw(18)
+         << "normwise error" << endl;
+    for (size_t threshold = m, levels = 0; threshold >= 64 && levels <= 4; threshold /= 2, levels++)
+    {
+        hpc::strassen(m, m, m, A.data(), m, B.data(), m, C.data(), m, threshold);
+        double maxError = 0, sum = 0;
+        for (size_t i = 0; i < m * m; i++)
+        {
+            const double e = abs(double(C[i]) - R[i]);
+            maxError = max(maxError, e);
+            sum += e * e;
+        }
+        cout << left << setw(9) << levels << right << setw(9) << threshold << scientific << setprecision(2)
+             << setw(15) << maxError << setw(18) << sqrt(sum) / norm << fixed << endl;
+    }
+    return 0;
+}
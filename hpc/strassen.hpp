@@ -0,0 +1,391 @@
+/*
+ * Strassen-Winograd Matrix Multiply (header-only) on top of gemm.hpp using OpenMP Tasks
+ * =====================================================================================
+ *
+ * C = A * B for row-major int32, float and double matrices with 7 half-size products per
+ * level instead of 8, recursing until a dimension reaches the threshold and finishing with
+ * the blocked SIMD kernel of gemm.hpp. Above a few thousand rows this does less work than
+ * any O(n^3) kernel can: each level saves 1/8 of the multiply-adds.
+ *
+ * USAGE:
+ *
+ *   #include "strassen.hpp"
+ *
+ *   hpc::strassen_matmul(A, B, C, n);                       // square: C = A * B
+ *   hpc::strassen(m, n, k, A, lda, B, ldb, C, ldc);         // C (m x n) = A (m x k) * B (k x n)
+ *
+ *   hpc::strassen_workspace<float> ws(m, n, k);             // allocate once ...
+ *   for (...) hpc::strassen(m, n, k, A, lda, B, ldb, C, ldc, ws);   // ... reuse per call
+ *
+ * COMPILATION:
+ *   g++ -std=c++20 -O2 -fopenmp -o program program.cpp
+ *
+ * ALGORITHM (Winograd's variant: 7 products, 15 additions per level):
+ * ------------------------------------------------------------------
+ *   S1 = A21 + A22   S2 = S1 - A11   S3 = A11 - A21   S4 = A12 - S2
+ *   T1 = B12 - B11   T2 = B22 - T1   T3 = B22 - B12   T4 = T2 - B21
+ *   P1 = A11 B11  P2 = A12 B21  P3 = S4 B22  P4 = A22 T4  P5 = S1 T1  P6 = S2 T2  P7 = S3 T3
+ *   U2 = P1 + P6     U3 = U2 + P7    U4 = U2 + P5
+ *   C11 = P1 + P2    C12 = U4 + P3   C21 = U3 - P4   C22 = U3 + P5
+ * - Recursion stops once min(m, n, k) <= threshold; below that the additions cost more
+ *   than the product they save. Odd dimensions are peeled: the even part recurses, and the
+ *   last row, last column and last rank-1 term are added with vector loops.
+ * - Serial levels follow the schedule of Douglas et al. (1994): the products are computed
+ *   into C's own quadrants where possible, so each level needs only three temporaries,
+ *   X (A quadrant), Y (B quadrant) and Z (C quadrant); summed over all levels, ~1/3 of
+ *   one m*k + k*n + m*n.
+ *
+ * PARALLELIZATION:
+ * ---------------
+ * - The top levels run the 7 products as OpenMP tasks, as many levels as it takes to give
+ *   every thread a product (7 tasks up to 7 threads, 49 up to 49). Their operands S1..S4
+ *   and T1..T4 must then exist at the same time, so those levels keep 11 quadrants each;
+ *   the additions there are taskloops over rows.
+ * - Below the task levels, the recursion and the leaf gemm calls run on one thread each:
+ *   the tasks inherit a thread count of 1, so a leaf gemm does not open a nested team even
+ *   when OMP_MAX_ACTIVE_LEVELS allows one. With a single thread nothing is tasked and the
+ *   leaves are plain gemm calls.
+ *
+ * WORKSPACE:
+ * ---------
+ * - strassen_workspace holds all temporaries of one call in a single 64-byte aligned
+ *   block. Calls grow it if needed and never shrink it, so a loop over same-sized products
+ *   allocates once. The overloads without a workspace allocate one per call.
+ *
+ * ACCURACY:
+ * --------
+ * - int32 is exact: the additions and subtractions wrap modulo 2^32 like the products.
+ * - Floating point loses a little per level: the error bound grows by a small constant
+ *   factor per level instead of staying ~k * eps * |A| |B|. strassen.cpp measures it.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include <omp.h>
+#include "gemm.hpp"
+
+namespace hpc
+{
+
+// Recursion continues while min(m, n, k) > threshold. Tuned with strassen.cpp on AVX-512:
+// 512 and 1024 are level at n = 4096, 256 loses ~20%; 1024 costs less accuracy.
+constexpr std::size_t strassen_threshold = 1024;
+
+namespace detail
+{
+
+// Temporaries start on 64-byte boundaries (16 floats).
+constexpr std::size_t strassen_round(std::size_t count)
+{
+    return (count + 15) / 16 * 16;
+}
+
+inline std::size_t strassen_depth(std::size_t m, std::size_t n, std::size_t k, std::size_t threshold)
+{
+    std::size_t depth = 0;
+    for (; std::min({m, n, k}) > std::max<std::size_t>(threshold, 1); m /= 2, n /= 2, k /= 2)
+        depth++;
+    return depth;
+}
+
+// Levels of 7 tasks needed to give every thread a product.
+inline int strassen_task_levels(int threads, std::size_t depth)
+{
+    int levels = 0;
+    for (long long tasks = 1; tasks < threads && std::size_t(levels) < depth; tasks *= 7)
+        levels++;
+    return levels;
+}
+
+// Elements of workspace one call needs: three quadrants per serial level, eleven plus
+// seven private sub-workspaces per task level.
+inline std::size_t strassen_words(std::size_t m, std::size_t n, std::size_t k, std::size_t threshold, int task_levels)
+{
+    if (std::min({m, n, k}) <= std::max<std::size_t>(threshold, 1))
+        return 0;
+    const std::size_t x = strassen_round(m / 2 * (k / 2)), y = strassen_round(k / 2 * (n / 2)),
+                      z = strassen_round(m / 2 * (n / 2));
+    const std::size_t child = strassen_words(m / 2, n / 2, k / 2, threshold, std::max(task_levels - 1, 0));
+    return task_levels > 0 ? 4 * x + 4 * y + 3 * z + 7 * child : x + y + z + child;
+}
+
+// fn(i) for each row i < rows; as a taskloop when the caller is a task level.
+template <class F>
+void strassen_rows(std::size_t rows, bool tasks, F &&fn)
+{
+    if (tasks)
+    {
+#pragma omp taskloop grainsize(16)
+        for (std::size_t i = 0; i < rows; i++)
+            fn(i);
+    }
+    else
+    {
+        for (std::size_t i = 0; i < rows; i++)
+            fn(i);
+    }
+}
+
+// z = x + y (Sign = 1) or z = x - y (Sign = -1) on rows x cols views; z may alias x or y.
+template <int Sign, class T>
+void strassen_add(std::size_t rows, std::size_t cols, const T *x, std::size_t ldx, const T *y, std::size_t ldy, T *z,
+                  std::size_t ldz, bool tasks)
+{
+    strassen_rows(rows, tasks, [=](std::size_t i) {
+        const T *xr = x + i * ldx, *yr = y + i * ldy;
+        T *zr = z + i * ldz;
+#pragma omp simd
+        for (std::size_t j = 0; j < cols; j++)
+            zr[j] = Sign > 0 ? xr[j] + yr[j] : xr[j] - yr[j];
+    });
+}
+
+// Odd dimensions: the even (m & ~1) x (n & ~1) x (k & ~1) part of C is done; add the last
+// k term, then compute the last column and row. Plain vector loops: gemm would pad a lone
+// row or column out to a whole micro-tile.
+template <class T>
+void strassen_peel(std::size_t m, std::size_t n, std::size_t k, const T *a, std::size_t lda, const T *b,
+                   std::size_t ldb, T *c, std::size_t ldc)
+{
+    const std::size_t me = m & ~std::size_t(1), ne = n & ~std::size_t(1), ke = k & ~std::size_t(1);
+    if (k > ke)
+        for (std::size_t i = 0; i < me; i++)
+        {
+            const T x = a[i * lda + ke];
+            const T *br = b + ke * ldb;
+            T *cr = c + i * ldc;
+#pragma omp simd
+            for (std::size_t j = 0; j < ne; j++)
+                cr[j] += x * br[j];
+        }
+    if (n > ne)
+    {
+        std::vector<T> column(k);
+        for (std::size_t p = 0; p < k; p++)
+            column[p] = b[p * ldb + ne];
+        for (std::size_t i = 0; i < me; i++)
+        {
+            const T *ar = a + i * lda;
+            T sum = T(0);
+#pragma omp simd reduction(+ : sum)
+            for (std::size_t p = 0; p < k; p++)
+                sum += ar[p] * column[p];
+            c[i * ldc + ne] = sum;
+        }
+    }
+    if (m > me)
+    {
+        T *cr = c + me * ldc;
+        std::fill(cr, cr + n, T(0));
+        for (std::size_t p = 0; p < k; p++)
+        {
+            const T x = a[me * lda + p];
+            const T *br = b + p * ldb;
+#pragma omp simd
+            for (std::size_t j = 0; j < n; j++)
+                cr[j] += x * br[j];
+        }
+    }
+}
+
+template <class T>
+void strassen_rec(std::size_t m, std::size_t n, std::size_t k, const T *a, std::size_t lda, const T *b,
+                  std::size_t ldb, T *c, std::size_t ldc, T *ws, std::size_t threshold, int task_levels,
+                  simd_level level)
+{
+    if (std::min({m, n, k}) <= std::max<std::size_t>(threshold, 1))
+    {
+        gemm(m, n, k, T(1), a, lda, b, ldb, T(0), c, ldc, level);
+        return;
+    }
+
+    const std::size_t hm = m / 2, hn = n / 2, hk = k / 2;
+    const T *a11 = a, *a12 = a + hk, *a21 = a + hm * lda, *a22 = a21 + hk;
+    const T *b11 = b, *b12 = b + hn, *b21 = b + hk * ldb, *b22 = b21 + hn;
+    T *c11 = c, *c12 = c + hn, *c21 = c + hm * ldc, *c22 = c21 + hn;
+    const std::size_t xs = strassen_round(hm * hk), ys = strassen_round(hk * hn), zs = strassen_round(hm * hn);
+    const int child_levels = std::max(task_levels - 1, 0);
+    const std::size_t child = strassen_words(hm, hn, hk, threshold, child_levels);
+    auto product = [&](const T *x, std::size_t ldx, const T *y, std::size_t ldy, T *z, std::size_t ldz, T *w) {
+        strassen_rec(hm, hn, hk, x, ldx, y, ldy, z, ldz, w, threshold, child_levels, level);
+    };
+
+    if (task_levels > 0)
+    {
+        T *s1 = ws, *s2 = s1 + xs, *s3 = s2 + xs, *s4 = s3 + xs;
+        T *t1 = s4 + xs, *t2 = t1 + ys, *t3 = t2 + ys, *t4 = t3 + ys;
+        T *p1 = t4 + ys, *p2 = p1 + zs, *p4 = p2 + zs, *w = p4 + zs;
+
+        // All of S and T up front, one pass over each operand.
+        strassen_rows(hm, true, [=](std::size_t i) {
+            const T *r11 = a11 + i * lda, *r12 = a12 + i * lda, *r21 = a21 + i * lda, *r22 = a22 + i * lda;
+            T *q1 = s1 + i * hk, *q2 = s2 + i * hk, *q3 = s3 + i * hk, *q4 = s4 + i * hk;
+#pragma omp simd
+            for (std::size_t j = 0; j < hk; j++)
+            {
+                q1[j] = r21[j] + r22[j];
+                q2[j] = q1[j] - r11[j];
+                q3[j] = r11[j] - r21[j];
+                q4[j] = r12[j] - q2[j];
+            }
+        });
+        strassen_rows(hk, true, [=](std::size_t i) {
+            const T *r11 = b11 + i * ldb, *r12 = b12 + i * ldb, *r21 = b21 + i * ldb, *r22 = b22 + i * ldb;
+            T *q1 = t1 + i * hn, *q2 = t2 + i * hn, *q3 = t3 + i * hn, *q4 = t4 + i * hn;
+#pragma omp simd
+            for (std::size_t j = 0; j < hn; j++)
+            {
+                q1[j] = r12[j] - r11[j];
+                q2[j] = r22[j] - q1[j];
+                q3[j] = r22[j] - r12[j];
+                q4[j] = q2[j] - r21[j];
+            }
+        });
+
+#pragma omp taskgroup
+        {
+#pragma omp task
+            product(a11, lda, b11, ldb, p1, hn, w);
+#pragma omp task
+            product(a12, lda, b21, ldb, p2, hn, w + child);
+#pragma omp task
+            product(s4, hk, b22, ldb, c11, ldc, w + 2 * child);
+#pragma omp task
+            product(a22, lda, t4, hn, p4, hn, w + 3 * child);
+#pragma omp task
+            product(s1, hk, t1, hn, c22, ldc, w + 4 * child);
+#pragma omp task
+            product(s2, hk, t2, hn, c12, ldc, w + 5 * child);
+#pragma omp task
+            product(s3, hk, t3, hn, c21, ldc, w + 6 * child);
+        }
+
+        // C11 holds P3, C12 P6, C21 P7, C22 P5.
+        strassen_rows(hm, true, [=](std::size_t i) {
+            const T *q1 = p1 + i * hn, *q2 = p2 + i * hn, *q4 = p4 + i * hn;
+            T *r11 = c11 + i * ldc, *r12 = c12 + i * ldc, *r21 = c21 + i * ldc, *r22 = c22 + i * ldc;
+#pragma omp simd
+            for (std::size_t j = 0; j < hn; j++)
+            {
+                const T u2 = q1[j] + r12[j], u3 = u2 + r21[j];
+                r12[j] = u2 + r22[j] + r11[j];
+                r21[j] = u3 - q4[j];
+                r22[j] = u3 + r22[j];
+                r11[j] = q1[j] + q2[j];
+            }
+        });
+    }
+    else
+    {
+        T *x = ws, *y = x + xs, *z = y + ys, *w = z + zs;
+        strassen_add<-1>(hm, hk, a11, lda, a21, lda, x, hk, false); // S3
+        strassen_add<-1>(hk, hn, b22, ldb, b12, ldb, y, hn, false); // T3
+        product(x, hk, y, hn, c21, ldc, w);                         // P7
+        strassen_add<1>(hm, hk, a21, lda, a22, lda, x, hk, false);  // S1
+        strassen_add<-1>(hk, hn, b12, ldb, b11, ldb, y, hn, false); // T1
+        product(x, hk, y, hn, c22, ldc, w);                         // P5
+        strassen_add<-1>(hm, hk, x, hk, a11, lda, x, hk, false);    // S2
+        strassen_add<-1>(hk, hn, b22, ldb, y, hn, y, hn, false);    // T2
+        product(x, hk, y, hn, c12, ldc, w);                         // P6
+        strassen_add<-1>(hm, hk, a12, lda, x, hk, x, hk, false);    // S4
+        product(x, hk, b22, ldb, c11, ldc, w);                      // P3
+        product(a11, lda, b11, ldb, z, hn, w);                      // P1
+        strassen_add<1>(hm, hn, z, hn, c12, ldc, c12, ldc, false);  // U2 = P1 + P6
+        strassen_add<1>(hm, hn, c12, ldc, c21, ldc, c21, ldc, false); // U3 = U2 + P7
+        strassen_add<1>(hm, hn, c12, ldc, c22, ldc, c12, ldc, false); // U4 = U2 + P5
+        strassen_add<1>(hm, hn, c21, ldc, c22, ldc, c22, ldc, false); // C22 = U3 + P5
+        strassen_add<1>(hm, hn, c12, ldc, c11, ldc, c12, ldc, false); // C12 = U4 + P3
+        strassen_add<-1>(hk, hn, y, hn, b21, ldb, y, hn, false);      // T4
+        product(a22, lda, y, hn, c11, ldc, w);                        // P4
+        strassen_add<-1>(hm, hn, c21, ldc, c11, ldc, c21, ldc, false); // C21 = U3 - P4
+        product(a12, lda, b21, ldb, c11, ldc, w);                      // P2
+        strassen_add<1>(hm, hn, z, hn, c11, ldc, c11, ldc, false);     // C11 = P1 + P2
+    }
+
+    if (m > 2 * hm || n > 2 * hn || k > 2 * hk)
+        strassen_peel(m, n, k, a, lda, b, ldb, c, ldc);
+}
+
+} // namespace detail
+
+// Temporaries for hpc::strassen, kept between calls.
+template <class T>
+class strassen_workspace
+{
+public:
+    strassen_workspace() = default;
+    strassen_workspace(std::size_t m, std::size_t n, std::size_t k, std::size_t threshold = strassen_threshold,
+                       int threads = omp_get_max_threads())
+    {
+        reserve(m, n, k, threshold, threads);
+    }
+
+    // Grows the buffer to what an m x n x k product needs; never shrinks it.
+    void reserve(std::size_t m, std::size_t n, std::size_t k, std::size_t threshold = strassen_threshold,
+                 int threads = omp_get_max_threads())
+    {
+        const int task_levels = detail::strassen_task_levels(threads, detail::strassen_depth(m, n, k, threshold));
+        const std::size_t words = detail::strassen_words(m, n, k, threshold, task_levels);
+        if (words > size_)
+        {
+            buffer_.reset();
+            buffer_ = detail::gemm_buffer<T>(words);
+            size_ = words;
+        }
+    }
+
+    std::size_t size() const { return size_; }
+    T *data() { return buffer_.get(); }
+
+private:
+    std::unique_ptr<T, detail::gemm_free> buffer_;
+    std::size_t size_ = 0;
+};
+
+// C (m x n) = A (m x k) * B (k x n), row-major with leading dimensions lda >= k, ldb >= n,
+// ldc >= n. C must not overlap A or B. Below the threshold this is exactly hpc::gemm.
+template <class T>
+void strassen(std::size_t m, std::size_t n, std::size_t k, const T *a, std::size_t lda, const T *b, std::size_t ldb,
+              T *c, std::size_t ldc, strassen_workspace<T> &workspace, std::size_t threshold = strassen_threshold,
+              simd_level level = detected_simd_level())
+{
+    static_assert(detail::gemm_type<T>, "hpc::strassen supports int32_t, float and double");
+    const std::size_t depth = detail::strassen_depth(m, n, k, threshold);
+    if (depth == 0)
+        return gemm(m, n, k, T(1), a, lda, b, ldb, T(0), c, ldc, level);
+
+    const int threads = omp_get_max_threads();
+    const int task_levels = detail::strassen_task_levels(threads, depth);
+    workspace.reserve(m, n, k, threshold, threads);
+    if (task_levels == 0)
+        return detail::strassen_rec(m, n, k, a, lda, b, ldb, c, ldc, workspace.data(), threshold, 0, level);
+
+#pragma omp parallel num_threads(threads)
+#pragma omp single
+    {
+        // Inherited by every task below: a leaf gemm gets one thread, not a nested team.
+        omp_set_num_threads(1);
+        detail::strassen_rec(m, n, k, a, lda, b, ldb, c, ldc, workspace.data(), threshold, task_levels, level);
+    }
+}
+
+template <class T>
+void strassen(std::size_t m, std::size_t n, std::size_t k, const T *a, std::size_t lda, const T *b, std::size_t ldb,
+              T *c, std::size_t ldc, std::size_t threshold = strassen_threshold, simd_level level = detected_simd_level())
+{
+    strassen_workspace<T> workspace;
+    strassen(m, n, k, a, lda, b, ldb, c, ldc, workspace, threshold, level);
+}
+
+// C = A * B for n x n row-major matrices.
+template <class T>
+void strassen_matmul(const T *a, const T *b, T *c, std::size_t n, std::size_t threshold = strassen_threshold)
+{
+    strassen(n, n, n, a, n, b, n, c, n, threshold);
+}
+
+} // namespace hpc
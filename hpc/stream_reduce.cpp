@@ -0,0 +1,214 @@
+/*
+ * Out-of-Core Streaming Reduction Benchmark using stream_reduce.hpp
+ * =================================================================
+ *
+ * COMPILATION & EXECUTION:
+ *
+ * For Ubuntu:
+ * -----------
+ * g++ -std=c++20 -O2 -fopenmp -o stream_reduce stream_reduce.cpp
+ * ./stream_reduce
+ *
+ * For macOS:
+ * ----------
+ * g++ -std=c++20 -O2 -Xpreprocessor -fopenmp -I"$(brew --prefix libomp)/include" -L"$(brew --prefix libomp)/lib" -lomp -o stream_reduce stream_reduce.cpp
+ * ./stream_reduce
+ *
+ * Writes stream_values.bin and stream_values.txt to the current directory and deletes
+ * them at the end. For cold-cache numbers, make the file larger than RAM or drop the page
+ * cache between runs (Linux: sync; echo 3 | sudo tee /proc/sys/vm/drop_caches).
+ *
+ * THEORETICAL CONCEPTS:
+ *
+ * Out-of-Core Processing:
+ * ----------------------
+ * - Loading a whole file before reducing it needs as much RAM as the file, and the CPU
+ *   sits idle while the disk reads
+ * - Streaming keeps two fixed-size chunks: one being reduced, one being filled. Memory
+ *   stays constant (peak RSS below does not grow with the file) and I/O overlaps compute
+ *
+ * read() vs mmap:
+ * --------------
+ * - read() copies from the page cache into a user buffer, in large sequential requests
+ * - mmap maps the page cache directly (no copy) but pays a page fault per 4 KB page;
+ *   MADV_SEQUENTIAL / MADV_WILLNEED let the kernel read ahead and drop pages behind
+ * - Which wins depends on the OS and storage; both are usually within a few percent of
+ *   the raw read bandwidth once the reduction keeps up
+ *
+ * Bandwidth Bound:
+ * ---------------
+ * - A fused one-pass reduction (min/max/sum/count together) costs about as much as the
+ *   raw read, so the run is I/O bound; parsing text is much slower than binary
+ *
+ * SAMPLE INPUT/OUTPUT:
+ * ------------------
+ *
+ * Input:
+ *   512                          (File size in MB)
+ *   64                           (Chunk size in MB)
+ *
+ * Output (single core, warm page cache):
+ *   Threads: 1
+ *   Writing 134217728 ints (512 MB binary, 946 MB text)...
+ *
+ *   raw read (no reduction)         0.2500 s   2147.3 MB/s   waiting for I/O 0.2496 s
+ *   sum            read             0.2728 s   1968.1 MB/s   waiting for I/O 0.1004 s   ok
+ *   sum            mmap             0.0826 s   6501.0 MB/s   waiting for I/O 0.0031 s   ok
+ *   min/max/sum    read             0.2327 s   2307.5 MB/s   waiting for I/O 0.0858 s   ok
+ *   min/max/sum    mmap             0.0694 s   7735.2 MB/s   waiting for I/O 0.0030 s   ok
+ *   argmax         read             0.3201 s   1677.2 MB/s   waiting for I/O 0.0498 s   ok
+ *   welford        text             5.5225 s    179.7 MB/s   waiting for I/O 0.0401 s   ok
+ *
+ *   min -1000000, max 1000000, mean -141.2458, argmax at 3036145
+ *   Peak RSS: 260 MB (file 512 MB, chunk 64 MB)
+ *
+ * With the page cache warm, mmap skips the copy and wins; read() is the one that keeps its
+ * speed when the data really comes from disk. Peak RSS is set by the text pass (two
+ * buffers of chunk + carry, plus the parsed values) and stays the same for larger files.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <vector>
+#include <random>
+#include <string>
+#include <cmath>
+#include <cstdio>
+#include <sys/resource.h>
+#include <omp.h>
+#include "stream_reduce.hpp"
+#include "fused_stats.hpp"
+using namespace std;
+
+const char *BIN_FILE = "stream_values.bin";
+const char *TEXT_FILE = "stream_values.txt";
+
+void row(const string &name, const hpc::stream_stats &s, bool ok)
+{
+    cout << left << setw(32) << name << right << fixed << setprecision(4) << s.seconds << " s  " << setprecision(1)
+         << setw(7) << s.bandwidth() << " MB/s   waiting for I/O " << setprecision(4) << s.wait_seconds << " s   "
+         << (ok ? "ok" : "WRONG") << endl;
+}
+
+long peakRssMB()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / (1024 * 1024); // bytes
+#else
+    return usage.ru_maxrss / 1024; // KB
+#endif
+}
+
+int main()
+{
+    long long mb, chunkMb;
+    cout << "Enter the file size in MB: ";
+    cin >> mb;
+    cout << "Enter the chunk size in MB: ";
+    cin >> chunkMb;
+
+    if (mb <= 0 || chunkMb <= 0)
+    {
+        cout << "Invalid size!" << endl;
+        return 1;
+    }
+
+    // Generate the files a block at a time, keeping the expected results on the side
+    const long long n = mb * (1 << 20) / sizeof(int);
+    hpc::int_stats expected;
+    hpc::indexed_value<int> expectedMax;
+    {
+        cout << "\nThreads: " << omp_get_max_threads() << endl;
+        ofstream bin(BIN_FILE, ios::binary), text(TEXT_FILE);
+        mt19937 rng(42);
+        vector<int> block(1 << 16);
+        string lines;
+        for (long long done = 0; done < n; done += block.size())
+        {
+            size_t count = min<long long>(block.size(), n - done);
+            lines.clear();
+            for (size_t i = 0; i < count; i++)
+            {
+                int v = static_cast<int>(rng() % 2000001) - 1000000;
+                block[i] = v;
+                expected = hpc::detail::combine_stats(expected, {v, v, v, 1});
+                if (v > expectedMax.value || expectedMax.index == expectedMax.npos)
+                    expectedMax = {v, size_t(done + i)};
+                lines += to_string(v);
+                lines += '\n';
+                if ((done + i) % 1000 == 999) // a missing value now and then
+                    lines += "NA\n";
+            }
+            bin.write(reinterpret_cast<const char *>(block.data()), count * sizeof(int));
+            text << lines;
+        }
+        cout << "Writing " << n << " ints (" << mb << " MB binary, " << text.tellp() / (1 << 20) << " MB text)...\n"
+             << endl;
+    }
+
+    hpc::stream_options readOpts, mmapOpts;
+    readOpts.chunk_bytes = mmapOpts.chunk_bytes = size_t(chunkMb) << 20;
+    mmapOpts.use_mmap = true;
+    hpc::stream_stats stats;
+
+    // Raw read bandwidth: the ceiling for everything below
+    {
+        hpc::detail::chunk_reader reader(BIN_FILE, hpc::detail::chunk_size(readOpts.chunk_bytes, 1));
+        double start = omp_get_wtime();
+        hpc::stream_stats raw;
+        while (reader.next())
+        {
+            reader.prefetch(0);
+            raw.bytes += reader.size();
+        }
+        raw.seconds = omp_get_wtime() - start;
+        raw.wait_seconds = reader.wait_seconds();
+        cout << left << setw(32) << "raw read (no reduction)" << right << fixed << setprecision(4) << raw.seconds
+             << " s  " << setprecision(1) << setw(7) << raw.bandwidth() << " MB/s   waiting for I/O "
+             << setprecision(4) << raw.wait_seconds << " s" << endl;
+    }
+
+    // Sum
+    auto sum = hpc::reducers::sum<long long>();
+    long long s = hpc::stream_reduce<int>(BIN_FILE, sum, readOpts, &stats);
+    row("sum            read", stats, s == expected.sum);
+    s = hpc::stream_reduce<int>(BIN_FILE, sum, mmapOpts, &stats);
+    row("sum            mmap", stats, s == expected.sum);
+
+    // Fused min/max/sum/count in one pass, using fused_stats.hpp's SIMD kernel
+    auto fused = hpc::make_reduction(
+        hpc::int_stats{}, hpc::detail::combine_stats,
+        [](hpc::int_stats &acc, int v) { acc = hpc::detail::combine_stats(acc, {v, v, v, 1}); },
+        [](const int *data, size_t count, size_t) {
+            return hpc::detail::stats_kernel(data, count, hpc::detected_simd_level());
+        });
+    auto check = [&](const hpc::int_stats &got) {
+        return got.min == expected.min && got.max == expected.max && got.sum == expected.sum &&
+               got.count == expected.count;
+    };
+    hpc::int_stats result = hpc::stream_reduce<int>(BIN_FILE, fused, readOpts, &stats);
+    row("min/max/sum    read", stats, check(result));
+    result = hpc::stream_reduce<int>(BIN_FILE, fused, mmapOpts, &stats);
+    row("min/max/sum    mmap", stats, check(result));
+
+    // Argmax: indices are positions in the whole file, not in the chunk
+    auto amax = hpc::stream_reduce<int>(BIN_FILE, hpc::reducers::argmax<int>(), readOpts, &stats);
+    row("argmax         read", stats, amax.index == expectedMax.index && amax.value == expectedMax.value);
+
+    // Welford over the text copy ("NA" lines are skipped)
+    hpc::moments m = hpc::stream_reduce_text<double>(TEXT_FILE, hpc::reducers::welford(), readOpts, &stats);
+    row("welford        text", stats,
+        m.count == expected.count && fabs(m.mean - expected.mean()) < 1e-6 &&
+            stats.skipped == size_t(n / 1000));
+
+    cout << "\nmin " << result.min << ", max " << result.max << ", mean " << result.mean() << ", argmax at "
+         << amax.index << endl;
+    cout << "Peak RSS: " << peakRssMB() << " MB (file " << mb << " MB, chunk " << chunkMb << " MB)" << endl;
+
+    remove(BIN_FILE);
+    remove(TEXT_FILE);
+    return 0;
+}
@@ -0,0 +1,459 @@
+/*
+ * Out-of-Core Streaming Reductions (header-only) using OpenMP
+ * ===========================================================
+ *
+ * Runs any reduce.hpp reduction over a file that may be much larger than RAM. The file
+ * is processed chunk by chunk while the next chunk is already being read, so memory use
+ * is two chunks no matter how big the file is, and a fast enough reduction runs at disk
+ * speed.
+ *
+ * USAGE:
+ *
+ *   #include "stream_reduce.hpp"
+ *
+ *   hpc::stream_options opts;                        // 64 MB chunks, read() + read-ahead
+ *   hpc::stream_stats stats;
+ *   long long sum = hpc::stream_reduce<int>("values.bin", hpc::reducers::sum<long long>(), opts, &stats);
+ *   auto [v, i] = hpc::stream_reduce<double>("prices.bin", hpc::reducers::argmax<double>());
+ *   hpc::moments m = hpc::stream_reduce_text<double>("price_column.txt", hpc::reducers::welford());
+ *   stats.print(cout);
+ *
+ * COMPILATION:
+ *   g++ -std=c++20 -O2 -fopenmp -o program program.cpp
+ *
+ * FILE FORMATS:
+ * ------------
+ * - stream_reduce<T>: raw binary array of T (native byte order), e.g. written with
+ *   ofstream::write. The size must be a multiple of sizeof(T).
+ * - stream_reduce_text<T>: one number per line (a CSV column cut out with `cut -d, -f3`).
+ *   Blank lines and lines that do not parse as T (missing values, "NA") are skipped and
+ *   counted in stream_stats::skipped.
+ * Argmin/argmax indices are positions in the whole file (record or parsed-value number).
+ *
+ * I/O MODES:
+ * ---------
+ * - read (default): two page-aligned chunk buffers. While the reduction runs on one, a
+ *   background thread read()s the next chunk into the other (double buffering). The file
+ *   is opened with POSIX_FADV_SEQUENTIAL where available so the kernel reads ahead further.
+ * - mmap (binary only, opts.use_mmap): the file is mapped one chunk-sized window at a time.
+ *   The next window is mapped early with MADV_WILLNEED, so the kernel starts paging it in
+ *   while the current one is reduced; finished windows are unmapped. No copy into a user
+ *   buffer, but page faults instead of large reads.
+ *
+ * ERROR HANDLING:
+ * --------------
+ * - I/O failures and malformed binary files throw std::runtime_error.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <numeric>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <omp.h>
+#include "reduce.hpp"
+
+namespace hpc
+{
+
+struct stream_options
+{
+    std::size_t chunk_bytes = std::size_t(64) << 20; // per buffer (read) or per mapped window (mmap)
+    bool use_mmap = false;                           // binary files only
+};
+
+struct stream_stats
+{
+    std::size_t bytes = 0;
+    std::size_t records = 0;      // values reduced
+    std::size_t skipped = 0;      // text lines that did not parse
+    std::size_t chunks = 0;
+    double seconds = 0;           // wall time of the whole stream
+    double wait_seconds = 0;      // time the reduction sat idle waiting for I/O
+
+    double bandwidth() const { return seconds > 0 ? bytes / seconds / 1e6 : 0.0; } // MB/s
+
+    void print(std::ostream &os) const
+    {
+        os << "Bytes: " << bytes << " in " << chunks << " chunks\n"
+           << "Values: " << records << " (skipped " << skipped << ")\n"
+           << "Time: " << seconds << " seconds (waiting for I/O: " << wait_seconds << ")\n"
+           << "Throughput: " << bandwidth() << " MB/s\n";
+    }
+};
+
+namespace detail
+{
+
+// The kernel's page size: 4 KB on x86-64, 16 or 64 KB on some arm64 kernels. mmap
+// offsets must be a multiple of it.
+inline std::size_t page_bytes()
+{
+    static const std::size_t bytes = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    return bytes;
+}
+
+inline double seconds_since(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Chunk size rounded down to whole pages and whole records (at least one of each).
+inline std::size_t chunk_size(std::size_t requested, std::size_t record_bytes)
+{
+    const std::size_t unit = std::lcm(page_bytes(), record_bytes);
+    return std::max(requested / unit, std::size_t(1)) * unit;
+}
+
+class file_descriptor
+{
+public:
+    explicit file_descriptor(const std::filesystem::path &path) : fd_(::open(path.c_str(), O_RDONLY))
+    {
+        if (fd_ < 0)
+            throw std::runtime_error("stream_reduce: cannot open " + path.string());
+        struct stat st;
+        if (::fstat(fd_, &st) != 0)
+        {
+            ::close(fd_);
+            throw std::runtime_error("stream_reduce: cannot stat " + path.string());
+        }
+        size_ = static_cast<std::size_t>(st.st_size);
+#ifdef POSIX_FADV_SEQUENTIAL
+        ::posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+    }
+    ~file_descriptor() { ::close(fd_); }
+    file_descriptor(const file_descriptor &) = delete;
+    file_descriptor &operator=(const file_descriptor &) = delete;
+
+    int get() const { return fd_; }
+    std::size_t size() const { return size_; }
+
+private:
+    int fd_;
+    std::size_t size_ = 0;
+};
+
+struct free_deleter
+{
+    void operator()(char *p) const { std::free(p); }
+};
+
+// Reads a file front to back into two alternating page-aligned buffers. prefetch() starts
+// the next read in the background; next() waits for it and makes it the current chunk.
+class chunk_reader
+{
+public:
+    // max_carry: the most bytes a caller will ever ask prefetch() to carry over.
+    chunk_reader(const std::filesystem::path &path, std::size_t chunk_bytes, std::size_t max_carry = 0)
+        : file_(path), chunk_(chunk_bytes), capacity_(chunk_bytes + max_carry)
+    {
+        for (auto &b : buffer_)
+        {
+            const std::size_t page = page_bytes();
+            b.reset(static_cast<char *>(std::aligned_alloc(page, (capacity_ + page - 1) / page * page)));
+            if (!b)
+                throw std::bad_alloc();
+        }
+        prefetch(0);
+    }
+
+    ~chunk_reader()
+    {
+        if (pending_.valid())
+            pending_.wait();
+    }
+
+    std::size_t file_size() const { return file_.size(); }
+    const char *data() const { return buffer_[current_].get(); }
+    std::size_t size() const { return size_; }
+    bool eof() const { return eof_; } // the current chunk ends at the end of the file
+    double wait_seconds() const { return wait_seconds_; }
+
+    // Copies the last `carry` bytes of the current chunk to the front of the spare buffer
+    // and starts reading the next chunk behind them.
+    void prefetch(std::size_t carry)
+    {
+        const int spare = 1 - current_;
+        if (carry)
+            std::memmove(buffer_[spare].get(), buffer_[current_].get() + size_ - carry, carry);
+        char *dst = buffer_[spare].get() + carry;
+        const int fd = file_.get();
+        const std::size_t want = chunk_;
+        pending_ = std::async(std::launch::async, [fd, dst, want, carry] {
+            std::size_t got = 0;
+            while (got < want)
+            {
+                ssize_t r = ::read(fd, dst + got, want - got);
+                if (r < 0)
+                    throw std::runtime_error("stream_reduce: read failed");
+                if (r == 0)
+                    break;
+                got += static_cast<std::size_t>(r);
+            }
+            return std::make_pair(carry + got, got < want);
+        });
+    }
+
+    // False once the file is exhausted and nothing was carried over.
+    bool next()
+    {
+        auto start = std::chrono::steady_clock::now();
+        auto [size, eof] = pending_.get();
+        wait_seconds_ += seconds_since(start);
+        current_ = 1 - current_;
+        size_ = size;
+        eof_ = eof;
+        return size_ > 0;
+    }
+
+private:
+    file_descriptor file_;
+    std::size_t chunk_;
+    std::size_t capacity_;
+    std::unique_ptr<char, free_deleter> buffer_[2];
+    int current_ = 1; // the constructor's prefetch fills buffer 0
+    std::size_t size_ = 0;
+    bool eof_ = false;
+    double wait_seconds_ = 0;
+    std::future<std::pair<std::size_t, bool>> pending_;
+};
+
+// Maps a file one window at a time, with the following window already mapped and
+// announced to the kernel (MADV_WILLNEED) so it is paged in ahead of use.
+class mapped_reader
+{
+public:
+    mapped_reader(const std::filesystem::path &path, std::size_t window_bytes) : file_(path), window_(window_bytes)
+    {
+        ahead_ = map(0);
+    }
+
+    ~mapped_reader()
+    {
+        unmap(current_);
+        unmap(ahead_);
+    }
+
+    std::size_t file_size() const { return file_.size(); }
+    const char *data() const { return static_cast<const char *>(current_.ptr); }
+    std::size_t size() const { return current_.len; }
+
+    bool next()
+    {
+        unmap(current_);
+        current_ = ahead_;
+        ahead_ = map(current_.offset + current_.len);
+        return current_.len > 0;
+    }
+
+private:
+    struct window
+    {
+        void *ptr = nullptr;
+        std::size_t offset = 0;
+        std::size_t len = 0;
+    };
+
+    window map(std::size_t offset)
+    {
+        window w{nullptr, offset, std::min(window_, file_.size() - std::min(offset, file_.size()))};
+        if (w.len == 0)
+            return w;
+        w.ptr = ::mmap(nullptr, w.len, PROT_READ, MAP_PRIVATE, file_.get(), static_cast<off_t>(offset));
+        if (w.ptr == MAP_FAILED)
+            throw std::runtime_error("stream_reduce: mmap failed");
+        ::madvise(w.ptr, w.len, MADV_SEQUENTIAL);
+        ::madvise(w.ptr, w.len, MADV_WILLNEED);
+        return w;
+    }
+
+    static void unmap(window &w)
+    {
+        if (w.ptr)
+            ::munmap(w.ptr, w.len);
+        w = {};
+    }
+
+    file_descriptor file_;
+    std::size_t window_;
+    window current_, ahead_;
+};
+
+// Start of the line containing position pos (or pos itself at a line start).
+inline std::size_t line_start(const char *data, std::size_t pos)
+{
+    while (pos > 0 && data[pos - 1] != '\n')
+        pos--;
+    return pos;
+}
+
+// Parses the numbers of whole lines in [data + begin, data + end) into out.
+template <class T>
+std::size_t parse_lines(const char *data, std::size_t begin, std::size_t end, std::vector<T> &out)
+{
+    std::size_t skipped = 0;
+    while (begin < end)
+    {
+        const char *line = data + begin;
+        const char *stop = static_cast<const char *>(std::memchr(line, '\n', end - begin));
+        if (!stop)
+            stop = data + end;
+        begin = static_cast<std::size_t>(stop - data) + 1;
+
+        const char *first = line, *last = stop;
+        while (first < last && (*first == ' ' || *first == '\t' || *first == '"' || *first == '+'))
+            first++;
+        while (last > first && (last[-1] == ' ' || last[-1] == '\t' || last[-1] == '\r' || last[-1] == '"'))
+            last--;
+        if (first == last)
+            continue;
+        T value;
+        auto [ptr, ec] = std::from_chars(first, last, value);
+        if (ec == std::errc() && ptr == last)
+            out.push_back(value);
+        else
+            skipped++;
+    }
+    return skipped;
+}
+
+} // namespace detail
+
+// Reduces a binary file of T records with r, chunk by chunk.
+template <class T, class Acc, class Combine, class Accumulate, class Kernel>
+Acc stream_reduce(const std::filesystem::path &path, const reduction<Acc, Combine, Accumulate, Kernel> &r,
+                  const stream_options &opts = {}, stream_stats *stats = nullptr)
+{
+    static_assert(std::is_trivially_copyable_v<T>, "stream_reduce reads raw binary records");
+    const auto start = std::chrono::steady_clock::now();
+    const std::size_t chunk = detail::chunk_size(opts.chunk_bytes, sizeof(T));
+    stream_stats local;
+    Acc total = r.identity;
+
+    auto reduce_chunk = [&](const char *data, std::size_t bytes) {
+        const T *first = reinterpret_cast<const T *>(data);
+        const std::size_t count = bytes / sizeof(T);
+        total = r.combine(total, parallel_reduce(first, first + count, r, local.records));
+        local.records += count;
+        local.bytes += bytes;
+        local.chunks++;
+    };
+
+    if (opts.use_mmap)
+    {
+        detail::mapped_reader reader(path, chunk);
+        if (reader.file_size() % sizeof(T))
+            throw std::runtime_error("stream_reduce: " + path.string() + " is not a whole number of records");
+        while (true)
+        {
+            auto wait = std::chrono::steady_clock::now();
+            if (!reader.next())
+                break;
+            local.wait_seconds += detail::seconds_since(wait);
+            reduce_chunk(reader.data(), reader.size());
+        }
+    }
+    else
+    {
+        detail::chunk_reader reader(path, chunk);
+        if (reader.file_size() % sizeof(T))
+            throw std::runtime_error("stream_reduce: " + path.string() + " is not a whole number of records");
+        while (reader.next())
+        {
+            reader.prefetch(0);
+            reduce_chunk(reader.data(), reader.size());
+        }
+        local.wait_seconds = reader.wait_seconds();
+    }
+
+    local.seconds = detail::seconds_since(start);
+    if (stats)
+        *stats = local;
+    return total;
+}
+
+// Reduces a text file holding one number per line with r. Lines are split between threads
+// at line boundaries and parsed in parallel; a line cut by a chunk boundary is carried
+// over to the next chunk.
+template <class T, class Acc, class Combine, class Accumulate, class Kernel>
+Acc stream_reduce_text(const std::filesystem::path &path, const reduction<Acc, Combine, Accumulate, Kernel> &r,
+                       const stream_options &opts = {}, stream_stats *stats = nullptr)
+{
+    const auto start = std::chrono::steady_clock::now();
+    const std::size_t chunk = detail::chunk_size(opts.chunk_bytes, 1);
+    const int threads = omp_get_max_threads();
+    detail::chunk_reader reader(path, chunk, chunk);
+
+    stream_stats local;
+    Acc total = r.identity;
+    std::vector<std::vector<T>> values(threads);          // reused: capacity stays within a chunk
+    std::vector<detail::cache_padded<Acc>> partial(threads);
+    std::vector<std::size_t> offset(threads + 1);
+
+    while (reader.next())
+    {
+        const char *data = reader.data();
+        std::size_t complete = reader.size();
+        if (!reader.eof())
+        {
+            complete = detail::line_start(data, complete);
+            if (complete == 0)
+                throw std::runtime_error("stream_reduce: line longer than the chunk size in " + path.string());
+        }
+        reader.prefetch(reader.size() - complete);
+
+        std::size_t skipped = 0;
+#pragma omp parallel num_threads(threads) reduction(+ : skipped)
+        {
+            const int nt = omp_get_num_threads();
+            const int t = omp_get_thread_num();
+            const std::size_t lo = t == 0 ? 0 : detail::line_start(data, complete * t / nt);
+            const std::size_t hi = t + 1 == nt ? complete : detail::line_start(data, complete * (t + 1) / nt);
+            values[t].clear();
+            skipped += detail::parse_lines(data, lo, hi, values[t]);
+#pragma omp barrier
+#pragma omp single
+            {
+                offset[0] = local.records;
+                for (int u = 0; u < nt; u++)
+                    offset[u + 1] = offset[u] + values[u].size();
+                local.records = offset[nt];
+            }
+            partial[t].value = detail::reduce_slice(values[t].begin(), 0, values[t].size(), r, offset[t]);
+#pragma omp barrier
+#pragma omp single
+            for (int u = 0; u < nt; u++)
+                total = r.combine(total, partial[u].value);
+        }
+
+        local.skipped += skipped;
+        local.bytes += complete;
+        local.chunks++;
+    }
+
+    local.wait_seconds = reader.wait_seconds();
+    local.seconds = detail::seconds_since(start);
+    if (stats)
+        *stats = local;
+    return total;
+}
+
+} // namespace hpc
@@ -0,0 +1,202 @@
+/*
+ * Fork-Join Overhead: OpenMP Regions vs a Persistent Pool using thread_pool.hpp
+ * =============================================================================
+ *
+ * COMPILATION & EXECUTION:
+ *
+ * For Ubuntu:
+ * -----------
+ * g++ -std=c++20 -O2 -fopenmp -o thread_pool thread_pool.cpp
+ * ./thread_pool
+ *
+ * For macOS:
+ * ----------
+ * g++ -std=c++20 -O2 -Xpreprocessor -fopenmp -I"$(brew --prefix libomp)/include" -L"$(brew --prefix libomp)/lib" -lomp -o thread_pool thread_pool.cpp
+ * ./thread_pool
+ *
+ * THEORETICAL CONCEPTS:
+ *
+ * Where Small Parallel Loops Lose:
+ * -------------------------------
+ * - MIN_MAX_mine.cpp ends with the observation that for 10,000 elements the parallel
+ *   min/max is slower than the serial loop: the work is a few microseconds, and starting
+ *   and joining the team costs about as much
+ * - Amdahl with a fixed overhead o: T(p) = T1 / p + o. Parallelism only pays once
+ *   T1 > o * p / (p - 1), so the smaller o, the smaller the inputs worth splitting
+ *
+ * Spin, Then Park:
+ * ---------------
+ * - A parked thread needs a futex syscall to wake (several microseconds, more if the core
+ *   went to a deep sleep state); a spinning thread sees the new job as soon as the cache
+ *   line holding the epoch arrives (tens of nanoseconds)
+ * - Spinning forever burns cores, so workers spin for 50 us after each job and then park.
+ *   Bursts of small jobs stay on the fast path; an idle program costs nothing
+ * - GOMP does the same with OMP_WAIT_POLICY / GOMP_SPINCOUNT; the pool adds a cheaper
+ *   dispatch (one epoch store, one counter) and a caller that works instead of waiting
+ *
+ * Oversubscription:
+ * ----------------
+ * - With more threads than cores a spinning thread steals the slice of the thread it is
+ *   waiting for; the pool then parks immediately (spin 0), and so should OpenMP
+ *
+ * SAMPLE INPUT/OUTPUT:
+ * ------------------
+ *
+ * Input:
+ *   4                            (Number of threads)
+ *
+ * Output (single core, so 4 threads are oversubscribed and the pool parks at once; with a
+ * core per thread the workers spin instead, which is what brings the fork-join under 2 us
+ * but cannot be shown here):
+ *   Threads: 4 (pool spin 0 us, 1 hardware threads)
+ *
+ *   Empty fork-join          omp parallel:   27.404 us   pool.run:    5.207 us
+ *
+ *   sum            n          serial (us)    omp (us)   pool (us)   match
+ *                  1000              0.40        0.31        0.35   yes
+ *                  10000             3.87        4.14       10.41   yes
+ *                  100000           40.19       89.48       38.81   yes
+ *                  1000000         453.33      518.62      468.87   yes
+ *   min/max        n          serial (us)    omp (us)   pool (us)   match
+ *                  1000              1.06        1.09        1.06   yes
+ *                  10000            11.21       11.61       19.19   yes
+ *                  100000          113.06      181.87      122.44   yes
+ *                  1000000        1072.57     1081.76     1037.32   yes
+ *   sort           n          serial (us)    omp (us)   pool (us)   match
+ *                  1000             13.54       13.07       12.21   yes
+ *                  10000           642.90      632.44      810.40   yes
+ *                  100000         9644.56     8158.12     8928.44   yes
+ *                  1000000      101678.54   109784.17   111429.58   yes
+ *
+ * On one core nothing can speed up; what the table shows is the overhead. The pool's
+ * fork-join is 5x cheaper than an OpenMP region, and at n = 100000 (where both split
+ * the work) the pool stays at the serial time while the OpenMP versions pay for the region.
+ * At n = 10000 only the pool splits (its grain is smaller), which on one core is pure cost.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <climits>
+#include <omp.h>
+#include "thread_pool.hpp"
+#include "parallel_sort.hpp"
+#include "random.hpp"
+using namespace std;
+
+// Average microseconds per call of f over enough repetitions to total ~0.2 s.
+template <class F>
+double microseconds(F &&f)
+{
+    f(); // warm up: first-touch, pool wake-up
+    long long reps = 1;
+    double elapsed = 0;
+    while (true)
+    {
+        double start = omp_get_wtime();
+        for (long long r = 0; r < reps; r++)
+            f();
+        elapsed = omp_get_wtime() - start;
+        if (elapsed > 0.2)
+            break;
+        reps *= 4;
+    }
+    return elapsed / reps * 1e6;
+}
+
+struct MinMax
+{
+    int min = INT_MAX, max = INT_MIN;
+    bool operator==(const MinMax &) const = default;
+};
+
+int main()
+{
+    int threads;
+    cout << "Enter the number of threads: ";
+    cin >> threads;
+
+    if (threads <= 0)
+    {
+        cout << "Invalid number of threads!" << endl;
+        return 1;
+    }
+
+    omp_set_num_threads(threads);
+    hpc::thread_pool pool(threads);
+    cout << "\nThreads: " << threads << " (pool spin " << pool.spin().count() << " us, "
+         << thread::hardware_concurrency() << " hardware threads)\n" << endl;
+    cout << fixed << setprecision(3);
+
+    // The bare cost of starting and joining a team
+    volatile int sink = 0;
+    double ompEmpty = microseconds([&] {
+#pragma omp parallel num_threads(threads)
+        {
+            if (omp_get_thread_num() == threads) // never true; keeps the region
+                sink = 1;
+        }
+    });
+    double poolEmpty = microseconds([&] {
+        pool.run([&](int t, int) {
+            if (t == threads)
+                sink = 1;
+        });
+    });
+    cout << "Empty fork-join          omp parallel: " << setw(8) << ompEmpty << " us   pool.run: " << setw(8)
+         << poolEmpty << " us\n" << endl;
+
+    auto minmax = hpc::make_reduction(
+        MinMax{}, [](MinMax a, MinMax b) { return MinMax{min(a.min, b.min), max(a.max, b.max)}; },
+        [](MinMax &acc, int x) {
+            acc.min = min(acc.min, x);
+            acc.max = max(acc.max, x);
+        });
+    auto sum = hpc::reducers::sum<long long>();
+
+    cout << setprecision(2);
+    for (const char *kernel : {"sum", "min/max", "sort"})
+    {
+        cout << left << setw(15) << kernel << setw(10) << "n" << right << setw(12) << "serial (us)" << setw(12)
+             << "omp (us)" << setw(12) << "pool (us)" << "   match" << endl;
+        for (int n : {1000, 10000, 100000, 1000000})
+        {
+            vector<int> data = hpc::random_vector<int>(n, hpc::distribution::uniform, 7);
+            double serial, omp, viaPool;
+            bool match;
+            if (kernel == string("sum"))
+            {
+                long long a = 0, b = 0, c = 0;
+                serial = microseconds([&] { a = hpc::detail::reduce_slice(data.begin(), 0, n, sum); });
+                omp = microseconds([&] { b = hpc::parallel_reduce(data, sum); });
+                viaPool = microseconds([&] { c = hpc::parallel_reduce(pool, data, sum); });
+                match = a == b && b == c;
+            }
+            else if (kernel == string("min/max"))
+            {
+                MinMax a, b, c;
+                serial = microseconds([&] { a = hpc::detail::reduce_slice(data.begin(), 0, n, minmax); });
+                omp = microseconds([&] { b = hpc::parallel_reduce(data, minmax); });
+                viaPool = microseconds([&] { c = hpc::parallel_reduce(pool, data, minmax); });
+                match = a == b && b == c;
+            }
+            else
+            {
+                // Each repetition sorts a fresh copy; the copy is timed on its own and subtracted.
+                // A lambda comparator keeps hpc::parallel_sort on comparison sorts (no radix).
+                auto byValue = [](int x, int y) { return x < y; };
+                vector<int> a, b, c, work;
+                double copy = microseconds([&] { work = data; });
+                serial = microseconds([&] { a = data; sort(a.begin(), a.end(), byValue); }) - copy;
+                omp = microseconds([&] { b = data; hpc::parallel_sort(b, byValue); }) - copy;
+                viaPool = microseconds([&] { c = data; hpc::parallel_sort(pool, c, byValue); }) - copy;
+                match = a == b && b == c;
+            }
+            cout << left << setw(15) << "" << setw(10) << n << right << setw(12) << serial << setw(12) << omp
+                 << setw(12) << viaPool << "   " << (match ? "yes" : "NO") << endl;
+        }
+    }
+    return 0;
+}
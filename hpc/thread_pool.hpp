@@ -0,0 +1,406 @@
+/*
+ * Persistent Spinning/Parking Thread Pool (header-only)
+ * =====================================================
+ *
+ * Every `#pragma omp parallel` is a fork-join: wake the team, hand out the work, wait at
+ * the closing barrier. On large arrays that cost disappears, but for a reduction over
+ * 10,000 elements (a few microseconds of work) it is most of the run time, which is why
+ * the parallel min/max in MIN_MAX_mine.cpp loses to the serial loop. This pool keeps its
+ * workers alive between calls, spinning for a short while on a shared epoch word and only
+ * then parking in the kernel, so back-to-back small jobs are dispatched through one cache
+ * line instead of a syscall.
+ *
+ * USAGE:
+ *
+ *   #include "thread_pool.hpp"
+ *
+ *   hpc::thread_pool &pool = hpc::thread_pool::global();   // omp_get_max_threads() threads
+ *   pool.run([&](int t, int nt) { ... slice t of nt ... }); // fork-join, caller is t = 0
+ *
+ *   hpc::parallel_for(pool, 0, n, [&](std::ptrdiff_t i) { y[i] += a * x[i]; });
+ *   long long sum = hpc::parallel_reduce(pool, v.begin(), v.end(), hpc::reducers::sum<long long>());
+ *   hpc::parallel_sort(pool, v.begin(), v.end());
+ *
+ * COMPILATION:
+ *   g++ -std=c++20 -O2 -fopenmp -o program program.cpp
+ *
+ * DISPATCH:
+ * --------
+ * - The caller writes the job (a function pointer and a context pointer), then bumps a
+ *   64-bit epoch whose low 16 bits carry the number of threads taking part. Workers that
+ *   are not taking part only ever read the epoch, so they never race with the next job.
+ * - Idle workers spin on the epoch for `spin` (default 50 us), then sleep in
+ *   std::atomic::wait. The caller only pays for notify_all when someone is asleep.
+ * - The caller runs slice 0 itself and then spins on a count of outstanding workers.
+ *   No barrier and no allocation on the fast path; one uncontended mutex lock.
+ * - When the pool has more threads than the machine has cores, spinning only steals time
+ *   from the thread being waited for, so the default spin drops to zero.
+ *
+ * ERROR HANDLING:
+ * --------------
+ * - An exception thrown by any slice is caught, the job still joins, and the first one is
+ *   rethrown from run().
+ * - run() from inside a job of the same pool runs the nested job inline on the calling
+ *   thread. Concurrent run() calls from different outside threads are serialized.
+ *
+ * ALGORITHMS:
+ * ----------
+ * - parallel_for / parallel_for_blocks: static contiguous slices, like `schedule(static)`
+ * - parallel_reduce: the reduce.hpp reductions (identity, accumulate, combine, kernel);
+ *   partials are combined by the caller in slice order, so combine need not commute
+ * - parallel_sort: each thread sorts a block, then log2(p) rounds of pairwise merges
+ * The grains are 4x smaller than the OpenMP versions': a cheaper fork-join pays off on
+ * smaller inputs.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <omp.h>
+#include "reduce.hpp"
+
+namespace hpc
+{
+
+namespace detail
+{
+
+constexpr std::ptrdiff_t pool_for_grain = 1 << 10;
+constexpr std::ptrdiff_t pool_reduce_grain = 1 << 12;
+constexpr std::ptrdiff_t pool_sort_grain = 1 << 12;
+
+// Tells the core this is a spin-wait loop (frees pipeline resources for the sibling
+// hyperthread and avoids a memory-order mis-speculation on exit).
+inline void cpu_relax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+} // namespace detail
+
+class thread_pool
+{
+public:
+    // threads counts the caller: thread_pool(4) starts 3 workers. A negative spin picks
+    // the default (50 us, or 0 when oversubscribed).
+    explicit thread_pool(int threads = omp_get_max_threads(),
+                         std::chrono::microseconds spin = std::chrono::microseconds(-1))
+        : threads_(std::clamp(threads, 1, max_threads))
+    {
+        spin_ = spin.count() >= 0 ? spin : default_spin(threads_);
+        workers_.reserve(threads_ - 1);
+        for (int i = 1; i < threads_; i++)
+            workers_.emplace_back([this, i] { worker(i); });
+    }
+
+    thread_pool(const thread_pool &) = delete;
+    thread_pool &operator=(const thread_pool &) = delete;
+
+    ~thread_pool()
+    {
+        stop_.store(true, std::memory_order_relaxed);
+        publish(0);
+        for (std::thread &w : workers_)
+            w.join();
+    }
+
+    // Process-wide pool, created on first use with omp_get_max_threads() threads.
+    static thread_pool &global()
+    {
+        static thread_pool pool;
+        return pool;
+    }
+
+    int size() const noexcept
+    {
+        return threads_;
+    }
+
+    std::chrono::microseconds spin() const noexcept
+    {
+        return spin_;
+    }
+
+    // Calls fn(t, nt) for t in [0, nt) on nt = min(threads, size()) threads and returns
+    // when all calls have returned. The calling thread runs t = 0.
+    template <class F>
+    void run(int threads, F &&fn)
+    {
+        using Fn = std::remove_reference_t<F>;
+        const int nt = std::clamp(threads, 1, threads_);
+        if (nt == 1 || current_pool() == this)
+        {
+            fn(0, 1);
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(run_mutex_);
+        job_ = const_cast<void *>(static_cast<const void *>(std::addressof(fn)));
+        invoke_ = [](void *f, int t, int n) { (*static_cast<Fn *>(f))(t, n); };
+        error_ = nullptr;
+        pending_.store(nt - 1, std::memory_order_relaxed);
+        publish(nt);
+
+        thread_pool *outer = std::exchange(current_pool(), this);
+        try
+        {
+            fn(0, nt);
+        }
+        catch (...)
+        {
+            record_error();
+        }
+        current_pool() = outer;
+
+        // Oversubscribed (spin 0): the workers we wait for may need this very core.
+        const int spin_limit = spin_.count() > 0 ? 4096 : 0;
+        for (int spins = 0; pending_.load(std::memory_order_acquire) != 0; spins++)
+        {
+            detail::cpu_relax();
+            if (spins >= spin_limit)
+                std::this_thread::yield(); // a worker is still busy or was preempted
+        }
+        if (error_)
+            std::rethrow_exception(error_);
+    }
+
+    template <class F>
+    void run(F &&fn)
+    {
+        run(threads_, std::forward<F>(fn));
+    }
+
+private:
+    static constexpr int max_threads = 0xFFFF;
+
+    static std::chrono::microseconds default_spin(int threads)
+    {
+        const unsigned cores = std::thread::hardware_concurrency();
+        return std::chrono::microseconds(cores != 0 && unsigned(threads) > cores ? 0 : 50);
+    }
+
+    static thread_pool *&current_pool()
+    {
+        thread_local thread_pool *pool = nullptr;
+        return pool;
+    }
+
+    // New epoch carrying the thread count. seq_cst on both sides of the sleeper check:
+    // either the caller sees the sleeper, or the sleeper sees the new epoch before waiting.
+    void publish(int nt)
+    {
+        const std::uint64_t next = ((epoch_.load(std::memory_order_relaxed) >> 16) + 1) << 16 | std::uint64_t(nt);
+        epoch_.store(next, std::memory_order_seq_cst);
+        if (sleepers_.load(std::memory_order_seq_cst) != 0)
+            epoch_.notify_all();
+    }
+
+    void record_error()
+    {
+        std::lock_guard<std::mutex> lock(error_mutex_);
+        if (!error_)
+            error_ = std::current_exception();
+    }
+
+    void worker(int index)
+    {
+        using clock = std::chrono::steady_clock;
+        current_pool() = this;
+        std::uint64_t seen = 0;
+        for (;;)
+        {
+            std::uint64_t epoch = epoch_.load(std::memory_order_acquire);
+            if (epoch == seen && spin_.count() > 0)
+            {
+                // Check the clock only every 64 pauses; it costs more than the pause.
+                const clock::time_point deadline = clock::now() + spin_;
+                for (int spins = 1; (epoch = epoch_.load(std::memory_order_acquire)) == seen; spins++)
+                {
+                    detail::cpu_relax();
+                    if (spins % 64 == 0 && clock::now() > deadline)
+                        break;
+                }
+            }
+            while (epoch == seen)
+            {
+                sleepers_.fetch_add(1, std::memory_order_seq_cst);
+                epoch_.wait(seen, std::memory_order_seq_cst);
+                sleepers_.fetch_sub(1, std::memory_order_relaxed);
+                epoch = epoch_.load(std::memory_order_acquire);
+            }
+            seen = epoch;
+
+            if (stop_.load(std::memory_order_relaxed))
+                return;
+            const int nt = static_cast<int>(epoch & 0xFFFF);
+            if (index >= nt)
+                continue;
+            try
+            {
+                invoke_(job_, index, nt);
+            }
+            catch (...)
+            {
+                record_error();
+            }
+            pending_.fetch_sub(1, std::memory_order_release);
+        }
+    }
+
+    int threads_;
+    std::chrono::microseconds spin_;
+    std::vector<std::thread> workers_;
+
+    // The epoch and the join counter are the only hot shared words; keep them apart.
+    alignas(64) std::atomic<std::uint64_t> epoch_{0};
+    alignas(64) std::atomic<int> pending_{0};
+    alignas(64) std::atomic<int> sleepers_{0};
+    std::atomic<bool> stop_{false};
+
+    void *job_ = nullptr;
+    void (*invoke_)(void *, int, int) = nullptr;
+    std::exception_ptr error_;
+    std::mutex error_mutex_;
+    std::mutex run_mutex_;
+};
+
+namespace detail
+{
+
+inline int pool_threads(const thread_pool &pool, std::ptrdiff_t n, std::ptrdiff_t grain)
+{
+    return static_cast<int>(std::clamp<std::ptrdiff_t>(n / grain, 1, pool.size()));
+}
+
+} // namespace detail
+
+// fn(lo, hi) once per thread on contiguous blocks of [begin, end).
+template <class F>
+void parallel_for_blocks(thread_pool &pool, std::ptrdiff_t begin, std::ptrdiff_t end, F &&fn,
+                         std::ptrdiff_t grain = detail::pool_for_grain)
+{
+    const std::ptrdiff_t n = end - begin;
+    if (n <= 0)
+        return;
+    pool.run(detail::pool_threads(pool, n, std::max<std::ptrdiff_t>(grain, 1)), [&](int t, int nt) {
+        fn(begin + n * t / nt, begin + n * (t + 1) / nt);
+    });
+}
+
+// fn(i) for every i in [begin, end).
+template <class F>
+void parallel_for(thread_pool &pool, std::ptrdiff_t begin, std::ptrdiff_t end, F &&fn,
+                  std::ptrdiff_t grain = detail::pool_for_grain)
+{
+    parallel_for_blocks(
+        pool, begin, end,
+        [&](std::ptrdiff_t lo, std::ptrdiff_t hi) {
+            for (std::ptrdiff_t i = lo; i < hi; i++)
+                fn(i);
+        },
+        grain);
+}
+
+// Same contract and result as hpc::parallel_reduce(first, last, r, base_index).
+template <std::random_access_iterator It, class Acc, class Combine, class Accumulate, class Kernel>
+Acc parallel_reduce(thread_pool &pool, It first, It last, const reduction<Acc, Combine, Accumulate, Kernel> &r,
+                    std::size_t base_index = 0)
+{
+    const std::ptrdiff_t n = last - first;
+    const int threads = detail::pool_threads(pool, n, detail::pool_reduce_grain);
+    if (threads == 1)
+        return detail::reduce_slice(first, 0, n, r, base_index);
+
+    // p is small: one pass by the caller beats a log2(p)-round tree that needs barriers.
+    std::vector<detail::cache_padded<Acc>> partial(threads, {r.identity});
+    pool.run(threads, [&](int t, int nt) {
+        partial[t].value = detail::reduce_slice(first, n * t / nt, n * (t + 1) / nt, r, base_index);
+    });
+    Acc acc = std::move(partial[0].value);
+    for (int t = 1; t < threads; t++)
+        acc = r.combine(acc, partial[t].value);
+    return acc;
+}
+
+template <std::ranges::random_access_range Range, class Acc, class Combine, class Accumulate, class Kernel>
+Acc parallel_reduce(thread_pool &pool, Range &&range, const reduction<Acc, Combine, Accumulate, Kernel> &r,
+                    std::size_t base_index = 0)
+{
+    return parallel_reduce(pool, std::ranges::begin(range), std::ranges::end(range), r, base_index);
+}
+
+// Unstable sort of [first, last): std::sort per block, then pairwise std::merge rounds
+// between [first, last) and a buffer. The last round is one serial merge of n elements,
+// so this is meant for the small and medium inputs the pool exists for; large inputs are
+// better served by hpc::parallel_sort's parallel merges.
+template <std::random_access_iterator RandomIt, class Compare = std::less<>>
+void parallel_sort(thread_pool &pool, RandomIt first, RandomIt last, Compare comp = {})
+{
+    using T = std::iter_value_t<RandomIt>;
+    const std::ptrdiff_t n = last - first;
+    const int threads = detail::pool_threads(pool, n, detail::pool_sort_grain);
+    if (threads == 1)
+    {
+        std::sort(first, last, comp);
+        return;
+    }
+
+    std::vector<std::ptrdiff_t> bound(threads + 1);
+    for (int t = 0; t <= threads; t++)
+        bound[t] = n * t / threads;
+    pool.run(threads, [&](int t, int) { std::sort(first + bound[t], first + bound[t + 1], comp); });
+
+    std::vector<T> buffer(n);
+    bool inBuffer = false;
+    for (int width = 1; width < threads; width *= 2)
+    {
+        // Pair p merges runs [2p*width, (2p+1)*width) and [(2p+1)*width, (2p+2)*width);
+        // an unpaired last run is copied across so every round switches sides.
+        const int pairs = (threads + 2 * width - 1) / (2 * width);
+        auto step = [&](auto src, auto dst) {
+            pool.run(pairs, [&](int p, int) {
+                const int a = 2 * p * width;
+                const int b = std::min(a + width, threads), c = std::min(a + 2 * width, threads);
+                if (b == c)
+                    std::move(src + bound[a], src + bound[c], dst + bound[a]);
+                else
+                    std::merge(std::make_move_iterator(src + bound[a]), std::make_move_iterator(src + bound[b]),
+                               std::make_move_iterator(src + bound[b]), std::make_move_iterator(src + bound[c]),
+                               dst + bound[a], comp);
+            });
+        };
+        if (inBuffer)
+            step(buffer.begin(), first);
+        else
+            step(first, buffer.begin());
+        inBuffer = !inBuffer;
+    }
+    if (inBuffer)
+        parallel_for_blocks(pool, 0, n, [&](std::ptrdiff_t lo, std::ptrdiff_t hi) {
+            std::move(buffer.begin() + lo, buffer.begin() + hi, first + lo);
+        });
+}
+
+template <std::ranges::random_access_range Range, class Compare = std::less<>>
+void parallel_sort(thread_pool &pool, Range &&range, Compare comp = {})
+{
+    parallel_sort(pool, std::ranges::begin(range), std::ranges::end(range), comp);
+}
+
+} // namespace hpc
@@ -0,0 +1,157 @@
+/*
+ * Matrix Transpose and Layout Conversion Bandwidth using transpose.hpp
+ * ====================================================================
+ *
+ * COMPILATION & EXECUTION:
+ *
+ * For Ubuntu:
+ * -----------
+ * g++ -std=c++20 -O2 -fopenmp -o transpose transpose.cpp
+ * ./transpose
+ *
+ * For macOS:
+ * ----------
+ * g++ -std=c++20 -O2 -Xpreprocessor -fopenmp -I"$(brew --prefix libomp)/include" -L"$(brew --prefix libomp)/lib" -lomp -o transpose transpose.cpp
+ * ./transpose
+ *
+ * THEORETICAL CONCEPTS:
+ *
+ * Row-Major vs Column-Major:
+ * -------------------------
+ * - Element (i, j) of an n x n matrix is at i * n + j in row-major order (C, metrixmul.cu)
+ *   and at j * n + i in column-major order (Fortran, BLAS, cuBLAS). Converting one into
+ *   the other is a transpose
+ *
+ * Why the Naive Loop is Slow:
+ * --------------------------
+ * - dst[j * n + i] = src[i * n + j] reads rows but writes columns: every write lands on a
+ *   different cache line and, for n >= 1024 floats, on a different 4 KB page. Each line is
+ *   evicted before its other 15 elements are written, and the TLB misses on every write
+ * - Splitting the matrix recursively until a block fits in L1 makes both sides of the copy
+ *   walk whole cache lines; transposing 8 x 8 tiles in registers makes every load and store
+ *   a full vector
+ * - Out of cache that is still not enough: every destination line is a write miss on a
+ *   different page. Non-temporal stores of whole lines avoid reading those lines first
+ *
+ * Bandwidth:
+ * ---------
+ * - GB/s = 2 x matrix bytes / time (every byte is read once and written once). A parallel
+ *   memcpy of the same bytes is the ceiling: a transpose moves exactly the same data
+ *
+ * SAMPLE INPUT/OUTPUT:
+ * ------------------
+ *
+ * Input:
+ *   8192                         (Matrix size n, n x n)
+ *
+ * Output (single core, AVX-512 machine):
+ *   Threads: 1, kernels: AVX-512, 8192 x 8192
+ *
+ *   type    operation                    seconds      GB/s   check
+ *   float   memcpy (parallel)             0.0455     11.79   ok
+ *   float   naive loop                    1.9808      0.27   ok
+ *   float   transpose                     0.0680      7.90   ok
+ *   float   transpose_inplace             0.1108      4.85   ok
+ *   float   to_blocked 64 x 64            0.0905      5.94   ok
+ *   float   blocked -> column-major       0.0664      8.09   ok
+ *   double  memcpy (parallel)             0.0940     11.42   ok
+ *   double  naive loop                    2.3169      0.46   ok
+ *   double  transpose                     0.1527      7.03   ok
+ *   double  transpose_inplace             0.1738      6.18   ok
+ *   double  to_blocked 64 x 64            0.1449      7.41   ok
+ *   double  blocked -> column-major       0.1418      7.57   ok
+ *
+ * The naive loop runs at 2-4% of memcpy, the tiled transposes at 50-70%. Without the
+ * streaming stores the out-of-place transpose managed 1.9 GB/s here: the in-place one never
+ * writes a line it has not just read, and is already at 5-6 GB/s without them.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <omp.h>
+#include "transpose.hpp"
+#include "random.hpp"
+using namespace std;
+
+// Best of 3 runs, after one warm-up.
+template <class F>
+double bestOf3(F &&f)
+{
+    f();
+    double best = 1e30;
+    for (int rep = 0; rep < 3; rep++)
+    {
+        double start = omp_get_wtime();
+        f();
+        best = min(best, omp_get_wtime() - start);
+    }
+    return best;
+}
+
+template <class T>
+void benchmark(const string &type, size_t n)
+{
+    // hpc::vec: 64-byte aligned, so large transposes can use whole-line streaming stores.
+    hpc::vec<T> A(n * n), B(n * n), C(n * n), T1(hpc::blocked_size(n, n, 64, 64));
+    hpc::parallel_fill_uniform(A.begin(), A.end(), T(-1), T(1), 1);
+    const double bytes = 2.0 * sizeof(T) * n * n;
+    const long long len = static_cast<long long>(n);
+
+    auto same = [](const hpc::vec<T> &x, const hpc::vec<T> &y) { return equal(x.begin(), x.end(), y.begin()); };
+    auto report = [&](const string &name, double seconds, bool ok) {
+        cout << left << setw(8) << type << setw(26) << name << right << fixed << setprecision(4) << setw(10) << seconds
+             << setprecision(2) << setw(10) << bytes / seconds / 1e9 << "   " << (ok ? "ok" : "WRONG") << endl;
+    };
+
+    double t = bestOf3([&] {
+        hpc::convert_layout(n, n, A.data(), n, hpc::matrix_layout::row_major, B.data(), n,
+                            hpc::matrix_layout::row_major);
+    });
+    report("memcpy (parallel)", t, same(B, A));
+
+    t = bestOf3([&] {
+#pragma omp parallel for
+        for (long long i = 0; i < len; i++)
+            for (long long j = 0; j < len; j++)
+                B[j * len + i] = A[i * len + j];
+    });
+    report("naive loop", t, true);
+
+    t = bestOf3([&] { hpc::transpose(n, n, A.data(), n, C.data(), n); });
+    report("transpose", t, same(B, C));
+
+    // bestOf3 runs it 4 times: an even number of in-place transposes leaves same(C, A).
+    C = A;
+    t = bestOf3([&] { hpc::transpose_inplace(n, C.data(), n); });
+    report("transpose_inplace", t, same(C, A));
+
+    t = bestOf3([&] { hpc::to_blocked(n, n, A.data(), n, hpc::matrix_layout::row_major, 64, 64, T1.data()); });
+    report("to_blocked 64 x 64", t, true);
+
+    t = bestOf3([&] { hpc::from_blocked(n, n, T1.data(), 64, 64, C.data(), n, hpc::matrix_layout::column_major); });
+    report("blocked -> column-major", t, same(B, C));
+}
+
+int main()
+{
+    size_t n;
+    cout << "Enter the matrix size: ";
+    cin >> n;
+
+    if (n == 0)
+    {
+        cout << "Invalid matrix size!" << endl;
+        return 1;
+    }
+
+    cout << "\nThreads: " << omp_get_max_threads() << ", kernels: " << hpc::simd_level_name(hpc::detected_simd_level())
+         << ", " << n << " x " << n << "\n" << endl;
+    cout << left << setw(8) << "type" << setw(26) << "operation" << right << setw(10) << "seconds" << setw(10)
+         << "GB/s" << "   check" << endl;
+    benchmark<float>("float", n);
+    benchmark<double>("double", n);
+    return 0;
+}
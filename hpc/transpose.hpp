@@ -0,0 +1,536 @@
+/*
+ * Parallel Matrix Transpose and Layout Conversion (header-only) using OpenMP Tasks and SIMD
+ * ========================================================================================
+ *
+ * Row-major, column-major and blocked (tiled) layouts of the same matrix, and the
+ * transposes between them. metrixmul.cu indexes row-major (row * N + col); cuBLAS,
+ * Fortran and most GPU libraries expect column-major. The two layouts are transposes of
+ * each other, and a naive transpose reads or writes with a stride of a whole row, touching
+ * one element per cache line and one page per row: 5-10x slower than copying the bytes.
+ *
+ * USAGE:
+ *
+ *   #include "transpose.hpp"
+ *
+ *   hpc::transpose(rows, cols, A, lda, B, ldb);          // B (cols x rows) = A^T, row-major
+ *   hpc::transpose_inplace(n, A, lda);                   // square, in place
+ *   hpc::convert_layout(rows, cols, A, lda, hpc::matrix_layout::row_major,
+ *                       B, ldb, hpc::matrix_layout::column_major);
+ *
+ *   std::vector<float> T(hpc::blocked_size(rows, cols, 64, 64));
+ *   hpc::to_blocked(rows, cols, A, lda, hpc::matrix_layout::row_major, 64, 64, T.data());
+ *   hpc::from_blocked(rows, cols, T.data(), 64, 64, B, ldb, hpc::matrix_layout::column_major);
+ *
+ * COMPILATION:
+ *   g++ -std=c++20 -O2 -fopenmp -o program program.cpp
+ * Any trivially copyable T works; 4- and 8-byte types (int32, float, int64, double) get the
+ * SIMD tile kernels, picked at run time as in gemm.hpp.
+ *
+ * ALGORITHM:
+ * ---------
+ * - Cache-oblivious recursion: split the longer side in half until a block's source and
+ *   destination fit in L1 (16 KB each), without knowing the cache sizes. Every level of the
+ *   memory hierarchy then sees blocks that fit it, and both matrices are walked in runs of
+ *   whole cache lines.
+ * - Leaf: 8 x 8 tiles of 4-byte elements (4 x 4 of 8-byte) are loaded as 8 row vectors,
+ *   transposed in registers with unpack / shuffle / permute, and stored as 8 row vectors,
+ *   so the leaf makes no strided accesses. The tiles are grouped into blocks whose rows are
+ *   one cache line (16 x 16 floats, 8 x 8 doubles). AVX-512 would only move the same bytes
+ *   in fewer instructions of a memory-bound kernel, so its level uses the AVX2 tiles.
+ * - Out of cache (streaming_threshold from vector_expr.hpp, 32 MB): every destination line
+ *   is a write miss, and write misses to lines on different pages drain from the store
+ *   buffer one at a time. Transposes that big instead walk panels of 16 source rows (16
+ *   sequential streams the hardware prefetcher follows), build each block in an L1 buffer,
+ *   and write its rows with non-temporal stores: whole lines, no read for ownership. This
+ *   needs a 64-byte aligned destination with a leading dimension of whole lines (hpc::vec).
+ * - In place (square): transpose A11 and A22 in place and swap A12 with A21^T; the swap
+ *   recurses like the out-of-place case, exchanging pairs of tiles at the leaves.
+ * - Blocked layout: the matrix cut into br x bc tiles, each stored row-major and
+ *   contiguously, tiles in row-major order, edge tiles zero-padded. This is what gemm.hpp's
+ *   packing produces for one block and what a tiled kernel wants to stream.
+ *
+ * PARALLELIZATION:
+ * ---------------
+ * - Recursive halves run as OpenMP tasks down to 2^16 elements; threads = clamp(rows * cols
+ *   / 2^16, 1, omp_get_max_threads()), one when called from a region that cannot nest.
+ *   Blocked conversion shares the tiles with a parallel for.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+#include <omp.h>
+#include "vector_expr.hpp"
+
+namespace hpc
+{
+
+enum class matrix_layout
+{
+    row_major,
+    column_major
+};
+
+namespace detail
+{
+
+// Recursion stops at blocks of this many bytes (source and destination both fit in L1).
+constexpr std::size_t transpose_leaf_bytes = 16 * 1024;
+
+// Blocks above this many elements are split into tasks.
+constexpr std::size_t transpose_grain = std::size_t(1) << 16;
+
+inline int transpose_threads(std::size_t elements)
+{
+    const int available = omp_get_active_level() < omp_get_max_active_levels() ? omp_get_max_threads() : 1;
+    return static_cast<int>(std::clamp<std::size_t>(elements / transpose_grain, 1, static_cast<std::size_t>(available)));
+}
+
+// dst (c x r) = src (r x c)^T, element by element.
+template <class T>
+inline void transpose_scalar(std::size_t r, std::size_t c, const T *src, std::size_t lds, T *dst, std::size_t ldd)
+{
+    for (std::size_t i = 0; i < r; i++)
+        for (std::size_t j = 0; j < c; j++)
+            dst[j * ldd + i] = src[i * lds + j];
+}
+
+// Tile kernels: K x K tiles. The scalar one lets the leaf loops below run unchanged.
+template <class T>
+struct scalar_tile
+{
+    static constexpr std::size_t K = 8;
+    static void transpose(const T *src, std::size_t lds, T *dst, std::size_t ldd)
+    {
+        transpose_scalar(K, K, src, lds, dst, ldd);
+    }
+};
+
+#ifdef HPC_X86_SIMD
+
+// 8 x 8 of 4-byte elements: 8 rows in 8 registers; unpack interleaves pairs of rows,
+// shuffle pairs of pairs, and permute2f128 exchanges the 128-bit halves.
+struct avx2_tile32
+{
+    static constexpr std::size_t K = 8;
+    template <class T>
+    __attribute__((target("avx2"))) static void transpose(const T *src, std::size_t lds, T *dst, std::size_t ldd)
+    {
+        const float *s = reinterpret_cast<const float *>(src);
+        float *d = reinterpret_cast<float *>(dst);
+        __m256 r0 = _mm256_loadu_ps(s), r1 = _mm256_loadu_ps(s + lds), r2 = _mm256_loadu_ps(s + 2 * lds),
+               r3 = _mm256_loadu_ps(s + 3 * lds), r4 = _mm256_loadu_ps(s + 4 * lds), r5 = _mm256_loadu_ps(s + 5 * lds),
+               r6 = _mm256_loadu_ps(s + 6 * lds), r7 = _mm256_loadu_ps(s + 7 * lds);
+        __m256 t0 = _mm256_unpacklo_ps(r0, r1), t1 = _mm256_unpackhi_ps(r0, r1), t2 = _mm256_unpacklo_ps(r2, r3),
+               t3 = _mm256_unpackhi_ps(r2, r3), t4 = _mm256_unpacklo_ps(r4, r5), t5 = _mm256_unpackhi_ps(r4, r5),
+               t6 = _mm256_unpacklo_ps(r6, r7), t7 = _mm256_unpackhi_ps(r6, r7);
+        r0 = _mm256_shuffle_ps(t0, t2, 0x44);
+        r1 = _mm256_shuffle_ps(t0, t2, 0xEE);
+        r2 = _mm256_shuffle_ps(t1, t3, 0x44);
+        r3 = _mm256_shuffle_ps(t1, t3, 0xEE);
+        r4 = _mm256_shuffle_ps(t4, t6, 0x44);
+        r5 = _mm256_shuffle_ps(t4, t6, 0xEE);
+        r6 = _mm256_shuffle_ps(t5, t7, 0x44);
+        r7 = _mm256_shuffle_ps(t5, t7, 0xEE);
+        _mm256_storeu_ps(d, _mm256_permute2f128_ps(r0, r4, 0x20));
+        _mm256_storeu_ps(d + ldd, _mm256_permute2f128_ps(r1, r5, 0x20));
+        _mm256_storeu_ps(d + 2 * ldd, _mm256_permute2f128_ps(r2, r6, 0x20));
+        _mm256_storeu_ps(d + 3 * ldd, _mm256_permute2f128_ps(r3, r7, 0x20));
+        _mm256_storeu_ps(d + 4 * ldd, _mm256_permute2f128_ps(r0, r4, 0x31));
+        _mm256_storeu_ps(d + 5 * ldd, _mm256_permute2f128_ps(r1, r5, 0x31));
+        _mm256_storeu_ps(d + 6 * ldd, _mm256_permute2f128_ps(r2, r6, 0x31));
+        _mm256_storeu_ps(d + 7 * ldd, _mm256_permute2f128_ps(r3, r7, 0x31));
+    }
+};
+
+// 4 x 4 of 8-byte elements.
+struct avx2_tile64
+{
+    static constexpr std::size_t K = 4;
+    template <class T>
+    __attribute__((target("avx2"))) static void transpose(const T *src, std::size_t lds, T *dst, std::size_t ldd)
+    {
+        const double *s = reinterpret_cast<const double *>(src);
+        double *d = reinterpret_cast<double *>(dst);
+        const __m256d r0 = _mm256_loadu_pd(s), r1 = _mm256_loadu_pd(s + lds), r2 = _mm256_loadu_pd(s + 2 * lds),
+                      r3 = _mm256_loadu_pd(s + 3 * lds);
+        const __m256d t0 = _mm256_unpacklo_pd(r0, r1), t1 = _mm256_unpackhi_pd(r0, r1), t2 = _mm256_unpacklo_pd(r2, r3),
+                      t3 = _mm256_unpackhi_pd(r2, r3);
+        _mm256_storeu_pd(d, _mm256_permute2f128_pd(t0, t2, 0x20));
+        _mm256_storeu_pd(d + ldd, _mm256_permute2f128_pd(t1, t3, 0x20));
+        _mm256_storeu_pd(d + 2 * ldd, _mm256_permute2f128_pd(t0, t2, 0x31));
+        _mm256_storeu_pd(d + 3 * ldd, _mm256_permute2f128_pd(t1, t3, 0x31));
+    }
+};
+
+#endif
+
+// Leaves work in L x L blocks whose rows are whole cache lines (16 x 16 floats, 8 x 8
+// doubles), each made of K x K register tiles. A block then reads and writes complete
+// lines, and nothing depends on a half-written line surviving in cache until its other
+// half comes: with power-of-two leading dimensions all rows of a block map to the same
+// cache set, and it would not.
+template <class Tile, class T>
+constexpr std::size_t line_block = std::max(Tile::K, 64 / sizeof(T) / Tile::K * Tile::K);
+
+template <class Tile, class T>
+inline void transpose_block(const T *src, std::size_t lds, T *dst, std::size_t ldd)
+{
+    constexpr std::size_t K = Tile::K, L = line_block<Tile, T>;
+    for (std::size_t i = 0; i < L; i += K)
+        for (std::size_t j = 0; j < L; j += K)
+            Tile::transpose(src + i * lds + j, lds, dst + j * ldd + i, ldd);
+}
+
+// Leaf: full blocks through Tile, the ragged right and bottom edges element by element.
+template <class Tile, class T>
+inline void transpose_tiles(std::size_t r, std::size_t c, const T *src, std::size_t lds, T *dst, std::size_t ldd)
+{
+    constexpr std::size_t L = line_block<Tile, T>;
+    const std::size_t r_full = r / L * L, c_full = c / L * L;
+    for (std::size_t i = 0; i < r_full; i += L)
+        for (std::size_t j = 0; j < c_full; j += L)
+            transpose_block<Tile>(src + i * lds + j, lds, dst + j * ldd + i, ldd);
+    transpose_scalar(r_full, c - c_full, src + c_full, lds, dst + c_full * ldd, ldd);
+    transpose_scalar(r - r_full, c, src + r_full * lds, lds, dst + r_full, ldd);
+}
+
+// Swap leaf: X (r x c at x) and Y (c x r at y) become Y^T and X^T, block pair by block pair.
+template <class Tile, class T>
+inline void swap_tiles(std::size_t r, std::size_t c, T *x, T *y, std::size_t ld)
+{
+    constexpr std::size_t L = line_block<Tile, T>;
+    alignas(64) T buffer[L * L];
+    const std::size_t r_full = r / L * L, c_full = c / L * L;
+    for (std::size_t i = 0; i < r_full; i += L)
+        for (std::size_t j = 0; j < c_full; j += L)
+        {
+            T *xb = x + i * ld + j, *yb = y + j * ld + i;
+            for (std::size_t row = 0; row < L; row++)
+                std::memcpy(buffer + row * L, xb + row * ld, L * sizeof(T));
+            transpose_block<Tile>(yb, ld, xb, ld);
+            transpose_block<Tile>(buffer, L, yb, ld);
+        }
+    for (std::size_t i = 0; i < r; i++)
+        for (std::size_t j = i < r_full ? c_full : 0; j < c; j++)
+            std::swap(x[i * ld + j], y[j * ld + i]);
+}
+
+// Diagonal leaf: an n x n block transposed in place.
+template <class Tile, class T>
+inline void inplace_tiles(std::size_t n, T *a, std::size_t ld)
+{
+    constexpr std::size_t L = line_block<Tile, T>;
+    alignas(64) T buffer[L * L];
+    const std::size_t n_full = n / L * L;
+    for (std::size_t i = 0; i < n_full; i += L)
+    {
+        T *d = a + i * ld + i;
+        for (std::size_t row = 0; row < L; row++)
+            std::memcpy(buffer + row * L, d + row * ld, L * sizeof(T));
+        transpose_block<Tile>(buffer, L, d, ld);
+        if (i + L < n_full)
+            swap_tiles<Tile>(L, n_full - i - L, d + L, d + L * ld, ld);
+    }
+    for (std::size_t i = 0; i < n; i++)
+        for (std::size_t j = std::max(i + 1, n_full); j < n; j++)
+            std::swap(a[i * ld + j], a[j * ld + i]);
+}
+
+// Streaming leaf for destinations that will not be read again soon: each L x L block is
+// transposed into an L1 buffer and its L rows, exactly one cache line each, are written with
+// non-temporal stores. dst and ldd must keep every block row on a line boundary.
+template <class Tile, class Line, class T>
+inline void transpose_stream(std::size_t r, std::size_t c, const T *src, std::size_t lds, T *dst, std::size_t ldd)
+{
+    constexpr std::size_t L = line_block<Tile, T>;
+    static_assert(L * sizeof(T) == 64, "a block row must be one cache line");
+    alignas(64) T buffer[L * L];
+    const std::size_t r_full = r / L * L, c_full = c / L * L;
+    for (std::size_t i = 0; i < r_full; i += L)
+        for (std::size_t j = 0; j < c_full; j += L)
+        {
+            transpose_block<Tile>(src + i * lds + j, lds, buffer, L);
+            for (std::size_t row = 0; row < L; row++)
+                Line::stream(reinterpret_cast<char *>(dst + (j + row) * ldd + i),
+                             reinterpret_cast<const char *>(buffer + row * L));
+        }
+    transpose_scalar(r_full, c - c_full, src + c_full, lds, dst + c_full * ldd, ldd);
+    transpose_scalar(r - r_full, c, src + r_full * lds, lds, dst + r_full, ldd);
+}
+
+// The leaves for one instruction set, as plain function pointers for the recursion.
+// stream is null where there are no non-temporal stores.
+template <class T>
+struct transpose_kernels
+{
+    void (*tiles)(std::size_t, std::size_t, const T *, std::size_t, T *, std::size_t);
+    void (*stream)(std::size_t, std::size_t, const T *, std::size_t, T *, std::size_t);
+    void (*swap)(std::size_t, std::size_t, T *, T *, std::size_t);
+    void (*inplace)(std::size_t, T *, std::size_t);
+    std::size_t L; // block side: recursion splits on multiples of it
+};
+
+#ifdef HPC_X86_SIMD
+
+template <class Tile, class T>
+__attribute__((target("avx2"), flatten)) void tiles_avx2(std::size_t r, std::size_t c, const T *src, std::size_t lds,
+                                                         T *dst, std::size_t ldd)
+{
+    transpose_tiles<Tile>(r, c, src, lds, dst, ldd);
+}
+
+template <class Tile, class T>
+__attribute__((target("avx2"), flatten)) void stream_avx2(std::size_t r, std::size_t c, const T *src, std::size_t lds,
+                                                          T *dst, std::size_t ldd)
+{
+    transpose_stream<Tile, avx2_line>(r, c, src, lds, dst, ldd);
+    _mm_sfence();
+}
+
+template <class Tile, class T>
+__attribute__((target("avx2"), flatten)) void swap_avx2(std::size_t r, std::size_t c, T *x, T *y, std::size_t ld)
+{
+    swap_tiles<Tile>(r, c, x, y, ld);
+}
+
+template <class Tile, class T>
+__attribute__((target("avx2"), flatten)) void inplace_avx2(std::size_t n, T *a, std::size_t ld)
+{
+    inplace_tiles<Tile>(n, a, ld);
+}
+
+#endif
+
+template <class T>
+transpose_kernels<T> select_transpose(simd_level level)
+{
+#ifdef HPC_X86_SIMD
+    if (level >= simd_level::avx2)
+    {
+        if constexpr (sizeof(T) == 4)
+            return {tiles_avx2<avx2_tile32, T>, stream_avx2<avx2_tile32, T>, swap_avx2<avx2_tile32, T>, inplace_avx2<avx2_tile32, T>,
+                    line_block<avx2_tile32, T>};
+        else if constexpr (sizeof(T) == 8)
+            return {tiles_avx2<avx2_tile64, T>, stream_avx2<avx2_tile64, T>, swap_avx2<avx2_tile64, T>, inplace_avx2<avx2_tile64, T>,
+                    line_block<avx2_tile64, T>};
+    }
+#endif
+    (void)level;
+    return {transpose_tiles<scalar_tile<T>, T>, nullptr, swap_tiles<scalar_tile<T>, T>, inplace_tiles<scalar_tile<T>, T>,
+            line_block<scalar_tile<T>, T>};
+}
+
+// Non-temporal stores into dst pay off once the matrix is too big to stay in cache, and
+// need every L x L block of dst to start on a cache line.
+template <class T>
+bool transpose_streams(const transpose_kernels<T> &k, std::size_t elements, const T *dst, std::size_t ldd)
+{
+    return k.stream && elements * sizeof(T) >= streaming_threshold &&
+           reinterpret_cast<std::uintptr_t>(dst) % 64 == 0 && ldd * sizeof(T) % 64 == 0;
+}
+
+// Split point of a side: half, rounded down to whole tiles.
+inline std::size_t transpose_half(std::size_t n, std::size_t K)
+{
+    return std::max(n / 2 / K * K, std::min(K, n / 2));
+}
+
+template <class T>
+void transpose_rec(std::size_t r, std::size_t c, const T *src, std::size_t lds, T *dst, std::size_t ldd,
+                   const transpose_kernels<T> &k, bool tasks)
+{
+    if (r * c * sizeof(T) <= transpose_leaf_bytes || (r <= k.L && c <= k.L))
+        return k.tiles(r, c, src, lds, dst, ldd);
+    tasks = tasks && r * c > transpose_grain;
+    if (r >= c)
+    {
+        const std::size_t h = transpose_half(r, k.L);
+#pragma omp task if (tasks)
+        transpose_rec(h, c, src, lds, dst, ldd, k, tasks);
+        transpose_rec(r - h, c, src + h * lds, lds, dst + h, ldd, k, tasks);
+    }
+    else
+    {
+        const std::size_t h = transpose_half(c, k.L);
+#pragma omp task if (tasks)
+        transpose_rec(r, h, src, lds, dst, ldd, k, tasks);
+        transpose_rec(r, c - h, src + h, lds, dst + h * ldd, ldd, k, tasks);
+    }
+#pragma omp taskwait
+}
+
+// X (r x c at x) <-> Y (c x r at y), both in the matrix with leading dimension ld.
+template <class T>
+void swap_rec(std::size_t r, std::size_t c, T *x, T *y, std::size_t ld, const transpose_kernels<T> &k, bool tasks)
+{
+    if (2 * r * c * sizeof(T) <= transpose_leaf_bytes || (r <= k.L && c <= k.L))
+        return k.swap(r, c, x, y, ld);
+    tasks = tasks && r * c > transpose_grain;
+    if (r >= c)
+    {
+        const std::size_t h = transpose_half(r, k.L);
+#pragma omp task if (tasks)
+        swap_rec(h, c, x, y, ld, k, tasks);
+        swap_rec(r - h, c, x + h * ld, y + h, ld, k, tasks);
+    }
+    else
+    {
+        const std::size_t h = transpose_half(c, k.L);
+#pragma omp task if (tasks)
+        swap_rec(r, h, x, y, ld, k, tasks);
+        swap_rec(r, c - h, x + h, y + h * ld, ld, k, tasks);
+    }
+#pragma omp taskwait
+}
+
+template <class T>
+void inplace_rec(std::size_t n, T *a, std::size_t ld, const transpose_kernels<T> &k, bool tasks)
+{
+    if (n * n * sizeof(T) <= transpose_leaf_bytes || n <= k.L)
+        return k.inplace(n, a, ld);
+    tasks = tasks && n * n > transpose_grain;
+    const std::size_t h = transpose_half(n, k.L);
+#pragma omp task if (tasks)
+    inplace_rec(h, a, ld, k, tasks);
+#pragma omp task if (tasks)
+    inplace_rec(n - h, a + h * ld + h, ld, k, tasks);
+    swap_rec(h, n - h, a + h, a + h * ld, ld, k, tasks);
+#pragma omp taskwait
+}
+
+// Runs f(tasks) on a team sized for `elements`, or directly on this thread.
+template <class F>
+void transpose_run(std::size_t elements, F &&f)
+{
+    const int threads = transpose_threads(elements);
+    if (threads == 1)
+        return f(false);
+#pragma omp parallel num_threads(threads)
+#pragma omp single
+    f(true);
+}
+
+} // namespace detail
+
+// dst (cols x rows, leading dimension ldd) = src (rows x cols, leading dimension lds)^T,
+// both row-major. Equivalently: src row-major -> dst column-major with the same shape.
+// The two matrices must not overlap. A level the CPU does not support falls back to the
+// detected one.
+template <class T>
+void transpose(std::size_t rows, std::size_t cols, const T *src, std::size_t lds, T *dst, std::size_t ldd,
+               simd_level level = detected_simd_level())
+{
+    static_assert(std::is_trivially_copyable_v<T>, "hpc::transpose copies elements as bytes");
+    if (rows == 0 || cols == 0)
+        return;
+    const auto kernels = detail::select_transpose<T>(std::min(level, detected_simd_level()));
+    if (detail::transpose_streams(kernels, rows * cols, dst, ldd))
+    {
+        // Panels of L source rows: L sequential read streams, whole-line writes.
+        const std::size_t L = kernels.L, panels = (rows + L - 1) / L;
+        const int threads = detail::transpose_threads(rows * cols);
+#pragma omp parallel for num_threads(threads) if (threads > 1) schedule(static)
+        for (std::size_t p = 0; p < panels; p++)
+            kernels.stream(std::min(L, rows - p * L), cols, src + p * L * lds, lds, dst + p * L, ldd);
+        return;
+    }
+    detail::transpose_run(rows * cols,
+                          [&](bool tasks) { detail::transpose_rec(rows, cols, src, lds, dst, ldd, kernels, tasks); });
+}
+
+// a (n x n, leading dimension lda) = a^T.
+template <class T>
+void transpose_inplace(std::size_t n, T *a, std::size_t lda, simd_level level = detected_simd_level())
+{
+    static_assert(std::is_trivially_copyable_v<T>, "hpc::transpose_inplace copies elements as bytes");
+    if (n < 2)
+        return;
+    const auto kernels = detail::select_transpose<T>(std::min(level, detected_simd_level()));
+    detail::transpose_run(n * n, [&](bool tasks) { detail::inplace_rec(n, a, lda, kernels, tasks); });
+}
+
+// The rows x cols matrix in layout `from` (leading dimension lds: row length for row-major,
+// column length for column-major) rewritten in layout `to`. Same layout is a row-by-row copy.
+template <class T>
+void convert_layout(std::size_t rows, std::size_t cols, const T *src, std::size_t lds, matrix_layout from, T *dst,
+                    std::size_t ldd, matrix_layout to, simd_level level = detected_simd_level())
+{
+    if (from == matrix_layout::row_major && to == matrix_layout::column_major)
+        return transpose(rows, cols, src, lds, dst, ldd, level);
+    if (from == matrix_layout::column_major && to == matrix_layout::row_major)
+        return transpose(cols, rows, src, lds, dst, ldd, level);
+
+    const std::size_t lines = from == matrix_layout::row_major ? rows : cols;
+    const std::size_t length = from == matrix_layout::row_major ? cols : rows;
+    const int threads = detail::transpose_threads(rows * cols);
+#pragma omp parallel for num_threads(threads) if (threads > 1) schedule(static)
+    for (std::size_t i = 0; i < lines; i++)
+        std::memcpy(dst + i * ldd, src + i * lds, length * sizeof(T));
+}
+
+// Elements of a rows x cols matrix in the blocked layout (edge tiles padded to br x bc).
+inline std::size_t blocked_size(std::size_t rows, std::size_t cols, std::size_t br, std::size_t bc)
+{
+    return (rows + br - 1) / br * br * ((cols + bc - 1) / bc * bc);
+}
+
+// Matrix in layout `from` -> blocked layout: tile (I, J) at dst + (I * tiles_per_row + J) * br * bc,
+// row-major inside, zero outside the matrix.
+template <class T>
+void to_blocked(std::size_t rows, std::size_t cols, const T *src, std::size_t lds, matrix_layout from, std::size_t br,
+                std::size_t bc, T *dst, simd_level level = detected_simd_level())
+{
+    const auto kernels = detail::select_transpose<T>(std::min(level, detected_simd_level()));
+    const std::size_t tiles_r = (rows + br - 1) / br, tiles_c = (cols + bc - 1) / bc;
+    const int threads = detail::transpose_threads(rows * cols);
+#pragma omp parallel for collapse(2) num_threads(threads) if (threads > 1) schedule(static)
+    for (std::size_t ti = 0; ti < tiles_r; ti++)
+        for (std::size_t tj = 0; tj < tiles_c; tj++)
+        {
+            T *tile = dst + (ti * tiles_c + tj) * br * bc;
+            const std::size_t i0 = ti * br, j0 = tj * bc;
+            const std::size_t r = std::min(br, rows - i0), c = std::min(bc, cols - j0);
+            if (r < br || c < bc)
+                std::fill(tile, tile + br * bc, T());
+            if (from == matrix_layout::row_major)
+                for (std::size_t i = 0; i < r; i++)
+                    std::memcpy(tile + i * bc, src + (i0 + i) * lds + j0, c * sizeof(T));
+            else
+                detail::transpose_rec(c, r, src + j0 * lds + i0, lds, tile, bc, kernels, false);
+        }
+}
+
+// Blocked layout (as written by to_blocked) -> matrix in layout `to`.
+template <class T>
+void from_blocked(std::size_t rows, std::size_t cols, const T *src, std::size_t br, std::size_t bc, T *dst,
+                  std::size_t ldd, matrix_layout to, simd_level level = detected_simd_level())
+{
+    const auto kernels = detail::select_transpose<T>(std::min(level, detected_simd_level()));
+    const std::size_t tiles_r = (rows + br - 1) / br, tiles_c = (cols + bc - 1) / bc;
+    const bool stream = to == matrix_layout::column_major && br % kernels.L == 0 &&
+                        detail::transpose_streams(kernels, rows * cols, dst, ldd);
+    const int threads = detail::transpose_threads(rows * cols);
+#pragma omp parallel for collapse(2) num_threads(threads) if (threads > 1) schedule(static)
+    for (std::size_t ti = 0; ti < tiles_r; ti++)
+        for (std::size_t tj = 0; tj < tiles_c; tj++)
+        {
+            const T *tile = src + (ti * tiles_c + tj) * br * bc;
+            const std::size_t i0 = ti * br, j0 = tj * bc;
+            const std::size_t r = std::min(br, rows - i0), c = std::min(bc, cols - j0);
+            if (to == matrix_layout::row_major)
+                for (std::size_t i = 0; i < r; i++)
+                    std::memcpy(dst + (i0 + i) * ldd + j0, tile + i * bc, c * sizeof(T));
+            else if (stream)
+                kernels.stream(r, c, tile, bc, dst + j0 * ldd + i0, ldd);
+            else
+                detail::transpose_rec(r, c, tile, bc, dst + j0 * ldd + i0, ldd, kernels, false);
+        }
+}
+
+} // namespace hpc
@@ -1,5 +1,14 @@
-%%cu
+// Builds with nvcc or, through cuda_portable.hpp, as plain C++ on a CPU-only machine:
+//   nvcc -std=c++17 -Xcompiler -fopenmp -o vector_add vector_add.cu
+//   g++ -std=c++20 -O2 -fopenmp -x c++ -o vector_add vector_add.cu
+// In a notebook (nvcc4jupyter), put %%cu on the first line of the cell.
+// ./vector_add --roofline (or --csv, --json) times the kernel over N = 2^12 ... 2^26
+// instead; see roofline.hpp.
 #include <iostream>
+#include "cuda_portable.hpp"
+#include "random.hpp"
+#include "buffer_pool.hpp"
+#include "roofline.hpp"
 using namespace std;
 
 __global__ void add(int* A, int* B, int* C, int size) {
@@ -11,10 +20,8 @@ __global__ void add(int* A, int* B, int* C, int size) {
 }
 
 
-void initialize(int* vector, int size) {
-    for (int i = 0; i < size; i++) {
-        vector[i] = rand() % 10;
-    }
+void initialize(int* vector, int size, int seed) {
+    hpc::parallel_fill_uniform(vector, vector + size, 0, 9, seed);
 }
 
 void print(int* vector, int size) {
@@ -24,19 +31,58 @@ void print(int* vector, int size) {
     cout << endl;
 }
 
-int main() {
+// C = A + B for N = 2^12 ... 2^26: N operations on 12 N bytes.
+int benchmark(hpc::roofline_format format) {
+    hpc::launch_reporting() = false;
+#ifdef __CUDACC__
+    hpc::roofline_report report(hpc::machine_peaks{"GPU"});
+#else
+    hpc::roofline_report report(hpc::measure_peaks());
+#endif
+    for (int N = 1 << 12; N <= 1 << 26; N *= 4) {
+        size_t vectorBytes = size_t(N) * sizeof(int);
+        hpc::pooled_buffer<int> A = hpc::buffer_pool::global().acquire<int>(N);
+        initialize(A.data(), N, 1);
+
+        int* X, * Y, * Z;
+        cudaMalloc(&X, vectorBytes);
+        cudaMalloc(&Y, vectorBytes);
+        cudaMalloc(&Z, vectorBytes);
+        cudaMemcpy(X, A.data(), vectorBytes, cudaMemcpyHostToDevice);
+        cudaMemcpy(Y, A.data(), vectorBytes, cudaMemcpyHostToDevice);
+
+        int threadsPerBlock = 256;
+        int blocksPerGrid = (N + threadsPerBlock - 1) / threadsPerBlock;
+        report.measure("add (vector_add.cu)", N, N, 3.0 * vectorBytes,
+                       [&] { hpc::launch<add>(blocksPerGrid, threadsPerBlock, X, Y, Z, N); });
+
+        cudaFree(X);
+        cudaFree(Y);
+        cudaFree(Z);
+    }
+    report.write(cout, format);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (auto format = hpc::roofline_arg(argc, argv))
+        return benchmark(*format);
+
     int N = 4;
     int* A, * B, * C;
 
     int vectorSize = N;
     size_t vectorBytes = vectorSize * sizeof(int);
 
-    A = new int[vectorSize];
-    B = new int[vectorSize];
-    C = new int[vectorSize];
+    hpc::pooled_buffer<int> bufferA = hpc::buffer_pool::global().acquire<int>(vectorSize);
+    hpc::pooled_buffer<int> bufferB = hpc::buffer_pool::global().acquire<int>(vectorSize);
+    hpc::pooled_buffer<int> bufferC = hpc::buffer_pool::global().acquire<int>(vectorSize);
+    A = bufferA.data();
+    B = bufferB.data();
+    C = bufferC.data();
 
-    initialize(A, vectorSize);
-    initialize(B, vectorSize);
+    initialize(A, vectorSize, 1);
+    initialize(B, vectorSize, 2);
 
     cout << "Vector A: ";
     print(A, N);
@@ -54,16 +100,13 @@ int main() {
     int threadsPerBlock = 256;
     int blocksPerGrid = (N + threadsPerBlock - 1) / threadsPerBlock;
 
-    add<<<blocksPerGrid, threadsPerBlock>>>(X, Y, Z, N);
+    hpc::launch<add>(blocksPerGrid, threadsPerBlock, X, Y, Z, N);
 
     cudaMemcpy(C, Z, vectorBytes, cudaMemcpyDeviceToHost);
 
     cout << "Addition: ";
     print(C, N);
 
-    delete[] A;
-    delete[] B;
-    delete[] C;
 
     cudaFree(X);
     cudaFree(Y);
@@ -1,4 +1,11 @@
+// Builds with nvcc or, through cuda_portable.hpp, as plain C++ on a CPU-only machine:
+//   nvcc -std=c++17 -Xcompiler -fopenmp -o vector_addition vector_addition.cu
+//   g++ -std=c++20 -O2 -fopenmp -x c++ -o vector_addition vector_addition.cu
+// In a notebook (nvcc4jupyter), put %%cu on the first line of the cell.
 #include <iostream>
+#include "cuda_portable.hpp"
+#include "random.hpp"
+#include "buffer_pool.hpp"
 using namespace std;
 
 __global__ void add(int* A, int* B, int* C, int size) {
@@ -10,10 +17,8 @@ __global__ void add(int* A, int* B, int* C, int size) {
 }
 
 
-void initialize(int* vector, int size) {
-    for (int i = 0; i < size; i++) {
-        vector[i] = rand() % 10;
-    }
+void initialize(int* vector, int size, int seed) {
+    hpc::parallel_fill_uniform(vector, vector + size, 0, 9, seed);
 }
 
 void print(int* vector, int size) {
@@ -30,12 +35,15 @@ int main() {
     int vectorSize = N;
     size_t vectorBytes = vectorSize * sizeof(int);
 
-    A = new int[vectorSize];
-    B = new int[vectorSize];
-    C = new int[vectorSize];
+    hpc::pooled_buffer<int> bufferA = hpc::buffer_pool::global().acquire<int>(vectorSize);
+    hpc::pooled_buffer<int> bufferB = hpc::buffer_pool::global().acquire<int>(vectorSize);
+    hpc::pooled_buffer<int> bufferC = hpc::buffer_pool::global().acquire<int>(vectorSize);
+    A = bufferA.data();
+    B = bufferB.data();
+    C = bufferC.data();
 
-    initialize(A, vectorSize);
-    initialize(B, vectorSize);
+    initialize(A, vectorSize, 1);
+    initialize(B, vectorSize, 2);
 
     cout << "Vector A: ";
     print(A, N);
@@ -53,16 +61,13 @@ int main() {
     int threadsPerBlock = 256;
     int blocksPerGrid = (N + threadsPerBlock - 1) / threadsPerBlock;
 
-    add<<<blocksPerGrid, threadsPerBlock>>>(X, Y, Z, N);
+    hpc::launch<add>(blocksPerGrid, threadsPerBlock, X, Y, Z, N);
 
     cudaMemcpy(C, Z, vectorBytes, cudaMemcpyDeviceToHost);
 
     cout << "Addition: ";
     print(C, N);
 
-    delete[] A;
-    delete[] B;
-    delete[] C;
 
     cudaFree(X);
     cudaFree(Y);
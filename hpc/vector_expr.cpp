@@ -0,0 +1,152 @@
+/*
+ * Fused vs Unfused Vector Arithmetic: Memory Traffic and Time using vector_expr.hpp
+ * ================================================================================
+ *
+ * COMPILATION & EXECUTION:
+ *
+ * For Ubuntu:
+ * -----------
+ * g++ -std=c++20 -O2 -fopenmp -o vector_expr vector_expr.cpp
+ * ./vector_expr
+ *
+ * For macOS:
+ * ----------
+ * g++ -std=c++20 -O2 -Xpreprocessor -fopenmp -I"$(brew --prefix libomp)/include" -L"$(brew --prefix libomp)/lib" -lomp -o vector_expr vector_expr.cpp
+ * ./vector_expr
+ *
+ * THEORETICAL CONCEPTS:
+ *
+ * Temporaries:
+ * -----------
+ * - D = a * A + B - C written as one loop per operator (the vector_add.cu way) is
+ *   T1 = a * A; T2 = T1 + B; D = T2 - C. Every line reads and writes whole arrays, so
+ *   each intermediate result goes out to memory and comes back in
+ * - Per element, in 4-byte floats: pass 1 reads A and writes T1, pass 2 reads T1, B and
+ *   writes T2, pass 3 reads T2, C and writes D. A write is two transfers (the line is read
+ *   for ownership first), so that is 2 + 3 + 3 reads and 3 writes: 44 bytes
+ *
+ * Fusion:
+ * ------
+ * - Expression templates make a * A + B - C a type, not a value. The assignment compiles
+ *   to one loop that reads A, B and C once and writes D once: 3 reads, 1 write = 20 bytes
+ * - Non-temporal stores skip the read for ownership: 16 bytes
+ * - All three loops do the same arithmetic (two flops per element), far below what the
+ *   cores can do, so time follows bytes once the arrays no longer fit in cache
+ *
+ * SAMPLE INPUT/OUTPUT:
+ * ------------------
+ *
+ * Input:
+ *   67108864                     (Largest vector length)
+ *
+ * Output (single core, AVX-512; GB/s = modelled bytes above / time):
+ *   Threads: 1, kernels: AVX-512, D = a * A + B - C (float)
+ *
+ *   n            MB/array    unfused ms    fused ms    stream ms    unfused    fused   stream   speedup   check
+ *                                                                     GB/s     GB/s     GB/s
+ *   16384            0.07         0.012       0.003        0.006       59.6     97.5     41.8      3.60   match
+ *   131072           0.52         0.178       0.054        0.049       32.4     48.5     42.8      3.63   match
+ *   1048576          4.19         2.760       1.077        0.746       16.7     19.5     22.5      3.70   match
+ *   8388608         33.55        22.160      10.321        8.333       16.7     16.3     16.1      2.66   match
+ *   67108864       268.44       191.908      82.848       71.858       15.4     16.2     14.9      2.67   match
+ *
+ *   Moved-from vec: empty, reusable
+ *
+ * speedup = unfused over the faster fused column. Out of cache all three columns move
+ * bytes at the same ~16 GB/s, so the time ratio is the traffic ratio: 44 / 20 bytes plus
+ * the fork/joins saved. In cache the unfused loops also lose to the temporaries' extra
+ * loads and stores. Streaming stores cost more than they save while D fits in L1/L2
+ * (16384); from 4 MB up they are faster on their own, but leave D out of cache for
+ * whatever reads it next, which is why store_mode::automatic only streams from 32 MB.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <vector>
+#include <omp.h>
+#include "vector_expr.hpp"
+#include "random.hpp"
+using namespace std;
+
+// Best of 5 runs, after one warm-up.
+template <class F>
+double bestOf5(F &&f)
+{
+    f();
+    double best = 1e30;
+    for (int rep = 0; rep < 5; rep++)
+    {
+        double start = omp_get_wtime();
+        f();
+        best = min(best, omp_get_wtime() - start);
+    }
+    return best;
+}
+
+int main()
+{
+    size_t n;
+    cout << "Enter the largest vector length: ";
+    cin >> n;
+
+    if (n < 1024)
+    {
+        cout << "Invalid vector length!" << endl;
+        return 1;
+    }
+
+    cout << "\nThreads: " << omp_get_max_threads() << ", kernels: " << hpc::simd_level_name(hpc::detected_simd_level())
+         << ", D = a * A + B - C (float)\n" << endl;
+    cout << left << setw(11) << "n" << right << setw(10) << "MB/array" << setw(14) << "unfused ms" << setw(12)
+         << "fused ms" << setw(13) << "stream ms" << setw(11) << "unfused" << setw(9) << "fused" << setw(9) << "stream"
+         << setw(10) << "speedup" << "   check" << endl;
+    cout << left << setw(59) << "" << right << setw(11) << "GB/s" << setw(9) << "GB/s" << setw(9) << "GB/s" << endl;
+
+    vector<size_t> sizes;
+    for (size_t s = 1 << 14; s < n; s *= 8)
+        sizes.push_back(s);
+    sizes.push_back(n);
+
+    const float a = 2.0f;
+    for (size_t s : sizes)
+    {
+        hpc::vec<float> A(s), B(s), C(s), D(s), T1(s), T2(s), E(s);
+        hpc::parallel_fill_uniform(A.begin(), A.end(), -1.0f, 1.0f, 1);
+        hpc::parallel_fill_uniform(B.begin(), B.end(), -1.0f, 1.0f, 2);
+        hpc::parallel_fill_uniform(C.begin(), C.end(), -1.0f, 1.0f, 3);
+        const long long len = static_cast<long long>(s);
+
+        // One OpenMP loop per operator, temporaries allocated once outside the timing.
+        double tUnfused = bestOf5([&] {
+#pragma omp parallel for simd
+            for (long long i = 0; i < len; i++)
+                T1[i] = a * A[i];
+#pragma omp parallel for simd
+            for (long long i = 0; i < len; i++)
+                T2[i] = T1[i] + B[i];
+#pragma omp parallel for simd
+            for (long long i = 0; i < len; i++)
+                D[i] = T2[i] - C[i];
+        });
+        double tFused = bestOf5([&] { hpc::evaluate(E.data(), s, a * A + B - C, hpc::store_mode::cached); });
+        double tStream = bestOf5([&] { hpc::evaluate(E.data(), s, a * A + B - C, hpc::store_mode::streaming); });
+
+        const bool match = equal(D.begin(), D.end(), E.begin());
+        const double bytes = 4.0 * s;
+        cout << left << setw(11) << s << right << fixed << setprecision(2) << setw(10) << bytes / 1e6 << setprecision(3)
+             << setw(14) << tUnfused * 1e3 << setw(12) << tFused * 1e3 << setw(13) << tStream * 1e3 << setprecision(1)
+             << setw(11) << 11 * bytes / tUnfused / 1e9 << setw(9) << 5 * bytes / tFused / 1e9 << setw(9)
+             << 4 * bytes / tStream / 1e9 << setprecision(2) << setw(10) << tUnfused / min(tFused, tStream) << "   "
+             << (match ? "match" : "MISMATCH") << endl;
+    }
+
+    // A moved-from vec is empty and takes a new value like any other.
+    hpc::vec<float> X(1024, 1.0f), Y = std::move(X);
+    const bool emptied = X.size() == 0 && X.data() == nullptr;
+    X = Y;
+    X = 2.0f * X + Y;
+    const bool reused = X.size() == 1024 && all_of(X.begin(), X.end(), [](float x) { return x == 3.0f; });
+    cout << "\nMoved-from vec: " << (emptied && reused ? "empty, reusable" : "BROKEN") << endl;
+    return 0;
+}
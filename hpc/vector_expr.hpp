@@ -0,0 +1,555 @@
+/*
+ * Fused Element-Wise Vector Expressions (header-only) using Expression Templates and OpenMP
+ * ========================================================================================
+ *
+ * The add kernel in vector_add.cu computes C = A + B. Written the obvious way,
+ * D = a * A + B - C is three such loops: each reads its inputs and writes a temporary, so
+ * the data crosses the memory bus about three times, and two extra arrays are allocated.
+ * Here operators on hpc::vec build a small expression object instead of computing
+ * anything. The assignment then evaluates the whole expression in one parallel, vectorized
+ * loop, with no temporaries.
+ *
+ * USAGE:
+ *
+ *   #include "vector_expr.hpp"
+ *
+ *   hpc::vec<float> A(n), B(n), C(n), D(n);                    // 64-byte aligned, zeroed in parallel
+ *   D = 2.0f * A + B - C;                                      // one pass, no temporaries
+ *   D = hpc::max(A - B, 0.0f) / (hpc::abs(C) + 1.0f);         // min, max, abs, + - * /, unary -
+ *   D = hpc::map([](float a, float b) { return a > b ? a : b * b; }, A, B);   // any element-wise function
+ *   hpc::vec<double> E = 0.5 * hpc::view(x) + hpc::view(y);   // std::vector / raw pointer operands
+ *   hpc::evaluate(out.data(), n, A * B, hpc::store_mode::streaming);          // explicit destination
+ *
+ * COMPILATION:
+ *   g++ -std=c++20 -O2 -fopenmp -o program program.cpp
+ * The evaluation loop is compiled for AVX2 and AVX-512 with target attributes and the
+ * widest one the CPU supports is picked at run time, as in gemm.hpp.
+ *
+ * EXPRESSIONS:
+ * -----------
+ * - An expression is a tree of small structs (leaves hold a pointer and a size, scalars a
+ *   value). e[i] computes element i of the whole tree, and the evaluation loop inlines
+ *   every node into a single loop body.
+ * - Scalars take the element type of the vector they meet: 2.0 * A stays float for float A.
+ * - Operand sizes are checked when the expression is built; a mismatch throws
+ *   std::invalid_argument.
+ * - Leaves point into their vectors, so an expression saved with auto must not outlive them.
+ *   The destination may appear in the expression (A = A * A): element i is only ever read
+ *   before it is written.
+ *
+ * STORES:
+ * ------
+ * - A normal store first reads the destination's cache line into the cache (read for
+ *   ownership), so a write costs two transfers. A non-temporal (streaming) store writes
+ *   whole lines straight to memory: one transfer, and the inputs are not evicted.
+ * - It only pays when the result is too big to still be in cache when it is next used:
+ *   store_mode::automatic streams outputs of streaming_threshold bytes (32 MB) or more.
+ *   Elements are computed into a 256-byte tile and streamed out four cache lines at a time.
+ *
+ * PARALLELIZATION:
+ * ---------------
+ * - One contiguous slice per thread, boundaries on cache lines; threads =
+ *   clamp(n / 2^15, 1, omp_get_max_threads()), so short vectors stay serial.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <omp.h>
+#include "fused_stats.hpp"
+
+namespace hpc
+{
+
+enum class store_mode
+{
+    automatic, // streaming at streaming_threshold bytes and above
+    cached,
+    streaming
+};
+
+constexpr std::size_t streaming_threshold = std::size_t(32) << 20;
+
+template <class T>
+class vec;
+
+namespace detail
+{
+
+// Each thread gets at least this many elements.
+constexpr std::size_t expr_grain = std::size_t(1) << 15;
+
+// Size of a scalar operand: it matches any vector.
+constexpr std::size_t any_size = static_cast<std::size_t>(-1);
+
+struct expr_tag
+{
+};
+
+template <class E>
+concept expression = std::is_base_of_v<expr_tag, std::remove_cvref_t<E>>;
+
+template <class T>
+struct is_vec : std::false_type
+{
+};
+
+template <class T>
+struct is_vec<vec<T>> : std::true_type
+{
+};
+
+template <class A>
+concept vector_operand = expression<A> || is_vec<std::remove_cvref_t<A>>::value;
+
+template <class A>
+concept scalar_operand = std::is_arithmetic_v<std::remove_cvref_t<A>>;
+
+template <class A, class B>
+concept binary_operands = (vector_operand<A> && (vector_operand<B> || scalar_operand<B>)) ||
+                          (scalar_operand<A> && vector_operand<B>);
+
+template <class T>
+struct expr_leaf : expr_tag
+{
+    using value_type = T;
+
+    const T *data;
+    std::size_t n;
+
+    T operator[](std::size_t i) const { return data[i]; }
+    std::size_t size() const { return n; }
+};
+
+template <class T>
+struct expr_scalar : expr_tag
+{
+    using value_type = T;
+
+    T value;
+
+    T operator[](std::size_t) const { return value; }
+    static constexpr std::size_t size() { return any_size; }
+};
+
+template <class F, class... E>
+struct expr_node : expr_tag
+{
+    using value_type = std::remove_cvref_t<std::invoke_result_t<const F &, typename E::value_type...>>;
+
+    F f;
+    std::tuple<E...> args;
+    std::size_t n;
+
+    expr_node(F fn, E... operands) : f(std::move(fn)), args(std::move(operands)...), n(any_size)
+    {
+        for (std::size_t s : {operands.size()...})
+        {
+            if (n != any_size && s != any_size && s != n)
+                throw std::invalid_argument("vector expression: operands of different sizes");
+            if (s != any_size)
+                n = s;
+        }
+    }
+
+    value_type operator[](std::size_t i) const
+    {
+        return std::apply([&](const E &...e) { return f(e[i]...); }, args);
+    }
+    std::size_t size() const { return n; }
+};
+
+template <class A>
+struct operand_value
+{
+    using type = typename std::remove_cvref_t<A>::value_type;
+};
+
+// Operand -> expression. Scalars take the element type of the vector operand they meet.
+template <class Other, class A>
+auto as_expr(const A &a)
+{
+    if constexpr (expression<A>)
+        return a;
+    else if constexpr (is_vec<A>::value)
+        return expr_leaf<typename A::value_type>{{}, a.data(), a.size()};
+    else
+        return expr_scalar<typename operand_value<Other>::type>{{}, static_cast<typename operand_value<Other>::type>(a)};
+}
+
+template <class F, class A, class B>
+auto make_binary(F f, const A &a, const B &b)
+{
+    if constexpr (vector_operand<A>)
+        return expr_node(std::move(f), as_expr<A>(a), as_expr<A>(b));
+    else
+        return expr_node(std::move(f), as_expr<B>(a), as_expr<B>(b));
+}
+
+struct expr_min
+{
+    template <class T>
+    T operator()(T a, T b) const { return b < a ? b : a; }
+};
+
+struct expr_max
+{
+    template <class T>
+    T operator()(T a, T b) const { return a < b ? b : a; }
+};
+
+struct expr_abs
+{
+    template <class T>
+    T operator()(T a) const { return a < T(0) ? -a : a; }
+};
+
+// dst[lo .. hi) = e[lo .. hi) with ordinary stores.
+template <class T, class E>
+inline void expr_store(T *dst, const E &e, std::size_t lo, std::size_t hi)
+{
+#pragma omp simd
+    for (std::size_t i = lo; i < hi; i++)
+        dst[i] = static_cast<T>(e[i]);
+}
+
+// The same with non-temporal stores: cached stores up to the first cache line boundary,
+// then 256-byte tiles computed into a local buffer and streamed out one line at a time
+// by Line::stream, then cached stores for the rest.
+template <class Line, class T, class E>
+inline void expr_stream(T *dst, const E &e, std::size_t lo, std::size_t hi)
+{
+    constexpr std::size_t tile = 256 / sizeof(T);
+    const std::size_t misaligned = reinterpret_cast<std::uintptr_t>(dst + lo) % 64;
+    std::size_t i = std::min(hi, lo + (64 - misaligned) % 64 / sizeof(T));
+    expr_store(dst, e, lo, i);
+    for (; i + tile <= hi; i += tile)
+    {
+        alignas(64) T buffer[tile];
+#pragma omp simd
+        for (std::size_t j = 0; j < tile; j++)
+            buffer[j] = static_cast<T>(e[i + j]);
+        for (std::size_t line = 0; line < 4; line++)
+            Line::stream(reinterpret_cast<char *>(dst + i) + 64 * line,
+                         reinterpret_cast<const char *>(buffer) + 64 * line);
+    }
+    expr_store(dst, e, i, hi);
+}
+
+#ifdef HPC_X86_SIMD
+
+// One 64-byte line, aligned at both ends, written around the caches.
+struct sse_line
+{
+    static void stream(char *dst, const char *src)
+    {
+        for (int part = 0; part < 4; part++)
+            _mm_stream_si128(reinterpret_cast<__m128i *>(dst) + part,
+                             _mm_load_si128(reinterpret_cast<const __m128i *>(src) + part));
+    }
+};
+
+struct avx2_line
+{
+    __attribute__((target("avx2"))) static void stream(char *dst, const char *src)
+    {
+        _mm256_stream_si256(reinterpret_cast<__m256i *>(dst), _mm256_load_si256(reinterpret_cast<const __m256i *>(src)));
+        _mm256_stream_si256(reinterpret_cast<__m256i *>(dst) + 1,
+                            _mm256_load_si256(reinterpret_cast<const __m256i *>(src) + 1));
+    }
+};
+
+struct avx512_line
+{
+    __attribute__((target("avx512f"))) static void stream(char *dst, const char *src)
+    {
+        _mm512_stream_si512(reinterpret_cast<__m512i *>(dst), _mm512_load_si512(src));
+    }
+};
+
+// Streaming stores are weakly ordered: the fence makes them visible before the slice is
+// reported done (the implicit barrier of the parallel region).
+template <class T, class E>
+void expr_eval_scalar(T *dst, const E &e, std::size_t lo, std::size_t hi, bool stream)
+{
+    if (stream)
+    {
+        expr_stream<sse_line>(dst, e, lo, hi);
+        _mm_sfence();
+    }
+    else
+        expr_store(dst, e, lo, hi);
+}
+
+template <class T, class E>
+__attribute__((target("avx2,fma"), flatten)) void expr_eval_avx2(T *dst, const E &e, std::size_t lo, std::size_t hi,
+                                                                   bool stream)
+{
+    if (stream)
+    {
+        expr_stream<avx2_line>(dst, e, lo, hi);
+        _mm_sfence();
+    }
+    else
+        expr_store(dst, e, lo, hi);
+}
+
+template <class T, class E>
+__attribute__((target("avx512f,prefer-vector-width=512"), flatten)) void
+expr_eval_avx512(T *dst, const E &e, std::size_t lo, std::size_t hi, bool stream)
+{
+    if (stream)
+    {
+        expr_stream<avx512_line>(dst, e, lo, hi);
+        _mm_sfence();
+    }
+    else
+        expr_store(dst, e, lo, hi);
+}
+
+#else
+
+template <class T, class E>
+void expr_eval_scalar(T *dst, const E &e, std::size_t lo, std::size_t hi, bool)
+{
+    expr_store(dst, e, lo, hi);
+}
+
+#endif
+
+template <class T, class E>
+void expr_eval(T *dst, const E &e, std::size_t lo, std::size_t hi, bool stream, simd_level level)
+{
+#ifdef HPC_X86_SIMD
+    if (level == simd_level::avx512)
+        return expr_eval_avx512(dst, e, lo, hi, stream);
+    if (level == simd_level::avx2)
+        return expr_eval_avx2(dst, e, lo, hi, stream);
+#endif
+    expr_eval_scalar(dst, e, lo, hi, stream);
+}
+
+struct vec_free
+{
+    void operator()(void *p) const { std::free(p); }
+};
+
+} // namespace detail
+
+// dst[0 .. n) = e, in one parallel pass. Throws std::invalid_argument if e has a size
+// other than n. A level the CPU does not support falls back to the detected one.
+template <class T, detail::expression E>
+void evaluate(T *dst, std::size_t n, const E &e, store_mode mode = store_mode::automatic,
+              simd_level level = detected_simd_level())
+{
+    static_assert(64 % sizeof(T) == 0, "hpc::evaluate streams whole cache lines of T");
+    if (e.size() != detail::any_size && e.size() != n)
+        throw std::invalid_argument("vector expression: destination and expression sizes differ");
+    level = std::min(level, detected_simd_level());
+    const bool stream = mode == store_mode::streaming ||
+                        (mode == store_mode::automatic && n * sizeof(T) >= streaming_threshold);
+    const int threads = static_cast<int>(
+        std::clamp<std::size_t>(n / detail::expr_grain, 1, static_cast<std::size_t>(omp_get_max_threads())));
+    if (threads == 1)
+        return detail::expr_eval(dst, e, 0, n, stream, level);
+
+#pragma omp parallel num_threads(threads)
+    {
+        const std::size_t nt = omp_get_num_threads();
+        const std::size_t t = omp_get_thread_num();
+        // Slice boundaries on cache lines (for an aligned dst), so no two threads write one line.
+        const std::size_t line = 64 / sizeof(T);
+        const std::size_t begin = n * t / nt / line * line;
+        const std::size_t end = t + 1 == nt ? n : n * (t + 1) / nt / line * line;
+        detail::expr_eval(dst, e, begin, end, stream, level);
+    }
+}
+
+// Operand view of memory the caller owns.
+template <class T>
+detail::expr_leaf<T> view(const T *data, std::size_t n)
+{
+    return {{}, data, n};
+}
+
+template <class T, class Alloc>
+detail::expr_leaf<T> view(const std::vector<T, Alloc> &v)
+{
+    return {{}, v.data(), v.size()};
+}
+
+// Fixed-size array of T on 64-byte aligned memory, first touched by the threads that
+// later evaluate into it (so pages land on their NUMA nodes). Assigning an expression
+// evaluates it in place.
+template <class T>
+class vec
+{
+public:
+    using value_type = T;
+
+    vec() = default;
+    explicit vec(std::size_t n, T value = T()) : data_(allocate(n)), n_(n)
+    {
+        evaluate(data(), n_, detail::expr_scalar<T>{{}, value});
+    }
+    vec(std::initializer_list<T> values) : data_(allocate(values.size())), n_(values.size())
+    {
+        std::copy(values.begin(), values.end(), data());
+    }
+    vec(const vec &other) : data_(allocate(other.n_)), n_(other.n_) { evaluate(data(), n_, view(other.data(), n_)); }
+    vec(vec &&other) noexcept : data_(std::move(other.data_)), n_(std::exchange(other.n_, 0)) {}
+
+    template <detail::expression E>
+    vec(const E &e) : data_(allocate(e.size())), n_(e.size())
+    {
+        evaluate(data(), n_, e);
+    }
+
+    vec &operator=(const vec &other)
+    {
+        if (this != &other)
+        {
+            if (n_ != other.n_)
+                *this = vec(other.n_);
+            evaluate(data(), n_, view(other.data(), n_));
+        }
+        return *this;
+    }
+    // A moved-from vec is empty (size 0), so it can be assigned to again.
+    vec &operator=(vec &&other) noexcept
+    {
+        data_ = std::move(other.data_);
+        n_ = std::exchange(other.n_, 0);
+        return *this;
+    }
+
+    // Size stays fixed: the expression must have this vector's size (or be a scalar).
+    template <detail::expression E>
+    vec &operator=(const E &e)
+    {
+        evaluate(data(), n_, e);
+        return *this;
+    }
+
+    vec &operator=(T value)
+    {
+        evaluate(data(), n_, detail::expr_scalar<T>{{}, value});
+        return *this;
+    }
+
+    std::size_t size() const { return n_; }
+    T *data() { return data_.get(); }
+    const T *data() const { return data_.get(); }
+    T &operator[](std::size_t i) { return data_.get()[i]; }
+    const T &operator[](std::size_t i) const { return data_.get()[i]; }
+    T *begin() { return data(); }
+    T *end() { return data() + n_; }
+    const T *begin() const { return data(); }
+    const T *end() const { return data() + n_; }
+
+private:
+    static std::unique_ptr<T, detail::vec_free> allocate(std::size_t n)
+    {
+        if (n == detail::any_size)
+            throw std::invalid_argument("hpc::vec: cannot size a vector from a scalar expression");
+        if (n == 0)
+            return nullptr;
+        const std::size_t bytes = (n * sizeof(T) + 63) / 64 * 64;
+        T *p = static_cast<T *>(std::aligned_alloc(64, bytes));
+        if (!p)
+            throw std::bad_alloc();
+        return std::unique_ptr<T, detail::vec_free>(p);
+    }
+
+    std::unique_ptr<T, detail::vec_free> data_;
+    std::size_t n_ = 0;
+};
+
+// The operators live next to the expression types so that argument-dependent lookup finds
+// them for expressions as well as for hpc::vec.
+namespace detail
+{
+
+template <class A, class B>
+    requires binary_operands<A, B>
+auto operator+(const A &a, const B &b)
+{
+    return make_binary(std::plus<>(), a, b);
+}
+
+template <class A, class B>
+    requires binary_operands<A, B>
+auto operator-(const A &a, const B &b)
+{
+    return make_binary(std::minus<>(), a, b);
+}
+
+template <class A, class B>
+    requires binary_operands<A, B>
+auto operator*(const A &a, const B &b)
+{
+    return make_binary(std::multiplies<>(), a, b);
+}
+
+template <class A, class B>
+    requires binary_operands<A, B>
+auto operator/(const A &a, const B &b)
+{
+    return make_binary(std::divides<>(), a, b);
+}
+
+template <vector_operand A>
+auto operator-(const A &a)
+{
+    return expr_node(std::negate<>(), as_expr<A>(a));
+}
+
+} // namespace detail
+
+using detail::operator+;
+using detail::operator-;
+using detail::operator*;
+using detail::operator/;
+
+template <class A, class B>
+    requires detail::binary_operands<A, B>
+auto min(const A &a, const B &b)
+{
+    return detail::make_binary(detail::expr_min(), a, b);
+}
+
+template <class A, class B>
+    requires detail::binary_operands<A, B>
+auto max(const A &a, const B &b)
+{
+    return detail::make_binary(detail::expr_max(), a, b);
+}
+
+template <detail::vector_operand A>
+auto abs(const A &a)
+{
+    return detail::expr_node(detail::expr_abs(), detail::as_expr<A>(a));
+}
+
+// f applied element by element: f(a[i], b[i], ...). f must be a plain computation on its
+// arguments for the loop to vectorize (no I/O, no calls the compiler cannot inline).
+template <class F, detail::vector_operand... A>
+auto map(F f, const A &...a)
+{
+    return detail::expr_node(std::move(f), detail::as_expr<A>(a)...);
+}
+
+} // namespace hpc
@@ -12,10 +12,16 @@
  * 1. Ensure NVIDIA CUDA Toolkit is installed.
  * 2. Save the code as vectoradd.cu (or vectoradd.cpp if your nvcc is configured for it).
  * 3. Compile:
- *    nvcc vectoradd.cu -o vectoradd
+ *    nvcc -std=c++17 -Xcompiler -fopenmp vectoradd.cu -o vectoradd
  * 4. Execute:
  *    ./vectoradd
  *
+ * COMPILATION & EXECUTION (CPU only, no GPU or CUDA Toolkit):
+ * ----------------------------------------------------------
+ * cuda_portable.hpp runs the same kernel on a CPU thread pool:
+ *    g++ -std=c++20 -O2 -fopenmp -x c++ vectoradd.cu -o vectoradd
+ *    ./vectoradd
+ *
  * THEORETICAL CONCEPTS:
  *
  * CUDA (Compute Unified Device Architecture):
@@ -38,7 +44,9 @@
  *   - `cudaMemcpyHostToDevice`: Host to Device.
  *   - `cudaMemcpyDeviceToHost`: Device to Host.
  * - Kernel Launch (`add<<<blocksPerGrid, threadsPerBlock>>>`): Syntax to execute a
- *   `__global__` function on the GPU.
+ *   `__global__` function on the GPU. Written here as
+ *   `hpc::launch<add>(blocksPerGrid, threadsPerBlock, ...)`, which is exactly that launch
+ *   under nvcc, and a timed run on the CPU otherwise.
  *   - `blocksPerGrid`: The number of thread blocks in the grid.
  *   - `threadsPerBlock`: The number of threads in each block.
  * - `cudaFree()`: Frees memory on the GPU.
@@ -64,15 +72,17 @@
  *   values of `cudaMalloc`, `cudaMemcpy`, `cudaGetLastError`). In real-world applications,
  *   robust error handling is crucial.
  *
- * Sample Output (for N=4, random numbers):
- * ----------------------------------------
- * Vector A: 3 6 7 5
- * Vector B: 9 2 4 1
- * Addition: 12 8 11 6
- *
- * (Note: The actual numbers will vary due to `rand() % 10`)
+ * Sample Output (for N=4, CPU build; the inputs are seeded, so they repeat run to run):
+ * -----------------------------------------------------------------------------------
+ * [launch] add<<<(1,1,1), (256,1,1)>>> 0.015 ms on 1 CPU thread
+ * Vector A: 4 0 0 5
+ * Vector B: 0 8 7 4
+ * Addition: 4 8 7 9
  */
 #include <iostream>
+#include "cuda_portable.hpp"
+#include "random.hpp"
+#include "buffer_pool.hpp"
 using namespace std;
 __global__ void add(int *A, int *B, int *C, int size)
 {
@@ -82,12 +92,9 @@ __global__ void add(int *A, int *B, int *C, int size)
         C[tid] = A[tid] + B[tid];
     }
 }
-void initialize(int *vector, int size)
+void initialize(int *vector, int size, int seed)
 {
-    for (int i = 0; i < size; i++)
-    {
-        vector[i] = rand() % 10;
-    }
+    hpc::parallel_fill_uniform(vector, vector + size, 0, 9, seed);
 }
 void print(int *vector, int size)
 {
@@ -103,11 +110,14 @@ int main()
     int *A, *B, *C;
     int vectorSize = N;
     size_t vectorBytes = vectorSize * sizeof(int);
-    A = new int[vectorSize];
-    B = new int[vectorSize];
-    C = new int[vectorSize];
-    initialize(A, vectorSize);
-    initialize(B, vectorSize);
+    hpc::pooled_buffer<int> bufferA = hpc::buffer_pool::global().acquire<int>(vectorSize);
+    hpc::pooled_buffer<int> bufferB = hpc::buffer_pool::global().acquire<int>(vectorSize);
+    hpc::pooled_buffer<int> bufferC = hpc::buffer_pool::global().acquire<int>(vectorSize);
+    A = bufferA.data();
+    B = bufferB.data();
+    C = bufferC.data();
+    initialize(A, vectorSize, 1);
+    initialize(B, vectorSize, 2);
     cout << "Vector A: ";
     print(A, N);
     cout << "Vector B: ";
@@ -120,13 +130,10 @@ int main()
     cudaMemcpy(Y, B, vectorBytes, cudaMemcpyHostToDevice);
     int threadsPerBlock = 256;
     int blocksPerGrid = (N + threadsPerBlock - 1) / threadsPerBlock;
-    add<<<blocksPerGrid, threadsPerBlock>>>(X, Y, Z, N);
+    hpc::launch<add>(blocksPerGrid, threadsPerBlock, X, Y, Z, N);
     cudaMemcpy(C, Z, vectorBytes, cudaMemcpyDeviceToHost);
     cout << "Addition: ";
     print(C, N);
-    delete[] A;
-    delete[] B;
-    delete[] C;
     cudaFree(X);
     cudaFree(Y);
     cudaFree(Z);
@@ -186,7 +193,7 @@ int main()
  *       `tid`, it computes `Z[tid] = X[tid] + Y[tid]`.
  *    f. Data Transfer (Device to Host): The resulting vector Z is copied from the GPU to vector C on the CPU.
  *    g. Cleanup (Host calls CUDA API & C++): Memory allocated on the device (`cudaFree`) and on the
- *       host (`delete[]`) is freed.
+ *       host (the pooled buffers, on leaving main) is freed.
  *
  * 5. Scalability:
  *    - The performance benefit of CUDA comes from executing thousands of threads in parallel.